@@ -73,8 +73,6 @@ layer_state_t posix_io_layer_on_data_ready(
 
     posix_data_t* posix_data = ( posix_data_t* ) context->self->user_data;
 
-    XI_UNUSED( hint );
-
     data_descriptor_t* buffer = 0;
 
     if( data )
@@ -95,7 +93,15 @@ layer_state_t posix_io_layer_on_data_ready(
     {
         memset( buffer->data_ptr, 0, buffer->data_size );
 
-        int len = read( posix_data->socket_fd, buffer->data_ptr, buffer->data_size - 1 );
+        int len = hint == LAYER_HINT_NO_WAIT
+            ? recv( posix_data->socket_fd, buffer->data_ptr, buffer->data_size - 1, MSG_DONTWAIT )
+            : read( posix_data->socket_fd, buffer->data_ptr, buffer->data_size - 1 );
+
+        if( len < 0 && hint == LAYER_HINT_NO_WAIT && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+        {
+            // nothing more has arrived
+            return LAYER_STATE_WANT_READ;
+        }
 
         if( len == 0 )
         {
@@ -0,0 +1,419 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+#include <time.h>
+
+#include "xi_aggregator.h"
+#include "xi_allocator.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_data_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef XI_NOB_ENABLED
+
+static const struct
+{
+    uint8_t     aggregate;
+    const char* suffix;
+} xi_aggregator_names[] =
+{
+      { XI_AGGREGATE_LAST, "_last" }
+    , { XI_AGGREGATE_MIN, "_min" }
+    , { XI_AGGREGATE_MAX, "_max" }
+    , { XI_AGGREGATE_MEAN, "_mean" }
+};
+
+static uint32_t xi_aggregator_default_clock_ms( void )
+{
+    return ( uint32_t ) time( 0 ) * 1000;
+}
+
+static inline uint32_t xi_aggregator_now( const xi_aggregator_t* aggregator )
+{
+    return aggregator->config.clock_ms ? aggregator->config.clock_ms() : xi_aggregator_default_clock_ms();
+}
+
+static inline const xi_aggregation_rule_t* xi_aggregator_rule(
+      const xi_aggregator_t* aggregator
+    , const xi_aggregator_stream_t* stream )
+{
+    return stream->has_rule ? &stream->rule : &aggregator->config.rule;
+}
+
+static inline double xi_aggregator_value( const xi_datapoint_t* datapoint )
+{
+    return datapoint->value_type == XI_VALUE_TYPE_I32
+        ? ( double ) datapoint->value.i32_value
+        : ( double ) datapoint->value.f32_value;
+}
+
+// the stream of the datastream, it is added if there is room for it
+static xi_aggregator_stream_t* xi_aggregator_stream(
+      xi_aggregator_t* aggregator
+    , const char* datastream_id )
+{
+    xi_aggregator_stream_t* stream = 0;
+
+    for( size_t i = 0; i < aggregator->stream_count; ++i )
+    {
+        if( strcmp( aggregator->streams[ i ].datastream_id, datastream_id ) == 0 )
+        {
+            return &aggregator->streams[ i ];
+        }
+    }
+
+    XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME, XI_DATASTREAM_ID_TOO_LONG );
+    XI_CHECK_CND( aggregator->stream_count == XI_MAX_DATASTREAMS, XI_AGGREGATOR_FULL );
+
+    stream = &aggregator->streams[ aggregator->stream_count++ ];
+
+    memset( stream, 0, sizeof( xi_aggregator_stream_t ) );
+    strcpy( stream->datastream_id, datastream_id );
+
+    return stream;
+
+err_handling:
+    return 0;
+}
+
+static inline int xi_aggregator_in_deadband(
+      const xi_aggregation_rule_t* rule
+    , const xi_aggregator_stream_t* stream
+    , size_t index
+    , double value )
+{
+    const double output = stream->output[ index ];
+
+    return rule->deadband > 0
+        && ( stream->has_output & xi_aggregator_names[ index ].aggregate )
+        && value - output <= rule->deadband && output - value <= rule->deadband;
+}
+
+static inline int xi_aggregator_failed( const xi_response_t* response )
+{
+    return response == 0 || response->http.http_status < 200 || response->http.http_status >= 300;
+}
+
+// sends the datapoint wherever it would go without the aggregator
+static const xi_response_t* xi_aggregator_forward(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    void* aggregator                = xi->aggregator;
+    const xi_response_t* response   = 0;
+
+    xi->aggregator  = 0;
+    response        = xi_datastream_update( xi, xi->feed_id, datastream_id, datapoint );
+    xi->aggregator  = aggregator;
+
+    return response;
+}
+
+// sends the aggregates of the open window and closes it, the window is kept if one of them fails
+// and only the ones that have not been sent yet are sent again
+static const xi_response_t* xi_aggregator_send_window(
+      xi_context_t* xi
+    , xi_aggregator_t* aggregator
+    , xi_aggregator_stream_t* stream )
+{
+    const xi_aggregation_rule_t* rule   = xi_aggregator_rule( aggregator, stream );
+    const uint8_t aggregates            = rule->aggregates ? rule->aggregates : XI_AGGREGATE_LAST;
+    const xi_response_t* response       = 0;
+    char datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_datapoint_t datapoint;
+
+    if( stream->count == 0 )
+    {
+        return 0;
+    }
+
+    for( size_t i = 0; i < sizeof( xi_aggregator_names ) / sizeof( xi_aggregator_names[ 0 ] ); ++i )
+    {
+        const uint8_t aggregate = xi_aggregator_names[ i ].aggregate;
+
+        if( ( aggregates & aggregate ) == 0 || ( stream->sent & aggregate ) )
+        {
+            continue;
+        }
+
+        // the only aggregate takes the place of the datastream
+        strcpy( datastream_id, stream->datastream_id );
+
+        if( aggregates & ( aggregates - 1 ) )
+        {
+            if( strlen( datastream_id ) + strlen( xi_aggregator_names[ i ].suffix ) >= XI_MAX_DATASTREAM_NAME )
+            {
+                xi_debug_format( "the aggregate of [%s] does not fit the id", datastream_id );
+                continue;
+            }
+
+            strcat( datastream_id, xi_aggregator_names[ i ].suffix );
+        }
+
+        datapoint       = stream->last;
+        double value    = xi_aggregator_value( &datapoint );
+
+        switch( aggregate )
+        {
+            case XI_AGGREGATE_MIN:
+            case XI_AGGREGATE_MAX:
+                value = aggregate == XI_AGGREGATE_MIN ? stream->min : stream->max;
+
+                if( stream->all_i32 )
+                {
+                    xi_set_value_i32( &datapoint, ( int32_t ) value );
+                }
+                else
+                {
+                    xi_set_value_f32( &datapoint, ( float ) value );
+                }
+                break;
+            case XI_AGGREGATE_MEAN:
+                value = stream->sum / stream->count;
+                xi_set_value_f32( &datapoint, ( float ) value );
+                break;
+            default:
+                break;
+        }
+
+        // the deadband is around the value the aggregate has been sent with last
+        if( !xi_aggregator_in_deadband( rule, stream, i, value ) )
+        {
+            response = xi_aggregator_forward( xi, datastream_id, &datapoint );
+
+            if( xi_aggregator_failed( response ) )
+            {
+                return response;
+            }
+
+            stream->output[ i ]     = value;
+            stream->has_output     |= aggregate;
+        }
+
+        stream->sent |= aggregate;
+    }
+
+    stream->count   = 0;
+    stream->sent    = 0;
+
+    return response;
+}
+
+static const xi_response_t* xi_aggregator_accepted( xi_context_t* xi )
+{
+    xi_response_t* accepted = xi_data_layer_response( xi->layer_chain.top );
+
+    memset( accepted, 0, sizeof( xi_response_t ) );
+
+    accepted->http.http_status = 202;
+    strcpy( accepted->http.http_status_string, "Accepted" );
+
+    return accepted;
+}
+
+xi_context_t* xi_aggregator_enable(
+      xi_context_t* xi
+    , const xi_aggregator_config_t* config )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( config != 0 );
+
+    xi_aggregator_t* aggregator = ( xi_aggregator_t* ) xi->aggregator;
+
+    if( aggregator == 0 )
+    {
+        aggregator = ( xi_aggregator_t* ) xi_alloc( sizeof( xi_aggregator_t ) );
+
+        XI_CHECK_MEMORY( aggregator );
+
+        memset( aggregator, 0, sizeof( xi_aggregator_t ) );
+    }
+
+    aggregator->config  = *config;
+    xi->aggregator      = aggregator;
+
+    return xi;
+
+err_handling:
+    return 0;
+}
+
+int xi_aggregator_set_rule(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_aggregation_rule_t* rule )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( xi->aggregator != 0 );
+    assert( rule != 0 );
+
+    xi_aggregator_t* aggregator     = ( xi_aggregator_t* ) xi->aggregator;
+    xi_aggregator_stream_t* stream  = xi_aggregator_stream( aggregator, datastream_id );
+
+    if( stream == 0 )
+    {
+        return -1;
+    }
+
+    // the window is over with the rule it has been opened with
+    xi_aggregator_send_window( xi, aggregator, stream );
+
+    // the window that could not be sent is kept
+    if( stream->count )
+    {
+        return -1;
+    }
+
+    stream->rule        = *rule;
+    stream->has_rule    = 1;
+
+    return 0;
+}
+
+const xi_response_t* xi_aggregator_poll( xi_context_t* xi )
+{
+    xi_aggregator_t* aggregator     = ( xi_aggregator_t* ) xi->aggregator;
+    const xi_response_t* response   = 0;
+
+    if( aggregator == 0 )
+    {
+        return 0;
+    }
+
+    const uint32_t now = xi_aggregator_now( aggregator );
+
+    for( size_t i = 0; i < aggregator->stream_count; ++i )
+    {
+        xi_aggregator_stream_t* stream = &aggregator->streams[ i ];
+
+        if( stream->count && now - stream->window_start_ms >= xi_aggregator_rule( aggregator, stream )->window_ms )
+        {
+            const xi_response_t* ret = xi_aggregator_send_window( xi, aggregator, stream );
+
+            response = ret ? ret : response;
+
+            // the window that could not be sent is kept and the failure is reported
+            if( stream->count )
+            {
+                break;
+            }
+        }
+    }
+
+    return response;
+}
+
+const xi_response_t* xi_aggregator_disable( xi_context_t* xi )
+{
+    xi_aggregator_t* aggregator     = ( xi_aggregator_t* ) xi->aggregator;
+    const xi_response_t* response   = 0;
+
+    if( aggregator == 0 )
+    {
+        return 0;
+    }
+
+    for( size_t i = 0; i < aggregator->stream_count; ++i )
+    {
+        const xi_response_t* ret = xi_aggregator_send_window( xi, aggregator, &aggregator->streams[ i ] );
+
+        response = ret ? ret : response;
+
+        // the aggregation stays enabled with the window that could not be sent
+        if( aggregator->streams[ i ].count )
+        {
+            return response;
+        }
+    }
+
+    XI_SAFE_FREE( xi->aggregator );
+
+    return response;
+}
+
+const xi_response_t* xi_aggregator_update(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    xi_aggregator_t* aggregator         = ( xi_aggregator_t* ) xi->aggregator;
+    xi_aggregator_stream_t* stream      = 0;
+    const xi_aggregation_rule_t* rule   = 0;
+    const xi_response_t* response       = 0;
+
+    if( datapoint->value_type != XI_VALUE_TYPE_I32 && datapoint->value_type != XI_VALUE_TYPE_F32 )
+    {
+        return xi_aggregator_forward( xi, datastream_id, datapoint );
+    }
+
+    stream = xi_aggregator_stream( aggregator, datastream_id );
+
+    if( stream == 0 )
+    {
+        xi_set_err( XI_NO_ERR );
+        return xi_aggregator_forward( xi, datastream_id, datapoint );
+    }
+
+    rule = xi_aggregator_rule( aggregator, stream );
+
+    const uint32_t now  = xi_aggregator_now( aggregator );
+    const double value  = xi_aggregator_value( datapoint );
+
+    // the window that has passed is sent before the sample opens the next one
+    if( stream->count && now - stream->window_start_ms >= rule->window_ms )
+    {
+        response = xi_aggregator_send_window( xi, aggregator, stream );
+    }
+
+    // without the window the sample is its own aggregate
+    if( rule->window_ms == 0 )
+    {
+        if( xi_aggregator_in_deadband( rule, stream, 0, value ) )
+        {
+            return xi_aggregator_accepted( xi );
+        }
+
+        response = xi_aggregator_forward( xi, datastream_id, datapoint );
+
+        if( !xi_aggregator_failed( response ) )
+        {
+            stream->output[ 0 ]     = value;
+            stream->has_output     |= XI_AGGREGATE_LAST;
+        }
+
+        return response;
+    }
+
+    if( stream->count == 0 )
+    {
+        stream->window_start_ms = now;
+        stream->sum             = 0;
+        stream->min             = value;
+        stream->max             = value;
+        stream->all_i32         = 1;
+    }
+
+    stream->sum     += value;
+    stream->min      = value < stream->min ? value : stream->min;
+    stream->max      = value > stream->max ? value : stream->max;
+    stream->all_i32 &= datapoint->value_type == XI_VALUE_TYPE_I32;
+    stream->last     = *datapoint;
+    stream->count   += 1;
+
+    return response ? response : xi_aggregator_accepted( xi );
+}
+
+#endif // XI_NOB_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,49 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_AGGREGATOR_H__
+#define __XI_AGGREGATOR_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    char                    datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_aggregation_rule_t   rule;
+    char                    has_rule;           // set by xi_aggregator_set_rule, the default one is used otherwise
+    uint8_t                 has_output;         // the xi_aggregate_t flags of the aggregates sent at least once
+    double                  output[ 4 ];        // the value each aggregate has been sent with last, the deadband is around it
+    uint8_t                 sent;               // the xi_aggregate_t flags of the open window that have been sent already
+    uint32_t                window_start_ms;
+    uint32_t                count;              // the samples of the open window
+    double                  sum;
+    double                  min;
+    double                  max;
+    char                    all_i32;
+    xi_datapoint_t          last;
+} xi_aggregator_stream_t;
+
+typedef struct
+{
+    xi_aggregator_config_t  config;
+    size_t                  stream_count;
+    xi_aggregator_stream_t  streams[ XI_MAX_DATASTREAMS ];
+} xi_aggregator_t;
+
+// filters the datapoint and adds it to the window of its datastream, sends the aggregates of the window if it has passed
+const xi_response_t* xi_aggregator_update(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_AGGREGATOR_H__
@@ -0,0 +1,185 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xively.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline size_t xi_arena_align( size_t size )
+{
+    return ( size + XI_ARENA_ALIGNMENT - 1 ) & ~( ( size_t ) XI_ARENA_ALIGNMENT - 1 );
+}
+
+void xi_arena_init( xi_arena_t* arena, void* buffer, size_t size )
+{
+    // PRECONDITIONS
+    assert( arena != 0 );
+    assert( buffer != 0 || size == 0 );
+
+    // the beginning of the buffer may be not aligned
+    const size_t skip   = xi_arena_align( ( size_t ) buffer ) - ( size_t ) buffer;
+
+    arena->base         = ( unsigned char* ) buffer + ( skip < size ? skip : size );
+    arena->size         = skip < size ? size - skip : 0;
+
+    xi_arena_reset( arena );
+}
+
+void xi_arena_reset( xi_arena_t* arena )
+{
+    // PRECONDITIONS
+    assert( arena != 0 );
+
+    arena->used = 0;
+    arena->last = 0;
+}
+
+void* xi_arena_alloc( xi_arena_t* arena, size_t size )
+{
+    // PRECONDITIONS
+    assert( arena != 0 );
+
+    void* ret = 0;
+
+    XI_CHECK_CND( size > arena->size - arena->used, XI_OUT_OF_MEMORY );
+
+    ret             = arena->base + arena->used;
+    arena->used     = XI_MIN( arena->used + xi_arena_align( size ), arena->size );
+    arena->last     = ret;
+
+    return ret;
+
+err_handling:
+    return 0;
+}
+
+// resizes the block, the latest one grows in place, the others are copied
+static void* xi_arena_grow( xi_arena_t* arena, void* ptr, size_t size, size_t new_size )
+{
+    if( ptr != 0 && ptr == arena->last )
+    {
+        const size_t offset = ( size_t ) ( ( unsigned char* ) ptr - arena->base );
+
+        XI_CHECK_CND( new_size > arena->size - offset, XI_OUT_OF_MEMORY );
+
+        arena->used = XI_MIN( offset + xi_arena_align( new_size ), arena->size );
+
+        return ptr;
+    }
+
+    {
+        void* ret = xi_arena_alloc( arena, new_size );
+
+        XI_CHECK_MEMORY( ret );
+
+        if( size )
+        {
+            memcpy( ret, ptr, size );
+        }
+
+        return ret;
+    }
+
+err_handling:
+    return 0;
+}
+
+xi_arena_feed_t* xi_arena_feed_create( xi_arena_t* arena, xi_feed_id_t feed_id )
+{
+    // PRECONDITIONS
+    assert( arena != 0 );
+
+    xi_arena_feed_t* feed = ( xi_arena_feed_t* ) xi_arena_alloc( arena, sizeof( xi_arena_feed_t ) );
+
+    XI_CHECK_MEMORY( feed );
+
+    memset( feed, 0, sizeof( xi_arena_feed_t ) );
+
+    feed->arena     = arena;
+    feed->feed_id   = feed_id;
+
+    return feed;
+
+err_handling:
+    return 0;
+}
+
+xi_arena_datastream_t* xi_arena_feed_add_datastream(
+          xi_arena_feed_t* feed
+        , const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( feed != 0 );
+    assert( datastream_id != 0 );
+
+    const size_t id_size            = strlen( datastream_id ) + 1;
+    xi_arena_datastream_t* ret      = ( xi_arena_datastream_t* ) xi_arena_alloc( feed->arena, sizeof( xi_arena_datastream_t ) + id_size );
+
+    XI_CHECK_MEMORY( ret );
+
+    memset( ret, 0, sizeof( xi_arena_datastream_t ) );
+    memcpy( ret + 1, datastream_id, id_size );
+
+    ret->datastream_id = ( const char* ) ( ret + 1 );
+
+    if( feed->last )
+    {
+        feed->last->next = ret;
+    }
+    else
+    {
+        feed->datastreams = ret;
+    }
+
+    feed->last               = ret;
+    feed->datastream_count  += 1;
+
+    return ret;
+
+err_handling:
+    return 0;
+}
+
+int xi_arena_datastream_append(
+          xi_arena_feed_t* feed
+        , xi_arena_datastream_t* datastream
+        , const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( feed != 0 );
+    assert( datastream != 0 );
+    assert( datapoint != 0 );
+
+    if( datastream->datapoint_count == datastream->datapoint_capacity )
+    {
+        const size_t capacity   = datastream->datapoint_capacity ? datastream->datapoint_capacity * 2 : 4;
+        xi_datapoint_t* ret     = ( xi_datapoint_t* ) xi_arena_grow(
+                  feed->arena
+                , datastream->datapoints
+                , datastream->datapoint_count * sizeof( xi_datapoint_t )
+                , capacity * sizeof( xi_datapoint_t ) );
+
+        XI_CHECK_MEMORY( ret );
+
+        datastream->datapoints          = ret;
+        datastream->datapoint_capacity  = capacity;
+    }
+
+    datastream->datapoints[ datastream->datapoint_count++ ] = *datapoint;
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
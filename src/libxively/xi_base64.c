@@ -0,0 +1,37 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include "xi_base64.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static const char XI_BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+char* xi_base64_encode( char* dst, const void* src, size_t size )
+{
+    const unsigned char* p  = ( const unsigned char* ) src;
+    char* out               = dst;
+
+    for( size_t i = 0; i < size; i += 3 )
+    {
+        const unsigned long v = ( ( unsigned long ) p[ i ] << 16 )
+                              | ( i + 1 < size ? ( unsigned long ) p[ i + 1 ] << 8 : 0 )
+                              | ( i + 2 < size ? ( unsigned long ) p[ i + 2 ] : 0 );
+
+        *out++ = XI_BASE64_ALPHABET[ ( v >> 18 ) & 0x3F ];
+        *out++ = XI_BASE64_ALPHABET[ ( v >> 12 ) & 0x3F ];
+        *out++ = i + 1 < size ? XI_BASE64_ALPHABET[ ( v >> 6 ) & 0x3F ] : '=';
+        *out++ = i + 2 < size ? XI_BASE64_ALPHABET[ v & 0x3F ] : '=';
+    }
+
+    *out = '\0';
+
+    return dst;
+}
+
+#ifdef __cplusplus
+}
+#endif
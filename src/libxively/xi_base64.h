@@ -0,0 +1,23 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_BASE64_H__
+#define __XI_BASE64_H__
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the size of the encoded data without the guard
+#define XI_BASE64_ENCODED_SIZE( size ) ( ( ( size ) + 2 ) / 3 * 4 )
+
+// encodes the data and puts the guard, dst must hold XI_BASE64_ENCODED_SIZE( size ) + 1 characters
+char* xi_base64_encode( char* dst, const void* src, size_t size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_BASE64_H__
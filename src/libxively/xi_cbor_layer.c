@@ -0,0 +1,883 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xi_cbor_layer.h"
+#include "xively.h"
+
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_coroutine.h"
+#include "xi_generator.h"
+#include "xi_cbor_layer_data.h"
+#include "xi_layer_api.h"
+#include "xi_http_layer_input.h"
+#include "xi_feed_delta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the major types of the items
+#define CBOR_UNSIGNED   0
+#define CBOR_NEGATIVE   1
+#define CBOR_TEXT       3
+#define CBOR_ARRAY      4
+#define CBOR_SIMPLE     7
+
+#define CBOR_NULL       0xF6
+#define CBOR_FLOAT16    25
+#define CBOR_FLOAT32    26
+#define CBOR_FLOAT64    27
+
+// the biggest piece that is generated at once is the create of the datastream with its datapoint
+static unsigned char cbor_buffer[ 96 ];
+
+// the at of the datapoint encoded before within the same body
+static int64_t cbor_time_base = 0;
+
+// the head of the item with the argument in the shortest form
+static size_t cbor_encode_head( unsigned char* out, unsigned char major, uint64_t arg )
+{
+    size_t size = 0;
+
+    if( arg < 24 )
+    {
+        out[ 0 ] = ( unsigned char ) ( ( major << 5 ) | arg );
+        return 1;
+    }
+
+    size    = arg <= 0xFF ? 1 : arg <= 0xFFFF ? 2 : arg <= 0xFFFFFFFF ? 4 : 8;
+    out[ 0 ] = ( unsigned char ) ( ( major << 5 ) | ( size == 1 ? 24 : size == 2 ? 25 : size == 4 ? 26 : 27 ) );
+
+    for( size_t i = 0; i < size; ++i )
+    {
+        out[ 1 + i ] = ( unsigned char ) ( arg >> ( 8 * ( size - 1 - i ) ) );
+    }
+
+    return 1 + size;
+}
+
+static inline size_t cbor_encode_int( unsigned char* out, int64_t value )
+{
+    return value >= 0
+        ? cbor_encode_head( out, CBOR_UNSIGNED, ( uint64_t ) value )
+        : cbor_encode_head( out, CBOR_NEGATIVE, ( uint64_t ) ( -1 - value ) );
+}
+
+static inline size_t cbor_encode_text( unsigned char* out, const char* text )
+{
+    const size_t length = strlen( text );
+    const size_t size   = cbor_encode_head( out, CBOR_TEXT, length );
+
+    memcpy( out + size, text, length );
+
+    return size + length;
+}
+
+static size_t cbor_encode_datapoint( unsigned char* out, const xi_datapoint_t* dp )
+{
+    size_t size = 0;
+
+    out[ size++ ] = ( CBOR_ARRAY << 5 ) | 2;
+
+    if( dp->timestamp.timestamp == 0 )
+    {
+        out[ size++ ] = CBOR_NULL;
+    }
+    else
+    {
+        const int64_t at = ( int64_t ) dp->timestamp.timestamp * 1000000 + dp->timestamp.micro;
+
+        size            += cbor_encode_int( out + size, at - cbor_time_base );
+        cbor_time_base  = at;
+    }
+
+    switch( dp->value_type )
+    {
+        case XI_VALUE_TYPE_I32:
+            size += cbor_encode_int( out + size, dp->value.i32_value );
+            break;
+        case XI_VALUE_TYPE_F32:
+            {
+                uint32_t bits = 0;
+
+                memcpy( &bits, &dp->value.f32_value, sizeof( bits ) );
+
+                out[ size++ ] = ( CBOR_SIMPLE << 5 ) | CBOR_FLOAT32;
+
+                for( int shift = 24; shift >= 0; shift -= 8 )
+                {
+                    out[ size++ ] = ( unsigned char ) ( bits >> shift );
+                }
+            }
+            break;
+        case XI_VALUE_TYPE_STR:
+            size += cbor_encode_text( out + size, dp->value.str_value );
+            break;
+        default:
+            out[ size++ ] = CBOR_NULL;
+    }
+
+    return size;
+}
+
+// [ id, [ the head of the datapoints array
+static inline size_t cbor_encode_datastream_head( unsigned char* out, const char* datastream_id, size_t datapoint_count )
+{
+    size_t size = 0;
+
+    out[ size++ ]   = ( CBOR_ARRAY << 5 ) | 2;
+    size            += cbor_encode_text( out + size, datastream_id );
+    size            += cbor_encode_head( out + size, CBOR_ARRAY, datapoint_count );
+
+    return size;
+}
+
+// the datastream without the datapoints is sent with the first one as the other formats do
+static inline size_t cbor_datapoint_count( const xi_datastream_t* datastream )
+{
+    return datastream->datapoint_count == 0 ? 1 : XI_MIN( datastream->datapoint_count, ( size_t ) XI_MAX_DATAPOINTS );
+}
+
+const void* cbor_layer_data_generator_datapoint(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    size_t size                         = 0;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        cbor_time_base  = 0;
+        size            = cbor_encode_head( cbor_buffer, CBOR_ARRAY, 1 );
+        size            += cbor_encode_datapoint( cbor_buffer + size, ld->xi_get_datastream.value );
+
+        gen_ptr_data_and_exit( *state, cbor_buffer, size );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* cbor_layer_data_generator_datastream(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    size_t size                         = 0;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        cbor_time_base  = 0;
+        size            = cbor_encode_head( cbor_buffer, CBOR_ARRAY, 1 );
+        size            += cbor_encode_datastream_head( cbor_buffer + size, ld->xi_create_datastream.datastream, 1 );
+        size            += cbor_encode_datapoint( cbor_buffer + size, ld->xi_create_datastream.value );
+
+        gen_ptr_data_and_exit( *state, cbor_buffer, size );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* cbor_layer_data_generator_feed(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    const xi_feed_t* feed               = ( const xi_feed_t* ) ld->xi_get_feed.feed;
+    static unsigned char i              = 0;                                            // local global indexes required to be static cause used via the persistent for
+    static unsigned char j              = 0;
+    size_t size                         = 0;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        cbor_time_base  = 0;
+        size            = cbor_encode_head( cbor_buffer, CBOR_ARRAY, xi_feed_delta_dirty_count( ld->xi_update_feed.delta, feed ) );
+
+        gen_ptr_data( *state, cbor_buffer, size );
+
+        for( i = 0; i < feed->datastream_count; ++i )
+        {
+            // the delta update leaves out the ones that have not changed
+            if( !xi_feed_delta_is_dirty( ld->xi_update_feed.delta, i ) )
+            {
+                continue;
+            }
+
+            size = cbor_encode_datastream_head( cbor_buffer, feed->datastreams[ i ].datastream_id, cbor_datapoint_count( &feed->datastreams[ i ] ) );
+
+            gen_ptr_data( *state, cbor_buffer, size );
+
+            for( j = 0; j < cbor_datapoint_count( &feed->datastreams[ i ] ); ++j )
+            {
+                size = cbor_encode_datapoint( cbor_buffer, &feed->datastreams[ i ].datapoints[ j ] );
+
+                gen_ptr_data( *state, cbor_buffer, size );
+            }
+        }
+
+        gen_ptr_data_and_exit( *state, cbor_buffer, 0 );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* cbor_layer_data_generator_datapoints(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    static size_t i                     = 0;                                            // local global index required to be static cause used via the persistent for
+    size_t size                         = 0;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        cbor_time_base  = 0;
+        size            = cbor_encode_head( cbor_buffer, CBOR_ARRAY, ld->xi_post_datapoints.count );
+
+        gen_ptr_data( *state, cbor_buffer, size );
+
+        for( i = 0; i < ld->xi_post_datapoints.count; ++i )
+        {
+            size = cbor_encode_datapoint( cbor_buffer, &ld->xi_post_datapoints.values[ i ] );
+
+            gen_ptr_data( *state, cbor_buffer, size );
+        }
+
+        gen_ptr_data_and_exit( *state, cbor_buffer, 0 );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* cbor_layer_data_generator_columns(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    const xi_feed_columns_t* columns    = ld->xi_update_columns.columns;
+    static size_t i                     = 0;                                            // local global indexes required to be static cause used via the persistent for
+    static size_t j                     = 0;
+    static xi_datapoint_t tmp_datapoint;
+    size_t size                         = 0;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        cbor_time_base  = 0;
+        size            = cbor_encode_head( cbor_buffer, CBOR_ARRAY, columns->column_count );
+
+        gen_ptr_data( *state, cbor_buffer, size );
+
+        for( i = 0; i < columns->column_count; ++i )
+        {
+            size = cbor_encode_datastream_head( cbor_buffer, columns->columns[ i ].datastream_id, columns->columns[ i ].sample_count );
+
+            gen_ptr_data( *state, cbor_buffer, size );
+
+            for( j = 0; j < columns->columns[ i ].sample_count; ++j )
+            {
+                size = cbor_encode_datapoint( cbor_buffer, xi_feed_columns_datapoint( columns, &columns->columns[ i ], j, &tmp_datapoint ) );
+
+                gen_ptr_data( *state, cbor_buffer, size );
+            }
+        }
+
+        gen_ptr_data_and_exit( *state, cbor_buffer, 0 );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* cbor_layer_data_generator_arena_feed(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld       = ( const union http_union_data_t* ) input;
+    static const xi_arena_datastream_t* ds  = 0;                                        // local global iterators required to be static cause used via the persistent for
+    static size_t j                         = 0;
+    size_t size                             = 0;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        cbor_time_base  = 0;
+        size            = cbor_encode_head( cbor_buffer, CBOR_ARRAY, ld->xi_update_arena_feed.feed->datastream_count );
+
+        gen_ptr_data( *state, cbor_buffer, size );
+
+        for( ds = ld->xi_update_arena_feed.feed->datastreams; ds != 0; ds = ds->next )
+        {
+            // the id of any length is sent from where it is stored
+            cbor_buffer[ 0 ]    = ( CBOR_ARRAY << 5 ) | 2;
+            size                = 1 + cbor_encode_head( cbor_buffer + 1, CBOR_TEXT, strlen( ds->datastream_id ) );
+
+            gen_ptr_data( *state, cbor_buffer, size );
+            gen_ptr_data( *state, ds->datastream_id, strlen( ds->datastream_id ) );
+
+            size = cbor_encode_head( cbor_buffer, CBOR_ARRAY, ds->datapoint_count );
+
+            gen_ptr_data( *state, cbor_buffer, size );
+
+            for( j = 0; j < ds->datapoint_count; ++j )
+            {
+                size = cbor_encode_datapoint( cbor_buffer, &ds->datapoints[ j ] );
+
+                gen_ptr_data( *state, cbor_buffer, size );
+            }
+        }
+
+        gen_ptr_data_and_exit( *state, cbor_buffer, 0 );
+
+    END_CORO()
+
+    return 0;
+}
+
+// the levels of the arrays, the datastream reads start at the datapoints
+typedef enum
+{
+      CBOR_LEVEL_FEED = 1
+    , CBOR_LEVEL_DATASTREAM
+    , CBOR_LEVEL_DATAPOINTS
+    , CBOR_LEVEL_DATAPOINT
+} cbor_level_t;
+
+static inline char cbor_layer_is_feed( const cbor_layer_data_t* cbor )
+{
+    return cbor->http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET
+        || cbor->http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET_ALL;
+}
+
+static inline unsigned char cbor_layer_level( const cbor_layer_data_t* cbor )
+{
+    return cbor->depth + ( cbor_layer_is_feed( cbor ) ? 0 : CBOR_LEVEL_DATAPOINTS - 1 );
+}
+
+// the feed's datastream the one being read is stored at, 0 if it is handed over to the sink or dropped,
+// the datastream read stores all of its datapoints only if it has been asked to
+static xi_datastream_t* cbor_layer_target( const cbor_layer_data_t* cbor )
+{
+    const struct xi_get_feed_t* get_feed = &cbor->http_layer_input->http_union_data.xi_get_feed;
+
+    if( cbor->http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_GET )
+    {
+        return cbor->http_layer_input->http_union_data.xi_get_datastream.datapoints;
+    }
+
+    if( !cbor_layer_is_feed( cbor ) || get_feed->sink || cbor->datastream_count >= XI_MAX_DATASTREAMS )
+    {
+        return 0;
+    }
+
+    return &( ( xi_feed_t* ) get_feed->feed )->datastreams[ cbor->datastream_count ];
+}
+
+static inline signed char cbor_layer_error( void )
+{
+    xi_set_err( XI_CBOR_DECODE_PARSER_ERROR );
+    return -1;
+}
+
+static float cbor_decode_half( uint16_t half )
+{
+    const uint32_t sign     = ( uint32_t ) ( half & 0x8000 ) << 16;
+    const uint32_t exponent = ( half >> 10 ) & 0x1F;
+    const uint32_t mantissa = half & 0x3FF;
+    uint32_t bits           = 0;
+    float value             = 0;
+
+    if( exponent == 0 )
+    {
+        // subnormal, exact within the float
+        value = ( float ) mantissa / 16777216.0f;
+        return sign ? -value : value;
+    }
+
+    bits = sign | ( exponent == 31 ? 0xFF : exponent - 15 + 127 ) << 23 | mantissa << 13;
+    memcpy( &value, &bits, sizeof( value ) );
+
+    return value;
+}
+
+// the number or the text of the datapoint's value
+static signed char cbor_layer_decode_value(
+      cbor_layer_data_t* cbor
+    , unsigned char major
+    , unsigned char info
+    , uint64_t arg
+    , xi_datapoint_t* dp )
+{
+    switch( major )
+    {
+        case CBOR_UNSIGNED:
+        case CBOR_NEGATIVE:
+            // the integers that do not fit are kept as floats
+            if( arg > INT32_MAX )
+            {
+                dp->value.f32_value = major == CBOR_UNSIGNED ? ( float ) arg : -1.0f - ( float ) arg;
+                dp->value_type      = XI_VALUE_TYPE_F32;
+                return 0;
+            }
+
+            dp->value.i32_value = major == CBOR_UNSIGNED ? ( int32_t ) arg : -1 - ( int32_t ) arg;
+            dp->value_type      = XI_VALUE_TYPE_I32;
+            return 0;
+        case CBOR_TEXT:
+            if( cbor->text_length >= XI_VALUE_STRING_MAX_SIZE )
+            {
+                xi_set_err( XI_DATAPOINT_VALUE_BUFFER_OVERFLOW );
+                return -1;
+            }
+
+            memcpy( dp->value.str_value, cbor->text, cbor->text_length + 1 );
+            dp->value_type = XI_VALUE_TYPE_STR;
+            return 0;
+        case CBOR_SIMPLE:
+            dp->value_type = XI_VALUE_TYPE_F32;
+
+            if( info == CBOR_FLOAT16 )
+            {
+                dp->value.f32_value = cbor_decode_half( ( uint16_t ) arg );
+            }
+            else if( info == CBOR_FLOAT32 )
+            {
+                const uint32_t bits = ( uint32_t ) arg;
+                memcpy( &dp->value.f32_value, &bits, sizeof( bits ) );
+            }
+            else if( info == CBOR_FLOAT64 )
+            {
+                double value = 0;
+                memcpy( &value, &arg, sizeof( value ) );
+                dp->value.f32_value = ( float ) value;
+            }
+            else
+            {
+                // the null and the booleans leave the value as it has been
+                dp->value_type = 0;
+            }
+            return 0;
+        default:
+            return cbor_layer_error();
+    }
+}
+
+static void cbor_layer_begin( cbor_layer_data_t* cbor )
+{
+    xi_datastream_t* target = cbor_layer_target( cbor );
+
+    switch( cbor_layer_level( cbor ) )
+    {
+        case CBOR_LEVEL_DATASTREAM:
+            memset( cbor->datastream_id, 0, sizeof( cbor->datastream_id ) );
+
+            if( target )
+            {
+                memset( target, 0, sizeof( xi_datastream_t ) );
+            }
+            break;
+        case CBOR_LEVEL_DATAPOINT:
+            memset( &cbor->datapoint, 0, sizeof( xi_datapoint_t ) );
+            break;
+    }
+}
+
+static void cbor_layer_end( cbor_layer_data_t* cbor )
+{
+    const http_layer_input_t* input = cbor->http_layer_input;
+    xi_datastream_t* target         = cbor_layer_target( cbor );
+
+    switch( cbor_layer_level( cbor ) )
+    {
+        case CBOR_LEVEL_DATAPOINT:
+            if( input->query_type == HTTP_LAYER_INPUT_DATASTREAM_GET && !target )
+            {
+                // the last one is the current value
+                *( ( xi_datapoint_t* ) input->http_union_data.xi_get_datastream.value ) = cbor->datapoint;
+            }
+            else if( input->query_type == HTTP_LAYER_INPUT_DATASTREAM_HISTORY )
+            {
+                ( *input->http_union_data.xi_get_datastream_history.sink )(
+                      input->http_union_data.xi_get_datastream_history.datastream
+                    , &cbor->datapoint
+                    , input->http_union_data.xi_get_datastream_history.sink_data );
+            }
+            else if( target )
+            {
+                if( target->datapoint_count < XI_MAX_DATAPOINTS )
+                {
+                    target->datapoints[ target->datapoint_count++ ] = cbor->datapoint;
+                }
+            }
+            else if( cbor_layer_is_feed( cbor ) && input->http_union_data.xi_get_feed.sink )
+            {
+                ( *input->http_union_data.xi_get_feed.sink )(
+                      cbor->datastream_id
+                    , &cbor->datapoint
+                    , input->http_union_data.xi_get_feed.sink_data );
+            }
+            break;
+        case CBOR_LEVEL_DATASTREAM:
+            if( target )
+            {
+                memcpy( target->datastream_id, cbor->datastream_id, sizeof( target->datastream_id ) );
+                ( ( xi_feed_t* ) input->http_union_data.xi_get_feed.feed )->datastream_count = cbor->datastream_count + 1;
+            }
+            else if( !input->http_union_data.xi_get_feed.sink )
+            {
+                xi_debug_format( "datastream %s dropped, the feed is full", cbor->datastream_id );
+            }
+
+            cbor->datastream_count += 1;
+            break;
+    }
+}
+
+static signed char cbor_layer_close_array( cbor_layer_data_t* cbor );
+
+// the item or the array that has just been read is one more of the array it is within
+static signed char cbor_layer_element_done( cbor_layer_data_t* cbor )
+{
+    cbor->index[ cbor->depth ] += 1;
+
+    if( --cbor->remaining[ cbor->depth ] == 0 )
+    {
+        return cbor_layer_close_array( cbor );
+    }
+
+    return 0;
+}
+
+// returns 1 once the root is closed
+static signed char cbor_layer_close_array( cbor_layer_data_t* cbor )
+{
+    cbor_layer_end( cbor );
+
+    if( --cbor->depth == 0 )
+    {
+        return 1;
+    }
+
+    return cbor_layer_element_done( cbor );
+}
+
+static signed char cbor_layer_open_array( cbor_layer_data_t* cbor, uint64_t count )
+{
+    if( cbor_layer_level( cbor ) >= CBOR_LEVEL_DATAPOINT || count > UINT32_MAX )
+    {
+        return cbor_layer_error();
+    }
+
+    cbor->depth                     += 1;
+    cbor->remaining[ cbor->depth ]  = ( uint32_t ) count;
+    cbor->index[ cbor->depth ]      = 0;
+
+    cbor_layer_begin( cbor );
+
+    return count == 0 ? cbor_layer_close_array( cbor ) : 0;
+}
+
+static signed char cbor_layer_on_item( cbor_layer_data_t* cbor )
+{
+    const unsigned char major   = cbor->head[ 0 ] >> 5;
+    const unsigned char info    = cbor->head[ 0 ] & 0x1F;
+    uint64_t arg                = info < 24 ? info : 0;
+    signed char ret             = 0;
+
+    for( unsigned char i = 1; i < cbor->head_size; ++i )
+    {
+        arg = ( arg << 8 ) | cbor->head[ i ];
+    }
+
+    if( major == CBOR_ARRAY )
+    {
+        return cbor_layer_open_array( cbor, arg );
+    }
+
+    if( cbor->depth == 0 )
+    {
+        return cbor_layer_error();
+    }
+
+    switch( cbor_layer_level( cbor ) * 2 + ( cbor->index[ cbor->depth ] == 0 ? 0 : 1 ) )
+    {
+        case CBOR_LEVEL_DATASTREAM * 2:
+            if( major != CBOR_TEXT )
+            {
+                return cbor_layer_error();
+            }
+
+            if( cbor->text_length >= XI_MAX_DATASTREAM_NAME )
+            {
+                xi_set_err( XI_DATASTREAM_ID_TOO_LONG );
+                return -1;
+            }
+
+            memcpy( cbor->datastream_id, cbor->text, cbor->text_length + 1 );
+            break;
+        case CBOR_LEVEL_DATAPOINT * 2:
+            if( major == CBOR_UNSIGNED || major == CBOR_NEGATIVE )
+            {
+                const int64_t at = cbor->time_base + ( major == CBOR_UNSIGNED ? ( int64_t ) arg : -1 - ( int64_t ) arg );
+
+                cbor->datapoint.timestamp.timestamp = ( xi_time_t ) ( at / 1000000 );
+                cbor->datapoint.timestamp.micro     = ( xi_time_t ) ( at % 1000000 );
+                cbor->time_base                     = at;
+            }
+            break;
+        case CBOR_LEVEL_DATAPOINT * 2 + 1:
+            if( cbor->index[ cbor->depth ] == 1 )
+            {
+                ret = cbor_layer_decode_value( cbor, major, info, arg, &cbor->datapoint );
+            }
+            break;
+    }
+
+    return ret < 0 ? ret : cbor_layer_element_done( cbor );
+}
+
+// reads the items of the data, returns 1 at the end of the body, 0 if it needs more and -1 on error
+static signed char cbor_layer_read( cbor_layer_data_t* cbor, const_data_descriptor_t* data )
+{
+    signed char ret = 0;
+
+    while( ret == 0 && data->curr_pos < data->real_size )
+    {
+        const unsigned char* begin  = ( const unsigned char* ) data->data_ptr + data->curr_pos;
+        const size_t left           = data->real_size - data->curr_pos;
+
+        if( cbor->head_size == 0 )
+        {
+            const unsigned char info = begin[ 0 ] & 0x1F;
+
+            // the indefinite lengths and the reserved ones are not used
+            if( info > 27 )
+            {
+                return cbor_layer_error();
+            }
+
+            cbor->head_need     = 1 + ( info < 24 ? 0 : 1 << ( info - 24 ) );
+            cbor->text_left     = 0;
+            cbor->text_length   = 0;
+        }
+
+        if( cbor->head_size < cbor->head_need )
+        {
+            const size_t size = XI_MIN( left, ( size_t ) ( cbor->head_need - cbor->head_size ) );
+
+            memcpy( cbor->head + cbor->head_size, begin, size );
+
+            cbor->head_size += size;
+            data->curr_pos  += size;
+
+            if( cbor->head_size < cbor->head_need )
+            {
+                break;
+            }
+
+            // the strings are read after their heads
+            if( ( cbor->head[ 0 ] >> 5 ) == 2 || ( cbor->head[ 0 ] >> 5 ) == CBOR_TEXT )
+            {
+                uint64_t length = ( cbor->head[ 0 ] & 0x1F ) < 24 ? ( cbor->head[ 0 ] & 0x1F ) : 0;
+
+                for( unsigned char i = 1; i < cbor->head_size; ++i )
+                {
+                    length = ( length << 8 ) | cbor->head[ i ];
+                }
+
+                if( length > UINT32_MAX )
+                {
+                    return cbor_layer_error();
+                }
+
+                cbor->text_length   = ( uint32_t ) length;
+                cbor->text_left     = ( uint32_t ) length;
+            }
+
+            continue;
+        }
+
+        if( cbor->text_left )
+        {
+            // the part over the buffer is skipped, the length tells it has been cut
+            const size_t size   = XI_MIN( left, ( size_t ) cbor->text_left );
+            const size_t offset = cbor->text_length - cbor->text_left;
+
+            if( offset < XI_VALUE_STRING_MAX_SIZE - 1 )
+            {
+                memcpy( cbor->text + offset, begin, XI_MIN( size, ( size_t ) XI_VALUE_STRING_MAX_SIZE - 1 - offset ) );
+            }
+
+            cbor->text_left -= size;
+            data->curr_pos  += size;
+
+            if( cbor->text_left )
+            {
+                break;
+            }
+        }
+
+        cbor->text[ XI_MIN( cbor->text_length, ( uint32_t ) XI_VALUE_STRING_MAX_SIZE - 1 ) ] = '\0';
+
+        ret             = cbor_layer_on_item( cbor );
+        cbor->head_size = 0;
+    }
+
+    // the item that is complete with the last byte is read at once
+    if( ret == 0 && cbor->head_size && cbor->head_size == cbor->head_need && cbor->text_left == 0 )
+    {
+        cbor->text[ XI_MIN( cbor->text_length, ( uint32_t ) XI_VALUE_STRING_MAX_SIZE - 1 ) ] = '\0';
+
+        ret             = cbor_layer_on_item( cbor );
+        cbor->head_size = 0;
+    }
+
+    return ret;
+}
+
+layer_state_t cbor_layer_parse(
+        cbor_layer_data_t* cbor_layer_data
+      , const_data_descriptor_t* data
+      , const layer_hint_t hint )
+{
+    signed char ret = 0;
+
+    BEGIN_CORO( cbor_layer_data->decode_state )
+
+    // the beginning of the response, everything but the request is cleared
+    {
+        xi_response_t* response                 = cbor_layer_data->response;
+        http_layer_input_t* http_layer_input    = cbor_layer_data->http_layer_input;
+
+        memset( cbor_layer_data, 0, sizeof( cbor_layer_data_t ) );
+
+        cbor_layer_data->response           = response;
+        cbor_layer_data->http_layer_input   = http_layer_input;
+
+        if( cbor_layer_is_feed( cbor_layer_data ) && !http_layer_input->http_union_data.xi_get_feed.sink )
+        {
+            ( ( xi_feed_t* ) http_layer_input->http_union_data.xi_get_feed.feed )->datastream_count = 0;
+        }
+        else if( cbor_layer_target( cbor_layer_data ) )
+        {
+            cbor_layer_target( cbor_layer_data )->datapoint_count = 0;
+        }
+    }
+
+    // the items may span any number of reads
+    while( ( ret = cbor_layer_read( cbor_layer_data, data ) ) == 0 && hint == LAYER_HINT_MORE_DATA )
+    {
+        YIELD( cbor_layer_data->decode_state, LAYER_STATE_WANT_READ );
+        ret = 0;
+    }
+
+    if( ret == 0 )
+    {
+        xi_debug_logger( "the cbor body is not complete" );
+        xi_set_err( XI_CBOR_DECODE_PARSER_ERROR );
+    }
+
+    EXIT( cbor_layer_data->decode_state, ( ret == 1 ? LAYER_STATE_OK : LAYER_STATE_ERROR ) );
+
+    END_CORO()
+
+    return LAYER_STATE_ERROR;
+}
+
+layer_state_t cbor_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    http_layer_input_t* http_layer_input    = ( http_layer_input_t* ) ( data );
+    cbor_layer_data_t* cbor_layer_data      = ( cbor_layer_data_t* ) context->self->user_data;
+
+    // the response to this request is read from the beginning
+    cbor_layer_data->http_layer_input   = http_layer_input;
+    cbor_layer_data->decode_state       = 0;
+
+    switch( http_layer_input->query_type )
+    {
+        case HTTP_LAYER_INPUT_DATASTREAM_DELETE:
+        case HTTP_LAYER_INPUT_DATAPOINT_DELETE:
+        case HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE:
+        case HTTP_LAYER_INPUT_FEED_GET:
+        case HTTP_LAYER_INPUT_FEED_GET_ALL:
+        case HTTP_LAYER_INPUT_DATASTREAM_GET:
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
+            http_layer_input->payload_generator = 0;
+            break;
+        case HTTP_LAYER_INPUT_DATASTREAM_UPDATE:
+            http_layer_input->payload_generator = &cbor_layer_data_generator_datapoint;
+            break;
+        case HTTP_LAYER_INPUT_DATASTREAM_CREATE:
+            http_layer_input->payload_generator = &cbor_layer_data_generator_datastream;
+            break;
+        case HTTP_LAYER_INPUT_FEED_UPDATE:
+            http_layer_input->payload_generator = &cbor_layer_data_generator_feed;
+            break;
+        case HTTP_LAYER_INPUT_DATAPOINTS_POST:
+            http_layer_input->payload_generator = &cbor_layer_data_generator_datapoints;
+            break;
+        case HTTP_LAYER_INPUT_COLUMNS_UPDATE:
+            http_layer_input->payload_generator = &cbor_layer_data_generator_columns;
+            break;
+        case HTTP_LAYER_INPUT_ARENA_FEED_UPDATE:
+            http_layer_input->payload_generator = &cbor_layer_data_generator_arena_feed;
+            break;
+        default:
+            return LAYER_STATE_ERROR;
+    };
+
+    return CALL_ON_PREV_DATA_READY( context->self, ( void* ) http_layer_input, hint );
+}
+
+layer_state_t cbor_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    cbor_layer_data_t* cbor_layer_data = ( cbor_layer_data_t* ) context->self->user_data;
+
+    switch( cbor_layer_data->http_layer_input->query_type )
+    {
+        case HTTP_LAYER_INPUT_DATASTREAM_GET:
+        case HTTP_LAYER_INPUT_FEED_GET:
+        case HTTP_LAYER_INPUT_FEED_GET_ALL:
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
+            return cbor_layer_parse( cbor_layer_data, ( const_data_descriptor_t* ) data, hint );
+        default:
+            break;
+    }
+
+    return LAYER_STATE_OK;
+}
+
+layer_state_t cbor_layer_close(
+    layer_connectivity_t* context )
+{
+    return CALL_ON_PREV_CLOSE( context->self );
+}
+
+layer_state_t cbor_layer_on_close(
+    layer_connectivity_t* context )
+{
+    XI_UNUSED( context );
+
+    return LAYER_STATE_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_CBOR_LAYER_H__
+#define __XI_CBOR_LAYER_H__
+
+#include "xi_layer.h"
+#include "xi_common.h"
+#include "xively.h"
+#include "xi_cbor_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The bodies are CBOR (RFC 7049) of the definite length arrays only:
+ *
+ *   feed       = [ *datastream ]
+ *   datastream = [ id : text, datapoints ]
+ *   datapoints = [ *datapoint ]
+ *   datapoint  = [ at : int / null, value : int / float / text ]
+ *
+ * The at is the microseconds since the at of the datapoint before within the same body,
+ * the first one is since the epoch, the null leaves the timestamp to the server.
+ *
+ * The datastream update and the datapoints post send the datapoints, the datastream create
+ * and the feed update send the feed. The feed read gets the feed, the datastream read and its history get
+ * the datapoints.
+ */
+
+layer_state_t cbor_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t cbor_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t cbor_layer_close(
+    layer_connectivity_t* context );
+
+layer_state_t cbor_layer_on_close(
+    layer_connectivity_t* context );
+
+// reads the body of the response to the cbor_layer_data->http_layer_input request
+layer_state_t cbor_layer_parse(
+        cbor_layer_data_t* cbor_layer_data
+      , const_data_descriptor_t* data
+      , const layer_hint_t hint );
+
+const void* cbor_layer_data_generator_datapoint(
+          const void* input
+        , short* state );
+
+const void* cbor_layer_data_generator_datastream(
+          const void* input
+        , short* state );
+
+const void* cbor_layer_data_generator_feed(
+          const void* input
+        , short* state );
+
+const void* cbor_layer_data_generator_datapoints(
+          const void* input
+        , short* state );
+
+const void* cbor_layer_data_generator_columns(
+          const void* input
+        , short* state );
+
+const void* cbor_layer_data_generator_arena_feed(
+          const void* input
+        , short* state );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_CBOR_LAYER_H__
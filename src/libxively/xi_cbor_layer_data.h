@@ -0,0 +1,47 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_CBOR_LAYER_DATA_H__
+#define __XI_CBOR_LAYER_DATA_H__
+
+#include <stdint.h>
+
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the feed, the datastream, its datapoints and the datapoint
+#define XI_CBOR_MAX_DEPTH   4
+
+typedef struct
+{
+    xi_response_t*          response;           // first, see xi_data_layer_data.h
+    http_layer_input_t*     http_layer_input;
+    unsigned short          decode_state;
+
+    // the item that is being read, it may span the reads
+    unsigned char           head[ 9 ];
+    unsigned char           head_size;
+    unsigned char           head_need;
+    uint32_t                text_length;
+    uint32_t                text_left;          // the bytes of the string still to come
+    char                    text[ XI_VALUE_STRING_MAX_SIZE ];
+
+    // the arrays that are being read
+    unsigned char           depth;
+    uint32_t                remaining[ XI_CBOR_MAX_DEPTH + 1 ];
+    uint32_t                index[ XI_CBOR_MAX_DEPTH + 1 ];
+    int64_t                 time_base;
+
+    unsigned short          datastream_count;
+    char                    datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_datapoint_t          datapoint;
+} cbor_layer_data_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_CBOR_LAYER_DATA_H__
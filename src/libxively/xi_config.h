@@ -51,6 +51,44 @@
 #define XI_VALUE_STRING_MAX_SIZE           32
 #endif
 
+// the samples of a column of the xi_feed_columns_t
+#ifndef XI_MAX_COLUMN_SAMPLES
+#define XI_MAX_COLUMN_SAMPLES              XI_MAX_DATAPOINTS
+#endif
+
+// the distinct string values shared by all of the columns of the xi_feed_columns_t
+#ifndef XI_MAX_COLUMN_STRINGS
+#define XI_MAX_COLUMN_STRINGS              8
+#endif
+
+// the datastream ids the xi_id_table_t interns, a power of two
+#ifndef XI_MAX_INTERNED_IDS
+#define XI_MAX_INTERNED_IDS                64
+#endif
+
+// the hash slots of the xi_feed_index_t, a power of two above XI_MAX_DATASTREAMS
+#ifndef XI_FEED_INDEX_SLOTS
+#define XI_FEED_INDEX_SLOTS                32
+#endif
+
+#if ( XI_MAX_INTERNED_IDS & ( XI_MAX_INTERNED_IDS - 1 ) ) || ( XI_FEED_INDEX_SLOTS & ( XI_FEED_INDEX_SLOTS - 1 ) )
+#error "XI_MAX_INTERNED_IDS and XI_FEED_INDEX_SLOTS have to be the powers of two"
+#endif
+
+#if XI_FEED_INDEX_SLOTS <= XI_MAX_DATASTREAMS
+#error "XI_FEED_INDEX_SLOTS has to be above XI_MAX_DATASTREAMS"
+#endif
+
+// the outbox keeps its queue in a memory-mapped file
+#if !defined( XI_OPT_NO_OUTBOX ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+#define XI_OUTBOX_ENABLED                  1
+#endif
+
+// the alignment of the allocations of the xi_arena_t
+#ifndef XI_ARENA_ALIGNMENT
+#define XI_ARENA_ALIGNMENT                 8
+#endif
+
 #ifndef XI_QUERY_BUFFER_SIZE
 #define XI_QUERY_BUFFER_SIZE               512
 #endif
@@ -67,6 +105,30 @@
 #define XI_CSV_BUFFER_SIZE                 128
 #endif
 
+// the number of decimals the float values are sent with, -1 sends the shortest text that reads back to the same float
+#ifndef XI_CSV_FLOAT_PRECISION
+#define XI_CSV_FLOAT_PRECISION             -1
+#endif
+
+#ifndef XI_JSON_FLOAT_PRECISION
+#define XI_JSON_FLOAT_PRECISION            XI_CSV_FLOAT_PRECISION
+#endif
+
+// the number of feed reads kept by the feed cache
+#ifndef XI_FEED_CACHE_ENTRIES
+#define XI_FEED_CACHE_ENTRIES              4
+#endif
+
+// the number of datapoints requested at once by the history query, the api allows up to 1000
+#ifndef XI_HISTORY_PAGE_SIZE
+#define XI_HISTORY_PAGE_SIZE               1000
+#endif
+
+// the number of datapoints posted at once, the api allows up to 500
+#ifndef XI_DATAPOINTS_POST_SIZE
+#define XI_DATAPOINTS_POST_SIZE            500
+#endif
+
 #ifndef XI_HOST
 #define XI_HOST                            "api.xively.com"
 #endif
@@ -75,4 +137,57 @@
 #define XI_PORT                            80
 #endif
 
+#ifndef XI_WS_PORT
+#define XI_WS_PORT                         8080
+#endif
+
+#ifndef XI_WS_RESOURCE
+#define XI_WS_RESOURCE                     "/"
+#endif
+
+#ifndef XI_WS_BUFFER_SIZE
+#define XI_WS_BUFFER_SIZE                  64
+#endif
+
+#ifndef XI_TCP_PORT
+#define XI_TCP_PORT                        8081
+#endif
+
+#ifndef XI_MQTT_PORT
+#define XI_MQTT_PORT                       1883
+#endif
+
+// the number of QoS 1 publishes that may wait for the acknowledgement
+#ifndef XI_MQTT_MAX_INFLIGHT
+#define XI_MQTT_MAX_INFLIGHT               4
+#endif
+
+// the QoS 1 publishes up to this size are kept until they're acknowledged and sent
+// again after the reconnection, the bigger ones block till their acknowledgement
+#ifndef XI_MQTT_INFLIGHT_PACKET_SIZE
+#define XI_MQTT_INFLIGHT_PACKET_SIZE       128
+#endif
+
+#ifndef XI_MQTT_MAX_SUBSCRIPTIONS
+#define XI_MQTT_MAX_SUBSCRIPTIONS          4
+#endif
+
+#ifndef XI_MQTT_TOPIC_SIZE
+#define XI_MQTT_TOPIC_SIZE                 64
+#endif
+
+#ifndef XI_HTTP2_PORT
+#define XI_HTTP2_PORT                      XI_PORT
+#endif
+
+// the size of the buffer the request header block is built in
+#ifndef XI_HTTP2_HEADER_BUFFER_SIZE
+#define XI_HTTP2_HEADER_BUFFER_SIZE        256
+#endif
+
+// the number of the streams open at the same time, one of them is kept for the blocking calls
+#ifndef XI_HTTP2_MAX_STREAMS
+#define XI_HTTP2_MAX_STREAMS               4
+#endif
+
 #endif // __XI_CONFIG_H__
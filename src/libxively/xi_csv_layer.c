@@ -9,11 +9,15 @@
 #include "xi_coroutine.h"
 #include "xi_generator.h"
 #include "xi_stated_csv_decode_value_state.h"
+#include "xi_csv_scan.h"
+#include "xi_number_format.h"
 #include "xi_stated_sscanf.h"
+#include "xi_stated_sscanf_helpers.h"
 #include "xi_http_layer_constants.h"
 #include "xi_csv_layer_data.h"
 #include "xi_layer_api.h"
 #include "xi_http_layer_input.h"
+#include "xi_feed_delta.h"
 #include "xi_layer_helpers.h"
 
 #ifdef __cplusplus
@@ -33,9 +37,9 @@ inline static int csv_encode_value(
     switch( p->value_type )
     {
         case XI_VALUE_TYPE_I32:
-            return snprintf( buffer, buffer_size, "%"PRIi32, p->value.i32_value );
+            return xi_format_i32( buffer, buffer_size, p->value.i32_value );
         case XI_VALUE_TYPE_F32:
-            return snprintf( buffer, buffer_size, "%f", p->value.f32_value );
+            return xi_format_f32( buffer, buffer_size, p->value.f32_value, XI_CSV_FLOAT_PRECISION );
         case XI_VALUE_TYPE_STR:
             return snprintf( buffer, buffer_size, "%s", p->value.str_value );
         default:
@@ -51,6 +55,9 @@ typedef enum
     XI_STATE_FLOAT,
     XI_STATE_DOT,
     XI_STATE_STRING,
+    XI_STATE_EXP,
+    XI_STATE_EXP_SIGN,
+    XI_STATE_EXP_NUMBER,
     XI_STATES_NO
 } xi_dfa_state_t;
 
@@ -64,6 +71,8 @@ typedef enum
     XI_CHAR_NEWLINE,
     XI_CHAR_TAB,
     XI_CHAR_MINUS,
+    XI_CHAR_EXP,
+    XI_CHAR_PLUS,
     XI_CHARS_NO
 } xi_char_type_t;
 
@@ -79,7 +88,11 @@ inline static xi_char_type_t csv_classify_char( char c )
         case 32:
             return XI_CHAR_SPACE;
         case 33: case 34: case 35: case 36: case 37: case 38: case 39:
-        case 40: case 41: case 42: case 43: case 44:
+        case 40: case 41: case 42:
+            return XI_CHAR_UNKNOWN;
+        case 43:
+            return XI_CHAR_PLUS;
+        case 44:
             return XI_CHAR_UNKNOWN;
         case 45:
             return XI_CHAR_MINUS;
@@ -94,7 +107,9 @@ inline static xi_char_type_t csv_classify_char( char c )
         case 58: case 59: case 60: case 61: case 62: case 63:
         case 64:
             return XI_CHAR_UNKNOWN;
-        case 65: case 66: case 67: case 68: case 69: case 70: case 71:
+        case 69: case 101:
+            return XI_CHAR_EXP;
+        case 65: case 66: case 67: case 68: case 70: case 71:
         case 72: case 73: case 74: case 75: case 76: case 77: case 78:
         case 79: case 80: case 81: case 82: case 83: case 84: case 85:
         case 86: case 87: case 88: case 89:
@@ -103,7 +118,7 @@ inline static xi_char_type_t csv_classify_char( char c )
         case 91: case 92: case 93: case 94: case 95:
         case 96:
             return XI_CHAR_UNKNOWN;
-        case 97: case 98: case 99: case 100: case 101: case 102: case 103:
+        case 97: case 98: case 99: case 100: case 102: case 103:
         case 104: case 105: case 106: case 107: case 108: case 109: case 110:
         case 111: case 112: case 113: case 114: case 115: case 116: case 117:
         case 118: case 119: case 120: case 121:
@@ -119,19 +134,50 @@ inline static xi_char_type_t csv_classify_char( char c )
 }
 
 // the transition function
-static const short states[][6][2] =
+static const short states[][9][2] =
 {
-      // state initial                          // state minus                            // state number                           // state float                            // state dot                              // string
-    { { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  } },
-    { { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT   }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT   }, { XI_CHAR_NUMBER    , XI_STATE_STRING  } },
-    { { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  } },
-    { { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_STRING  }, { XI_CHAR_DOT       , XI_STATE_STRING  }, { XI_CHAR_DOT       , XI_STATE_STRING  } },
-    { { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  } },
-    { { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL } },
-    { { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  } },
-    { { XI_CHAR_MINUS     , XI_STATE_MINUS   }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  } }
+      // state initial                             // state minus                               // state number                              // state float                               // state dot                                 // state string                              // state exp                                 // state exp sign                            // state exp number
+    { { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING     } },
+    { { XI_CHAR_NUMBER    , XI_STATE_NUMBER     }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER     }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER     }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT      }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT      }, { XI_CHAR_NUMBER    , XI_STATE_STRING     }, { XI_CHAR_NUMBER    , XI_STATE_EXP_NUMBER }, { XI_CHAR_NUMBER    , XI_STATE_EXP_NUMBER }, { XI_CHAR_NUMBER    , XI_STATE_EXP_NUMBER } },
+    { { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     }, { XI_CHAR_LETTER    , XI_STATE_STRING     } },
+    { { XI_CHAR_DOT       , XI_STATE_DOT        }, { XI_CHAR_DOT       , XI_STATE_DOT        }, { XI_CHAR_DOT       , XI_STATE_DOT        }, { XI_CHAR_DOT       , XI_STATE_STRING     }, { XI_CHAR_DOT       , XI_STATE_STRING     }, { XI_CHAR_DOT       , XI_STATE_STRING     }, { XI_CHAR_DOT       , XI_STATE_STRING     }, { XI_CHAR_DOT       , XI_STATE_STRING     }, { XI_CHAR_DOT       , XI_STATE_STRING     } },
+    { { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     }, { XI_CHAR_SPACE     , XI_STATE_STRING     } },
+    { { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL    } },
+    { { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     }, { XI_CHAR_TAB       , XI_STATE_STRING     } },
+    { { XI_CHAR_MINUS     , XI_STATE_MINUS      }, { XI_CHAR_MINUS     , XI_STATE_STRING     }, { XI_CHAR_MINUS     , XI_STATE_STRING     }, { XI_CHAR_MINUS     , XI_STATE_STRING     }, { XI_CHAR_MINUS     , XI_STATE_STRING     }, { XI_CHAR_MINUS     , XI_STATE_STRING     }, { XI_CHAR_MINUS     , XI_STATE_EXP_SIGN   }, { XI_CHAR_MINUS     , XI_STATE_STRING     }, { XI_CHAR_MINUS     , XI_STATE_STRING     } },
+    { { XI_CHAR_EXP       , XI_STATE_STRING     }, { XI_CHAR_EXP       , XI_STATE_STRING     }, { XI_CHAR_EXP       , XI_STATE_EXP        }, { XI_CHAR_EXP       , XI_STATE_EXP        }, { XI_CHAR_EXP       , XI_STATE_STRING     }, { XI_CHAR_EXP       , XI_STATE_STRING     }, { XI_CHAR_EXP       , XI_STATE_STRING     }, { XI_CHAR_EXP       , XI_STATE_STRING     }, { XI_CHAR_EXP       , XI_STATE_STRING     } },
+    { { XI_CHAR_PLUS      , XI_STATE_STRING     }, { XI_CHAR_PLUS      , XI_STATE_STRING     }, { XI_CHAR_PLUS      , XI_STATE_STRING     }, { XI_CHAR_PLUS      , XI_STATE_STRING     }, { XI_CHAR_PLUS      , XI_STATE_STRING     }, { XI_CHAR_PLUS      , XI_STATE_STRING     }, { XI_CHAR_PLUS      , XI_STATE_EXP_SIGN   }, { XI_CHAR_PLUS      , XI_STATE_STRING     }, { XI_CHAR_PLUS      , XI_STATE_STRING     } }
 };
 
+// the powers of ten that are exact floats
+static const float csv_float_pow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+// both the mantissa up to 2^24 and the powers of ten are exact floats so the single division
+// or multiplication is rounded correctly, the longer numbers are left to the library
+static inline float csv_decode_float( const xi_stated_csv_decode_value_state_t* st, const char* str )
+{
+    const short pow10_count = ( short ) ( sizeof( csv_float_pow10 ) / sizeof( csv_float_pow10[ 0 ] ) );
+
+    // the digits after the dot less the power of ten written after the 'e'
+    const short scale = st->exponent - ( st->power_negative ? -st->power : st->power );
+
+    if( !st->inexact
+        && st->mantissa <= ( 1ul << 24 )
+        && scale > -pow10_count && scale < pow10_count )
+    {
+        const float value = scale >= 0 ? ( float ) st->mantissa / csv_float_pow10[ scale ]
+                                       : ( float ) st->mantissa * csv_float_pow10[ -scale ];
+
+        return st->negative ? -value : value;
+    }
+
+#ifdef __AVR__
+    return ( float ) strtod( str, 0 );  // the double is a float there
+#else
+    return strtof( str, 0 );
+#endif
+}
+
 signed char xi_stated_csv_decode_value(
           xi_stated_csv_decode_value_state_t* st
         , const_data_descriptor_t* source
@@ -147,8 +193,8 @@ signed char xi_stated_csv_decode_value(
     assert( p != 0 );
 
     // tmp
-    char c = 0;
-    xi_char_type_t ct = XI_CHAR_UNKNOWN;
+    size_t size = 0;
+    size_t i    = 0;
 
     // if not the first run jump into the proper label
     if( st->state != XI_STATE_INITIAL )
@@ -159,8 +205,14 @@ signed char xi_stated_csv_decode_value(
     // secure the output buffer
     XI_GUARD_EOS( p->value.str_value, XI_VALUE_STRING_MAX_SIZE );
 
-    // clean the counter
-    st->counter = 0;
+    // clean the counter and the number
+    st->counter     = 0;
+    st->mantissa    = 0;
+    st->exponent    = 0;
+    st->negative    = 0;
+    st->inexact     = 0;
+    st->power       = 0;
+    st->power_negative = 0;
 
     // check if the buffer needs more data
     if( source->curr_pos == source->real_size )
@@ -168,53 +220,83 @@ signed char xi_stated_csv_decode_value(
         return 0;
     }
 
-    c           = source->data_ptr[ source->curr_pos++ ];
-    st->state   = XI_STATE_INITIAL;
-
-    // main processing loop
-    while( c != '\n' && c !='\0' && c!='\r' )
+    // main processing loop, the value is taken up to the end of the line or of the data at once
+    for( ;; )
     {
-        if( st->counter >= XI_VALUE_STRING_MAX_SIZE - 1 )
+        size = xi_csv_scan_line( source->data_ptr + source->curr_pos, source->real_size - source->curr_pos );
+
+        if( st->counter + size >= XI_VALUE_STRING_MAX_SIZE )
         {
             xi_set_err( XI_DATAPOINT_VALUE_BUFFER_OVERFLOW );
             return 0;
         }
 
-        ct          = csv_classify_char( c );
-        st->state   = states[ ct ][ st->state ][ 1 ];
+        memcpy( p->value.str_value + st->counter, source->data_ptr + source->curr_pos, size );
 
-        switch( st->state )
+        // the type of the value is decided char by char over the copied part and the number is decoded on the way
+        for( i = st->counter; i < st->counter + size; ++i )
         {
-            case XI_STATE_MINUS:
-            case XI_STATE_NUMBER:
-            case XI_STATE_FLOAT:
-            case XI_STATE_DOT:
-            case XI_STATE_STRING:
-                p->value.str_value[ st->counter ] = c;
-                break;
+            const char c = p->value.str_value[ i ];
+
+            st->state = states[ csv_classify_char( c ) ][ st->state ][ 1 ];
+
+            switch( st->state )
+            {
+                case XI_STATE_MINUS:
+                    st->negative = 1;
+                    break;
+                case XI_STATE_FLOAT:
+                    st->exponent += 1;
+                    // fall through
+                case XI_STATE_NUMBER:
+                    if( st->mantissa > ( UINT32_MAX - 9 ) / 10 )
+                    {
+                        st->inexact = 1;
+                        break;
+                    }
+
+                    st->mantissa = st->mantissa * 10 + ( uint32_t ) ( c - '0' );
+                    break;
+                case XI_STATE_EXP_SIGN:
+                    st->power_negative = ( c == '-' );
+                    break;
+                case XI_STATE_EXP_NUMBER:
+                    // way past the range of the float, the library tells the inf or zero
+                    if( st->power < 1000 )
+                    {
+                        st->power = st->power * 10 + ( c - '0' );
+                    }
+                    break;
+            }
+        }
+
+        st->counter         += size;
+        source->curr_pos    += size;
+
+        if( source->curr_pos < source->real_size )
+        {
+            // skip the delimiter
+            source->curr_pos += 1;
+            break;
         }
 
         // this is where we shall need to jump for more data
-        if( source->curr_pos == source->real_size )
+        if( hint != LAYER_HINT_MORE_DATA )
         {
-            if( hint == LAYER_HINT_MORE_DATA )
-            {
-                // need more data
-                return 0;
-            }
+            break;
+        }
 
-            if( hint == LAYER_HINT_NONE )
-            {
-                ++( st->counter );
-                break;
-            }
-data_ready:
-            source->curr_pos = 0; // reset the counter
+        if( st->state == XI_STATE_INITIAL )
+        {
+            // keep the suspended value apart from a new one
+            st->state = XI_STATE_STRING;
         }
 
-        //
-        ++( st->counter );
-        c = source->data_ptr[ ( source->curr_pos )++ ];
+        // need more data
+        return 0;
+
+data_ready:
+        source->curr_pos = 0; // reset the counter
     }
 
     // set the guard
@@ -226,18 +308,30 @@ data_ready:
         case XI_STATE_MINUS:
         case XI_STATE_DOT:
         case XI_STATE_INITIAL:
+        case XI_STATE_EXP:
+        case XI_STATE_EXP_SIGN:
             st->state = XI_STATE_STRING;
             break;
+        case XI_STATE_EXP_NUMBER:
+            st->state = XI_STATE_FLOAT;
+            break;
+    }
+
+    // the integers that do not fit are kept as floats
+    if( st->state == XI_STATE_NUMBER
+        && ( st->inexact || st->mantissa > ( uint32_t ) INT32_MAX + ( uint32_t ) st->negative ) )
+    {
+        st->state = XI_STATE_FLOAT;
     }
 
     switch( st->state )
     {
         case XI_STATE_NUMBER:
-            p->value.i32_value  = atoi( p->value.str_value );
+            p->value.i32_value  = ( int32_t ) ( st->negative ? 0u - st->mantissa : st->mantissa );
             p->value_type       = XI_VALUE_TYPE_I32;
             break;
         case XI_STATE_FLOAT:
-            p->value.f32_value  = ( float ) atof( p->value.str_value );
+            p->value.f32_value  = csv_decode_float( st, p->value.str_value );
             p->value_type       = XI_VALUE_TYPE_F32;
             break;
         case XI_STATE_STRING:
@@ -258,28 +352,13 @@ const void* csv_layer_data_generator_datapoint(
     const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
     const xi_datapoint_t* dp            = ( const xi_datapoint_t* ) ld->xi_get_datastream.value;
 
-    // tmp
-    struct xi_tm* gmtinfo               = 0;
-
     ENABLE_GENERATOR();
     BEGIN_CORO( *state )
 
         // if there is a timestamp encode it
         if( dp->timestamp.timestamp != 0 )
         {
-            gmtinfo = xi_gmtime( &dp->timestamp.timestamp );
-
-            memset( buffer_32, 0, 32 );
-
-            snprintf( buffer_32, 32
-                , XI_CSV_TIMESTAMP_PATTERN
-                , gmtinfo->tm_year + 1900
-                , gmtinfo->tm_mon + 1
-                , gmtinfo->tm_mday
-                , gmtinfo->tm_hour
-                , gmtinfo->tm_min
-                , gmtinfo->tm_sec
-                , ( int ) dp->timestamp.micro );
+            xi_format_iso8601( buffer_32, dp->timestamp.timestamp, dp->timestamp.micro );
 
             gen_ptr_text( *state, buffer_32 );
             gen_ptr_text( *state, XI_CSV_COMMA );
@@ -322,6 +401,41 @@ const void* csv_layer_data_generator_datastream(
 
 }
 
+const void* csv_layer_data_generator_datapoints(
+          const void* input
+        , short* state )
+{
+    // we expect input to be the datapoints of the datastream
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    static size_t i                     = 0;                                            // local global index required to be static cause used via the persistent for
+    static union http_union_data_t tmp_http_data;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        memset( &tmp_http_data, 0, sizeof( union http_union_data_t ) );
+
+        // the timestamp and the value of each one at the line of its own
+        for( i = 0; i < ld->xi_post_datapoints.count; ++i )
+        {
+            tmp_http_data.xi_get_datastream.value = &ld->xi_post_datapoints.values[ i ];
+
+            call_sub_gen( *state, &tmp_http_data, csv_layer_data_generator_datapoint );
+        }
+
+        gen_ptr_text_and_exit( *state, XI_HTTP_EMPTY );
+
+    END_CORO()
+
+    return 0;
+}
+
+// the number of the lines the datastream is sent with
+static inline size_t csv_layer_datapoint_count( const xi_datastream_t* datastream )
+{
+    return datastream->datapoint_count == 0 ? 1 : ( XI_MIN( datastream->datapoint_count, ( size_t ) XI_MAX_DATAPOINTS ) );
+}
+
 const void* csv_layer_data_generator_feed(
           const void* input
         , short* state )
@@ -329,8 +443,8 @@ const void* csv_layer_data_generator_feed(
     // we expect input to be datapoint
     const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
     const xi_feed_t* feed               = ( const xi_feed_t* ) ld->xi_get_feed.feed;
-    static unsigned char i              = 0;                                            // local global index required to be static cause used via the persistent for
-                                                                                        //
+    static unsigned char i              = 0;                                            // local global indexes required to be static cause used via the persistent for
+    static unsigned char j              = 0;                                            //
     static union http_union_data_t tmp_http_data;
 
     ENABLE_GENERATOR();
@@ -344,11 +458,21 @@ const void* csv_layer_data_generator_feed(
         {
             for( ; i < feed->datastream_count; ++i )
             {
-                tmp_http_data.xi_get_datastream.datastream  = feed->datastreams[ i ].datastream_id;
-                tmp_http_data.xi_get_datastream.value       = ( xi_datapoint_t* ) &feed->datastreams[ i ].datapoints[ 0 ];
+                // the delta update leaves out the ones that have not changed
+                if( !xi_feed_delta_is_dirty( ld->xi_update_feed.delta, i ) )
+                {
+                    continue;
+                }
 
-                // SEND THE REST THROUGH SUB GENERATOR
-                call_sub_gen( *state, &tmp_http_data, csv_layer_data_generator_datastream );
+                // each datapoint is the line of its own, the datastream without them sends the first one
+                for( j = 0; j < csv_layer_datapoint_count( &feed->datastreams[ i ] ); ++j )
+                {
+                    tmp_http_data.xi_get_datastream.datastream  = feed->datastreams[ i ].datastream_id;
+                    tmp_http_data.xi_get_datastream.value       = ( xi_datapoint_t* ) &feed->datastreams[ i ].datapoints[ j ];
+
+                    // SEND THE REST THROUGH SUB GENERATOR
+                    call_sub_gen( *state, &tmp_http_data, csv_layer_data_generator_datastream );
+                }
             }
 
             gen_ptr_text_and_exit( *state, XI_HTTP_EMPTY );
@@ -359,6 +483,74 @@ const void* csv_layer_data_generator_feed(
     return 0;
 }
 
+const void* csv_layer_data_generator_columns(
+          const void* input
+        , short* state )
+{
+    // we expect input to be the columns of the feed
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    const xi_feed_columns_t* columns    = ld->xi_update_columns.columns;
+    static size_t i                     = 0;                                            // local global indexes required to be static cause used via the persistent for
+    static size_t j                     = 0;                                            //
+    static xi_datapoint_t tmp_datapoint;
+    static union http_union_data_t tmp_http_data;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        memset( &tmp_http_data, 0, sizeof( union http_union_data_t ) );
+
+        // each sample is the line of its own, rebuilt into the single datapoint
+        for( i = 0; i < columns->column_count; ++i )
+        {
+            for( j = 0; j < columns->columns[ i ].sample_count; ++j )
+            {
+                tmp_http_data.xi_get_datastream.datastream  = columns->columns[ i ].datastream_id;
+                tmp_http_data.xi_get_datastream.value       = xi_feed_columns_datapoint( columns, &columns->columns[ i ], j, &tmp_datapoint );
+
+                call_sub_gen( *state, &tmp_http_data, csv_layer_data_generator_datastream );
+            }
+        }
+
+        gen_ptr_text_and_exit( *state, XI_HTTP_EMPTY );
+
+    END_CORO()
+
+    return 0;
+}
+const void* csv_layer_data_generator_arena_feed(
+          const void* input
+        , short* state )
+{
+    // we expect input to be the runtime-sized feed
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    static const xi_arena_datastream_t* ds  = 0;                                        // local global iterators required to be static cause used via the persistent for
+    static size_t j                         = 0;                                        //
+    static union http_union_data_t tmp_http_data;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        memset( &tmp_http_data, 0, sizeof( union http_union_data_t ) );
+
+        // each datapoint is the line of its own
+        for( ds = ld->xi_update_arena_feed.feed->datastreams; ds != 0; ds = ds->next )
+        {
+            for( j = 0; j < ds->datapoint_count; ++j )
+            {
+                tmp_http_data.xi_get_datastream.datastream  = ds->datastream_id;
+                tmp_http_data.xi_get_datastream.value       = &ds->datapoints[ j ];
+
+                call_sub_gen( *state, &tmp_http_data, csv_layer_data_generator_datastream );
+            }
+        }
+
+        gen_ptr_text_and_exit( *state, XI_HTTP_EMPTY );
+
+    END_CORO()
+
+    return 0;
+}
 
 // parse the timestamp and the value and save it within the proper datastream field
 layer_state_t csv_layer_parse_datastream(
@@ -392,7 +584,15 @@ layer_state_t csv_layer_parse_datastream(
 
     memset( &gmtinfo, 0, sizeof( struct xi_tm ) );
 
-    // parse the timestamp
+    // the whole timestamp with its comma is usually within the data so it is read at once
+    if( csv_layer_data->stated_sscanf_state.state == 0
+        && data->real_size - data->curr_pos > XI_ISO8601_SIZE
+        && data->data_ptr[ data->curr_pos + XI_ISO8601_SIZE ] == ','
+        && xi_parse_iso8601( data->data_ptr + data->curr_pos, &dp->timestamp.timestamp, &dp->timestamp.micro ) )
+    {
+        data->curr_pos += XI_ISO8601_SIZE + 1;
+    }
+    else // parse the timestamp
     {
 
         // read timestamp
@@ -462,15 +662,91 @@ layer_state_t csv_layer_parse_datastream(
     //return LAYER_STATE_OK;
 }
 
+// appends the datapoint to the datastream, the ones that do not fit are dropped
+static void csv_layer_datastream_sink(
+        const char* datastream_id
+      , const xi_datapoint_t* datapoint
+      , void* user_data )
+{
+    XI_UNUSED( datastream_id );
+
+    xi_datastream_t* datastream = ( xi_datastream_t* ) user_data;
+
+    if( datastream->datapoint_count >= XI_MAX_DATAPOINTS )
+    {
+        xi_debug_format( "datapoint of %s dropped, the datastream is full", datastream_id );
+        return;
+    }
+
+    datastream->datapoints[ datastream->datapoint_count++ ] = *datapoint;
+}
+
+// stores the decoded datastream within the caller's feed, the ones that do not fit are dropped,
+// the consecutive lines of the same datastream are its datapoints
+static void csv_layer_feed_sink(
+        const char* datastream_id
+      , const xi_datapoint_t* datapoint
+      , void* user_data )
+{
+    csv_layer_data_t* csv_layer_data    = ( csv_layer_data_t* ) user_data;
+    xi_feed_t* feed                     = ( xi_feed_t* ) csv_layer_data->http_layer_input->http_union_data.xi_get_feed.feed;
+
+    if( feed->datastream_count > 0
+        && strcmp( feed->datastreams[ feed->datastream_count - 1 ].datastream_id, datastream_id ) == 0 )
+    {
+        csv_layer_datastream_sink( datastream_id, datapoint, &feed->datastreams[ feed->datastream_count - 1 ] );
+        return;
+    }
+
+    if( feed->datastream_count >= XI_MAX_DATASTREAMS )
+    {
+        xi_debug_format( "datastream %s dropped, the feed is full", datastream_id );
+        return;
+    }
+
+    xi_datastream_t* datastream = &feed->datastreams[ feed->datastream_count++ ];
+
+    memcpy( datastream->datastream_id, datastream_id, sizeof( datastream->datastream_id ) );
+    datastream->datapoints[ 0 ]     = *datapoint;
+    datastream->datapoint_count     = 1;
+}
+
+// takes the datastream id with its comma at once if both are within the data, otherwise the stated sscanf does it
+static inline char csv_layer_take_datastream_id(
+        char* dst
+      , const_data_descriptor_t* data )
+{
+    const char* begin   = data->data_ptr + data->curr_pos;
+    const size_t size   = xi_csv_scan_field( begin, data->real_size - data->curr_pos );
+
+    if( data->curr_pos + size == data->real_size || begin[ size ] != ',' || size > XI_MAX_DATASTREAM_NAME - 2 )
+    {
+        return 0;
+    }
+
+    for( size_t i = 0; i < size; ++i )
+    {
+        if( !is_channel_id( begin[ i ] ) )
+        {
+            return 0;
+        }
+    }
+
+    memcpy( dst, begin, size );
+    dst[ size ] = '\0';
+
+    data->curr_pos += size + 1;
+
+    return 1;
+}
+
 layer_state_t csv_layer_parse_feed(
         csv_layer_data_t* csv_layer_data
       , const_data_descriptor_t* data
       , const layer_hint_t hint
-      , xi_feed_t* dp )
+      , xi_feed_sink_t* sink
+      , void* sink_data )
 {
-    XI_UNUSED( hint );
-    XI_UNUSED( dp );
-
     // some tmp variables
     signed char sscanf_state               = 0;
     layer_state_t state                    = LAYER_STATE_OK;
@@ -483,16 +759,22 @@ layer_state_t csv_layer_parse_feed(
     BEGIN_CORO( csv_layer_data->feed_decode_state )
 
     // clear the count of datastreams that has been read so far
-    dp->datastream_count = 0;
+    csv_layer_data->datastream_count = 0;
 
-    // loop over datastreams
+    // loop over datastreams, each one is decoded into the same place and handed over to the sink
     do
     {
+        memset( csv_layer_data->datastream_id, 0, sizeof( csv_layer_data->datastream_id ) );
+        memset( &csv_layer_data->datapoint, 0, sizeof( xi_datapoint_t ) );
+
         // we are expecting the patttern with datapoint id
+        if( csv_layer_data->stated_sscanf_state.state != 0
+            || data->curr_pos == data->real_size
+            || !csv_layer_take_datastream_id( csv_layer_data->datastream_id, data ) )
         {
             do
             {
-                pv1[ 0 ] = ( void* ) dp->datastreams[ dp->datastream_count ].datastream_id;
+                pv1[ 0 ] = ( void* ) csv_layer_data->datastream_id;
 
                 sscanf_state = xi_stated_sscanf(
                               &( csv_layer_data->stated_sscanf_state )
@@ -519,7 +801,7 @@ layer_state_t csv_layer_parse_feed(
             //
             do
             {
-                state = csv_layer_parse_datastream( csv_layer_data, data, hint, &( dp->datastreams[ dp->datastream_count ].datapoints[ 0 ] ) );
+                state = csv_layer_parse_datastream( csv_layer_data, data, hint, &( csv_layer_data->datapoint ) );
 
                 if( state == LAYER_STATE_WANT_READ )
                 {
@@ -534,11 +816,10 @@ layer_state_t csv_layer_parse_feed(
 
             } while( state == LAYER_STATE_WANT_READ );
 
-            // update the counter values
-            dp->datastreams[ dp->datastream_count ].datapoint_count     = 1;
-            dp->datastream_count                                       += 1;
+            ( *sink )( csv_layer_data->datastream_id, &( csv_layer_data->datapoint ), sink_data );
+            csv_layer_data->datastream_count += 1;
         }
-    } while( hint == LAYER_HINT_MORE_DATA ); // continuation condition
+    } while( hint == LAYER_HINT_MORE_DATA || data->curr_pos < data->real_size ); // continuation condition
 
     EXIT( csv_layer_data->feed_decode_state, LAYER_STATE_OK );
 
@@ -547,6 +828,52 @@ layer_state_t csv_layer_parse_feed(
     //return LAYER_STATE_OK;
 }
 
+layer_state_t csv_layer_parse_history(
+        csv_layer_data_t* csv_layer_data
+      , const_data_descriptor_t* data
+      , const layer_hint_t hint
+      , xi_feed_sink_t* sink
+      , void* sink_data )
+{
+    layer_state_t state = LAYER_STATE_OK;
+
+    BEGIN_CORO( csv_layer_data->feed_decode_state )
+
+    // each line is a single datapoint of the requested datastream
+    while( hint == LAYER_HINT_MORE_DATA || data->curr_pos < data->real_size )
+    {
+        memset( &csv_layer_data->datapoint, 0, sizeof( xi_datapoint_t ) );
+
+        do
+        {
+            state = csv_layer_parse_datastream( csv_layer_data, data, hint, &( csv_layer_data->datapoint ) );
+
+            if( state == LAYER_STATE_WANT_READ )
+            {
+                YIELD( csv_layer_data->feed_decode_state, LAYER_STATE_WANT_READ );
+                state = LAYER_STATE_WANT_READ;
+                continue;
+            }
+            else if( state == LAYER_STATE_ERROR )
+            {
+                EXIT( csv_layer_data->feed_decode_state, LAYER_STATE_ERROR );
+            }
+
+        } while( state == LAYER_STATE_WANT_READ );
+
+        ( *sink )(
+              csv_layer_data->http_layer_input->http_union_data.xi_get_datastream_history.datastream
+            , &( csv_layer_data->datapoint )
+            , sink_data );
+    }
+
+    EXIT( csv_layer_data->feed_decode_state, LAYER_STATE_OK );
+
+    END_CORO()
+
+    return LAYER_STATE_ERROR;
+}
+
 layer_state_t csv_layer_data_ready(
       layer_connectivity_t* context
     , const void* data
@@ -574,6 +901,7 @@ layer_state_t csv_layer_data_ready(
         case HTTP_LAYER_INPUT_FEED_GET:
         case HTTP_LAYER_INPUT_FEED_GET_ALL:
         case HTTP_LAYER_INPUT_DATASTREAM_GET:
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
             http_layer_input->payload_generator = 0;
             break;
         case HTTP_LAYER_INPUT_DATASTREAM_UPDATE:
@@ -585,6 +913,15 @@ layer_state_t csv_layer_data_ready(
         case HTTP_LAYER_INPUT_FEED_UPDATE:
             http_layer_input->payload_generator = &csv_layer_data_generator_feed;
             break;
+        case HTTP_LAYER_INPUT_DATAPOINTS_POST:
+            http_layer_input->payload_generator = &csv_layer_data_generator_datapoints;
+            break;
+        case HTTP_LAYER_INPUT_COLUMNS_UPDATE:
+            http_layer_input->payload_generator = &csv_layer_data_generator_columns;
+            break;
+        case HTTP_LAYER_INPUT_ARENA_FEED_UPDATE:
+            http_layer_input->payload_generator = &csv_layer_data_generator_arena_feed;
+            break;
         default:
             return LAYER_STATE_ERROR;
     };
@@ -608,17 +945,52 @@ layer_state_t csv_layer_on_data_ready(
     switch( csv_layer_data->http_layer_input->query_type )
     {
         case HTTP_LAYER_INPUT_DATASTREAM_GET:
+            {
+                xi_datastream_t* datapoints = csv_layer_data->http_layer_input->http_union_data.xi_get_datastream.datapoints;
+
+                // every line is one more datapoint, the same way the history is read
+                if( datapoints )
+                {
+                    if( csv_layer_data->feed_decode_state <= 1 )
+                    {
+                        // the decoder is not suspended so this is the beginning of the response
+                        datapoints->datapoint_count = 0;
+                    }
+
+                    return csv_layer_parse_history( csv_layer_data, ( void* ) data, hint, &csv_layer_datastream_sink, ( void* ) datapoints );
+                }
+
                 return csv_layer_parse_datastream(
                               csv_layer_data
                             , ( void* ) data
                             , hint
                             , ( xi_datapoint_t* ) csv_layer_data->http_layer_input->http_union_data.xi_get_datastream.value );
+            }
         case HTTP_LAYER_INPUT_FEED_GET_ALL:
         case HTTP_LAYER_INPUT_FEED_GET:
-            return csv_layer_parse_feed(
+            {
+                const struct xi_get_feed_t* get_feed = &csv_layer_data->http_layer_input->http_union_data.xi_get_feed;
+
+                // without the sink the datastreams are stored within the feed
+                if( get_feed->sink )
+                {
+                    return csv_layer_parse_feed( csv_layer_data, ( void* ) data, hint, get_feed->sink, get_feed->sink_data );
+                }
+
+                if( csv_layer_data->feed_decode_state <= 1 )
+                {
+                    // the decoder is not suspended so this is the beginning of the response
+                    ( ( xi_feed_t* ) get_feed->feed )->datastream_count = 0;
+                }
+
+                return csv_layer_parse_feed( csv_layer_data, ( void* ) data, hint, &csv_layer_feed_sink, ( void* ) csv_layer_data );
+            }
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
+            return csv_layer_parse_history(
                               csv_layer_data
                             , ( void* ) data, hint
-                            , ( xi_feed_t* ) csv_layer_data->http_layer_input->http_union_data.xi_get_feed.feed );
+                            , csv_layer_data->http_layer_input->http_union_data.xi_get_datastream_history.sink
+                            , csv_layer_data->http_layer_input->http_union_data.xi_get_datastream_history.sink_data );
         default:
             break;
     }
@@ -29,6 +29,13 @@ layer_state_t csv_layer_close(
 layer_state_t csv_layer_on_close(
     layer_connectivity_t* context );
 
+// decodes the value up to the end of the line or of the data, returns 0 if it needs more
+signed char xi_stated_csv_decode_value(
+          xi_stated_csv_decode_value_state_t* st
+        , const_data_descriptor_t* source
+        , xi_datapoint_t* p
+        , layer_hint_t hint );
+
 layer_state_t csv_layer_parse_datastream(
         csv_layer_data_t* csv_layer_data
       , const_data_descriptor_t* data
@@ -39,7 +46,15 @@ layer_state_t csv_layer_parse_feed(
         csv_layer_data_t* csv_layer_data
       , const_data_descriptor_t* data
       , const layer_hint_t hint
-      , xi_feed_t* dp );
+      , xi_feed_sink_t* sink
+      , void* sink_data );
+
+layer_state_t csv_layer_parse_history(
+        csv_layer_data_t* csv_layer_data
+      , const_data_descriptor_t* data
+      , const layer_hint_t hint
+      , xi_feed_sink_t* sink
+      , void* sink_data );
 
 const void* csv_layer_data_generator_datastream_get(
           const void* input
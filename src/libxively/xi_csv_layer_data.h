@@ -14,12 +14,15 @@ extern "C" {
 
 typedef struct
 {
+    xi_response_t*                      response;           // first, see xi_data_layer_data.h
     http_layer_input_t*                 http_layer_input;
     unsigned short                      datapoint_decode_state;
     unsigned short                      feed_decode_state;
     xi_stated_csv_decode_value_state_t  csv_decode_value_state;
     xi_stated_sscanf_state_t            stated_sscanf_state;
-    xi_response_t*                      response;
+    unsigned short                      datastream_count;
+    char                                datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_datapoint_t                      datapoint;
 } csv_layer_data_t;
 
 #ifdef __cplusplus
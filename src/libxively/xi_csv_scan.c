@@ -0,0 +1,90 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include "xi_csv_scan.h"
+
+// the vector units are used if the compiler targets them, XI_OPTIMISE=NO_SIMD forces the bytewise scan
+#if !defined( XI_OPT_NO_SIMD ) && defined( __AVX2__ )
+    #include <immintrin.h>
+    #define XI_CSV_SCAN_AVX2
+#elif !defined( XI_OPT_NO_SIMD ) && defined( __SSE2__ )
+    #include <emmintrin.h>
+    #define XI_CSV_SCAN_SSE2
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the delimiters are '\n', '\r', '\0' and the extra one, the line scan passes the '\n' again
+static inline size_t xi_csv_scan( const char* data, size_t size, const char extra )
+{
+    size_t i = 0;
+
+#if defined( XI_CSV_SCAN_AVX2 )
+    const __m256i nl    = _mm256_set1_epi8( '\n' );
+    const __m256i cr    = _mm256_set1_epi8( '\r' );
+    const __m256i nul   = _mm256_setzero_si256();
+    const __m256i ex    = _mm256_set1_epi8( extra );
+
+    for( ; i + 32 <= size; i += 32 )
+    {
+        const __m256i v = _mm256_loadu_si256( ( const __m256i* ) ( data + i ) );
+        const __m256i m = _mm256_or_si256(
+              _mm256_or_si256( _mm256_cmpeq_epi8( v, nl ), _mm256_cmpeq_epi8( v, cr ) )
+            , _mm256_or_si256( _mm256_cmpeq_epi8( v, nul ), _mm256_cmpeq_epi8( v, ex ) ) );
+        const unsigned int mask = ( unsigned int ) _mm256_movemask_epi8( m );
+
+        if( mask )
+        {
+            return i + __builtin_ctz( mask );
+        }
+    }
+#elif defined( XI_CSV_SCAN_SSE2 )
+    const __m128i nl    = _mm_set1_epi8( '\n' );
+    const __m128i cr    = _mm_set1_epi8( '\r' );
+    const __m128i nul   = _mm_setzero_si128();
+    const __m128i ex    = _mm_set1_epi8( extra );
+
+    for( ; i + 16 <= size; i += 16 )
+    {
+        const __m128i v = _mm_loadu_si128( ( const __m128i* ) ( data + i ) );
+        const __m128i m = _mm_or_si128(
+              _mm_or_si128( _mm_cmpeq_epi8( v, nl ), _mm_cmpeq_epi8( v, cr ) )
+            , _mm_or_si128( _mm_cmpeq_epi8( v, nul ), _mm_cmpeq_epi8( v, ex ) ) );
+        const unsigned int mask = ( unsigned int ) _mm_movemask_epi8( m );
+
+        if( mask )
+        {
+            return i + __builtin_ctz( mask );
+        }
+    }
+#endif
+
+    // the tail or the whole data if there are no vector units
+    for( ; i < size; ++i )
+    {
+        const char c = data[ i ];
+
+        if( c == '\n' || c == '\r' || c == '\0' || c == extra )
+        {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+size_t xi_csv_scan_line( const char* data, size_t size )
+{
+    return xi_csv_scan( data, size, '\n' );
+}
+
+size_t xi_csv_scan_field( const char* data, size_t size )
+{
+    return xi_csv_scan( data, size, ',' );
+}
+
+#ifdef __cplusplus
+}
+#endif
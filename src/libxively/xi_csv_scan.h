@@ -0,0 +1,23 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_CSV_SCAN_H__
+#define __XI_CSV_SCAN_H__
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the offset of the first '\n', '\r' or '\0' within the data or the size if there is none
+size_t xi_csv_scan_line( const char* data, size_t size );
+
+// the same as the xi_csv_scan_line but it stops on the ',' as well
+size_t xi_csv_scan_field( const char* data, size_t size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_CSV_SCAN_H__
@@ -0,0 +1,30 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_DATA_LAYER_DATA_H__
+#define __XI_DATA_LAYER_DATA_H__
+
+#include "xively.h"
+#include "xi_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the data of every data layer starts with the response pointer
+// so the requests reach the response whatever the format is
+typedef struct
+{
+    xi_response_t*  response;
+} xi_data_layer_data_t;
+
+static inline xi_response_t* xi_data_layer_response( const layer_t* layer )
+{
+    return ( ( const xi_data_layer_data_t* ) layer->user_data )->response;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_DATA_LAYER_DATA_H__
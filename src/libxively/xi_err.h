@@ -43,6 +43,14 @@ typedef enum
     , XI_SOCKET_READ_ERROR
     , XI_SOCKET_CLOSE_ERROR
     , XI_DATAPOINT_VALUE_BUFFER_OVERFLOW
+    , XI_DATASTREAM_ID_TOO_LONG
+    , XI_JSON_DECODE_PARSER_ERROR
+    , XI_CBOR_DECODE_PARSER_ERROR
+    , XI_COLUMNS_FULL
+    , XI_COLUMN_TYPE_MISMATCH
+    , XI_ID_TABLE_FULL
+    , XI_AGGREGATOR_FULL
+    , XI_OUTBOX_FILE_ERROR
     , XI_ERR_COUNT
 } xi_err_t;
 
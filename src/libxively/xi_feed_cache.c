@@ -0,0 +1,312 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "xi_feed_cache.h"
+#include "xi_allocator.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_data_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef XI_NOB_ENABLED
+
+static uint32_t xi_feed_cache_default_clock_ms( void )
+{
+    return ( uint32_t ) time( 0 ) * 1000;
+}
+
+static inline uint32_t xi_feed_cache_now( const xi_feed_cache_t* cache )
+{
+    return cache->clock_ms ? cache->clock_ms() : xi_feed_cache_default_clock_ms();
+}
+
+xi_context_t* xi_feed_cache_enable(
+      xi_context_t* xi
+    , uint32_t ( *clock_ms )( void ) )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+
+    xi_feed_cache_t* cache = ( xi_feed_cache_t* ) xi->feed_cache;
+
+    if( cache == 0 )
+    {
+        cache = ( xi_feed_cache_t* ) xi_alloc( sizeof( xi_feed_cache_t ) );
+
+        XI_CHECK_MEMORY( cache );
+
+        memset( cache, 0, sizeof( xi_feed_cache_t ) );
+    }
+
+    cache->clock_ms = clock_ms;
+    xi->feed_cache  = cache;
+
+    return xi;
+
+err_handling:
+    return 0;
+}
+
+void xi_feed_cache_disable( xi_context_t* xi )
+{
+    XI_SAFE_FREE( xi->feed_cache );
+}
+
+const xi_feed_cache_stats_t* xi_feed_cache_stats( const xi_context_t* xi )
+{
+    const xi_feed_cache_t* cache = ( const xi_feed_cache_t* ) xi->feed_cache;
+
+    return cache ? &cache->stats : 0;
+}
+
+static xi_feed_cache_entry_t* xi_feed_cache_find(
+      xi_feed_cache_t* cache
+    , xi_feed_id_t feed_id
+    , char all
+    , const xi_feed_cache_key_t* key )
+{
+    for( size_t i = 0; i < XI_FEED_CACHE_ENTRIES; ++i )
+    {
+        xi_feed_cache_entry_t* entry = &cache->entries[ i ];
+
+        if( !entry->used || entry->feed_id != feed_id || entry->all != all )
+        {
+            continue;
+        }
+
+        if( all )
+        {
+            return entry;
+        }
+
+        if( entry->key.count == key->count
+            && memcmp( entry->key.ids, key->ids, key->count * XI_MAX_DATASTREAM_NAME ) == 0 )
+        {
+            return entry;
+        }
+    }
+
+    return 0;
+}
+
+// the free entry or the least recently used one
+static xi_feed_cache_entry_t* xi_feed_cache_victim( xi_feed_cache_t* cache )
+{
+    xi_feed_cache_entry_t* victim = &cache->entries[ 0 ];
+
+    for( size_t i = 0; i < XI_FEED_CACHE_ENTRIES; ++i )
+    {
+        xi_feed_cache_entry_t* entry = &cache->entries[ i ];
+
+        if( !entry->used )
+        {
+            return entry;
+        }
+
+        if( entry->last_used < victim->last_used )
+        {
+            victim = entry;
+        }
+    }
+
+    return victim;
+}
+
+static inline const char* xi_feed_cache_header(
+      const xi_response_t* response
+    , http_header_type_t type )
+{
+    const http_header_t* header = response->http.http_headers_checklist[ type ];
+
+    return header ? header->value : 0;
+}
+
+// the seconds the response stays fresh for, the Age is what it has already spent in caches
+static uint32_t xi_feed_cache_max_age( const xi_response_t* response, char* no_store )
+{
+    const char* cache_control   = xi_feed_cache_header( response, XI_HTTP_HEADER_CACHE_CONTROL );
+    const char* age             = xi_feed_cache_header( response, XI_HTTP_HEADER_AGE );
+    const char* max_age         = cache_control ? strstr( cache_control, "max-age=" ) : 0;
+
+    *no_store = cache_control && strstr( cache_control, "no-store" ) != 0;
+
+    if( max_age == 0 || strstr( cache_control, "no-cache" ) )
+    {
+        return 0;
+    }
+
+    const uint32_t lifetime = ( uint32_t ) strtoul( max_age + 8, 0, 10 );
+    const uint32_t spent    = age ? ( uint32_t ) strtoul( age, 0, 10 ) : 0;
+
+    return lifetime > spent ? lifetime - spent : 0;
+}
+
+// the src is the value of the parsed header so it has the same size
+static void xi_feed_cache_copy_validator( char* dst, const char* src )
+{
+    if( src )
+    {
+        memcpy( dst, src, XI_HTTP_HEADER_VALUE_MAX_SIZE );
+    }
+}
+
+// the feed is filled the same way the response has filled it
+static void xi_feed_cache_copy_out( const xi_feed_cache_entry_t* entry, xi_feed_t* feed )
+{
+    feed->datastream_count = entry->datastream_count;
+
+    memcpy( feed->datastreams, entry->datastreams, entry->datastream_count * sizeof( xi_datastream_t ) );
+}
+
+static void xi_feed_cache_store(
+      xi_feed_cache_entry_t* entry
+    , xi_feed_id_t feed_id
+    , char all
+    , const xi_feed_cache_key_t* key
+    , const xi_feed_t* feed
+    , const xi_response_t* response
+    , uint32_t max_age
+    , uint32_t now )
+{
+    memset( entry, 0, sizeof( xi_feed_cache_entry_t ) );
+
+    entry->used             = 1;
+    entry->feed_id          = feed_id;
+    entry->all              = all;
+    entry->stored_ms        = now;
+    entry->max_age          = max_age;
+    entry->key              = *key;
+    entry->datastream_count = XI_MIN( feed->datastream_count, ( size_t ) XI_MAX_DATASTREAMS );
+
+    memcpy( entry->datastreams, feed->datastreams, entry->datastream_count * sizeof( xi_datastream_t ) );
+
+    xi_feed_cache_copy_validator( entry->etag, xi_feed_cache_header( response, XI_HTTP_HEADER_ETAG ) );
+    xi_feed_cache_copy_validator( entry->last_modified, xi_feed_cache_header( response, XI_HTTP_HEADER_LAST_MODIFIED ) );
+}
+
+const xi_response_t* xi_feed_cache_get(
+      http_layer_input_t* http_layer_input
+    , xi_feed_t* feed
+    , xi_feed_cache_send_t* send )
+{
+    xi_context_t* xi                = http_layer_input->xi_context;
+    xi_feed_cache_t* cache          = ( xi_feed_cache_t* ) xi->feed_cache;
+    xi_response_t* cached           = xi_data_layer_response( xi->layer_chain.top );
+    const char all                  = http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET_ALL;
+    const uint32_t now              = xi_feed_cache_now( cache );
+    struct xi_get_feed_t* get_feed  = &http_layer_input->http_union_data.xi_get_feed;
+    xi_feed_cache_key_t key;
+
+    memset( &key, 0, sizeof( xi_feed_cache_key_t ) );
+
+    if( !all )
+    {
+        key.count = XI_MIN( feed->datastream_count, ( size_t ) XI_MAX_DATASTREAMS );
+
+        for( size_t i = 0; i < key.count; ++i )
+        {
+            strncpy( key.ids[ i ], feed->datastreams[ i ].datastream_id, XI_MAX_DATASTREAM_NAME );
+        }
+    }
+
+    xi_feed_cache_entry_t* entry = xi_feed_cache_find( cache, xi->feed_id, all, &key );
+
+    cache->tick += 1;
+
+    if( entry )
+    {
+        entry->last_used = cache->tick;
+
+        if( ( now - entry->stored_ms ) / 1000 < entry->max_age )
+        {
+            cache->stats.hits += 1;
+            xi_feed_cache_copy_out( entry, feed );
+
+            memset( cached, 0, sizeof( xi_response_t ) );
+
+            cached->http.http_status = 200;
+            strcpy( cached->http.http_status_string, "OK" );
+
+            return cached;
+        }
+
+        get_feed->if_none_match     = entry->etag[ 0 ] ? entry->etag : 0;
+        get_feed->if_modified_since = entry->last_modified[ 0 ] ? entry->last_modified : 0;
+    }
+
+    if( get_feed->if_none_match || get_feed->if_modified_since )
+    {
+        cache->stats.revalidations += 1;
+    }
+    else
+    {
+        cache->stats.misses += 1;
+    }
+
+    const xi_response_t* response = ( *send )( http_layer_input );
+
+    if( response == 0 )
+    {
+        return 0;
+    }
+
+    char no_store           = 0;
+    const uint32_t max_age  = xi_feed_cache_max_age( response, &no_store );
+
+    if( response->http.http_status == 304 && entry )
+    {
+        // still valid, the body has not even been sent
+        entry->stored_ms    = now;
+        entry->max_age      = max_age;
+
+        xi_feed_cache_copy_validator( entry->etag, xi_feed_cache_header( response, XI_HTTP_HEADER_ETAG ) );
+        xi_feed_cache_copy_validator( entry->last_modified, xi_feed_cache_header( response, XI_HTTP_HEADER_LAST_MODIFIED ) );
+        xi_feed_cache_copy_out( entry, feed );
+
+        // the response of the request is the one of the csv layer
+        cached->http.http_status = 200;
+        strcpy( cached->http.http_status_string, "OK" );
+
+        return cached;
+    }
+
+    if( response->http.http_status != 200 )
+    {
+        return response;
+    }
+
+    const char validated = xi_feed_cache_header( response, XI_HTTP_HEADER_ETAG )
+                        || xi_feed_cache_header( response, XI_HTTP_HEADER_LAST_MODIFIED );
+
+    if( no_store || ( max_age == 0 && !validated ) )
+    {
+        // nothing to gain from keeping it
+        if( entry )
+        {
+            entry->used = 0;
+        }
+
+        return response;
+    }
+
+    entry = entry ? entry : xi_feed_cache_victim( cache );
+
+    xi_feed_cache_store( entry, xi->feed_id, all, &key, feed, response, max_age, now );
+    entry->last_used = cache->tick;
+
+    return response;
+}
+
+#endif // XI_NOB_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
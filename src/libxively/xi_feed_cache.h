@@ -0,0 +1,58 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_FEED_CACHE_H__
+#define __XI_FEED_CACHE_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the datastreams asked for, the feed gets overwritten by the response
+typedef struct
+{
+    size_t              count;
+    char                ids[ XI_MAX_DATASTREAMS ][ XI_MAX_DATASTREAM_NAME ];
+} xi_feed_cache_key_t;
+
+typedef struct
+{
+    xi_feed_id_t        feed_id;
+    char                used;
+    char                all;                // read by the xi_feed_get_all
+    uint32_t            last_used;          // the tick of the cache it has been used at
+    uint32_t            stored_ms;          // the time it has been stored or revalidated at
+    uint32_t            max_age;            // the seconds it stays fresh for since the stored_ms
+    xi_feed_cache_key_t key;                // the datastreams the xi_feed_get has asked for
+    size_t              datastream_count;
+    xi_datastream_t     datastreams[ XI_MAX_DATASTREAMS ]; // with all of the datapoints of the response
+    char                etag[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+    char                last_modified[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+} xi_feed_cache_entry_t;
+
+typedef struct
+{
+    uint32_t                ( *clock_ms )( void );
+    uint32_t                tick;
+    xi_feed_cache_stats_t   stats;
+    xi_feed_cache_entry_t   entries[ XI_FEED_CACHE_ENTRIES ];
+} xi_feed_cache_t;
+
+typedef const xi_response_t* ( xi_feed_cache_send_t )( const http_layer_input_t* );
+
+// reads the feed through the context's cache, the send is used if the entry is not fresh
+const xi_response_t* xi_feed_cache_get(
+      http_layer_input_t* http_layer_input
+    , xi_feed_t* feed
+    , xi_feed_cache_send_t* send );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_FEED_CACHE_H__
@@ -0,0 +1,165 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xively.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_helpers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static xi_column_t* xi_feed_columns_find( xi_feed_columns_t* columns, const char* datastream_id )
+{
+    for( size_t i = 0; i < columns->column_count; ++i )
+    {
+        if( strcmp( columns->columns[ i ].datastream_id, datastream_id ) == 0 )
+        {
+            return &columns->columns[ i ];
+        }
+    }
+
+    return 0;
+}
+
+// the index of the string within the table, the same strings are stored once
+static int xi_feed_columns_intern( xi_feed_columns_t* columns, const char* str )
+{
+    for( size_t i = 0; i < columns->string_count; ++i )
+    {
+        if( strcmp( columns->strings[ i ], str ) == 0 )
+        {
+            return ( int ) i;
+        }
+    }
+
+    if( columns->string_count == XI_MAX_COLUMN_STRINGS )
+    {
+        return -1;
+    }
+
+    // the datapoint's string always fits the entry
+    xi_str_copy_untiln( columns->strings[ columns->string_count ], XI_VALUE_STRING_MAX_SIZE, str, '\0' );
+
+    return ( int ) columns->string_count++;
+}
+
+int xi_feed_columns_append(
+          xi_feed_columns_t* columns
+        , const char* datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( columns != 0 );
+    assert( datastream_id != 0 );
+    assert( datapoint != 0 );
+
+    xi_column_t* column = xi_feed_columns_find( columns, datastream_id );
+    xi_column_value_t value;
+    int str_index       = 0;
+
+    XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME, XI_DATASTREAM_ID_TOO_LONG );
+    XI_CHECK_CND( column == 0 && columns->column_count == XI_MAX_DATASTREAMS, XI_COLUMNS_FULL );
+    XI_CHECK_CND( column != 0 && column->sample_count == XI_MAX_COLUMN_SAMPLES, XI_COLUMNS_FULL );
+
+    // the strings and the numbers do not mix
+    XI_CHECK_CND( column != 0 && column->sample_count
+                  && ( column->value_type == XI_VALUE_TYPE_STR ) != ( datapoint->value_type == XI_VALUE_TYPE_STR )
+                , XI_COLUMN_TYPE_MISMATCH );
+
+    if( datapoint->value_type == XI_VALUE_TYPE_STR )
+    {
+        str_index = xi_feed_columns_intern( columns, datapoint->value.str_value );
+
+        XI_CHECK_CND( str_index < 0, XI_COLUMNS_FULL );
+    }
+
+    if( column == 0 )
+    {
+        column = &columns->columns[ columns->column_count++ ];
+
+        memset( column->datastream_id, 0, sizeof( column->datastream_id ) );
+        strcpy( column->datastream_id, datastream_id );
+        column->sample_count = 0;
+    }
+
+    if( column->sample_count == 0 )
+    {
+        column->value_type = datapoint->value_type;
+    }
+    else if( column->value_type == XI_VALUE_TYPE_I32 && datapoint->value_type == XI_VALUE_TYPE_F32 )
+    {
+        // the float turns all of the column into floats
+        for( size_t i = 0; i < column->sample_count; ++i )
+        {
+            column->values[ i ].f32_value = ( float ) column->values[ i ].i32_value;
+        }
+
+        column->value_type = XI_VALUE_TYPE_F32;
+    }
+
+    switch( column->value_type )
+    {
+        case XI_VALUE_TYPE_F32:
+            value.f32_value = datapoint->value_type == XI_VALUE_TYPE_I32
+                ? ( float ) datapoint->value.i32_value
+                : datapoint->value.f32_value;
+            break;
+        case XI_VALUE_TYPE_STR:
+            value.str_index = ( uint32_t ) str_index;
+            break;
+        default:
+            value.i32_value = datapoint->value.i32_value;
+    }
+
+    column->at[ column->sample_count ]      = datapoint->timestamp.timestamp == 0
+        ? 0 : ( int64_t ) datapoint->timestamp.timestamp * 1000000 + datapoint->timestamp.micro;
+    column->values[ column->sample_count ]  = value;
+    column->sample_count                   += 1;
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+xi_datapoint_t* xi_feed_columns_datapoint(
+          const xi_feed_columns_t* columns
+        , const xi_column_t* column
+        , size_t sample
+        , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( columns != 0 );
+    assert( column != 0 );
+    assert( sample < column->sample_count );
+    assert( datapoint != 0 );
+
+    const int64_t at = column->at[ sample ];
+
+    datapoint->timestamp.timestamp  = ( xi_time_t ) ( at / 1000000 );
+    datapoint->timestamp.micro      = ( xi_time_t ) ( at % 1000000 );
+    datapoint->value_type           = column->value_type;
+
+    switch( column->value_type )
+    {
+        case XI_VALUE_TYPE_F32:
+            datapoint->value.f32_value = column->values[ sample ].f32_value;
+            break;
+        case XI_VALUE_TYPE_STR:
+            memcpy( datapoint->value.str_value, columns->strings[ column->values[ sample ].str_index ], XI_VALUE_STRING_MAX_SIZE );
+            break;
+        default:
+            datapoint->value.i32_value = column->values[ sample ].i32_value;
+    }
+
+    return datapoint;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xi_feed_delta.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the datastream without the datapoints is sent with the first one
+static inline const xi_datapoint_t* xi_feed_delta_last_datapoint( const xi_datastream_t* datastream )
+{
+    return &datastream->datapoints[ datastream->datapoint_count == 0 ? 0 : ( XI_MIN( datastream->datapoint_count, ( size_t ) XI_MAX_DATAPOINTS ) ) - 1 ];
+}
+
+static char xi_feed_delta_same_datapoint( const xi_datapoint_t* a, const xi_datapoint_t* b )
+{
+    if( a->value_type != b->value_type
+        || a->timestamp.timestamp != b->timestamp.timestamp
+        || a->timestamp.micro != b->timestamp.micro )
+    {
+        return 0;
+    }
+
+    switch( a->value_type )
+    {
+        case XI_VALUE_TYPE_I32:
+            return a->value.i32_value == b->value.i32_value;
+        case XI_VALUE_TYPE_F32:
+            // the bits, so that the same nan is the same value
+            return memcmp( &a->value.f32_value, &b->value.f32_value, sizeof( float ) ) == 0;
+        case XI_VALUE_TYPE_STR:
+            return strcmp( a->value.str_value, b->value.str_value ) == 0;
+        default:
+            return 1;
+    }
+}
+
+void xi_feed_delta_init( xi_feed_delta_t* delta )
+{
+    // PRECONDITIONS
+    assert( delta != 0 );
+
+    delta->sent_count = 0;
+    memset( delta->dirty, 0, sizeof( delta->dirty ) );
+}
+
+void xi_feed_delta_mark( xi_feed_delta_t* delta, size_t datastream_index )
+{
+    // PRECONDITIONS
+    assert( delta != 0 );
+    assert( datastream_index < XI_MAX_DATASTREAMS );
+
+    delta->dirty[ datastream_index >> 3 ] |= ( unsigned char ) ( 1 << ( datastream_index & 7 ) );
+}
+
+size_t xi_feed_delta_collect( xi_feed_delta_t* delta, const xi_feed_t* feed )
+{
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* ds = &feed->datastreams[ i ];
+
+        if( i >= delta->sent_count
+            || strcmp( delta->sent_ids[ i ], ds->datastream_id ) != 0
+            || delta->sent_datapoint_counts[ i ] != ds->datapoint_count
+            || !xi_feed_delta_same_datapoint( &delta->sent_datapoints[ i ], xi_feed_delta_last_datapoint( ds ) ) )
+        {
+            xi_feed_delta_mark( delta, i );
+        }
+    }
+
+    return xi_feed_delta_dirty_count( delta, feed );
+}
+
+void xi_feed_delta_commit( xi_feed_delta_t* delta, const xi_feed_t* feed )
+{
+    // the clean ones are the same as their snapshots already
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        if( xi_feed_delta_is_dirty( delta, i ) )
+        {
+            memcpy( delta->sent_ids[ i ], feed->datastreams[ i ].datastream_id, XI_MAX_DATASTREAM_NAME );
+
+            delta->sent_datapoint_counts[ i ]   = feed->datastreams[ i ].datapoint_count;
+            delta->sent_datapoints[ i ]         = *xi_feed_delta_last_datapoint( &feed->datastreams[ i ] );
+        }
+    }
+
+    delta->sent_count = feed->datastream_count;
+    memset( delta->dirty, 0, sizeof( delta->dirty ) );
+}
+
+#ifdef __cplusplus
+}
+#endif
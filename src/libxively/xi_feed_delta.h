@@ -0,0 +1,42 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_FEED_DELTA_H__
+#define __XI_FEED_DELTA_H__
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// all of the datastreams are sent without the delta
+static inline char xi_feed_delta_is_dirty( const xi_feed_delta_t* delta, size_t datastream_index )
+{
+    return delta == 0 || ( ( delta->dirty[ datastream_index >> 3 ] >> ( datastream_index & 7 ) ) & 1 );
+}
+
+// the number of the datastreams of the feed that are sent
+static inline size_t xi_feed_delta_dirty_count( const xi_feed_delta_t* delta, const xi_feed_t* feed )
+{
+    size_t ret = 0;
+
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        ret += xi_feed_delta_is_dirty( delta, i );
+    }
+
+    return ret;
+}
+
+// marks the datastreams that differ from the snapshot, returns the number of the dirty ones
+size_t xi_feed_delta_collect( xi_feed_delta_t* delta, const xi_feed_t* feed );
+
+// the dirty datastreams have been sent, they become the snapshot
+void xi_feed_delta_commit( xi_feed_delta_t* delta, const xi_feed_t* feed );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_FEED_DELTA_H__
@@ -4,3 +4,18 @@
 #include "xi_generator.h"
 
 const_data_descriptor_t __xi_tmp_desc = { 0, 0, 0, 0 };
+
+size_t xi_generator_length( xi_generator_t* gen, const void* input )
+{
+    short state = 0;
+    size_t ret  = 0;
+
+    while( state != 1 )
+    {
+        const const_data_descriptor_t* data = ( const const_data_descriptor_t* ) ( *gen )( input, &state );
+
+        ret += data ? data->real_size : 0;
+    }
+
+    return ret;
+}
@@ -17,6 +17,9 @@ typedef const void* ( xi_generator_t )( const void* input, short* curr_state );
 
 extern const_data_descriptor_t __xi_tmp_desc;
 
+// runs the generator till the end and returns the number of bytes it has generated
+extern size_t xi_generator_length( xi_generator_t* gen, const void* input );
+
 #define ENABLE_GENERATOR() \
     unsigned char __xi_len = 0; \
     static short __xi_gen_sub_state = 0; \
@@ -43,6 +46,23 @@ extern const_data_descriptor_t __xi_tmp_desc;
     EXIT( state, ( void* ) &__xi_tmp_desc ); \
 }
 
+// the binary data that may contain zeros
+#define gen_ptr_data( state, ptr_data, size ) \
+{ \
+    __xi_tmp_desc.data_ptr  = ( const char* ) ( ptr_data ); \
+    __xi_tmp_desc.data_size = ( size ); \
+    __xi_tmp_desc.real_size = ( size ); \
+    YIELD( state, ( void* ) &__xi_tmp_desc ); \
+}
+
+#define gen_ptr_data_and_exit( state, ptr_data, size ) \
+{ \
+    __xi_tmp_desc.data_ptr  = ( const char* ) ( ptr_data ); \
+    __xi_tmp_desc.data_size = ( size ); \
+    __xi_tmp_desc.real_size = ( size ); \
+    EXIT( state, ( void* ) &__xi_tmp_desc ); \
+}
+
 #define gen_static_text( state, text ) \
 { \
     static const char* const tmp_str = text; \
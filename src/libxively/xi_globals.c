@@ -3,4 +3,4 @@
 
 #include "xi_globals.h"
 
-xi_globals_t xi_globals = { 1500 };
+xi_globals_t xi_globals = { 1500, { 1, 100, 10000, 0, 0, 0 }, 0 };
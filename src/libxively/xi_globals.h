@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 
+#include "xively.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -13,7 +15,9 @@ extern "C" {
 // This struct is used for run-time config
 typedef struct
 {
-    uint32_t network_timeout;
+    uint32_t            network_timeout;
+    xi_retry_policy_t   retry_policy;
+    uint8_t             failure_streak;
 } xi_globals_t;
 
 extern xi_globals_t xi_globals;
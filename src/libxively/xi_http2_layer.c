@@ -0,0 +1,964 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "xi_layer_api.h"
+#include "xi_common.h"
+#include "xi_http2_layer.h"
+#include "xi_http2_layer_data.h"
+#include "xi_http_layer_constants.h"
+#include "xi_generator.h"
+#include "xi_resource.h"
+#include "xi_coroutine.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XI_HTTP2_PREFACE            "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define XI_HTTP2_MAX_FRAME_SIZE     16384
+
+// frame types
+#define XI_HTTP2_DATA               0x0
+#define XI_HTTP2_HEADERS            0x1
+#define XI_HTTP2_RST_STREAM         0x3
+#define XI_HTTP2_SETTINGS           0x4
+#define XI_HTTP2_PING               0x6
+#define XI_HTTP2_GOAWAY             0x7
+#define XI_HTTP2_WINDOW_UPDATE      0x8
+#define XI_HTTP2_CONTINUATION       0x9
+
+// frame flags
+#define XI_HTTP2_FLAG_END_STREAM    0x1
+#define XI_HTTP2_FLAG_ACK           0x1
+#define XI_HTTP2_FLAG_END_HEADERS   0x4
+#define XI_HTTP2_FLAG_PADDED        0x8
+#define XI_HTTP2_FLAG_PRIORITY      0x20
+
+enum
+{
+      XI_HTTP2_FRAME_HEADER = 0
+    , XI_HTTP2_FRAME_PAYLOAD
+};
+
+enum
+{
+      XI_HPACK_START = 0
+    , XI_HPACK_INTEGER
+    , XI_HPACK_STRING_LENGTH
+    , XI_HPACK_STRING
+};
+
+enum
+{
+      XI_HPACK_INDEX = 0
+    , XI_HPACK_NAME_INDEX
+    , XI_HPACK_TABLE_SIZE
+    , XI_HPACK_NAME_LENGTH
+    , XI_HPACK_VALUE_LENGTH
+};
+
+// :status values of the static table, starting at the index 8
+static const unsigned short XI_HPACK_STATIC_STATUS[] = { 200, 204, 206, 304, 400, 404, 500 };
+
+//-----------------------------------------------------------------------
+// HPACK
+//-----------------------------------------------------------------------
+
+// encodes the integer with the given prefix and the first byte's flags
+static size_t xi_hpack_put_int( unsigned char* dst, unsigned char flags, unsigned char prefix_bits, uint32_t value )
+{
+    const uint32_t max_prefix   = ( 1u << prefix_bits ) - 1;
+    size_t size                 = 0;
+
+    if( value < max_prefix )
+    {
+        dst[ size++ ] = flags | ( unsigned char ) value;
+        return size;
+    }
+
+    dst[ size++ ]   = flags | ( unsigned char ) max_prefix;
+    value          -= max_prefix;
+
+    while( value >= 0x80 )
+    {
+        dst[ size++ ]   = ( unsigned char ) ( ( value & 0x7F ) | 0x80 );
+        value         >>= 7;
+    }
+
+    dst[ size++ ] = ( unsigned char ) value;
+
+    return size;
+}
+
+// strings are never huffman encoded by this encoder
+static size_t xi_hpack_put_string( unsigned char* dst, const char* src, size_t length )
+{
+    size_t size = xi_hpack_put_int( dst, 0, 7, ( uint32_t ) length );
+
+    memcpy( dst + size, src, length );
+
+    return size + length;
+}
+
+// huffman decoding of the status digits, RFC 7541 Appendix B
+static void xi_hpack_huffman_digits( http2_stream_t* stream, unsigned char c )
+{
+    for( int i = 7; i >= 0; --i )
+    {
+        stream->hpack_bits = ( stream->hpack_bits << 1 ) | ( ( c >> i ) & 1 );
+        stream->hpack_bit_count += 1;
+
+        const uint32_t code = stream->hpack_bits;
+
+        if( stream->hpack_bit_count == 5 && code <= 0x2 )
+        {
+            stream->hpack_status = stream->hpack_status * 10 + code;
+        }
+        else if( stream->hpack_bit_count == 6 && code >= 0x19 && code <= 0x1F )
+        {
+            stream->hpack_status = stream->hpack_status * 10 + ( code - 0x19 + 3 );
+        }
+        else if( stream->hpack_bit_count < 6 )
+        {
+            continue;
+        }
+        // anything else is either the padding or not a digit
+
+        stream->hpack_bits        = 0;
+        stream->hpack_bit_count   = 0;
+    }
+}
+
+static void xi_hpack_begin_int( http2_stream_t* stream, unsigned char c, unsigned char prefix_bits, unsigned char kind );
+
+static void xi_hpack_end_int( http2_stream_t* stream, uint32_t value )
+{
+    stream->hpack_state = XI_HPACK_START;
+
+    switch( stream->hpack_kind )
+    {
+        case XI_HPACK_INDEX:
+            if( value >= 8 && value <= 14 )
+            {
+                stream->decoder.response->http.http_status = XI_HPACK_STATIC_STATUS[ value - 8 ];
+            }
+            break;
+        case XI_HPACK_NAME_INDEX:
+            stream->hpack_is_status   = value >= 8 && value <= 14;
+            stream->hpack_kind        = value ? XI_HPACK_VALUE_LENGTH : XI_HPACK_NAME_LENGTH;
+            stream->hpack_state       = XI_HPACK_STRING_LENGTH;
+            break;
+        case XI_HPACK_NAME_LENGTH:
+        case XI_HPACK_VALUE_LENGTH:
+            stream->hpack_remaining   = value;
+            stream->hpack_state       = XI_HPACK_STRING;
+            stream->hpack_bits        = 0;
+            stream->hpack_bit_count   = 0;
+            stream->hpack_status      = 0;
+
+            if( value == 0 )
+            {
+                // the empty string
+                stream->hpack_state   = XI_HPACK_START;
+
+                if( stream->hpack_kind == XI_HPACK_NAME_LENGTH )
+                {
+                    stream->hpack_kind    = XI_HPACK_VALUE_LENGTH;
+                    stream->hpack_state   = XI_HPACK_STRING_LENGTH;
+                }
+            }
+            break;
+        default: // XI_HPACK_TABLE_SIZE
+            break;
+    }
+}
+
+static void xi_hpack_begin_int( http2_stream_t* stream, unsigned char c, unsigned char prefix_bits, unsigned char kind )
+{
+    const unsigned char max_prefix = ( unsigned char ) ( ( 1u << prefix_bits ) - 1 );
+
+    stream->hpack_kind    = kind;
+    stream->hpack_int     = c & max_prefix;
+    stream->hpack_shift   = 0;
+
+    if( ( c & max_prefix ) == max_prefix )
+    {
+        stream->hpack_state = XI_HPACK_INTEGER;
+        return;
+    }
+
+    xi_hpack_end_int( stream, c & max_prefix );
+}
+
+// decodes the header block byte by byte, only the :status is kept
+static void xi_hpack_decode( http2_stream_t* stream, unsigned char c )
+{
+    switch( stream->hpack_state )
+    {
+        case XI_HPACK_START:
+            if( c & 0x80 )
+            {
+                xi_hpack_begin_int( stream, c, 7, XI_HPACK_INDEX );
+            }
+            else if( ( c & 0xC0 ) == 0x40 )
+            {
+                xi_hpack_begin_int( stream, c, 6, XI_HPACK_NAME_INDEX );
+            }
+            else if( ( c & 0xE0 ) == 0x20 )
+            {
+                xi_hpack_begin_int( stream, c, 5, XI_HPACK_TABLE_SIZE );
+            }
+            else
+            {
+                xi_hpack_begin_int( stream, c, 4, XI_HPACK_NAME_INDEX );
+            }
+            break;
+        case XI_HPACK_INTEGER:
+            stream->hpack_int    += ( uint32_t ) ( c & 0x7F ) << stream->hpack_shift;
+            stream->hpack_shift  += 7;
+
+            if( !( c & 0x80 ) )
+            {
+                xi_hpack_end_int( stream, stream->hpack_int );
+            }
+            break;
+        case XI_HPACK_STRING_LENGTH:
+            stream->hpack_huffman = c & 0x80;
+            xi_hpack_begin_int( stream, c, 7, stream->hpack_kind );
+            break;
+        default: // XI_HPACK_STRING
+            if( stream->hpack_kind == XI_HPACK_VALUE_LENGTH && stream->hpack_is_status )
+            {
+                if( stream->hpack_huffman )
+                {
+                    xi_hpack_huffman_digits( stream, c );
+                }
+                else if( c >= '0' && c <= '9' )
+                {
+                    stream->hpack_status = stream->hpack_status * 10 + ( c - '0' );
+                }
+            }
+
+            if( --stream->hpack_remaining > 0 )
+            {
+                break;
+            }
+
+            if( stream->hpack_kind == XI_HPACK_NAME_LENGTH )
+            {
+                stream->hpack_kind    = XI_HPACK_VALUE_LENGTH;
+                stream->hpack_state   = XI_HPACK_STRING_LENGTH;
+                break;
+            }
+
+            if( stream->hpack_is_status )
+            {
+                stream->decoder.response->http.http_status = stream->hpack_status;
+            }
+
+            stream->hpack_state = XI_HPACK_START;
+            break;
+    }
+}
+
+//-----------------------------------------------------------------------
+// FRAMES
+//-----------------------------------------------------------------------
+
+static inline layer_state_t http2_layer_send(
+      layer_connectivity_t* context
+    , const void* data
+    , size_t size )
+{
+    const const_data_descriptor_t desc = { ( const char* ) data, size, size, 0 };
+
+    return CALL_ON_PREV_DATA_READY( context->self, ( const void* ) &desc, LAYER_HINT_NONE );
+}
+
+static layer_state_t http2_layer_send_frame_header(
+      layer_connectivity_t* context
+    , uint32_t length
+    , unsigned char type
+    , unsigned char flags
+    , uint32_t stream_id )
+{
+    const unsigned char header[ 9 ] =
+    {
+          ( unsigned char ) ( length >> 16 ), ( unsigned char ) ( length >> 8 ), ( unsigned char ) length
+        , type, flags
+        , ( unsigned char ) ( stream_id >> 24 ), ( unsigned char ) ( stream_id >> 16 )
+        , ( unsigned char ) ( stream_id >> 8 ), ( unsigned char ) stream_id
+    };
+
+    return http2_layer_send( context, header, sizeof( header ) );
+}
+
+static layer_state_t http2_layer_send_window_update(
+      layer_connectivity_t* context
+    , uint32_t increment
+    , uint32_t stream_id )
+{
+    const unsigned char payload[ 4 ] =
+    {
+          ( unsigned char ) ( increment >> 24 ), ( unsigned char ) ( increment >> 16 )
+        , ( unsigned char ) ( increment >> 8 ), ( unsigned char ) increment
+    };
+
+    layer_state_t state = http2_layer_send_frame_header( context, sizeof( payload ), XI_HTTP2_WINDOW_UPDATE, 0, stream_id );
+
+    return state == LAYER_STATE_OK ? http2_layer_send( context, payload, sizeof( payload ) ) : state;
+}
+
+// builds the request header block, returns 0 if it does not fit the buffer
+static size_t http2_layer_header_block(
+      http2_layer_data_t* http2_layer_data
+    , const http_layer_input_t* http_layer_input
+    , size_t payload_size )
+{
+    unsigned char* const dst    = http2_layer_data->buffer;
+    const size_t capacity       = sizeof( http2_layer_data->buffer );
+    const char* method          = xi_resource_method( http_layer_input->query_type );
+    const size_t api_key_size   = strlen( http2_layer_data->api_key );
+    size_t size                 = 0;
+
+    // the fixed part has to fit the buffer no matter the path
+    if( api_key_size + sizeof( XI_HOST ) + sizeof( XI_USER_AGENT ) + 64 > capacity )
+    {
+        return 0;
+    }
+
+    // :method, GET and POST come from the static table
+    if( method == XI_HTTP_GET )
+    {
+        dst[ size++ ] = 0x82;
+    }
+    else if( method == XI_HTTP_POST )
+    {
+        dst[ size++ ] = 0x83;
+    }
+    else
+    {
+        dst[ size++ ] = 0x02;
+        size += xi_hpack_put_string( dst + size, method, strlen( method ) - 1 );
+    }
+
+    // :scheme http
+    dst[ size++ ] = 0x86;
+
+    // :path without indexing, the length is not known up front so it's
+    // written after the path
+    const size_t path_at    = size + 3;
+    size_t path_size        = 0;
+    short gstate            = 0;
+
+    while( gstate != 1 )
+    {
+        const const_data_descriptor_t* data
+            = ( const const_data_descriptor_t* ) xi_resource_path_generator( http_layer_input, &gstate );
+
+        if( !data ) { continue; }
+
+        if( path_at + path_size + data->real_size + 16 > capacity )
+        {
+            return 0;
+        }
+
+        memcpy( dst + path_at + path_size, data->data_ptr, data->real_size );
+        path_size += data->real_size;
+    }
+
+    dst[ size++ ] = 0x04;
+    const size_t length_size = xi_hpack_put_int( dst + size, 0, 7, ( uint32_t ) path_size );
+    memmove( dst + size + length_size, dst + path_at, path_size );
+    size += length_size + path_size;
+
+    if( !http2_layer_data->headers_indexed )
+    {
+        // :authority, user-agent and x-apikey with the incremental indexing
+        dst[ size++ ] = 0x41;
+        size += xi_hpack_put_string( dst + size, XI_HOST, sizeof( XI_HOST ) - 1 );
+        dst[ size++ ] = 0x40 | 58;
+        size += xi_hpack_put_string( dst + size, XI_USER_AGENT, sizeof( XI_USER_AGENT ) - 1 );
+        dst[ size++ ] = 0x40;
+        size += xi_hpack_put_string( dst + size, "x-apikey", 8 );
+        size += xi_hpack_put_string( dst + size, http2_layer_data->api_key, api_key_size );
+
+        http2_layer_data->headers_indexed = 1;
+    }
+    else
+    {
+        // the latest entry gets the lowest index
+        dst[ size++ ] = 0x80 | 64;
+        dst[ size++ ] = 0x80 | 63;
+        dst[ size++ ] = 0x80 | 62;
+    }
+
+    if( payload_size )
+    {
+        char length[ 12 ];
+        const int length_size = snprintf( length, sizeof( length ), "%lu", ( unsigned long ) payload_size );
+
+        // content-length without indexing
+        size += xi_hpack_put_int( dst + size, 0, 4, 28 );
+        size += xi_hpack_put_string( dst + size, length, length_size );
+    }
+
+    return size;
+}
+
+//-----------------------------------------------------------------------
+// STREAMS
+//-----------------------------------------------------------------------
+
+http2_stream_t* http2_layer_stream( http2_layer_data_t* http2_layer_data, uint32_t stream_id )
+{
+    for( size_t i = 0; stream_id && i < XI_HTTP2_MAX_STREAMS; ++i )
+    {
+        if( http2_layer_data->streams[ i ].id == stream_id )
+        {
+            return &http2_layer_data->streams[ i ];
+        }
+    }
+
+    return 0;
+}
+
+unsigned char http2_layer_submitted( const http2_layer_data_t* http2_layer_data )
+{
+    unsigned char submitted = 0;
+
+    for( size_t i = 0; i < XI_HTTP2_MAX_STREAMS; ++i )
+    {
+        if( http2_layer_data->streams[ i ].id && http2_layer_data->streams[ i ].submitted )
+        {
+            ++submitted;
+        }
+    }
+
+    return submitted;
+}
+
+// takes the free slot for the new stream, one of them is kept for the blocking calls
+static http2_stream_t* http2_layer_open_stream(
+      http2_layer_data_t* http2_layer_data
+    , const http_layer_input_t* http_layer_input )
+{
+    const char submit       = http_layer_input->xi_context->http2_submit;
+    http2_stream_t* stream  = 0;
+
+    for( size_t i = 0; !stream && i < XI_HTTP2_MAX_STREAMS; ++i )
+    {
+        if( http2_layer_data->streams[ i ].id == 0 )
+        {
+            stream = &http2_layer_data->streams[ i ];
+        }
+    }
+
+    if( !stream || ( submit && http2_layer_submitted( http2_layer_data ) + 1 >= XI_HTTP2_MAX_STREAMS ) )
+    {
+        return 0;
+    }
+
+    memset( stream, 0, sizeof( http2_stream_t ) );
+
+    // every request is a new stream
+    http2_layer_data->stream_id        += 2;
+
+    stream->id                          = http2_layer_data->stream_id;
+    stream->submitted                   = submit;
+    stream->input                       = *http_layer_input;
+    stream->decoder.http_layer_input    = &stream->input;
+    stream->decoder.response            = submit ? &stream->response : http2_layer_data->response;
+
+    if( !submit )
+    {
+        http2_layer_data->waiting = stream->id;
+    }
+
+    return stream;
+}
+
+// frees the slot of the stream that has ended, returns LAYER_STATE_OK if the blocking call waits for it
+static layer_state_t http2_layer_close_stream(
+      http2_layer_data_t* http2_layer_data
+    , http2_stream_t* stream )
+{
+    const char waited = stream->id == http2_layer_data->waiting;
+
+    stream->id                      = 0;
+    http2_layer_data->frame_slot    = 0;
+
+    if( waited )
+    {
+        http2_layer_data->waiting = 0;
+        return LAYER_STATE_OK;
+    }
+
+    return LAYER_STATE_WANT_READ;
+}
+
+static void http2_layer_close_streams( http2_layer_data_t* http2_layer_data )
+{
+    for( size_t i = 0; i < XI_HTTP2_MAX_STREAMS; ++i )
+    {
+        http2_layer_data->streams[ i ].id = 0;
+    }
+
+    http2_layer_data->waiting       = 0;
+    http2_layer_data->frame_slot    = 0;
+}
+
+layer_state_t http2_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    http2_layer_data_t* http2_layer_data        = ( http2_layer_data_t* ) context->self->user_data;
+    const http_layer_input_t* http_layer_input  = ( const http_layer_input_t* ) data;
+
+    if( xi_resource_method( http_layer_input->query_type ) == 0 || !http2_layer_data->connected )
+    {
+        return LAYER_STATE_ERROR;
+    }
+
+    const size_t payload_size = http_layer_input->payload_generator
+        ? xi_generator_length( http_layer_input->payload_generator, &http_layer_input->http_union_data )
+        : 0;
+
+    const size_t block_size = http2_layer_header_block( http2_layer_data, http_layer_input, payload_size );
+
+    if( block_size == 0 )
+    {
+        xi_debug_logger( "request headers do not fit the buffer" );
+        return LAYER_STATE_ERROR;
+    }
+
+    const http2_stream_t* stream = http2_layer_open_stream( http2_layer_data, http_layer_input );
+
+    if( !stream )
+    {
+        xi_debug_logger( "all of the streams are open" );
+        return LAYER_STATE_ERROR;
+    }
+
+    layer_state_t state = http2_layer_send_frame_header(
+          context, ( uint32_t ) block_size, XI_HTTP2_HEADERS
+        , XI_HTTP2_FLAG_END_HEADERS | ( payload_size ? 0 : XI_HTTP2_FLAG_END_STREAM )
+        , stream->id );
+
+    if( state == LAYER_STATE_OK )
+    {
+        state = http2_layer_send( context, http2_layer_data->buffer, block_size );
+    }
+
+    // the payload is split into the frames of the default maximum size
+    size_t left         = payload_size;
+    size_t frame_left   = 0;
+    short gstate        = 0;
+
+    while( state == LAYER_STATE_OK && left > 0 && gstate != 1 )
+    {
+        const const_data_descriptor_t* chunk = ( const const_data_descriptor_t* )
+            ( *http_layer_input->payload_generator )( &http_layer_input->http_union_data, &gstate );
+
+        for( size_t pos = 0; chunk && pos < chunk->real_size && state == LAYER_STATE_OK; )
+        {
+            if( frame_left == 0 )
+            {
+                frame_left = XI_MIN( left, ( size_t ) XI_HTTP2_MAX_FRAME_SIZE );
+                state = http2_layer_send_frame_header(
+                      context, ( uint32_t ) frame_left, XI_HTTP2_DATA
+                    , frame_left == left ? XI_HTTP2_FLAG_END_STREAM : 0
+                    , stream->id );
+            }
+
+            const size_t size = XI_MIN( frame_left, ( size_t ) chunk->real_size - pos );
+
+            if( state == LAYER_STATE_OK )
+            {
+                state = http2_layer_send( context, chunk->data_ptr + pos, size );
+            }
+
+            pos         += size;
+            frame_left  -= size;
+            left        -= size;
+        }
+    }
+
+    return state;
+}
+
+// the payload range that belongs to the application, without padding and priority
+static inline uint32_t http2_layer_payload_begin( const http2_layer_data_t* http2_layer_data )
+{
+    uint32_t begin = ( http2_layer_data->frame_flags & XI_HTTP2_FLAG_PADDED ) ? 1 : 0;
+
+    if( http2_layer_data->frame_type == XI_HTTP2_HEADERS
+        && ( http2_layer_data->frame_flags & XI_HTTP2_FLAG_PRIORITY ) )
+    {
+        begin += 5;
+    }
+
+    return begin;
+}
+
+static inline uint32_t http2_layer_payload_end( const http2_layer_data_t* http2_layer_data )
+{
+    return http2_layer_data->frame_length - http2_layer_data->frame_pad;
+}
+
+static layer_state_t http2_layer_on_body(
+      layer_connectivity_t* context
+    , http2_stream_t* stream
+    , const char* data
+    , uint32_t size
+    , char last )
+{
+    xi_response_t* response = stream->decoder.response;
+
+    if( response->http.http_status == 200 )
+    {
+        const_data_descriptor_t body    = { data, ( unsigned short ) size, ( unsigned short ) size, 0 };
+        layer_t* next                   = context->self->layer_connection.next;
+        void* const user_data           = next->user_data;
+
+        // the body is parsed with the state of its own stream
+        next->user_data = &stream->decoder;
+
+        const layer_state_t state = CALL_ON_NEXT_ON_DATA_READY(
+              context->self
+            , ( const void* ) &body
+            , last ? LAYER_HINT_NONE : LAYER_HINT_MORE_DATA );
+
+        next->user_data = user_data;
+
+        return state;
+    }
+
+    // the error message goes to the status string
+    for( uint32_t i = 0; i < size && stream->body_pos < XI_HTTP_STATUS_STRING_SIZE - 1; ++i )
+    {
+        response->http.http_status_string[ stream->body_pos++ ] = data[ i ];
+    }
+
+    return LAYER_STATE_OK;
+}
+
+// handles the byte of the frame's payload
+static void http2_layer_on_payload_byte(
+      http2_layer_data_t* http2_layer_data
+    , unsigned char c )
+{
+    const uint32_t pos = http2_layer_data->frame_pos;
+
+    if( pos == 0 && ( http2_layer_data->frame_flags & XI_HTTP2_FLAG_PADDED )
+        && ( http2_layer_data->frame_type == XI_HTTP2_DATA || http2_layer_data->frame_type == XI_HTTP2_HEADERS ) )
+    {
+        http2_layer_data->frame_pad = c;
+        return;
+    }
+
+    switch( http2_layer_data->frame_type )
+    {
+        case XI_HTTP2_HEADERS:
+        case XI_HTTP2_CONTINUATION:
+            if( http2_layer_data->frame_slot
+                && pos >= http2_layer_payload_begin( http2_layer_data )
+                && pos < http2_layer_payload_end( http2_layer_data ) )
+            {
+                xi_hpack_decode( http2_layer_data->frame_slot, c );
+            }
+            break;
+        case XI_HTTP2_PING:
+            if( pos < sizeof( http2_layer_data->ping ) )
+            {
+                http2_layer_data->ping[ pos ] = c;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// called when the whole frame has been received, returns LAYER_STATE_OK
+// when the frame completes what the layer has been waiting for
+static layer_state_t http2_layer_on_frame_end(
+      layer_connectivity_t* context
+    , http2_layer_data_t* http2_layer_data )
+{
+    http2_stream_t* stream      = http2_layer_data->frame_slot;
+    const unsigned char flags   = http2_layer_data->frame_flags;
+
+    http2_layer_data->frame_state = XI_HTTP2_FRAME_HEADER;
+
+    switch( http2_layer_data->frame_type )
+    {
+        case XI_HTTP2_SETTINGS:
+            if( flags & XI_HTTP2_FLAG_ACK )
+            {
+                break;
+            }
+
+            http2_layer_send_frame_header( context, 0, XI_HTTP2_SETTINGS, XI_HTTP2_FLAG_ACK, 0 );
+
+            if( !http2_layer_data->settings_received )
+            {
+                http2_layer_data->settings_received = 1;
+                return LAYER_STATE_OK;
+            }
+            break;
+        case XI_HTTP2_PING:
+            if( !( flags & XI_HTTP2_FLAG_ACK ) )
+            {
+                if( http2_layer_send_frame_header( context, sizeof( http2_layer_data->ping ), XI_HTTP2_PING, XI_HTTP2_FLAG_ACK, 0 ) == LAYER_STATE_OK )
+                {
+                    http2_layer_send( context, http2_layer_data->ping, sizeof( http2_layer_data->ping ) );
+                }
+            }
+            break;
+        case XI_HTTP2_DATA:
+            // give the connection window back, and the stream's one while it goes on,
+            // otherwise the response longer than the initial window would stall
+            if( http2_layer_data->frame_length )
+            {
+                http2_layer_send_window_update( context, http2_layer_data->frame_length, 0 );
+
+                if( stream && !( flags & XI_HTTP2_FLAG_END_STREAM ) )
+                {
+                    http2_layer_send_window_update( context, http2_layer_data->frame_length, stream->id );
+                }
+            }
+
+            // the stream may end with the frame that has no body, the data layer still needs to know
+            if( stream && ( flags & XI_HTTP2_FLAG_END_STREAM )
+                && http2_layer_payload_end( http2_layer_data ) <= http2_layer_payload_begin( http2_layer_data ) )
+            {
+                const layer_state_t state = http2_layer_on_body( context, stream, "", 0, 1 );
+
+                if( state == LAYER_STATE_ERROR )
+                {
+                    return state;
+                }
+            }
+            // fall through
+        case XI_HTTP2_HEADERS:
+            if( stream && ( flags & XI_HTTP2_FLAG_END_STREAM ) )
+            {
+                return http2_layer_close_stream( http2_layer_data, stream );
+            }
+            break;
+        case XI_HTTP2_RST_STREAM:
+            if( stream )
+            {
+                xi_debug_logger( "stream reset by the server" );
+
+                // the submitted one is left without the status
+                if( http2_layer_close_stream( http2_layer_data, stream ) == LAYER_STATE_OK )
+                {
+                    return LAYER_STATE_ERROR;
+                }
+            }
+            break;
+        case XI_HTTP2_GOAWAY:
+            xi_debug_logger( "connection closed by the server" );
+            http2_layer_data->connected = 0;
+            return LAYER_STATE_ERROR;
+        default:
+            break;
+    }
+
+    return LAYER_STATE_WANT_READ;
+}
+
+layer_state_t http2_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    http2_layer_data_t* http2_layer_data    = ( http2_layer_data_t* ) context->self->user_data;
+    const_data_descriptor_t* buffer         = ( const_data_descriptor_t* ) data;
+    char done                               = 0;
+
+    // the frames of the other streams that follow the awaited one are read as well
+    while( buffer->curr_pos < buffer->real_size )
+    {
+        if( http2_layer_data->frame_state == XI_HTTP2_FRAME_HEADER )
+        {
+            unsigned char* header = http2_layer_data->frame_header;
+
+            header[ http2_layer_data->frame_header_size++ ] = ( unsigned char ) buffer->data_ptr[ buffer->curr_pos++ ];
+
+            if( http2_layer_data->frame_header_size < sizeof( http2_layer_data->frame_header ) )
+            {
+                continue;
+            }
+
+            http2_layer_data->frame_header_size = 0;
+            http2_layer_data->frame_length      = ( ( uint32_t ) header[ 0 ] << 16 ) | ( header[ 1 ] << 8 ) | header[ 2 ];
+            http2_layer_data->frame_type        = header[ 3 ];
+            http2_layer_data->frame_flags       = header[ 4 ];
+            http2_layer_data->frame_stream      = ( ( uint32_t ) ( header[ 5 ] & 0x7F ) << 24 )
+                                                | ( ( uint32_t ) header[ 6 ] << 16 ) | ( header[ 7 ] << 8 ) | header[ 8 ];
+            http2_layer_data->frame_pos         = 0;
+            http2_layer_data->frame_pad         = 0;
+            http2_layer_data->frame_slot        = http2_layer_stream( http2_layer_data, http2_layer_data->frame_stream );
+            http2_layer_data->frame_state       = XI_HTTP2_FRAME_PAYLOAD;
+        }
+        else if( http2_layer_data->frame_type == XI_HTTP2_DATA
+            && http2_layer_data->frame_slot
+            && http2_layer_data->frame_pos >= http2_layer_payload_begin( http2_layer_data )
+            && http2_layer_data->frame_pos < http2_layer_payload_end( http2_layer_data ) )
+        {
+            const uint32_t end  = http2_layer_payload_end( http2_layer_data );
+            const uint32_t size = XI_MIN(
+                  ( uint32_t ) ( buffer->real_size - buffer->curr_pos )
+                , end - http2_layer_data->frame_pos );
+            const char last     = ( http2_layer_data->frame_flags & XI_HTTP2_FLAG_END_STREAM )
+                                    && http2_layer_data->frame_pos + size == end;
+
+            layer_state_t state = http2_layer_on_body(
+                  context, http2_layer_data->frame_slot, buffer->data_ptr + buffer->curr_pos, size, last );
+
+            if( state == LAYER_STATE_ERROR )
+            {
+                return state;
+            }
+
+            buffer->curr_pos            += size;
+            http2_layer_data->frame_pos += size;
+        }
+        else
+        {
+            http2_layer_on_payload_byte( http2_layer_data, ( unsigned char ) buffer->data_ptr[ buffer->curr_pos++ ] );
+            http2_layer_data->frame_pos += 1;
+        }
+
+        if( http2_layer_data->frame_state == XI_HTTP2_FRAME_PAYLOAD
+            && http2_layer_data->frame_pos == http2_layer_data->frame_length )
+        {
+            layer_state_t state = http2_layer_on_frame_end( context, http2_layer_data );
+
+            if( state == LAYER_STATE_ERROR )
+            {
+                return state;
+            }
+
+            done |= state == LAYER_STATE_OK;
+        }
+    }
+
+    return done ? LAYER_STATE_OK : LAYER_STATE_WANT_READ;
+}
+
+layer_state_t http2_layer_close(
+      layer_connectivity_t* context )
+{
+    http2_layer_data_t* http2_layer_data = ( http2_layer_data_t* ) context->self->user_data;
+
+    // the handshake cut short starts over with the next connect
+    http2_layer_data->connect_state = 0;
+
+    if( http2_layer_data->connected )
+    {
+        // GOAWAY with the last stream id we have seen and NO_ERROR
+        const uint32_t last_stream          = http2_layer_data->stream_id;
+        const unsigned char payload[ 8 ]    =
+        {
+              ( unsigned char ) ( last_stream >> 24 ), ( unsigned char ) ( last_stream >> 16 )
+            , ( unsigned char ) ( last_stream >> 8 ), ( unsigned char ) last_stream
+            , 0, 0, 0, 0
+        };
+
+        http2_layer_data->connected = 0;
+
+        if( http2_layer_send_frame_header( context, sizeof( payload ), XI_HTTP2_GOAWAY, 0, 0 ) == LAYER_STATE_OK )
+        {
+            http2_layer_send( context, payload, sizeof( payload ) );
+        }
+    }
+
+    return CALL_ON_PREV_CLOSE( context->self );
+}
+
+layer_state_t http2_layer_on_close(
+      layer_connectivity_t* context )
+{
+    http2_layer_data_t* http2_layer_data = ( http2_layer_data_t* ) context->self->user_data;
+
+    http2_layer_data->connected      = 0;
+    http2_layer_data->connect_state  = 0;
+
+    // the streams still open are lost with the connection
+    http2_layer_close_streams( http2_layer_data );
+
+    return CALL_ON_NEXT_ON_CLOSE( context->self );
+}
+
+layer_state_t http2_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( data );
+    XI_UNUSED( hint );
+
+    http2_layer_data_t* http2_layer_data = ( http2_layer_data_t* ) context->self->user_data;
+
+    BEGIN_CORO( http2_layer_data->connect_state )
+
+    {
+        // SETTINGS_HEADER_TABLE_SIZE = 0 and SETTINGS_ENABLE_PUSH = 0
+        static const unsigned char settings[] = { 0, 1, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0 };
+
+        http2_layer_data->connected             = 0;
+        http2_layer_data->settings_received     = 0;
+        http2_layer_data->headers_indexed       = 0;
+        http2_layer_data->stream_id             = 0xFFFFFFFF; // the first stream is 1
+        http2_layer_data->frame_state           = XI_HTTP2_FRAME_HEADER;
+        http2_layer_data->frame_header_size     = 0;
+
+        http2_layer_close_streams( http2_layer_data );
+
+        layer_state_t state = http2_layer_send( context, XI_HTTP2_PREFACE, sizeof( XI_HTTP2_PREFACE ) - 1 );
+
+        if( state == LAYER_STATE_OK )
+        {
+            state = http2_layer_send_frame_header( context, sizeof( settings ), XI_HTTP2_SETTINGS, 0, 0 );
+        }
+
+        if( state == LAYER_STATE_OK )
+        {
+            state = http2_layer_send( context, settings, sizeof( settings ) );
+        }
+
+        if( state != LAYER_STATE_OK )
+        {
+            EXIT( http2_layer_data->connect_state, LAYER_STATE_ERROR );
+        }
+    }
+
+    // the server's SETTINGS are parsed by the on_data_ready
+    YIELD( http2_layer_data->connect_state, LAYER_STATE_WANT_READ );
+
+    http2_layer_data->connected = http2_layer_data->settings_received;
+
+    // make the next connect start from the beginning
+    RESTART( http2_layer_data->connect_state, http2_layer_data->connected ? LAYER_STATE_OK : LAYER_STATE_ERROR );
+
+    END_CORO()
+
+    return LAYER_STATE_ERROR;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_HTTP2_LAYER_H__
+#define __XI_HTTP2_LAYER_H__
+
+#include "xi_layer.h"
+#include "xi_http_layer_input.h"
+#include "xi_http2_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The HTTP/2 layer replaces the HTTP/1.1 layer for the XI_HTTP2 protocol. It
+// connects with the prior knowledge (h2c) and sends every request as a new
+// stream on the same connection. The authority, user agent and api key are
+// added to the HPACK dynamic table by the first request, so the following ones
+// refer to them with a single byte each. The layer announces a zero sized
+// header table, so the server's responses can be decoded without one.
+//
+// Up to XI_HTTP2_MAX_STREAMS streams are open at the same time. Each one has
+// its own slot with the header block decoder, the response and the state of
+// the csv parser, which takes the place of the csv layer's data while the
+// stream's body is handed on, so the HEADERS and DATA frames of the streams
+// may interleave. The blocking calls wait for their own stream and read the
+// frames of the submitted ones on the way, one of the slots is kept for them.
+
+// the slot of the open stream, 0 if the stream is not open
+http2_stream_t* http2_layer_stream( http2_layer_data_t* http2_layer_data, uint32_t stream_id );
+
+// the number of the submitted streams that have not ended yet
+unsigned char http2_layer_submitted( const http2_layer_data_t* http2_layer_data );
+
+layer_state_t http2_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t http2_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t http2_layer_close(
+      layer_connectivity_t* context );
+
+layer_state_t http2_layer_on_close(
+      layer_connectivity_t* context );
+
+layer_state_t http2_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_HTTP2_LAYER_H__
@@ -0,0 +1,74 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_HTTP2_LAYER_DATA_H__
+#define __XI_HTTP2_LAYER_DATA_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+#include "xi_config.h"
+#include "xi_http_layer_input.h"
+#include "xi_csv_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    uint32_t                    id;                 // 0 when the slot is free
+    char                        submitted;          // whether the caller polls for it rather than waits
+
+    // header block decoder
+    unsigned char               hpack_state;
+    unsigned char               hpack_kind;
+    unsigned char               hpack_huffman;
+    unsigned char               hpack_is_status;
+    unsigned char               hpack_shift;
+    uint32_t                    hpack_int;
+    uint32_t                    hpack_remaining;
+    uint32_t                    hpack_bits;
+    unsigned char               hpack_bit_count;
+    unsigned short              hpack_status;
+
+    unsigned short              body_pos;           // within the status string the error body goes to
+    http_layer_input_t          input;              // the copy of the request, the body is decoded to its targets
+    csv_layer_data_t            decoder;            // takes the place of the csv layer's data while the body is read
+    xi_response_t               response;           // of the submitted stream, the blocking ones use the context's
+} http2_stream_t;
+
+typedef struct
+{
+    // connection
+    const char*                 api_key;
+    char                        connected;
+    short                       connect_state;
+    char                        settings_received;
+    char                        headers_indexed;
+    uint32_t                    stream_id;          // the last one opened
+    uint32_t                    waiting;            // the stream the blocking call waits for
+
+    // incoming frame
+    unsigned char               frame_state;
+    unsigned char               frame_header[ 9 ];
+    unsigned char               frame_header_size;
+    uint32_t                    frame_length;
+    uint32_t                    frame_pos;
+    unsigned char               frame_type;
+    unsigned char               frame_flags;
+    uint32_t                    frame_stream;
+    unsigned char               frame_pad;
+    http2_stream_t*             frame_slot;         // of the frame's stream, 0 if it is not open
+    unsigned char               ping[ 8 ];
+
+    http2_stream_t              streams[ XI_HTTP2_MAX_STREAMS ];
+    xi_response_t*              response;           // of the blocking calls
+    unsigned char               buffer[ XI_HTTP2_HEADER_BUFFER_SIZE ];
+} http2_layer_data_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_HTTP2_LAYER_DATA_H__
@@ -12,6 +12,7 @@
 #include "xi_stated_sscanf.h"
 #include "xi_coroutine.h"
 #include "xi_layer_helpers.h"
+#include "xi_resource.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,14 +27,18 @@ static const char* XI_HTTP_TOKEN_NAMES[ XI_HTTP_HEADERS_COUNT ] =
         , "connection"      // XI_HTTP_HEADER_CONNECTION
         , "x-request-id"    // XI_HTTP_HEADER_X_REQUEST_ID
         , "cache-control"   // XI_HTTP_HEADER_CACHE_CONTROL
-        , "age"             // XI_HTTP_HEADER_AGE
         , "vary"            // XI_HTTP_HEADER_VARY
+        , "count"           // XI_HTTP_HEADER_COUNT
+        , "age"             // XI_HTTP_HEADER_AGE
+        , "retry-after"     // XI_HTTP_HEADER_RETRY_AFTER
+        , "etag"            // XI_HTTP_HEADER_ETAG
+        , "last-modified"   // XI_HTTP_HEADER_LAST_MODIFIED
         , "unknown"         // XI_HTTP_HEADER_UNKNOWN, //!< !!!! this must be always on the last position
     };
 
 static inline http_header_type_t classify_header( const char* header )
 {
-    for( unsigned short i = 0; i < XI_HTTP_HEADER_COUNT - 1; ++i )
+    for( unsigned short i = 0; i < XI_HTTP_HEADER_UNKNOWN; ++i )
     {
         if( strcasecmp( header, XI_HTTP_TOKEN_NAMES[ i ] ) == 0 )
             return ( http_header_type_t ) i;
@@ -42,6 +47,173 @@ static inline http_header_type_t classify_header( const char* header )
     return XI_HTTP_HEADER_UNKNOWN;
 }
 
+// headers that are kept in the status only mode, all of the others are skipped
+// the retry-after is needed by the retry policy
+static const struct
+{
+    const char*         name;
+    http_header_type_t  type;
+} XI_HTTP_SKIM_HEADERS[] =
+    {
+          { "content-length", XI_HTTP_HEADER_CONTENT_LENGTH }
+        , { "connection",     XI_HTTP_HEADER_CONNECTION }
+        , { "retry-after",    XI_HTTP_HEADER_RETRY_AFTER }
+    };
+
+#define XI_HTTP_SKIM_HEADERS_COUNT ( sizeof( XI_HTTP_SKIM_HEADERS ) / sizeof( XI_HTTP_SKIM_HEADERS[ 0 ] ) )
+#define XI_HTTP_SKIM_ALL_CANDIDATES ( ( 1 << XI_HTTP_SKIM_HEADERS_COUNT ) - 1 )
+
+enum
+{
+      XI_HTTP_SKIM_LINE_START = 0
+    , XI_HTTP_SKIM_NAME
+    , XI_HTTP_SKIM_VALUE
+    , XI_HTTP_SKIM_SKIP_LINE
+    , XI_HTTP_SKIM_END
+};
+
+/**
+ * \brief   goes through the headers byte by byte without the xi_stated_sscanf,
+ *          matches the header names against the XI_HTTP_SKIM_HEADERS and stores
+ *          only the values of the matching ones
+ *
+ * \note    the state is kept in the http_layer_data so it can be resumed
+ *          with the next chunk of the data
+ *
+ * \return  1 when the empty line after the headers has been consumed,
+ *          0 if more data is needed, -1 on malformed data
+ */
+static short http_layer_skim_headers(
+      http_layer_data_t* http_layer_data
+    , const_data_descriptor_t* data )
+{
+    http_response_t* http = &http_layer_data->response->http;
+
+    while( data->curr_pos < data->real_size )
+    {
+        char c = data->data_ptr[ data->curr_pos++ ];
+
+        switch( http_layer_data->skim_state )
+        {
+            case XI_HTTP_SKIM_LINE_START:
+                if( c == '\r' )
+                {
+                    http_layer_data->skim_state = XI_HTTP_SKIM_END;
+                    break;
+                }
+
+                if( c == '\n' )
+                {
+                    return 1;
+                }
+
+                http_layer_data->skim_candidates = XI_HTTP_SKIM_ALL_CANDIDATES;
+                http_layer_data->skim_pos        = 0;
+                http_layer_data->skim_state      = XI_HTTP_SKIM_NAME;
+                // the character is the first character of the name
+                // fall through
+            case XI_HTTP_SKIM_NAME:
+                if( c == ':' )
+                {
+                    http_layer_data->skim_state = XI_HTTP_SKIM_SKIP_LINE;
+
+                    for( unsigned char i = 0; i < XI_HTTP_SKIM_HEADERS_COUNT; ++i )
+                    {
+                        if( ( http_layer_data->skim_candidates & ( 1 << i ) )
+                            && XI_HTTP_SKIM_HEADERS[ i ].name[ http_layer_data->skim_pos ] == '\0' )
+                        {
+                            http_layer_data->skim_header = XI_HTTP_SKIM_HEADERS[ i ].type;
+                            http_layer_data->skim_pos    = 0;
+                            http_layer_data->skim_state  = XI_HTTP_SKIM_VALUE;
+
+                            memcpy( http->http_headers[ http_layer_data->skim_header ].name
+                                  , XI_HTTP_SKIM_HEADERS[ i ].name
+                                  , strlen( XI_HTTP_SKIM_HEADERS[ i ].name ) + 1 );
+                            http->http_headers[ http_layer_data->skim_header ].value[ 0 ] = '\0';
+
+                            if( http_layer_data->skim_header == XI_HTTP_HEADER_CONTENT_LENGTH )
+                            {
+                                http_layer_data->content_length = 0;
+                            }
+                            break;
+                        }
+                    }
+                    break;
+                }
+
+                if( c == '\n' )
+                {
+                    http_layer_data->skim_state = XI_HTTP_SKIM_LINE_START;
+                    break;
+                }
+
+                c = ( c >= 'A' && c <= 'Z' ) ? c + ( 'a' - 'A' ) : c;
+
+                for( unsigned char i = 0; i < XI_HTTP_SKIM_HEADERS_COUNT; ++i )
+                {
+                    const char n = XI_HTTP_SKIM_HEADERS[ i ].name[ http_layer_data->skim_pos ];
+
+                    if( ( http_layer_data->skim_candidates & ( 1 << i ) ) && ( n == '\0' || n != c ) )
+                    {
+                        http_layer_data->skim_candidates &= ~( 1 << i );
+                    }
+                }
+
+                http_layer_data->skim_pos += 1;
+
+                if( http_layer_data->skim_candidates == 0 )
+                {
+                    http_layer_data->skim_state = XI_HTTP_SKIM_SKIP_LINE;
+                }
+                break;
+            case XI_HTTP_SKIM_VALUE:
+                if( c == '\n' )
+                {
+                    http->http_headers_checklist[ http_layer_data->skim_header ]
+                            = &http->http_headers[ http_layer_data->skim_header ];
+
+                    xi_debug_format( "%s: %s"
+                                     , http->http_headers[ http_layer_data->skim_header ].name
+                                     , http->http_headers[ http_layer_data->skim_header ].value );
+
+                    http_layer_data->skim_state = XI_HTTP_SKIM_LINE_START;
+                    break;
+                }
+
+                if( c == '\r' || ( c == ' ' && http_layer_data->skim_pos == 0 ) )
+                {
+                    break;
+                }
+
+                if( http_layer_data->skim_pos < XI_HTTP_HEADER_VALUE_MAX_SIZE - 1 )
+                {
+                    char* value = http->http_headers[ http_layer_data->skim_header ].value;
+
+                    value[ http_layer_data->skim_pos++ ]    = c;
+                    value[ http_layer_data->skim_pos ]      = '\0';
+                }
+
+                if( http_layer_data->skim_header == XI_HTTP_HEADER_CONTENT_LENGTH
+                    && c >= '0' && c <= '9' )
+                {
+                    http_layer_data->content_length
+                        = http_layer_data->content_length * 10 + ( c - '0' );
+                }
+                break;
+            case XI_HTTP_SKIM_SKIP_LINE:
+                if( c == '\n' )
+                {
+                    http_layer_data->skim_state = XI_HTTP_SKIM_LINE_START;
+                }
+                break;
+            case XI_HTTP_SKIM_END:
+                return c == '\n' ? 1 : -1;
+        }
+    }
+
+    return 0;
+}
+
 const void* http_layer_data_generator_query_body(
           const void* input
         , short* state )
@@ -96,6 +268,25 @@ const void* http_layer_data_generator_query_body(
                 gen_ptr_text( *state, XI_HTTP_CRLF );
             }
 
+            // the validators of the cached feed
+            if( ( http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET
+                  || http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET_ALL )
+                && http_layer_input->http_union_data.xi_get_feed.if_none_match )
+            {
+                gen_ptr_text( *state, XI_HTTP_TEMPLATE_IF_NONE_MATCH );
+                gen_ptr_text( *state, http_layer_input->http_union_data.xi_get_feed.if_none_match );
+                gen_ptr_text( *state, XI_HTTP_CRLF );
+            }
+
+            if( ( http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET
+                  || http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET_ALL )
+                && http_layer_input->http_union_data.xi_get_feed.if_modified_since )
+            {
+                gen_ptr_text( *state, XI_HTTP_TEMPLATE_IF_MODIFIED_SINCE );
+                gen_ptr_text( *state, http_layer_input->http_union_data.xi_get_feed.if_modified_since );
+                gen_ptr_text( *state, XI_HTTP_CRLF );
+            }
+
             // A API KEY
             gen_ptr_text( *state, XI_HTTP_TEMPLATE_X_API_KEY );
             gen_ptr_text( *state, http_layer_input->xi_context->api_key ); // api key
@@ -124,7 +315,7 @@ const void* http_layer_data_generator_query_body(
     return 0;
 }
 
-const void* http_layer_data_generator_datastream_body(
+const void* http_layer_data_generator_request(
           const void* input
         , short* state )
 {
@@ -136,173 +327,9 @@ const void* http_layer_data_generator_datastream_body(
 
     BEGIN_CORO( *state )
 
-        {
-            memset( buffer_32, 0, 32 );
-            sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-            gen_ptr_text( *state, buffer_32 ); // feed id
-        }
-
-        gen_ptr_text( *state, XI_CSV_SLASH );
-        gen_ptr_text( *state, XI_CSV_DATASTREAMS );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        gen_ptr_text( *state, http_layer_input->http_union_data.xi_get_datastream.datastream ); // datastream id
-        gen_ptr_text( *state, XI_CSV_DOT_CSV_SPACE );
-
-        // SEND HTTP
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_HTTP );
-        gen_ptr_text( *state, XI_HTTP_CRLF );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_query_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_datastream_get(
-          const void* input
-        , short* state )
-{
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        gen_ptr_text( *state, XI_HTTP_GET );
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_FEED );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_datastream_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_datastream_update(
-          const void* input
-        , short* state )
-{
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        gen_ptr_text( *state, XI_HTTP_PUT );
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_FEED );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_datastream_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_datastream_create_body(
-          const void* input
-        , short* state )
-{
-    // unpack the data
-    const http_layer_input_t* const http_layer_input
-            = ( const http_layer_input_t* ) input;
-
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        {
-            memset( buffer_32, 0, 32 );
-            sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-            gen_ptr_text( *state, buffer_32 ); // feed id
-        }
-
-        gen_ptr_text( *state, XI_CSV_SLASH );
-        gen_ptr_text( *state, XI_CSV_DATASTREAMS );
-        gen_static_text( *state, ".csv" );
-
-        // SEND HTTP
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_HTTP );
-        gen_ptr_text( *state, XI_HTTP_CRLF );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_query_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_datastream_create(
-          const void* input
-        , short* state )
-{
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        gen_ptr_text( *state, XI_HTTP_POST );
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_FEED );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_datastream_create_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_feed_get(
-          const void* input
-        , short* state )
-{
-    // unpack the data
-    const http_layer_input_t* const http_layer_input
-            = ( const http_layer_input_t* ) input;
-
-    // local patterns
-    static const char* const p1 = ".csv?datastreams=";
-
-    // PRECONDITIONS
-    assert( http_layer_input->http_union_data.xi_get_feed.feed->datastream_count > 0 );
-
-    static unsigned char i = 0;
-
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        // after starting coro reset static counter
-        i = 1;
-
-        gen_ptr_text( *state, XI_HTTP_GET );
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_FEED );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        {
-            memset( buffer_32, 0, 32 );
-            sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-            gen_ptr_text( *state, buffer_32 ); // feed id
-        }
-
-        gen_ptr_text( *state, p1 );
-
-        // 0 case separated
-        gen_ptr_text( *state, http_layer_input->http_union_data.xi_get_feed.feed->datastreams[ 0 ].datastream_id );
-
-        // iterate over all datastreams
-        {
-            for( ; i < http_layer_input->http_union_data.xi_get_feed.feed->datastream_count; ++i )
-            {
-                gen_ptr_text( *state, XI_CSV_COMMA );
-                gen_ptr_text( *state, http_layer_input->http_union_data.xi_get_feed.feed->datastreams[ i ].datastream_id );
-            }
-        }
-
-        // space
+        // SEND THE REQUEST LINE
+        gen_ptr_text( *state, xi_resource_method( http_layer_input->query_type ) );
+        call_sub_gen( *state, input, xi_resource_path_generator );
         gen_ptr_text( *state, XI_HTTP_SPACE );
 
         // SEND HTTP
@@ -317,258 +344,6 @@ const void* http_layer_data_generator_feed_get(
     return 0;
 }
 
-const void* http_layer_data_generator_feed_get_all(
-          const void* input
-        , short* state )
-{
-    // unpack the data
-    const http_layer_input_t* const http_layer_input
-            = ( const http_layer_input_t* ) input;
-
-    // PRECONDITIONS
-    assert( http_layer_input->http_union_data.xi_get_feed.feed != 0 );
-
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        gen_ptr_text( *state, XI_HTTP_GET );
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_FEED );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        {
-            memset( buffer_32, 0, 32 );
-            sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-            gen_ptr_text( *state, buffer_32 ); // feed id
-        }
-
-        gen_ptr_text( *state, XI_CSV_DOT_CSV_SPACE );
-
-        // SEND HTTP
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_HTTP );
-        gen_ptr_text( *state, XI_HTTP_CRLF );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_query_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_feed_update(
-          const void* input
-        , short* state )
-{
-    // unpack the data
-    const http_layer_input_t* const http_layer_input
-            = ( const http_layer_input_t* ) input;
-
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        gen_ptr_text( *state, XI_HTTP_PUT );
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_FEED );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        {
-            memset( buffer_32, 0, 32 );
-            sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-            gen_ptr_text( *state, buffer_32 ); // feed id
-        }
-
-        gen_ptr_text( *state, XI_CSV_DOT_CSV_SPACE );
-
-        // SEND HTTP
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_HTTP );
-        gen_ptr_text( *state, XI_HTTP_CRLF );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_query_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_datastream_delete(
-          const void* input
-        , short* state )
-{
-    // unpack the data
-    const http_layer_input_t* const http_layer_input
-            = ( const http_layer_input_t* ) input;
-
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        memset( buffer_32, 0, 32 );
-        sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-        gen_ptr_text( *state, buffer_32 ); // feed id
-
-        gen_ptr_text( *state, XI_CSV_SLASH );
-        gen_ptr_text( *state, XI_CSV_DATASTREAMS );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        gen_ptr_text( *state, http_layer_input->http_union_data.xi_delete_datastream.datastream );
-        gen_ptr_text( *state, XI_CSV_DOT_CSV_SPACE );
-
-        // SEND HTTP
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_HTTP );
-        gen_ptr_text( *state, XI_HTTP_CRLF );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_datastream_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_datapoint_delete(
-          const void* input
-        , short* state )
-{
-    // unpack the data
-    const http_layer_input_t* const http_layer_input
-            = ( const http_layer_input_t* ) input;
-
-    xi_time_t stamp         = 0;
-    struct xi_tm* gmtinfo   = 0;
-
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        memset( buffer_32, 0, 32 );
-        sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-        gen_ptr_text( *state, buffer_32 ); // feed id
-
-        gen_ptr_text( *state, XI_CSV_SLASH );
-        gen_ptr_text( *state, XI_CSV_DATASTREAMS );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        gen_ptr_text( *state, http_layer_input->http_union_data.xi_delete_datapoint.datastream );
-
-        gen_ptr_text( *state, XI_CSV_SLASH );
-        gen_ptr_text( *state, XI_CSV_DATAPOINTS );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        {
-            stamp   = http_layer_input->http_union_data.xi_delete_datapoint.value->timestamp.timestamp;
-            gmtinfo = xi_gmtime( &stamp );
-
-            memset( buffer_32, 0, 32 );
-            snprintf( buffer_32, 32
-                , XI_CSV_TIMESTAMP_PATTERN
-                , gmtinfo->tm_year + 1900
-                , gmtinfo->tm_mon + 1
-                , gmtinfo->tm_mday
-                , gmtinfo->tm_hour
-                , gmtinfo->tm_min
-                , gmtinfo->tm_sec
-                , ( int ) http_layer_input->http_union_data.xi_delete_datapoint.value->timestamp.micro );
-
-            gen_ptr_text( *state, buffer_32 );
-            gen_ptr_text( *state, XI_CSV_DOT_CSV_SPACE );
-        }
-
-        // SEND HTTP
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_HTTP );
-        gen_ptr_text( *state, XI_HTTP_CRLF );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_datastream_body );
-
-    END_CORO()
-
-    return 0;
-}
-
-const void* http_layer_data_generator_datapoint_delete_range(
-          const void* input
-        , short* state )
-{
-    // unpack the data
-    const http_layer_input_t* const http_layer_input
-            = ( const http_layer_input_t* ) input;
-
-    xi_time_t stamp         = 0;
-    struct xi_tm* gmtinfo   = 0;
-
-    static const char* const p1 = "?start=";
-
-    ENABLE_GENERATOR();
-
-    BEGIN_CORO( *state )
-
-        memset( buffer_32, 0, 32 );
-        sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
-        gen_ptr_text( *state, buffer_32 ); // feed id
-
-        gen_ptr_text( *state, XI_CSV_SLASH );
-        gen_ptr_text( *state, XI_CSV_DATASTREAMS );
-        gen_ptr_text( *state, XI_CSV_SLASH );
-
-        gen_ptr_text( *state, http_layer_input->http_union_data.xi_delete_datapoint_range.datastream );
-
-        gen_ptr_text( *state, XI_CSV_SLASH );
-        gen_ptr_text( *state, XI_CSV_DATAPOINTS );
-        gen_ptr_text( *state, p1 );
-
-        {
-            stamp   = http_layer_input->http_union_data.xi_delete_datapoint_range.value_start->timestamp;
-            gmtinfo = xi_gmtime( &stamp );
-
-            memset( buffer_32, 0, 32 );
-            snprintf( buffer_32, 32
-                , XI_CSV_TIMESTAMP_PATTERN
-                , gmtinfo->tm_year + 1900
-                , gmtinfo->tm_mon + 1
-                , gmtinfo->tm_mday
-                , gmtinfo->tm_hour
-                , gmtinfo->tm_min
-                , gmtinfo->tm_sec
-                , ( int ) http_layer_input->http_union_data.xi_delete_datapoint_range.value_start->micro );
-
-            gen_ptr_text( *state, buffer_32 );
-            gen_ptr_text( *state, XI_HTTP_AMPERSAND );
-
-            stamp   = http_layer_input->http_union_data.xi_delete_datapoint_range.value_end->timestamp;
-            gmtinfo = xi_gmtime( &stamp );
-
-            memset( buffer_32, 0, 32 );
-            snprintf( buffer_32, 32
-                , XI_CSV_TIMESTAMP_PATTERN
-                , gmtinfo->tm_year + 1900
-                , gmtinfo->tm_mon + 1
-                , gmtinfo->tm_mday
-                , gmtinfo->tm_hour
-                , gmtinfo->tm_min
-                , gmtinfo->tm_sec
-                , ( int ) http_layer_input->http_union_data.xi_delete_datapoint_range.value_end->micro );
-
-            gen_ptr_text( *state, buffer_32 );
-            gen_ptr_text( *state, XI_CSV_DOT_CSV_SPACE );
-        }
-
-
-        //
-
-        // SEND HTTP
-        gen_ptr_text( *state, XI_HTTP_TEMPLATE_HTTP );
-        gen_ptr_text( *state, XI_HTTP_CRLF );
-
-        // SEND THE REST THROUGH SUB GENERATOR
-        call_sub_gen_and_exit( *state, input, http_layer_data_generator_datastream_body );
-
-    END_CORO()
-
-    return 0;
-}
-
 static inline layer_state_t http_layer_data_ready_gen(
       layer_connectivity_t* context
     , const http_layer_input_t* input
@@ -621,56 +396,18 @@ layer_state_t http_layer_data_ready(
     // unpack the data
     const http_layer_input_t* http_layer_input = ( const http_layer_input_t* ) data;
 
-    switch( http_layer_input->query_type )
+    // the response mode is needed by the on_data_ready
+    ( ( http_layer_data_t* ) context->self->user_data )->response_mode = http_layer_input->response_mode;
+
+    if( xi_resource_method( http_layer_input->query_type ) == 0 )
     {
-        case HTTP_LAYER_INPUT_DATASTREAM_UPDATE:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_datastream_update );
-        case HTTP_LAYER_INPUT_DATASTREAM_GET:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_datastream_get );
-        case HTTP_LAYER_INPUT_DATASTREAM_CREATE:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_datastream_create );
-        case HTTP_LAYER_INPUT_FEED_GET:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_feed_get );
-        case HTTP_LAYER_INPUT_FEED_GET_ALL:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_feed_get_all );
-        case HTTP_LAYER_INPUT_FEED_UPDATE:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_feed_update );
-        case HTTP_LAYER_INPUT_DATASTREAM_DELETE:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_datastream_delete );
-        case HTTP_LAYER_INPUT_DATAPOINT_DELETE:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_datapoint_delete );
-        case HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE:
-            return http_layer_data_ready_gen(
-                          context
-                        , http_layer_input
-                        , &http_layer_data_generator_datapoint_delete_range );
-        default:
-            return LAYER_STATE_ERROR;
-    };
+        return LAYER_STATE_ERROR;
+    }
+
+    return http_layer_data_ready_gen(
+                  context
+                , http_layer_input
+                , &http_layer_data_generator_request );
 }
 
 layer_state_t http_layer_on_data_ready(
@@ -688,8 +425,9 @@ layer_state_t http_layer_on_data_ready(
     short sscanf_state      = 0;
     unsigned short prev_pos = 0;
     layer_state_t state     = LAYER_STATE_OK;
-    unsigned short before   = 0;
-    unsigned short after    = 0;
+    uint32_t before         = 0;
+    uint32_t after          = 0;
+    int content_length      = 0;
 
     xi_stated_sscanf_state_t tmp_state;
     memset( &tmp_state, 0, sizeof( xi_stated_sscanf_state_t ) );
@@ -718,7 +456,7 @@ layer_state_t http_layer_on_data_ready(
         , XI_HTTP_HEADER_VALUE_MAX_SIZE
         , 0
     };
-    void*                   pv3[]        = { ( void* ) &http_layer_data->content_length };
+    void*                   pv3[]        = { ( void* ) &content_length };
 
     const char status_pattern4[]       = "\r\n";
     const const_data_descriptor_t v4   = { status_pattern4, sizeof( status_pattern4 ) - 1, sizeof( status_pattern4 ) - 1, 0 };
@@ -734,6 +472,7 @@ layer_state_t http_layer_on_data_ready(
     BEGIN_CORO( cs )
 
     memset( xi_stated_state, 0, sizeof( xi_stated_sscanf_state_t ) );
+    http_layer_data->content_length = 0;
 
     // STAGE 01 find the http status
     {
@@ -766,6 +505,44 @@ layer_state_t http_layer_on_data_ready(
     //
     xi_debug_format( "HTTP STATUS: %d", http_layer_data->response->http.http_status );
 
+    // STATUS ONLY MODE skim the headers and skip the payload
+    if( http_layer_data->response_mode == XI_RESPONSE_MODE_STATUS_ONLY )
+    {
+        http_layer_data->skim_state = XI_HTTP_SKIM_LINE_START;
+
+        while( ( sscanf_state = http_layer_skim_headers( http_layer_data, ( const_data_descriptor_t* ) data ) ) == 0 )
+        {
+            YIELD( cs, LAYER_STATE_WANT_READ )
+        }
+
+        if( sscanf_state == -1 )
+        {
+            EXIT( cs, LAYER_STATE_ERROR )
+        }
+
+        http_layer_data->counter = 0;
+
+        while( 1 )
+        {
+            before = ( ( const_data_descriptor_t* ) data )->real_size - ( ( const_data_descriptor_t* ) data )->curr_pos;
+            after  = http_layer_data->content_length - http_layer_data->counter;
+            before = before < after ? before : after;
+
+            // skip the payload without copying it
+            ( ( const_data_descriptor_t* ) data )->curr_pos += before;
+            http_layer_data->counter                        += before;
+
+            if( http_layer_data->counter >= http_layer_data->content_length )
+            {
+                break;
+            }
+
+            YIELD( cs, LAYER_STATE_WANT_READ )
+        }
+
+        EXIT( cs, LAYER_STATE_OK )
+    }
+
     // STAGE 02 reading headers
     {
         do
@@ -806,6 +583,9 @@ layer_state_t http_layer_on_data_ready(
                     {
                         EXIT( cs, LAYER_STATE_ERROR );
                     }
+
+                    // the scanner writes an int, the length itself is kept unsigned
+                    http_layer_data->content_length = content_length < 0 ? 0 : ( uint32_t ) content_length;
                 }
 
                 if( header_type != XI_HTTP_HEADER_UNKNOWN )
@@ -30,7 +30,7 @@ layer_state_t http_layer_on_close(
 layer_t* init_http_layer(
       layer_t* layer );
 
-const void* http_layer_data_generator_datastream_get(
+const void* http_layer_data_generator_request(
       const void* input
     , short* state );
 
@@ -14,11 +14,15 @@ const char* const XI_HTTP_DELETE                  = "DELETE ";
 const char* const XI_HTTP_CRLF                    = "\r\n";
 const char* const XI_HTTP_TEMPLATE_FEED           = "/v2/feeds";
 const char* const XI_HTTP_TEMPLATE_CSV            = ".csv";
+const char* const XI_HTTP_TEMPLATE_JSON           = ".json";
+const char* const XI_HTTP_TEMPLATE_CBOR           = ".cbor";
 const char* const XI_HTTP_TEMPLATE_HTTP           = "HTTP/1.1";
 const char* const XI_HTTP_TEMPLATE_HOST           = "Host: ";
 const char* const XI_HTTP_TEMPLATE_USER_AGENT     = "User-Agent: ";
 const char* const XI_HTTP_TEMPLATE_X_API_KEY      = "X-ApiKey: ";
 const char* const XI_HTTP_TEMPLATE_ACCEPT         = "Accept: */*";
+const char* const XI_HTTP_TEMPLATE_IF_NONE_MATCH  = "If-None-Match: ";
+const char* const XI_HTTP_TEMPLATE_IF_MODIFIED_SINCE = "If-Modified-Since: ";
 const char* const XI_HTTP_CONTENT_LENGTH          = "Content-Length: ";
 const char* const XI_CSV_TIMESTAMP_PATTERN        = "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ";
 const char* const XI_CSV_SLASH                    = "/";
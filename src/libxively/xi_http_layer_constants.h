@@ -15,11 +15,15 @@ extern const char* const XI_HTTP_DELETE;
 extern const char* const XI_HTTP_CRLF;
 extern const char* const XI_HTTP_TEMPLATE_FEED;
 extern const char* const XI_HTTP_TEMPLATE_CSV;
+extern const char* const XI_HTTP_TEMPLATE_JSON;
+extern const char* const XI_HTTP_TEMPLATE_CBOR;
 extern const char* const XI_HTTP_TEMPLATE_HTTP;
 extern const char* const XI_HTTP_TEMPLATE_HOST;
 extern const char* const XI_HTTP_TEMPLATE_USER_AGENT;
 extern const char* const XI_HTTP_TEMPLATE_X_API_KEY;
 extern const char* const XI_HTTP_TEMPLATE_ACCEPT;
+extern const char* const XI_HTTP_TEMPLATE_IF_NONE_MATCH;
+extern const char* const XI_HTTP_TEMPLATE_IF_MODIFIED_SINCE;
 extern const char* const XI_HTTP_CONTENT_LENGTH;
 extern const char* const XI_CSV_TIMESTAMP_PATTERN;
 extern const char* const XI_CSV_SLASH;
@@ -16,9 +16,14 @@ typedef struct
     char                        parser_state;
     unsigned char               last_char_marker;
     xi_stated_sscanf_state_t    xi_stated_sscanf_state;
-    short                       counter;
-    short                       content_length;
+    uint32_t                    counter;
+    uint32_t                    content_length;
     xi_response_t*              response;
+    xi_response_mode_t          response_mode;
+    unsigned char               skim_state;
+    unsigned char               skim_candidates;
+    unsigned char               skim_pos;
+    http_header_type_t          skim_header;
 } http_layer_data_t;
 
 #ifdef __cplusplus
@@ -23,6 +23,10 @@ typedef enum
     , HTTP_LAYER_INPUT_FEED_UPDATE
     , HTTP_LAYER_INPUT_FEED_GET
     , HTTP_LAYER_INPUT_FEED_GET_ALL
+    , HTTP_LAYER_INPUT_DATASTREAM_HISTORY
+    , HTTP_LAYER_INPUT_DATAPOINTS_POST
+    , HTTP_LAYER_INPUT_COLUMNS_UPDATE
+    , HTTP_LAYER_INPUT_ARENA_FEED_UPDATE
 } xi_query_type_t;
 
 typedef struct
@@ -37,6 +41,7 @@ typedef struct
         {
             const char*     datastream;
             const xi_datapoint_t* value;
+            xi_datastream_t*    datapoints;             // all of them are stored here if it is set
         } xi_get_datastream;
 
         struct xi_update_datastream_t
@@ -72,14 +77,48 @@ typedef struct
         struct xi_get_feed_t
         {
             const xi_feed_t*      feed;
+            xi_feed_sink_t*       sink;
+            void*                 sink_data;
+            const char*           if_none_match;        // the validators of the cached feed
+            const char*           if_modified_since;
         } xi_get_feed;
 
         struct xi_update_feed_t
         {
-            const xi_feed_t*      feed;
+            const xi_feed_t*        feed;
+            const xi_feed_delta_t*  delta;              // only its dirty datastreams are sent if it is set
         } xi_update_feed;
+
+        struct xi_get_datastream_history_t
+        {
+            const char*             datastream;
+            const xi_timestamp_t*   start;
+            const xi_timestamp_t*   end;
+            uint32_t                interval;
+            uint32_t                limit;
+            xi_feed_sink_t*         sink;
+            void*                   sink_data;
+        } xi_get_datastream_history;
+
+        struct xi_post_datapoints_t
+        {
+            const char*             datastream;
+            const xi_datapoint_t*   values;
+            size_t                  count;
+        } xi_post_datapoints;
+
+        struct xi_update_columns_t
+        {
+            const xi_feed_columns_t*    columns;
+        } xi_update_columns;
+
+        struct xi_update_arena_feed_t
+        {
+            const xi_arena_feed_t*      feed;
+        } xi_update_arena_feed;
     } http_union_data;
 
+    xi_response_mode_t      response_mode;
 } http_layer_input_t;
 
 #ifdef __cplusplus
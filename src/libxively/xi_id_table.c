@@ -0,0 +1,167 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xively.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// FNV-1a, the ids are short so it is as good as any
+static inline uint32_t xi_id_hash( const char* id )
+{
+    uint32_t hash = 2166136261u;
+
+    while( *id )
+    {
+        hash ^= ( unsigned char ) *id++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// the slot of the id or the empty one it goes to, the slots are never full
+static size_t xi_id_table_probe( const xi_id_table_t* table, const char* datastream_id, uint32_t hash )
+{
+    const size_t mask   = XI_MAX_INTERNED_IDS * 2 - 1;
+    size_t slot         = hash & mask;
+
+    while( table->slots[ slot ] != 0 )
+    {
+        const size_t i = table->slots[ slot ] - 1;
+
+        if( table->hashes[ i ] == hash && strcmp( table->ids[ i ], datastream_id ) == 0 )
+        {
+            break;
+        }
+
+        slot = ( slot + 1 ) & mask;
+    }
+
+    return slot;
+}
+
+void xi_id_table_init( xi_id_table_t* table )
+{
+    // PRECONDITIONS
+    assert( table != 0 );
+
+    table->id_count = 0;
+    memset( table->slots, 0, sizeof( table->slots ) );
+}
+
+xi_id_handle_t xi_id_intern( xi_id_table_t* table, const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( table != 0 );
+    assert( datastream_id != 0 );
+
+    const uint32_t hash = xi_id_hash( datastream_id );
+    const size_t slot   = xi_id_table_probe( table, datastream_id, hash );
+
+    if( table->slots[ slot ] != 0 )
+    {
+        return ( xi_id_handle_t ) table->slots[ slot ] - 1;
+    }
+
+    XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME, XI_DATASTREAM_ID_TOO_LONG );
+    XI_CHECK_CND( table->id_count == XI_MAX_INTERNED_IDS, XI_ID_TABLE_FULL );
+
+    strcpy( table->ids[ table->id_count ], datastream_id );
+
+    table->hashes[ table->id_count ]    = hash;
+    table->slots[ slot ]                = ( uint16_t ) ( table->id_count + 1 );
+
+    return ( xi_id_handle_t ) table->id_count++;
+
+err_handling:
+    return -1;
+}
+
+xi_id_handle_t xi_id_lookup( const xi_id_table_t* table, const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( table != 0 );
+    assert( datastream_id != 0 );
+
+    return ( xi_id_handle_t ) table->slots[ xi_id_table_probe( table, datastream_id, xi_id_hash( datastream_id ) ) ] - 1;
+}
+
+const char* xi_id_string( const xi_id_table_t* table, xi_id_handle_t handle )
+{
+    // PRECONDITIONS
+    assert( table != 0 );
+    assert( handle >= 0 && ( size_t ) handle < table->id_count );
+
+    return table->ids[ handle ];
+}
+
+void xi_feed_index_build( xi_feed_index_t* index, const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( index != 0 );
+    assert( feed != 0 );
+
+    const size_t mask = XI_FEED_INDEX_SLOTS - 1;
+
+    memset( index->slots, 0, sizeof( index->slots ) );
+
+    for( size_t i = 0; i < ( XI_MIN( feed->datastream_count, ( size_t ) XI_MAX_DATASTREAMS ) ); ++i )
+    {
+        const char* id      = feed->datastreams[ i ].datastream_id;
+        const uint32_t hash = xi_id_hash( id );
+        size_t slot         = hash & mask;
+
+        index->hashes[ i ]  = hash;
+
+        // the repeated id keeps the slot of its first datastream
+        while( index->slots[ slot ] != 0
+               && !( index->hashes[ index->slots[ slot ] - 1 ] == hash
+                     && strcmp( feed->datastreams[ index->slots[ slot ] - 1 ].datastream_id, id ) == 0 ) )
+        {
+            slot = ( slot + 1 ) & mask;
+        }
+
+        if( index->slots[ slot ] == 0 )
+        {
+            index->slots[ slot ] = ( uint16_t ) ( i + 1 );
+        }
+    }
+}
+
+xi_datastream_t* xi_feed_find_datastream(
+          const xi_feed_index_t* index
+        , xi_feed_t* feed
+        , const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( index != 0 );
+    assert( feed != 0 );
+    assert( datastream_id != 0 );
+
+    const size_t mask   = XI_FEED_INDEX_SLOTS - 1;
+    const uint32_t hash = xi_id_hash( datastream_id );
+    size_t slot         = hash & mask;
+
+    for( ; index->slots[ slot ] != 0; slot = ( slot + 1 ) & mask )
+    {
+        const size_t i = index->slots[ slot ] - 1;
+
+        if( index->hashes[ i ] == hash && strcmp( feed->datastreams[ i ].datastream_id, datastream_id ) == 0 )
+        {
+            return &feed->datastreams[ i ];
+        }
+    }
+
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
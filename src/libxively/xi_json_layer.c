@@ -0,0 +1,1109 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xi_json_layer.h"
+#include "xively.h"
+
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_coroutine.h"
+#include "xi_generator.h"
+#include "xi_csv_layer.h"
+#include "xi_number_format.h"
+#include "xi_time.h"
+#include "xi_http_layer_constants.h"
+#include "xi_json_layer_data.h"
+#include "xi_layer_api.h"
+#include "xi_http_layer_input.h"
+#include "xi_feed_delta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// every char of the string value may become the \u00XX
+static char json_value_buffer[ XI_VALUE_STRING_MAX_SIZE * 6 ];
+
+static int json_encode_string(
+      char* buffer
+    , size_t buffer_size
+    , const char* str )
+{
+    static const char hex[] = "0123456789abcdef";
+
+    size_t size = 0;
+
+    for( ; *str; ++str )
+    {
+        const unsigned char c = ( unsigned char ) *str;
+
+        if( size + 7 > buffer_size )
+        {
+            buffer[ size ] = '\0';
+            return -1;
+        }
+
+        if( c == '"' || c == '\\' )
+        {
+            buffer[ size++ ] = '\\';
+            buffer[ size++ ] = ( char ) c;
+        }
+        else if( c < 0x20 )
+        {
+            memcpy( buffer + size, "\\u00", 4 );
+            size += 4;
+            buffer[ size++ ] = hex[ c >> 4 ];
+            buffer[ size++ ] = hex[ c & 15 ];
+        }
+        else
+        {
+            buffer[ size++ ] = ( char ) c;
+        }
+    }
+
+    buffer[ size ] = '\0';
+
+    return ( int ) size;
+}
+
+// the values are sent as strings so they read back as they are written whatever the type is
+inline static int json_encode_value(
+      char* buffer
+    , size_t buffer_size
+    , const xi_datapoint_t* p )
+{
+    // PRECONDITION
+    assert( buffer != 0 );
+    assert( buffer_size != 0 );
+    assert( p != 0 );
+
+    switch( p->value_type )
+    {
+        case XI_VALUE_TYPE_I32:
+            return xi_format_i32( buffer, buffer_size, p->value.i32_value );
+        case XI_VALUE_TYPE_F32:
+            return xi_format_f32( buffer, buffer_size, p->value.f32_value, XI_JSON_FLOAT_PRECISION );
+        case XI_VALUE_TYPE_STR:
+            return json_encode_string( buffer, buffer_size, p->value.str_value );
+        default:
+            buffer[ 0 ] = '\0';
+            return -1;
+    }
+}
+
+// "current_value":"...","at":"..." the at only if the datapoint has got the timestamp
+static const void* json_layer_data_generator_current_value(
+          const void* input
+        , short* state )
+{
+    // we expect input to be datapoint
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    const xi_datapoint_t* dp            = ( const xi_datapoint_t* ) ld->xi_get_datastream.value;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        gen_static_text( *state, "\"current_value\":\"" );
+
+        json_encode_value( json_value_buffer, sizeof( json_value_buffer ), dp );
+        gen_ptr_text( *state, json_value_buffer );
+
+        if( dp->timestamp.timestamp == 0 )
+        {
+            gen_static_text_and_exit( *state, "\"" );
+        }
+
+        gen_static_text( *state, "\",\"at\":\"" );
+
+        xi_format_iso8601( buffer_32, dp->timestamp.timestamp, dp->timestamp.micro );
+        gen_ptr_text( *state, buffer_32 );
+
+        gen_static_text_and_exit( *state, "\"" );
+
+    END_CORO()
+
+    return 0;
+}
+
+// {"at":"...","value":"..."} the element of the datapoints array
+static const void* json_layer_data_generator_datapoint_object(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    const xi_datapoint_t* dp            = ( const xi_datapoint_t* ) ld->xi_get_datastream.value;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        gen_static_text( *state, "{" );
+
+        if( dp->timestamp.timestamp != 0 )
+        {
+            gen_static_text( *state, "\"at\":\"" );
+
+            xi_format_iso8601( buffer_32, dp->timestamp.timestamp, dp->timestamp.micro );
+            gen_ptr_text( *state, buffer_32 );
+
+            gen_static_text( *state, "\"," );
+        }
+
+        gen_static_text( *state, "\"value\":\"" );
+
+        json_encode_value( json_value_buffer, sizeof( json_value_buffer ), dp );
+        gen_ptr_text( *state, json_value_buffer );
+
+        gen_static_text_and_exit( *state, "\"}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* json_layer_data_generator_datapoint(
+          const void* input
+        , short* state )
+{
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        gen_static_text( *state, "{" );
+
+        call_sub_gen( *state, input, json_layer_data_generator_current_value );
+
+        gen_static_text_and_exit( *state, "}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* json_layer_data_generator_datastream(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        gen_static_text( *state, "{\"version\":\"1.0.0\",\"datastreams\":[{\"id\":\"" );
+        gen_ptr_text( *state, ld->xi_create_datastream.datastream );
+        gen_static_text( *state, "\"," );
+
+        call_sub_gen( *state, ld, json_layer_data_generator_current_value );
+
+        gen_static_text_and_exit( *state, "}]}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* json_layer_data_generator_datapoints(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    static size_t i                     = 0;                                            // local global index required to be static cause used via the persistent for
+    static union http_union_data_t tmp_http_data;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        memset( &tmp_http_data, 0, sizeof( union http_union_data_t ) );
+
+        gen_static_text( *state, "{\"datapoints\":[" );
+
+        for( i = 0; i < ld->xi_post_datapoints.count; ++i )
+        {
+            if( i > 0 )
+            {
+                gen_static_text( *state, "," );
+            }
+
+            tmp_http_data.xi_get_datastream.value = &ld->xi_post_datapoints.values[ i ];
+
+            call_sub_gen( *state, &tmp_http_data, json_layer_data_generator_datapoint_object );
+        }
+
+        gen_static_text_and_exit( *state, "]}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* json_layer_data_generator_feed(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    const xi_feed_t* feed               = ( const xi_feed_t* ) ld->xi_get_feed.feed;
+    static unsigned char i              = 0;                                            // local global indexes required to be static cause used via the persistent for
+    static unsigned char j              = 0;
+    static unsigned char sent           = 0;                                            // the datastreams sent so far
+    static union http_union_data_t tmp_http_data;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        memset( &tmp_http_data, 0, sizeof( union http_union_data_t ) );
+
+        sent = 0;
+
+        gen_static_text( *state, "{\"version\":\"1.0.0\",\"datastreams\":[" );
+
+        for( i = 0; i < feed->datastream_count; ++i )
+        {
+            // the delta update leaves out the ones that have not changed
+            if( !xi_feed_delta_is_dirty( ld->xi_update_feed.delta, i ) )
+            {
+                continue;
+            }
+
+            if( sent++ > 0 )
+            {
+                gen_static_text( *state, "," );
+            }
+
+            gen_static_text( *state, "{\"id\":\"" );
+            gen_ptr_text( *state, feed->datastreams[ i ].datastream_id );
+            gen_static_text( *state, "\"," );
+
+            // the single datapoint becomes the current value, more of them are sent all
+            if( feed->datastreams[ i ].datapoint_count <= 1 )
+            {
+                tmp_http_data.xi_get_datastream.value = &feed->datastreams[ i ].datapoints[ 0 ];
+
+                call_sub_gen( *state, &tmp_http_data, json_layer_data_generator_current_value );
+            }
+            else
+            {
+                gen_static_text( *state, "\"datapoints\":[" );
+
+                for( j = 0; j < ( XI_MIN( feed->datastreams[ i ].datapoint_count, ( size_t ) XI_MAX_DATAPOINTS ) ); ++j )
+                {
+                    if( j > 0 )
+                    {
+                        gen_static_text( *state, "," );
+                    }
+
+                    tmp_http_data.xi_get_datastream.value = &feed->datastreams[ i ].datapoints[ j ];
+
+                    call_sub_gen( *state, &tmp_http_data, json_layer_data_generator_datapoint_object );
+                }
+
+                gen_static_text( *state, "]" );
+            }
+
+            gen_static_text( *state, "}" );
+        }
+
+        gen_static_text_and_exit( *state, "]}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* json_layer_data_generator_columns(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld   = ( const union http_union_data_t* ) input;
+    const xi_feed_columns_t* columns    = ld->xi_update_columns.columns;
+    static size_t i                     = 0;                                            // local global indexes required to be static cause used via the persistent for
+    static size_t j                     = 0;
+    static xi_datapoint_t tmp_datapoint;
+    static union http_union_data_t tmp_http_data;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        memset( &tmp_http_data, 0, sizeof( union http_union_data_t ) );
+
+        gen_static_text( *state, "{\"version\":\"1.0.0\",\"datastreams\":[" );
+
+        for( i = 0; i < columns->column_count; ++i )
+        {
+            if( i > 0 )
+            {
+                gen_static_text( *state, "," );
+            }
+
+            gen_static_text( *state, "{\"id\":\"" );
+            gen_ptr_text( *state, columns->columns[ i ].datastream_id );
+            gen_static_text( *state, "\",\"datapoints\":[" );
+
+            for( j = 0; j < columns->columns[ i ].sample_count; ++j )
+            {
+                if( j > 0 )
+                {
+                    gen_static_text( *state, "," );
+                }
+
+                tmp_http_data.xi_get_datastream.value = xi_feed_columns_datapoint( columns, &columns->columns[ i ], j, &tmp_datapoint );
+
+                call_sub_gen( *state, &tmp_http_data, json_layer_data_generator_datapoint_object );
+            }
+
+            gen_static_text( *state, "]}" );
+        }
+
+        gen_static_text_and_exit( *state, "]}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* json_layer_data_generator_arena_feed(
+          const void* input
+        , short* state )
+{
+    const union http_union_data_t* ld       = ( const union http_union_data_t* ) input;
+    static const xi_arena_datastream_t* ds  = 0;                                        // local global iterators required to be static cause used via the persistent for
+    static size_t j                         = 0;
+    static union http_union_data_t tmp_http_data;
+
+    ENABLE_GENERATOR();
+    BEGIN_CORO( *state )
+
+        memset( &tmp_http_data, 0, sizeof( union http_union_data_t ) );
+
+        gen_static_text( *state, "{\"version\":\"1.0.0\",\"datastreams\":[" );
+
+        for( ds = ld->xi_update_arena_feed.feed->datastreams; ds != 0; ds = ds->next )
+        {
+            if( ds != ld->xi_update_arena_feed.feed->datastreams )
+            {
+                gen_static_text( *state, "," );
+            }
+
+            gen_static_text( *state, "{\"id\":\"" );
+            gen_ptr_text( *state, ds->datastream_id );
+            gen_static_text( *state, "\"," );
+
+            // the single datapoint becomes the current value, more of them are sent all
+            if( ds->datapoint_count == 1 )
+            {
+                tmp_http_data.xi_get_datastream.value = &ds->datapoints[ 0 ];
+
+                call_sub_gen( *state, &tmp_http_data, json_layer_data_generator_current_value );
+            }
+            else
+            {
+                gen_static_text( *state, "\"datapoints\":[" );
+
+                for( j = 0; j < ds->datapoint_count; ++j )
+                {
+                    if( j > 0 )
+                    {
+                        gen_static_text( *state, "," );
+                    }
+
+                    tmp_http_data.xi_get_datastream.value = &ds->datapoints[ j ];
+
+                    call_sub_gen( *state, &tmp_http_data, json_layer_data_generator_datapoint_object );
+                }
+
+                gen_static_text( *state, "]" );
+            }
+
+            gen_static_text( *state, "}" );
+        }
+
+        gen_static_text_and_exit( *state, "]}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+typedef enum
+{
+      JSON_TOKEN_NONE = 0
+    , JSON_TOKEN_STRING
+    , JSON_TOKEN_ESCAPE
+    , JSON_TOKEN_UNICODE
+    , JSON_TOKEN_LITERAL
+} json_token_state_t;
+
+// the numbers, true, false and null
+static inline char json_is_literal_char( char c )
+{
+    return ( c >= '0' && c <= '9' ) || ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' )
+        || c == '-' || c == '+' || c == '.';
+}
+
+static inline int json_hex_digit( char c )
+{
+    if( c >= '0' && c <= '9' ) { return c - '0'; }
+    if( c >= 'a' && c <= 'f' ) { return c - 'a' + 10; }
+    if( c >= 'A' && c <= 'F' ) { return c - 'A' + 10; }
+
+    return -1;
+}
+
+// the token is cut at the XI_JSON_TOKEN_SIZE, the size saturates there to mark it
+static inline void json_token_append(
+      json_layer_data_t* json
+    , const char* src
+    , size_t size )
+{
+    if( json->token_size < XI_JSON_TOKEN_SIZE - 1 )
+    {
+        memcpy( json->token + json->token_size, src, XI_MIN( size, ( size_t ) XI_JSON_TOKEN_SIZE - 1 - json->token_size ) );
+    }
+
+    json->token_size = ( unsigned short ) ( XI_MIN( json->token_size + size, ( size_t ) XI_JSON_TOKEN_SIZE ) );
+}
+
+// utf-8 of the \u escape, the surrogate pairs are not joined
+static void json_token_append_code_point( json_layer_data_t* json, uint16_t code_point )
+{
+    char utf8[ 3 ];
+
+    if( code_point < 0x80 )
+    {
+        utf8[ 0 ] = ( char ) code_point;
+        json_token_append( json, utf8, 1 );
+    }
+    else if( code_point < 0x800 )
+    {
+        utf8[ 0 ] = ( char ) ( 0xC0 | ( code_point >> 6 ) );
+        utf8[ 1 ] = ( char ) ( 0x80 | ( code_point & 0x3F ) );
+        json_token_append( json, utf8, 2 );
+    }
+    else
+    {
+        utf8[ 0 ] = ( char ) ( 0xE0 | ( code_point >> 12 ) );
+        utf8[ 1 ] = ( char ) ( 0x80 | ( ( code_point >> 6 ) & 0x3F ) );
+        utf8[ 2 ] = ( char ) ( 0x80 | ( code_point & 0x3F ) );
+        json_token_append( json, utf8, 3 );
+    }
+}
+
+static inline char json_token_is_cut( const json_layer_data_t* json )
+{
+    return json->token_size == XI_JSON_TOKEN_SIZE;
+}
+
+static inline char json_key_is( const json_layer_data_t* json, const char* key )
+{
+    return strcmp( json->key, key ) == 0;
+}
+
+static inline char json_layer_in_object( const json_layer_data_t* json )
+{
+    return ( json->objects >> json->depth ) & 1;
+}
+
+static inline char json_layer_is_feed( const json_layer_data_t* json )
+{
+    return json->http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET
+        || json->http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET_ALL;
+}
+
+// the feed's datastream the one being read is stored at, 0 if it is handed over to the sink or dropped,
+// the datastream read stores all of its datapoints only if it has been asked to
+static xi_datastream_t* json_layer_target( const json_layer_data_t* json )
+{
+    const struct xi_get_feed_t* get_feed = &json->http_layer_input->http_union_data.xi_get_feed;
+
+    if( json->http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_GET )
+    {
+        return json->http_layer_input->http_union_data.xi_get_datastream.datapoints;
+    }
+
+    if( !json_layer_is_feed( json ) || get_feed->sink || json->datastream_count >= XI_MAX_DATASTREAMS )
+    {
+        return 0;
+    }
+
+    return &( ( xi_feed_t* ) get_feed->feed )->datastreams[ json->datastream_count ];
+}
+
+static signed char json_layer_decode_value( json_layer_data_t* json, xi_datapoint_t* dp )
+{
+    xi_stated_csv_decode_value_state_t st;
+    const_data_descriptor_t source = { json->token, json->token_size, json->token_size, 0 };
+
+    if( json_token_is_cut( json ) )
+    {
+        xi_set_err( XI_DATAPOINT_VALUE_BUFFER_OVERFLOW );
+        return -1;
+    }
+
+    if( json->token_size == 0 )
+    {
+        dp->value.str_value[ 0 ]    = '\0';
+        dp->value_type              = XI_VALUE_TYPE_STR;
+        return 0;
+    }
+
+    // the value is classified the same way the csv one is
+    memset( &st, 0, sizeof( xi_stated_csv_decode_value_state_t ) );
+
+    return xi_stated_csv_decode_value( &st, &source, dp, LAYER_HINT_NONE ) == 1 ? 0 : -1;
+}
+
+static void json_layer_decode_timestamp( json_layer_data_t* json, xi_datapoint_t* dp )
+{
+    // the other forms are left with the server-side timestamp
+    if( json->token_size == XI_ISO8601_SIZE )
+    {
+        xi_parse_iso8601( json->token, &dp->timestamp.timestamp, &dp->timestamp.micro );
+    }
+}
+
+static void json_layer_begin_datastream( json_layer_data_t* json )
+{
+    xi_datastream_t* target = json_layer_target( json );
+
+    memset( json->datastream_id, 0, sizeof( json->datastream_id ) );
+    memset( &json->current_value, 0, sizeof( xi_datapoint_t ) );
+
+    json->has_current_value = 0;
+    json->datapoint_count   = 0;
+
+    if( target )
+    {
+        memset( target, 0, sizeof( xi_datastream_t ) );
+    }
+}
+
+static void json_layer_end_datapoint( json_layer_data_t* json )
+{
+    const http_layer_input_t* input = json->http_layer_input;
+    xi_datastream_t* target         = json_layer_target( json );
+
+    json->datapoint_count += 1;
+
+    if( input->query_type == HTTP_LAYER_INPUT_DATASTREAM_HISTORY )
+    {
+        ( *input->http_union_data.xi_get_datastream_history.sink )(
+              input->http_union_data.xi_get_datastream_history.datastream
+            , &json->datapoint
+            , input->http_union_data.xi_get_datastream_history.sink_data );
+    }
+    else if( json_layer_is_feed( json ) && input->http_union_data.xi_get_feed.sink )
+    {
+        ( *input->http_union_data.xi_get_feed.sink )(
+              json->datastream_id
+            , &json->datapoint
+            , input->http_union_data.xi_get_feed.sink_data );
+    }
+    else if( target && target->datapoint_count < XI_MAX_DATAPOINTS )
+    {
+        target->datapoints[ target->datapoint_count++ ] = json->datapoint;
+    }
+}
+
+static void json_layer_end_datastream( json_layer_data_t* json )
+{
+    const http_layer_input_t* input = json->http_layer_input;
+    xi_datastream_t* target         = json_layer_target( json );
+
+    if( input->query_type == HTTP_LAYER_INPUT_DATASTREAM_GET )
+    {
+        if( target )
+        {
+            if( target->datapoint_count == 0 && json->has_current_value )
+            {
+                target->datapoints[ 0 ]     = json->current_value;
+                target->datapoint_count     = 1;
+            }
+        }
+        else if( json->has_current_value )
+        {
+            *( ( xi_datapoint_t* ) input->http_union_data.xi_get_datastream.value ) = json->current_value;
+        }
+
+        return;
+    }
+
+    if( !json_layer_is_feed( json ) )
+    {
+        return;
+    }
+
+    // the current value stands for the datastream that has come without the datapoints
+    if( input->http_union_data.xi_get_feed.sink )
+    {
+        if( json->datapoint_count == 0 && json->has_current_value )
+        {
+            ( *input->http_union_data.xi_get_feed.sink )(
+                  json->datastream_id
+                , &json->current_value
+                , input->http_union_data.xi_get_feed.sink_data );
+        }
+    }
+    else if( target )
+    {
+        memcpy( target->datastream_id, json->datastream_id, sizeof( target->datastream_id ) );
+
+        if( target->datapoint_count == 0 && json->has_current_value )
+        {
+            target->datapoints[ 0 ]     = json->current_value;
+            target->datapoint_count     = 1;
+        }
+
+        ( ( xi_feed_t* ) input->http_union_data.xi_get_feed.feed )->datastream_count = json->datastream_count + 1;
+    }
+    else
+    {
+        xi_debug_format( "datastream %s dropped, the feed is full", json->datastream_id );
+    }
+
+    json->datastream_count += 1;
+}
+
+static signed char json_layer_on_value( json_layer_data_t* json, char is_string )
+{
+    xi_datastream_t* target = json_layer_target( json );
+
+    if( json->depth == 0 )
+    {
+        xi_set_err( XI_JSON_DECODE_PARSER_ERROR );
+        return -1;
+    }
+
+    // the null leaves the value as it has been
+    if( !is_string && strcmp( json->token, "null" ) == 0 )
+    {
+        return 0;
+    }
+
+    if( json->datapoint_depth && json->depth == json->datapoint_depth )
+    {
+        if( json_key_is( json, "value" ) )
+        {
+            return json_layer_decode_value( json, &json->datapoint );
+        }
+
+        if( json_key_is( json, "at" ) )
+        {
+            json_layer_decode_timestamp( json, &json->datapoint );
+        }
+
+        return 0;
+    }
+
+    if( !json->datastream_depth || json->depth != json->datastream_depth )
+    {
+        return 0;
+    }
+
+    if( json_key_is( json, "id" ) )
+    {
+        if( json->token_size >= XI_MAX_DATASTREAM_NAME )
+        {
+            xi_set_err( XI_DATASTREAM_ID_TOO_LONG );
+            return -1;
+        }
+
+        memcpy( json->datastream_id, json->token, json->token_size + 1 );
+    }
+    else if( json_key_is( json, "current_value" ) )
+    {
+        json->has_current_value = 1;
+
+        return json_layer_decode_value( json, &json->current_value );
+    }
+    else if( json_key_is( json, "at" ) )
+    {
+        json_layer_decode_timestamp( json, &json->current_value );
+    }
+    else if( target && json_key_is( json, "min_value" ) )
+    {
+        return json_layer_decode_value( json, &target->min_value );
+    }
+    else if( target && json_key_is( json, "max_value" ) )
+    {
+        return json_layer_decode_value( json, &target->max_value );
+    }
+
+    return 0;
+}
+
+static signed char json_layer_on_token( json_layer_data_t* json, char is_string )
+{
+    json->token[ XI_MIN( json->token_size, ( unsigned short ) ( XI_JSON_TOKEN_SIZE - 1 ) ) ] = '\0';
+
+    if( is_string && json->expect_key && json_layer_in_object( json ) )
+    {
+        // the cut key does not match any of the ones that are read
+        memcpy( json->key, json->token, sizeof( json->key ) );
+        json->expect_key = 0;
+
+        return 0;
+    }
+
+    return json_layer_on_value( json, is_string );
+}
+
+static signed char json_layer_open_container( json_layer_data_t* json, char object )
+{
+    const unsigned char depth = json->depth + 1;
+
+    if( depth >= XI_JSON_MAX_DEPTH )
+    {
+        xi_set_err( XI_JSON_DECODE_PARSER_ERROR );
+        return -1;
+    }
+
+    if( object )
+    {
+        const char is_datastream = json_layer_is_feed( json )
+            ? json->datastreams_depth && depth == json->datastreams_depth + 1
+            : depth == 1;
+
+        if( !json->datastream_depth && is_datastream )
+        {
+            json->datastream_depth = depth;
+            json_layer_begin_datastream( json );
+        }
+        else if( json->datapoints_depth && !json->datapoint_depth && depth == json->datapoints_depth + 1 )
+        {
+            json->datapoint_depth = depth;
+            memset( &json->datapoint, 0, sizeof( xi_datapoint_t ) );
+        }
+
+        json->objects |= ( uint32_t ) 1 << depth;
+    }
+    else
+    {
+        if( json_layer_is_feed( json ) && depth == 2 && json_layer_in_object( json ) && json_key_is( json, "datastreams" ) )
+        {
+            json->datastreams_depth = depth;
+        }
+        else if( json->datastream_depth && depth == json->datastream_depth + 1 && json_key_is( json, "datapoints" ) )
+        {
+            json->datapoints_depth = depth;
+        }
+
+        json->objects &= ~( ( uint32_t ) 1 << depth );
+    }
+
+    json->depth         = depth;
+    json->expect_key    = object;
+
+    return 0;
+}
+
+// returns 1 once the root is closed
+static signed char json_layer_close_container( json_layer_data_t* json, char object )
+{
+    if( json->depth == 0 || json_layer_in_object( json ) != object )
+    {
+        xi_set_err( XI_JSON_DECODE_PARSER_ERROR );
+        return -1;
+    }
+
+    if( json->depth == json->datapoint_depth )
+    {
+        json_layer_end_datapoint( json );
+        json->datapoint_depth = 0;
+    }
+    else if( json->depth == json->datastream_depth )
+    {
+        json_layer_end_datastream( json );
+        json->datastream_depth = 0;
+    }
+    else if( json->depth == json->datapoints_depth )
+    {
+        json->datapoints_depth = 0;
+    }
+    else if( json->depth == json->datastreams_depth )
+    {
+        json->datastreams_depth = 0;
+    }
+
+    json->depth         -= 1;
+    json->expect_key    = 0;
+
+    return json->depth == 0 ? 1 : 0;
+}
+
+// runs the tokenizer over the data, returns 1 at the end of the document, 0 if it needs more and -1 on error
+static signed char json_layer_tokenize( json_layer_data_t* json, const_data_descriptor_t* data )
+{
+    signed char ret = 0;
+
+    while( ret == 0 && data->curr_pos < data->real_size )
+    {
+        const char c = data->data_ptr[ data->curr_pos ];
+
+        switch( json->token_state )
+        {
+            case JSON_TOKEN_NONE:
+                data->curr_pos += 1;
+
+                switch( c )
+                {
+                    case ' ': case '\t': case '\r': case '\n':
+                        break;
+                    case '{':
+                    case '[':
+                        ret = json_layer_open_container( json, c == '{' );
+                        break;
+                    case '}':
+                    case ']':
+                        ret = json_layer_close_container( json, c == '}' );
+                        break;
+                    case ':':
+                        json->expect_key = 0;
+                        break;
+                    case ',':
+                        json->expect_key = json_layer_in_object( json );
+                        break;
+                    case '"':
+                        json->token_size    = 0;
+                        json->token_state   = JSON_TOKEN_STRING;
+                        break;
+                    default:
+                        if( !json_is_literal_char( c ) )
+                        {
+                            xi_set_err( XI_JSON_DECODE_PARSER_ERROR );
+                            ret = -1;
+                            break;
+                        }
+
+                        json->token_size    = 0;
+                        json->token_state   = JSON_TOKEN_LITERAL;
+                        json_token_append( json, &c, 1 );
+                }
+                break;
+            case JSON_TOKEN_STRING:
+                {
+                    // the plain part of the string is copied at once
+                    const char* begin   = data->data_ptr + data->curr_pos;
+                    const size_t left   = data->real_size - data->curr_pos;
+                    size_t size         = 0;
+
+                    while( size < left && begin[ size ] != '"' && begin[ size ] != '\\' )
+                    {
+                        ++size;
+                    }
+
+                    json_token_append( json, begin, size );
+                    data->curr_pos += size;
+
+                    if( size == left )
+                    {
+                        break;
+                    }
+
+                    data->curr_pos += 1;
+
+                    if( begin[ size ] == '\\' )
+                    {
+                        json->token_state = JSON_TOKEN_ESCAPE;
+                        break;
+                    }
+
+                    json->token_state   = JSON_TOKEN_NONE;
+                    ret                 = json_layer_on_token( json, 1 );
+                }
+                break;
+            case JSON_TOKEN_ESCAPE:
+                {
+                    static const char escaped[]     = "\"\\/bfnrt";
+                    static const char unescaped[]   = "\"\\/\b\f\n\r\t";
+                    const char* found               = c ? strchr( escaped, c ) : 0;
+
+                    data->curr_pos      += 1;
+                    json->token_state   = JSON_TOKEN_STRING;
+
+                    if( found )
+                    {
+                        json_token_append( json, &unescaped[ found - escaped ], 1 );
+                    }
+                    else if( c == 'u' )
+                    {
+                        json->token_state       = JSON_TOKEN_UNICODE;
+                        json->unicode_digits    = 4;
+                        json->code_point        = 0;
+                    }
+                    else
+                    {
+                        xi_set_err( XI_JSON_DECODE_PARSER_ERROR );
+                        ret = -1;
+                    }
+                }
+                break;
+            case JSON_TOKEN_UNICODE:
+                {
+                    const int digit = json_hex_digit( c );
+
+                    if( digit < 0 )
+                    {
+                        xi_set_err( XI_JSON_DECODE_PARSER_ERROR );
+                        ret = -1;
+                        break;
+                    }
+
+                    data->curr_pos      += 1;
+                    json->code_point    = ( uint16_t ) ( ( json->code_point << 4 ) | digit );
+
+                    if( --json->unicode_digits == 0 )
+                    {
+                        json_token_append_code_point( json, json->code_point );
+                        json->token_state = JSON_TOKEN_STRING;
+                    }
+                }
+                break;
+            case JSON_TOKEN_LITERAL:
+                if( json_is_literal_char( c ) )
+                {
+                    json_token_append( json, &c, 1 );
+                    data->curr_pos += 1;
+                    break;
+                }
+
+                // the char after the literal is read as the next token
+                json->token_state   = JSON_TOKEN_NONE;
+                ret                 = json_layer_on_token( json, 0 );
+                break;
+        }
+    }
+
+    return ret;
+}
+
+layer_state_t json_layer_parse(
+        json_layer_data_t* json_layer_data
+      , const_data_descriptor_t* data
+      , const layer_hint_t hint )
+{
+    signed char ret = 0;
+
+    BEGIN_CORO( json_layer_data->decode_state )
+
+    // the beginning of the response, everything but the request is cleared
+    {
+        xi_response_t* response                 = json_layer_data->response;
+        http_layer_input_t* http_layer_input    = json_layer_data->http_layer_input;
+
+        memset( json_layer_data, 0, sizeof( json_layer_data_t ) );
+
+        json_layer_data->response           = response;
+        json_layer_data->http_layer_input   = http_layer_input;
+
+        if( json_layer_is_feed( json_layer_data ) && !http_layer_input->http_union_data.xi_get_feed.sink )
+        {
+            ( ( xi_feed_t* ) http_layer_input->http_union_data.xi_get_feed.feed )->datastream_count = 0;
+        }
+    }
+
+    // the tokens and the document may span any number of reads
+    while( ( ret = json_layer_tokenize( json_layer_data, data ) ) == 0 && hint == LAYER_HINT_MORE_DATA )
+    {
+        YIELD( json_layer_data->decode_state, LAYER_STATE_WANT_READ );
+        ret = 0;
+    }
+
+    if( ret == 0 )
+    {
+        xi_debug_logger( "the json document is not complete" );
+        xi_set_err( XI_JSON_DECODE_PARSER_ERROR );
+    }
+
+    EXIT( json_layer_data->decode_state, ( ret == 1 ? LAYER_STATE_OK : LAYER_STATE_ERROR ) );
+
+    END_CORO()
+
+    return LAYER_STATE_ERROR;
+}
+
+layer_state_t json_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    http_layer_input_t* http_layer_input    = ( http_layer_input_t* ) ( data );
+    json_layer_data_t* json_layer_data      = ( json_layer_data_t* ) context->self->user_data;
+
+    // the response to this request is read from the beginning
+    json_layer_data->http_layer_input   = http_layer_input;
+    json_layer_data->decode_state       = 0;
+
+    switch( http_layer_input->query_type )
+    {
+        case HTTP_LAYER_INPUT_DATASTREAM_DELETE:
+        case HTTP_LAYER_INPUT_DATAPOINT_DELETE:
+        case HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE:
+        case HTTP_LAYER_INPUT_FEED_GET:
+        case HTTP_LAYER_INPUT_FEED_GET_ALL:
+        case HTTP_LAYER_INPUT_DATASTREAM_GET:
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
+            http_layer_input->payload_generator = 0;
+            break;
+        case HTTP_LAYER_INPUT_DATASTREAM_UPDATE:
+            http_layer_input->payload_generator = &json_layer_data_generator_datapoint;
+            break;
+        case HTTP_LAYER_INPUT_DATASTREAM_CREATE:
+            http_layer_input->payload_generator = &json_layer_data_generator_datastream;
+            break;
+        case HTTP_LAYER_INPUT_FEED_UPDATE:
+            http_layer_input->payload_generator = &json_layer_data_generator_feed;
+            break;
+        case HTTP_LAYER_INPUT_DATAPOINTS_POST:
+            http_layer_input->payload_generator = &json_layer_data_generator_datapoints;
+            break;
+        case HTTP_LAYER_INPUT_COLUMNS_UPDATE:
+            http_layer_input->payload_generator = &json_layer_data_generator_columns;
+            break;
+        case HTTP_LAYER_INPUT_ARENA_FEED_UPDATE:
+            http_layer_input->payload_generator = &json_layer_data_generator_arena_feed;
+            break;
+        default:
+            return LAYER_STATE_ERROR;
+    };
+
+    return CALL_ON_PREV_DATA_READY( context->self, ( void* ) http_layer_input, hint );
+}
+
+layer_state_t json_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    json_layer_data_t* json_layer_data = ( json_layer_data_t* ) context->self->user_data;
+
+    switch( json_layer_data->http_layer_input->query_type )
+    {
+        case HTTP_LAYER_INPUT_DATASTREAM_GET:
+        case HTTP_LAYER_INPUT_FEED_GET:
+        case HTTP_LAYER_INPUT_FEED_GET_ALL:
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
+            return json_layer_parse( json_layer_data, ( const_data_descriptor_t* ) data, hint );
+        default:
+            break;
+    }
+
+    return LAYER_STATE_OK;
+}
+
+layer_state_t json_layer_close(
+    layer_connectivity_t* context )
+{
+    return CALL_ON_PREV_CLOSE( context->self );
+}
+
+layer_state_t json_layer_on_close(
+    layer_connectivity_t* context )
+{
+    XI_UNUSED( context );
+
+    return LAYER_STATE_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
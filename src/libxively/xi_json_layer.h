@@ -0,0 +1,66 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_JSON_LAYER_H__
+#define __XI_JSON_LAYER_H__
+
+#include "xi_layer.h"
+#include "xi_common.h"
+#include "xively.h"
+#include "xi_json_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+layer_state_t json_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t json_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t json_layer_close(
+    layer_connectivity_t* context );
+
+layer_state_t json_layer_on_close(
+    layer_connectivity_t* context );
+
+// reads the body of the response to the json_layer_data->http_layer_input request
+layer_state_t json_layer_parse(
+        json_layer_data_t* json_layer_data
+      , const_data_descriptor_t* data
+      , const layer_hint_t hint );
+
+const void* json_layer_data_generator_datapoint(
+          const void* input
+        , short* state );
+
+const void* json_layer_data_generator_datastream(
+          const void* input
+        , short* state );
+
+const void* json_layer_data_generator_feed(
+          const void* input
+        , short* state );
+
+const void* json_layer_data_generator_datapoints(
+          const void* input
+        , short* state );
+
+const void* json_layer_data_generator_columns(
+          const void* input
+        , short* state );
+
+const void* json_layer_data_generator_arena_feed(
+          const void* input
+        , short* state );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_JSON_LAYER_H__
@@ -0,0 +1,57 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_JSON_LAYER_DATA_H__
+#define __XI_JSON_LAYER_DATA_H__
+
+#include <stdint.h>
+
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the longest token kept, the longer ones are cut as they are of no interest
+#define XI_JSON_TOKEN_SIZE  XI_VALUE_STRING_MAX_SIZE
+
+// the bits of the container stack
+#define XI_JSON_MAX_DEPTH   32
+
+typedef struct
+{
+    xi_response_t*          response;           // first, see xi_data_layer_data.h
+    http_layer_input_t*     http_layer_input;
+    unsigned short          decode_state;
+
+    // the tokenizer, the token is read byte by byte so it may span the reads
+    unsigned char           token_state;
+    unsigned char           unicode_digits;     // the hex digits of the \u escape left
+    uint16_t                code_point;
+    unsigned short          token_size;         // may be over the XI_JSON_TOKEN_SIZE
+    char                    token[ XI_JSON_TOKEN_SIZE ];
+
+    // the document, the depths are of the containers that are being read
+    unsigned char           depth;
+    uint32_t                objects;            // bit per depth, set for the objects
+    char                    expect_key;
+    char                    key[ XI_JSON_TOKEN_SIZE ];
+    unsigned char           datastreams_depth;
+    unsigned char           datastream_depth;
+    unsigned char           datapoints_depth;
+    unsigned char           datapoint_depth;
+
+    // the datastream that is being read
+    unsigned short          datastream_count;
+    char                    datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    char                    has_current_value;
+    unsigned short          datapoint_count;
+    xi_datapoint_t          current_value;
+    xi_datapoint_t          datapoint;
+} json_layer_data_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_JSON_LAYER_DATA_H__
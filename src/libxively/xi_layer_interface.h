@@ -30,7 +30,8 @@ typedef enum
 typedef enum
 {
     LAYER_HINT_NONE = 0,    // no hint, default behaviour
-    LAYER_HINT_MORE_DATA    // more data will come in the future do not change the mode (that will happen on default)
+    LAYER_HINT_MORE_DATA,   // more data will come in the future do not change the mode (that will happen on default)
+    LAYER_HINT_NO_WAIT      // read only what has already arrived
 } layer_hint_t;
 
 typedef layer_state_t ( data_ready_t )      ( layer_connectivity_t* context, const void* data, const layer_hint_t hint );
@@ -0,0 +1,714 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xi_layer_api.h"
+#include "xi_common.h"
+#include "xi_mqtt_layer.h"
+#include "xi_mqtt_layer_data.h"
+#include "xi_generator.h"
+#include "xi_resource.h"
+#include "xi_coroutine.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// control packet types
+#define XI_MQTT_CONNECT         0x10
+#define XI_MQTT_CONNACK         0x20
+#define XI_MQTT_PUBLISH         0x30
+#define XI_MQTT_PUBACK          0x40
+#define XI_MQTT_SUBSCRIBE       0x82
+#define XI_MQTT_SUBACK          0x90
+#define XI_MQTT_PINGREQ         0xC0
+#define XI_MQTT_PINGRESP        0xD0
+#define XI_MQTT_DISCONNECT      0xE0
+
+enum
+{
+      XI_MQTT_WAITING_NONE = 0
+    , XI_MQTT_WAITING_CONNACK
+    , XI_MQTT_WAITING_PUBACK
+    , XI_MQTT_WAITING_SUBACK
+    , XI_MQTT_WAITING_PUBLISH
+};
+
+enum
+{
+      XI_MQTT_PACKET_TYPE = 0
+    , XI_MQTT_PACKET_LENGTH
+    , XI_MQTT_PACKET_BODY
+    , XI_MQTT_PACKET_TOPIC_SIZE
+    , XI_MQTT_PACKET_TOPIC
+    , XI_MQTT_PACKET_ID
+    , XI_MQTT_PACKET_PAYLOAD
+};
+
+static inline layer_state_t mqtt_layer_send(
+      layer_connectivity_t* context
+    , const void* data
+    , size_t size )
+{
+    const const_data_descriptor_t desc = { ( const char* ) data, size, size, 0 };
+
+    return CALL_ON_PREV_DATA_READY( context->self, ( const void* ) &desc, LAYER_HINT_NONE );
+}
+
+// writes the fixed header and returns its size
+static size_t mqtt_layer_fixed_header(
+      unsigned char* dst
+    , unsigned char type
+    , uint32_t remaining )
+{
+    size_t size = 0;
+
+    dst[ size++ ] = type;
+
+    do
+    {
+        dst[ size ]     = remaining & 0x7F;
+        remaining     >>= 7;
+        dst[ size++ ]  |= remaining ? 0x80 : 0;
+    } while( remaining );
+
+    return size;
+}
+
+static inline size_t mqtt_layer_put_u16( unsigned char* dst, uint16_t value )
+{
+    dst[ 0 ] = ( unsigned char ) ( value >> 8 );
+    dst[ 1 ] = ( unsigned char ) value;
+
+    return 2;
+}
+
+static inline uint16_t mqtt_layer_next_packet_id( mqtt_layer_data_t* mqtt_layer_data )
+{
+    if( ++mqtt_layer_data->next_packet_id == 0 )
+    {
+        mqtt_layer_data->next_packet_id = 1;
+    }
+
+    return mqtt_layer_data->next_packet_id;
+}
+
+// the topic is the resource path without the query string
+static size_t mqtt_layer_make_topic( char* dst, const http_layer_input_t* http_layer_input )
+{
+    short gstate    = 0;
+    size_t size     = 0;
+    char query      = 0;
+
+    while( gstate != 1 )
+    {
+        const const_data_descriptor_t* data
+            = ( const const_data_descriptor_t* ) xi_resource_path_generator( http_layer_input, &gstate );
+
+        for( size_t i = 0; data && i < data->real_size && !query; ++i )
+        {
+            query = data->data_ptr[ i ] == '?';
+
+            if( !query && size < XI_MQTT_TOPIC_SIZE - 1 )
+            {
+                dst[ size++ ] = data->data_ptr[ i ];
+            }
+        }
+    }
+
+    dst[ size ] = '\0';
+
+    return size;
+}
+
+// builds the QoS 1 publish in the inflight slot and sends it at once
+static layer_state_t mqtt_layer_publish_kept(
+      layer_connectivity_t* context
+    , mqtt_layer_data_t* mqtt_layer_data
+    , const http_layer_input_t* http_layer_input
+    , const unsigned char* header
+    , size_t header_size
+    , uint16_t packet_id )
+{
+    mqtt_inflight_t* inflight   = &mqtt_layer_data->inflight[ mqtt_layer_data->inflight_count ];
+    const size_t topic_size     = strlen( mqtt_layer_data->topic );
+    unsigned char* dst          = inflight->packet;
+
+    memcpy( dst, header, header_size );
+    dst += header_size;
+    memcpy( dst, mqtt_layer_data->topic, topic_size );
+    dst += topic_size;
+    dst += mqtt_layer_put_u16( dst, packet_id );
+
+    short gstate = 0;
+
+    while( gstate != 1 )
+    {
+        const const_data_descriptor_t* data = ( const const_data_descriptor_t* )
+            ( *http_layer_input->payload_generator )( &http_layer_input->http_union_data, &gstate );
+
+        if( data )
+        {
+            memcpy( dst, data->data_ptr, data->real_size );
+            dst += data->real_size;
+        }
+    }
+
+    inflight->packet_id = packet_id;
+    inflight->size      = ( uint16_t ) ( dst - inflight->packet );
+
+    layer_state_t state = mqtt_layer_send( context, inflight->packet, inflight->size );
+
+    // the failure is reported, so the publish is not kept to be sent twice
+    if( state != LAYER_STATE_OK )
+    {
+        return state;
+    }
+
+    // the window is full, wait till the broker acknowledges any of them
+    if( ++mqtt_layer_data->inflight_count == XI_MQTT_MAX_INFLIGHT )
+    {
+        mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_PUBACK;
+        mqtt_layer_data->waiting_id     = 0;
+        return LAYER_STATE_OK;
+    }
+
+    mqtt_layer_data->response->http.http_status = 202;
+
+    return LAYER_STATE_OK;
+}
+
+static layer_state_t mqtt_layer_publish(
+      layer_connectivity_t* context
+    , mqtt_layer_data_t* mqtt_layer_data
+    , const http_layer_input_t* http_layer_input )
+{
+    const unsigned char qos     = http_layer_input->xi_context->mqtt_qos ? 1 : 0;
+    const size_t topic_size     = mqtt_layer_make_topic( mqtt_layer_data->topic, http_layer_input );
+    const size_t payload_size   = xi_generator_length( http_layer_input->payload_generator, &http_layer_input->http_union_data );
+    const uint16_t packet_id    = qos ? mqtt_layer_next_packet_id( mqtt_layer_data ) : 0;
+
+    unsigned char header[ 9 ];
+    size_t header_size = mqtt_layer_fixed_header(
+          header, XI_MQTT_PUBLISH | ( qos << 1 )
+        , 2 + topic_size + ( qos ? 2 : 0 ) + payload_size );
+
+    header_size += mqtt_layer_put_u16( header + header_size, ( uint16_t ) topic_size );
+
+    const size_t packet_size = header_size + topic_size + ( qos ? 2 : 0 ) + payload_size;
+
+    // the whole packet is kept so that it can be sent again after the reconnection
+    if( qos && packet_size <= XI_MQTT_INFLIGHT_PACKET_SIZE && mqtt_layer_data->inflight_count < XI_MQTT_MAX_INFLIGHT )
+    {
+        return mqtt_layer_publish_kept( context, mqtt_layer_data, http_layer_input, header, header_size, packet_id );
+    }
+
+    layer_state_t state = mqtt_layer_send( context, header, header_size );
+
+    if( state == LAYER_STATE_OK )
+    {
+        state = mqtt_layer_send( context, mqtt_layer_data->topic, topic_size );
+    }
+
+    if( state == LAYER_STATE_OK && qos )
+    {
+        mqtt_layer_put_u16( header, packet_id );
+        state = mqtt_layer_send( context, header, 2 );
+    }
+
+    // stream the payload
+    short gstate = 0;
+
+    while( state == LAYER_STATE_OK && gstate != 1 )
+    {
+        const const_data_descriptor_t* data = ( const const_data_descriptor_t* )
+            ( *http_layer_input->payload_generator )( &http_layer_input->http_union_data, &gstate );
+
+        if( data )
+        {
+            state = CALL_ON_PREV_DATA_READY( context->self, ( const void* ) data, LAYER_HINT_NONE );
+        }
+    }
+
+    if( state != LAYER_STATE_OK )
+    {
+        return state;
+    }
+
+    // the one that is not kept is not lost with the connection only once it's acknowledged
+    if( qos )
+    {
+        mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_PUBACK;
+        mqtt_layer_data->waiting_id     = packet_id;
+        return LAYER_STATE_OK;
+    }
+
+    // nothing to wait for, the response is ready
+    mqtt_layer_data->response->http.http_status = 202;
+
+    return LAYER_STATE_OK;
+}
+
+// the broker answers the ping after all it has sent before, the retained message of the
+// new subscription included, so the get ends with its answer if nothing has come on the topic
+static inline layer_state_t mqtt_layer_ping(
+      layer_connectivity_t* context
+    , mqtt_layer_data_t* mqtt_layer_data
+    , const unsigned char* pingreq
+    , size_t size )
+{
+    const layer_state_t state = mqtt_layer_send( context, pingreq, size );
+
+    if( state == LAYER_STATE_OK )
+    {
+        mqtt_layer_data->pings += 1;
+    }
+
+    return state;
+}
+
+static layer_state_t mqtt_layer_subscribe(
+      layer_connectivity_t* context
+    , mqtt_layer_data_t* mqtt_layer_data
+    , const http_layer_input_t* http_layer_input )
+{
+    static const unsigned char pingreq[] = { XI_MQTT_PINGREQ, 0 };
+
+    const size_t topic_size = mqtt_layer_make_topic( mqtt_layer_data->topic, http_layer_input );
+
+    mqtt_layer_data->waiting_for = XI_MQTT_WAITING_PUBLISH;
+    mqtt_layer_data->subscribing = 0;
+
+    for( unsigned char i = 0; i < mqtt_layer_data->subscription_count; ++i )
+    {
+        if( strcmp( mqtt_layer_data->subscriptions[ i ], mqtt_layer_data->topic ) == 0 )
+        {
+            return mqtt_layer_ping( context, mqtt_layer_data, pingreq, sizeof( pingreq ) );
+        }
+    }
+
+    mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_SUBACK;
+    mqtt_layer_data->waiting_id     = mqtt_layer_next_packet_id( mqtt_layer_data );
+    mqtt_layer_data->subscribing    = 1;
+
+    unsigned char header[ 9 ];
+    size_t header_size = mqtt_layer_fixed_header( header, XI_MQTT_SUBSCRIBE, 2 + 2 + topic_size + 1 );
+
+    header_size += mqtt_layer_put_u16( header + header_size, mqtt_layer_data->waiting_id );
+    header_size += mqtt_layer_put_u16( header + header_size, ( uint16_t ) topic_size );
+
+    layer_state_t state = mqtt_layer_send( context, header, header_size );
+
+    if( state == LAYER_STATE_OK )
+    {
+        state = mqtt_layer_send( context, mqtt_layer_data->topic, topic_size );
+    }
+
+    if( state == LAYER_STATE_OK )
+    {
+        header[ 0 ] = http_layer_input->xi_context->mqtt_qos ? 1 : 0;
+        state = mqtt_layer_send( context, header, 1 );
+    }
+
+    return state == LAYER_STATE_OK ? mqtt_layer_ping( context, mqtt_layer_data, pingreq, sizeof( pingreq ) ) : state;
+}
+
+layer_state_t mqtt_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    mqtt_layer_data_t* mqtt_layer_data          = ( mqtt_layer_data_t* ) context->self->user_data;
+    const http_layer_input_t* http_layer_input  = ( const http_layer_input_t* ) data;
+
+    if( !mqtt_layer_data->connected )
+    {
+        return LAYER_STATE_ERROR;
+    }
+
+    mqtt_layer_data->waiting_for = XI_MQTT_WAITING_NONE;
+
+    switch( http_layer_input->query_type )
+    {
+        case HTTP_LAYER_INPUT_DATASTREAM_UPDATE:
+        case HTTP_LAYER_INPUT_FEED_UPDATE:
+        case HTTP_LAYER_INPUT_COLUMNS_UPDATE:
+        case HTTP_LAYER_INPUT_ARENA_FEED_UPDATE:
+        case HTTP_LAYER_INPUT_DATAPOINTS_POST:
+            return mqtt_layer_publish( context, mqtt_layer_data, http_layer_input );
+        case HTTP_LAYER_INPUT_DATASTREAM_GET:
+        case HTTP_LAYER_INPUT_FEED_GET:
+            return mqtt_layer_subscribe( context, mqtt_layer_data, http_layer_input );
+        default:
+            xi_debug_logger( "query type not supported over mqtt" );
+            return LAYER_STATE_ERROR;
+    }
+}
+
+// called when the whole packet has been received, returns LAYER_STATE_OK
+// if that was the packet the current request has been waiting for
+static layer_state_t mqtt_layer_on_packet_end(
+      layer_connectivity_t* context
+    , mqtt_layer_data_t* mqtt_layer_data )
+{
+    const unsigned char* variable   = mqtt_layer_data->variable;
+    const uint16_t packet_id        = ( uint16_t ) ( ( variable[ 0 ] << 8 ) | variable[ 1 ] );
+    xi_response_t* response         = mqtt_layer_data->response;
+
+    mqtt_layer_data->packet_state   = XI_MQTT_PACKET_TYPE;
+
+    switch( mqtt_layer_data->packet_type & 0xF0 )
+    {
+        case XI_MQTT_CONNACK:
+            mqtt_layer_data->connack_received   = 1;
+            mqtt_layer_data->connack_code       = variable[ 1 ];
+            return LAYER_STATE_OK;
+        case XI_MQTT_PUBACK:
+            for( unsigned char i = 0; i < mqtt_layer_data->inflight_count; ++i )
+            {
+                if( mqtt_layer_data->inflight[ i ].packet_id == packet_id )
+                {
+                    mqtt_inflight_t* last = &mqtt_layer_data->inflight[ --mqtt_layer_data->inflight_count ];
+
+                    if( last != &mqtt_layer_data->inflight[ i ] )
+                    {
+                        memcpy( &mqtt_layer_data->inflight[ i ], last, sizeof( mqtt_inflight_t ) );
+                    }
+                    break;
+                }
+            }
+
+            if( mqtt_layer_data->waiting_for == XI_MQTT_WAITING_PUBACK
+                && ( mqtt_layer_data->waiting_id == 0
+                     ? mqtt_layer_data->inflight_count < XI_MQTT_MAX_INFLIGHT
+                     : mqtt_layer_data->waiting_id == packet_id ) )
+            {
+                mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_NONE;
+                response->http.http_status      = 200;
+                return LAYER_STATE_OK;
+            }
+            break;
+        case XI_MQTT_SUBACK:
+            if( mqtt_layer_data->waiting_for != XI_MQTT_WAITING_SUBACK
+                || mqtt_layer_data->waiting_id != packet_id )
+            {
+                break;
+            }
+
+            if( variable[ 2 ] == 0x80 )
+            {
+                mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_NONE;
+                response->http.http_status      = 403;
+                return LAYER_STATE_OK;
+            }
+
+            if( mqtt_layer_data->subscription_count < XI_MQTT_MAX_SUBSCRIPTIONS )
+            {
+                strcpy( mqtt_layer_data->subscriptions[ mqtt_layer_data->subscription_count++ ], mqtt_layer_data->topic );
+            }
+
+            mqtt_layer_data->waiting_for = XI_MQTT_WAITING_PUBLISH;
+            break;
+        case XI_MQTT_PINGRESP:
+            if( mqtt_layer_data->pings )
+            {
+                mqtt_layer_data->pings -= 1;
+            }
+
+            // the answer of the last ping, nothing has come on the topic before it
+            if( mqtt_layer_data->waiting_for == XI_MQTT_WAITING_PUBLISH && mqtt_layer_data->pings == 0 )
+            {
+                mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_NONE;
+                response->http.http_status      = mqtt_layer_data->subscribing ? 404 : 304;
+                return LAYER_STATE_OK;
+            }
+            break;
+        case XI_MQTT_PUBLISH:
+            if( mqtt_layer_data->packet_type & 0x06 )
+            {
+                unsigned char puback[ 4 ] = { XI_MQTT_PUBACK, 2, variable[ 0 ], variable[ 1 ] };
+                mqtt_layer_send( context, puback, sizeof( puback ) );
+            }
+
+            if( mqtt_layer_data->waiting_for == XI_MQTT_WAITING_PUBLISH
+                && strcmp( mqtt_layer_data->packet_topic, mqtt_layer_data->topic ) == 0 )
+            {
+                mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_NONE;
+                response->http.http_status      = 200;
+                return LAYER_STATE_OK;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return LAYER_STATE_WANT_READ;
+}
+
+layer_state_t mqtt_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    mqtt_layer_data_t* mqtt_layer_data  = ( mqtt_layer_data_t* ) context->self->user_data;
+    const_data_descriptor_t* buffer     = ( const_data_descriptor_t* ) data;
+    layer_state_t result                = LAYER_STATE_WANT_READ;
+
+    // the whole buffer is always processed as it may hold more packets,
+    // a partial one is finished with the next read
+    while( buffer->curr_pos < buffer->real_size )
+    {
+        if( mqtt_layer_data->packet_state == XI_MQTT_PACKET_PAYLOAD )
+        {
+            const uint32_t size = XI_MIN(
+                  ( uint32_t ) ( buffer->real_size - buffer->curr_pos )
+                , mqtt_layer_data->remaining );
+            const char matched  = mqtt_layer_data->waiting_for == XI_MQTT_WAITING_PUBLISH
+                && strcmp( mqtt_layer_data->packet_topic, mqtt_layer_data->topic ) == 0;
+
+            mqtt_layer_data->remaining -= size;
+
+            if( matched )
+            {
+                const_data_descriptor_t payload = { buffer->data_ptr + buffer->curr_pos, ( unsigned short ) size, ( unsigned short ) size, 0 };
+
+                layer_state_t state = CALL_ON_NEXT_ON_DATA_READY(
+                      context->self
+                    , ( const void* ) &payload
+                    , mqtt_layer_data->remaining ? LAYER_HINT_MORE_DATA : LAYER_HINT_NONE );
+
+                if( state == LAYER_STATE_ERROR )
+                {
+                    return state;
+                }
+            }
+
+            buffer->curr_pos += size;
+        }
+        else
+        {
+            const unsigned char c = ( unsigned char ) buffer->data_ptr[ buffer->curr_pos++ ];
+
+            if( mqtt_layer_data->packet_state == XI_MQTT_PACKET_TYPE )
+            {
+                mqtt_layer_data->packet_type    = c;
+                mqtt_layer_data->packet_state   = XI_MQTT_PACKET_LENGTH;
+                mqtt_layer_data->remaining      = 0;
+                mqtt_layer_data->length_shift   = 0;
+                mqtt_layer_data->variable_size  = 0;
+                memset( mqtt_layer_data->variable, 0, sizeof( mqtt_layer_data->variable ) );
+                continue;
+            }
+
+            if( mqtt_layer_data->packet_state == XI_MQTT_PACKET_LENGTH )
+            {
+                mqtt_layer_data->remaining     |= ( uint32_t ) ( c & 0x7F ) << mqtt_layer_data->length_shift;
+                mqtt_layer_data->length_shift  += 7;
+
+                if( c & 0x80 )
+                {
+                    continue;
+                }
+
+                if( ( mqtt_layer_data->packet_type & 0xF0 ) == XI_MQTT_PUBLISH )
+                {
+                    mqtt_layer_data->packet_state   = XI_MQTT_PACKET_TOPIC_SIZE;
+                    mqtt_layer_data->topic_size     = 0;
+                    mqtt_layer_data->topic_pos      = 0;
+                }
+                else
+                {
+                    mqtt_layer_data->packet_state   = XI_MQTT_PACKET_BODY;
+                }
+            }
+            else
+            {
+                mqtt_layer_data->remaining -= 1;
+
+                switch( mqtt_layer_data->packet_state )
+                {
+                    case XI_MQTT_PACKET_TOPIC_SIZE:
+                        mqtt_layer_data->topic_size = ( uint16_t ) ( ( mqtt_layer_data->topic_size << 8 ) | c );
+
+                        if( ++mqtt_layer_data->variable_size == 2 )
+                        {
+                            mqtt_layer_data->variable_size  = 0;
+                            mqtt_layer_data->packet_state   = XI_MQTT_PACKET_TOPIC;
+                        }
+                        break;
+                    case XI_MQTT_PACKET_TOPIC:
+                        if( mqtt_layer_data->topic_pos < XI_MQTT_TOPIC_SIZE - 1 )
+                        {
+                            mqtt_layer_data->packet_topic[ mqtt_layer_data->topic_pos ] = ( char ) c;
+                        }
+
+                        if( ++mqtt_layer_data->topic_pos == mqtt_layer_data->topic_size )
+                        {
+                            mqtt_layer_data->packet_topic[ XI_MIN( mqtt_layer_data->topic_pos, XI_MQTT_TOPIC_SIZE - 1 ) ] = '\0';
+                            mqtt_layer_data->packet_state = ( mqtt_layer_data->packet_type & 0x06 )
+                                ? XI_MQTT_PACKET_ID : XI_MQTT_PACKET_PAYLOAD;
+                        }
+                        break;
+                    case XI_MQTT_PACKET_ID:
+                        mqtt_layer_data->variable[ mqtt_layer_data->variable_size++ ] = c;
+
+                        if( mqtt_layer_data->variable_size == 2 )
+                        {
+                            mqtt_layer_data->packet_state = XI_MQTT_PACKET_PAYLOAD;
+                        }
+                        break;
+                    default: // XI_MQTT_PACKET_BODY
+                        if( mqtt_layer_data->variable_size < sizeof( mqtt_layer_data->variable ) )
+                        {
+                            mqtt_layer_data->variable[ mqtt_layer_data->variable_size++ ] = c;
+                        }
+                        break;
+                }
+            }
+        }
+
+        if( mqtt_layer_data->remaining == 0 && mqtt_layer_data->packet_state != XI_MQTT_PACKET_LENGTH )
+        {
+            if( mqtt_layer_on_packet_end( context, mqtt_layer_data ) == LAYER_STATE_OK )
+            {
+                result = LAYER_STATE_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+layer_state_t mqtt_layer_close(
+      layer_connectivity_t* context )
+{
+    mqtt_layer_data_t* mqtt_layer_data = ( mqtt_layer_data_t* ) context->self->user_data;
+
+    // the handshake cut short starts over with the next connect
+    mqtt_layer_data->connect_state = 0;
+
+    if( mqtt_layer_data->connected )
+    {
+        static const unsigned char disconnect[] = { XI_MQTT_DISCONNECT, 0 };
+
+        mqtt_layer_data->connected = 0;
+        mqtt_layer_send( context, disconnect, sizeof( disconnect ) );
+    }
+
+    return CALL_ON_PREV_CLOSE( context->self );
+}
+
+layer_state_t mqtt_layer_on_close(
+      layer_connectivity_t* context )
+{
+    mqtt_layer_data_t* mqtt_layer_data = ( mqtt_layer_data_t* ) context->self->user_data;
+
+    mqtt_layer_data->connected      = 0;
+    mqtt_layer_data->connect_state  = 0;
+
+    return CALL_ON_NEXT_ON_CLOSE( context->self );
+}
+
+layer_state_t mqtt_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( data );
+    XI_UNUSED( hint );
+
+    mqtt_layer_data_t* mqtt_layer_data = ( mqtt_layer_data_t* ) context->self->user_data;
+
+    BEGIN_CORO( mqtt_layer_data->connect_state )
+
+    {
+        // clean session, the subscriptions are made again and the kept publishes are sent again
+        mqtt_layer_data->connected          = 0;
+        mqtt_layer_data->connack_received   = 0;
+        mqtt_layer_data->pings              = 0;
+        mqtt_layer_data->subscription_count = 0;
+        mqtt_layer_data->packet_state       = XI_MQTT_PACKET_TYPE;
+        mqtt_layer_data->waiting_for        = XI_MQTT_WAITING_CONNACK;
+
+        static const unsigned char protocol[] = { 0, 4, 'M', 'Q', 'T', 'T', 4 };
+
+        char client_id[ 12 ];
+        snprintf( client_id, sizeof( client_id ), "xi-%04x%04x", rand() & 0xFFFF, rand() & 0xFFFF );
+
+        const size_t client_id_size = strlen( client_id );
+        const size_t api_key_size   = strlen( mqtt_layer_data->api_key );
+
+        unsigned char header[ 16 ];
+        size_t header_size = mqtt_layer_fixed_header(
+              header, XI_MQTT_CONNECT
+            , sizeof( protocol ) + 1 + 2 + 2 + client_id_size + ( api_key_size ? 2 + api_key_size : 0 ) );
+
+        memcpy( header + header_size, protocol, sizeof( protocol ) );
+        header_size                += sizeof( protocol );
+        header[ header_size++ ]     = api_key_size ? 0x82 : 0x02; // user name, clean session
+        header_size                += mqtt_layer_put_u16( header + header_size, 0 ); // no keep alive
+        header_size                += mqtt_layer_put_u16( header + header_size, ( uint16_t ) client_id_size );
+
+        layer_state_t state = mqtt_layer_send( context, header, header_size );
+
+        if( state == LAYER_STATE_OK )
+        {
+            state = mqtt_layer_send( context, client_id, client_id_size );
+        }
+
+        if( state == LAYER_STATE_OK && api_key_size )
+        {
+            mqtt_layer_put_u16( header, ( uint16_t ) api_key_size );
+            state = mqtt_layer_send( context, header, 2 );
+
+            if( state == LAYER_STATE_OK )
+            {
+                state = mqtt_layer_send( context, mqtt_layer_data->api_key, api_key_size );
+            }
+        }
+
+        if( state != LAYER_STATE_OK )
+        {
+            EXIT( mqtt_layer_data->connect_state, LAYER_STATE_ERROR );
+        }
+    }
+
+    // the CONNACK is parsed by the on_data_ready
+    YIELD( mqtt_layer_data->connect_state, LAYER_STATE_WANT_READ );
+
+    mqtt_layer_data->waiting_for    = XI_MQTT_WAITING_NONE;
+    mqtt_layer_data->connected      = mqtt_layer_data->connack_received && mqtt_layer_data->connack_code == 0;
+
+    if( !mqtt_layer_data->connected )
+    {
+        xi_debug_format( "connection refused: %d", mqtt_layer_data->connack_code );
+    }
+
+    // the publishes that have not been acknowledged before the connection was lost
+    for( unsigned char i = 0; mqtt_layer_data->connected && i < mqtt_layer_data->inflight_count; ++i )
+    {
+        const mqtt_inflight_t* inflight = &mqtt_layer_data->inflight[ i ];
+
+        mqtt_layer_data->connected = mqtt_layer_send( context, inflight->packet, inflight->size ) == LAYER_STATE_OK;
+    }
+
+    // make the next connect start from the beginning
+    RESTART( mqtt_layer_data->connect_state, mqtt_layer_data->connected ? LAYER_STATE_OK : LAYER_STATE_ERROR );
+
+    END_CORO()
+
+    return LAYER_STATE_ERROR;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,56 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_MQTT_LAYER_H__
+#define __XI_MQTT_LAYER_H__
+
+#include "xi_layer.h"
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The MQTT 3.1.1 layer replaces the HTTP layer for the XI_MQTT protocol. The
+// API key is the user name of the session and the resource paths are used as
+// topics, e.g. `/v2/feeds/123/datastreams/temp.csv`.
+//
+// Updates and the posted datapoints are published with the CSV payload. With
+// QoS 1 up to XI_MQTT_MAX_INFLIGHT publishes of up to XI_MQTT_INFLIGHT_PACKET_SIZE
+// can wait for their PUBACK, the request only blocks when the window is full.
+// They are kept until they're acknowledged and published again once the
+// session, which is a clean one, has been reconnected. The bigger ones block
+// till their own PUBACK.
+//
+// Gets subscribe to the topic on the first call and then send a PINGREQ. The
+// broker answers it after whatever it has for the topic, so the get returns
+// the retained message of the new subscription or the message that has come
+// on the topic since, and 404 or 304 if there's none, instead of waiting for
+// the next update.
+
+layer_state_t mqtt_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t mqtt_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t mqtt_layer_close(
+      layer_connectivity_t* context );
+
+layer_state_t mqtt_layer_on_close(
+      layer_connectivity_t* context );
+
+layer_state_t mqtt_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_MQTT_LAYER_H__
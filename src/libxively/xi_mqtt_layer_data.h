@@ -0,0 +1,62 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_MQTT_LAYER_DATA_H__
+#define __XI_MQTT_LAYER_DATA_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+#include "xi_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    uint16_t                    packet_id;
+    uint16_t                    size;
+    unsigned char               packet[ XI_MQTT_INFLIGHT_PACKET_SIZE ];
+} mqtt_inflight_t;
+
+typedef struct
+{
+    // session
+    const char*                 api_key;
+    char                        connected;
+    short                       connect_state;
+    char                        connack_received;
+    unsigned char               connack_code;
+    uint16_t                    next_packet_id;
+    mqtt_inflight_t             inflight[ XI_MQTT_MAX_INFLIGHT ];   // sent again after the reconnection
+    unsigned char               inflight_count;
+    unsigned char               pings;              // the PINGRESPs still to come
+    char                        subscriptions[ XI_MQTT_MAX_SUBSCRIPTIONS ][ XI_MQTT_TOPIC_SIZE ];
+    unsigned char               subscription_count;
+
+    // current request
+    unsigned char               waiting_for;
+    uint16_t                    waiting_id;         // of the PUBACK or SUBACK, 0 for any PUBACK
+    char                        subscribing;        // the get has made the new subscription
+    char                        topic[ XI_MQTT_TOPIC_SIZE ];
+
+    // incoming packet
+    unsigned char               packet_state;
+    unsigned char               packet_type;
+    unsigned char               length_shift;
+    uint32_t                    remaining;
+    unsigned char               variable[ 4 ];
+    unsigned char               variable_size;
+    uint16_t                    topic_size;
+    uint16_t                    topic_pos;
+    char                        packet_topic[ XI_MQTT_TOPIC_SIZE ];
+
+    xi_response_t*              response;
+} mqtt_layer_data_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_MQTT_LAYER_DATA_H__
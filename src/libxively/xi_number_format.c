@@ -0,0 +1,460 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xi_number_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static const char xi_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// writes the digits of the value backwards from the end, returns the beginning
+static inline char* xi_format_u32_backwards( char* end, uint32_t value )
+{
+    while( value >= 100 )
+    {
+        const uint32_t pair = ( value % 100 ) * 2;
+
+        value  /= 100;
+        end    -= 2;
+        end[ 0 ] = xi_digit_pairs[ pair ];
+        end[ 1 ] = xi_digit_pairs[ pair + 1 ];
+    }
+
+    if( value >= 10 )
+    {
+        end    -= 2;
+        end[ 0 ] = xi_digit_pairs[ value * 2 ];
+        end[ 1 ] = xi_digit_pairs[ value * 2 + 1 ];
+    }
+    else
+    {
+        *( --end ) = ( char ) ( '0' + value );
+    }
+
+    return end;
+}
+
+int xi_format_i32( char* buffer, size_t buffer_size, int32_t value )
+{
+    char digits[ 12 ];
+    char* end                   = digits + sizeof( digits );
+    const uint32_t magnitude    = value < 0 ? 0u - ( uint32_t ) value : ( uint32_t ) value;
+    char* begin                 = xi_format_u32_backwards( end, magnitude );
+
+    if( value < 0 )
+    {
+        *( --begin ) = '-';
+    }
+
+    const size_t size = ( size_t ) ( end - begin );
+
+    if( size >= buffer_size )
+    {
+        return -1;
+    }
+
+    memcpy( buffer, begin, size );
+    buffer[ size ] = '\0';
+
+    return ( int ) size;
+}
+
+// the shortest decimal of a float is found the Ryu way, see Ulf Adams, "Ryu: fast float-to-string
+// conversion", PLDI 2018, the tables hold the powers of 5 and their inverses scaled to 59 and 61 bits
+#define XI_FLOAT_MANTISSA_BITS      23
+#define XI_FLOAT_EXPONENT_BITS      8
+#define XI_FLOAT_BIAS               127
+#define XI_FLOAT_POW5_INV_BITCOUNT  59
+#define XI_FLOAT_POW5_BITCOUNT      61
+
+static const uint64_t xi_float_pow5_inv_split[ 31 ] =
+{
+    UINT64_C( 576460752303423489 ), UINT64_C( 461168601842738791 ), UINT64_C( 368934881474191033 ),
+    UINT64_C( 295147905179352826 ), UINT64_C( 472236648286964522 ), UINT64_C( 377789318629571618 ),
+    UINT64_C( 302231454903657294 ), UINT64_C( 483570327845851670 ), UINT64_C( 386856262276681336 ),
+    UINT64_C( 309485009821345069 ), UINT64_C( 495176015714152110 ), UINT64_C( 396140812571321688 ),
+    UINT64_C( 316912650057057351 ), UINT64_C( 507060240091291761 ), UINT64_C( 405648192073033409 ),
+    UINT64_C( 324518553658426727 ), UINT64_C( 519229685853482763 ), UINT64_C( 415383748682786211 ),
+    UINT64_C( 332306998946228969 ), UINT64_C( 531691198313966350 ), UINT64_C( 425352958651173080 ),
+    UINT64_C( 340282366920938464 ), UINT64_C( 544451787073501542 ), UINT64_C( 435561429658801234 ),
+    UINT64_C( 348449143727040987 ), UINT64_C( 557518629963265579 ), UINT64_C( 446014903970612463 ),
+    UINT64_C( 356811923176489971 ), UINT64_C( 570899077082383953 ), UINT64_C( 456719261665907162 ),
+    UINT64_C( 365375409332725730 )
+};
+
+static const uint64_t xi_float_pow5_split[ 47 ] =
+{
+    UINT64_C( 1152921504606846976 ), UINT64_C( 1441151880758558720 ), UINT64_C( 1801439850948198400 ),
+    UINT64_C( 2251799813685248000 ), UINT64_C( 1407374883553280000 ), UINT64_C( 1759218604441600000 ),
+    UINT64_C( 2199023255552000000 ), UINT64_C( 1374389534720000000 ), UINT64_C( 1717986918400000000 ),
+    UINT64_C( 2147483648000000000 ), UINT64_C( 1342177280000000000 ), UINT64_C( 1677721600000000000 ),
+    UINT64_C( 2097152000000000000 ), UINT64_C( 1310720000000000000 ), UINT64_C( 1638400000000000000 ),
+    UINT64_C( 2048000000000000000 ), UINT64_C( 1280000000000000000 ), UINT64_C( 1600000000000000000 ),
+    UINT64_C( 2000000000000000000 ), UINT64_C( 1250000000000000000 ), UINT64_C( 1562500000000000000 ),
+    UINT64_C( 1953125000000000000 ), UINT64_C( 1220703125000000000 ), UINT64_C( 1525878906250000000 ),
+    UINT64_C( 1907348632812500000 ), UINT64_C( 1192092895507812500 ), UINT64_C( 1490116119384765625 ),
+    UINT64_C( 1862645149230957031 ), UINT64_C( 1164153218269348144 ), UINT64_C( 1455191522836685180 ),
+    UINT64_C( 1818989403545856475 ), UINT64_C( 2273736754432320594 ), UINT64_C( 1421085471520200371 ),
+    UINT64_C( 1776356839400250464 ), UINT64_C( 2220446049250313080 ), UINT64_C( 1387778780781445675 ),
+    UINT64_C( 1734723475976807094 ), UINT64_C( 2168404344971008868 ), UINT64_C( 1355252715606880542 ),
+    UINT64_C( 1694065894508600678 ), UINT64_C( 2117582368135750847 ), UINT64_C( 1323488980084844279 ),
+    UINT64_C( 1654361225106055349 ), UINT64_C( 2067951531382569187 ), UINT64_C( 1292469707114105741 ),
+    UINT64_C( 1615587133892632177 ), UINT64_C( 2019483917365790221 )
+};
+
+// ceil( log2( 5^e ) ) for e > 0, 1 for 0
+static inline int32_t xi_pow5_bits( const int32_t e )
+{
+    return ( int32_t ) ( ( ( uint32_t ) e * 1217359 ) >> 19 ) + 1;
+}
+
+// floor( log10( 2^e ) )
+static inline uint32_t xi_log10_pow2( const int32_t e )
+{
+    return ( ( uint32_t ) e * 78913 ) >> 18;
+}
+
+// floor( log10( 5^e ) )
+static inline uint32_t xi_log10_pow5( const int32_t e )
+{
+    return ( ( uint32_t ) e * 732923 ) >> 20;
+}
+
+static inline char xi_multiple_of_pow5( uint32_t value, const uint32_t p )
+{
+    uint32_t count = 0;
+
+    while( value % 5 == 0 )
+    {
+        value /= 5;
+        ++count;
+    }
+
+    return count >= p;
+}
+
+static inline char xi_multiple_of_pow2( const uint32_t value, const uint32_t p )
+{
+    return ( value & ( ( 1u << p ) - 1 ) ) == 0;
+}
+
+// ( m * factor ) >> shift, the shift is always above 32
+static inline uint32_t xi_mul_shift( const uint32_t m, const uint64_t factor, const int32_t shift )
+{
+    const uint64_t low  = ( uint64_t ) m * ( uint32_t ) factor;
+    const uint64_t high = ( uint64_t ) m * ( uint32_t ) ( factor >> 32 );
+
+    return ( uint32_t ) ( ( ( low >> 32 ) + high ) >> ( shift - 32 ) );
+}
+
+// the digits and the decimal exponent of the shortest decimal that reads back to the finite float
+static void xi_float_shortest( const uint32_t ieee_mantissa, const uint32_t ieee_exponent, uint32_t* digits, int32_t* exponent )
+{
+    int32_t e2  = 0;
+    uint32_t m2 = 0;
+
+    if( ieee_exponent == 0 )
+    {
+        e2 = 1 - XI_FLOAT_BIAS - XI_FLOAT_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    }
+    else
+    {
+        e2 = ( int32_t ) ieee_exponent - XI_FLOAT_BIAS - XI_FLOAT_MANTISSA_BITS - 2;
+        m2 = ( 1u << XI_FLOAT_MANTISSA_BITS ) | ieee_mantissa;
+    }
+
+    // the bounds are part of the interval if the mantissa is even
+    const char accept_bounds    = ( m2 & 1 ) == 0;
+    const uint32_t mv           = 4 * m2;
+    const uint32_t mp           = 4 * m2 + 2;
+    const uint32_t mm_shift     = ieee_mantissa != 0 || ieee_exponent <= 1;
+    const uint32_t mm           = 4 * m2 - 1 - mm_shift;
+
+    uint32_t vr = 0, vp = 0, vm = 0;
+    int32_t e10 = 0;
+    char vm_is_trailing_zeros       = 0;
+    char vr_is_trailing_zeros       = 0;
+    uint32_t last_removed_digit     = 0;
+
+    if( e2 >= 0 )
+    {
+        const uint32_t q    = xi_log10_pow2( e2 );
+        const int32_t k     = XI_FLOAT_POW5_INV_BITCOUNT + xi_pow5_bits( ( int32_t ) q ) - 1;
+        const int32_t i     = -e2 + ( int32_t ) q + k;
+
+        e10 = ( int32_t ) q;
+        vr  = xi_mul_shift( mv, xi_float_pow5_inv_split[ q ], i );
+        vp  = xi_mul_shift( mp, xi_float_pow5_inv_split[ q ], i );
+        vm  = xi_mul_shift( mm, xi_float_pow5_inv_split[ q ], i );
+
+        if( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            // the loop below may not run but the removed digit is needed for the rounding
+            const int32_t l     = XI_FLOAT_POW5_INV_BITCOUNT + xi_pow5_bits( ( int32_t ) ( q - 1 ) ) - 1;
+            last_removed_digit  = xi_mul_shift( mv, xi_float_pow5_inv_split[ q - 1 ], -e2 + ( int32_t ) q - 1 + l ) % 10;
+        }
+
+        if( q <= 9 )
+        {
+            // only one of the mp, mv and mm can be a multiple of 5
+            if( mv % 5 == 0 )
+            {
+                vr_is_trailing_zeros = xi_multiple_of_pow5( mv, q );
+            }
+            else if( accept_bounds )
+            {
+                vm_is_trailing_zeros = xi_multiple_of_pow5( mm, q );
+            }
+            else
+            {
+                vp -= xi_multiple_of_pow5( mp, q );
+            }
+        }
+    }
+    else
+    {
+        const uint32_t q    = xi_log10_pow5( -e2 );
+        const int32_t i     = -e2 - ( int32_t ) q;
+        const int32_t k     = xi_pow5_bits( i ) - XI_FLOAT_POW5_BITCOUNT;
+        int32_t j           = ( int32_t ) q - k;
+
+        e10 = ( int32_t ) q + e2;
+        vr  = xi_mul_shift( mv, xi_float_pow5_split[ i ], j );
+        vp  = xi_mul_shift( mp, xi_float_pow5_split[ i ], j );
+        vm  = xi_mul_shift( mm, xi_float_pow5_split[ i ], j );
+
+        if( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            j                   = ( int32_t ) q - 1 - ( xi_pow5_bits( i + 1 ) - XI_FLOAT_POW5_BITCOUNT );
+            last_removed_digit  = xi_mul_shift( mv, xi_float_pow5_split[ i + 1 ], j ) % 10;
+        }
+
+        if( q <= 1 )
+        {
+            // the mv has at least two trailing zero bits, the mm has one only if the mm_shift is 1
+            vr_is_trailing_zeros = 1;
+
+            if( accept_bounds )
+            {
+                vm_is_trailing_zeros = mm_shift == 1;
+            }
+            else
+            {
+                --vp;
+            }
+        }
+        else if( q < 31 )
+        {
+            vr_is_trailing_zeros = xi_multiple_of_pow2( mv, q - 1 );
+        }
+    }
+
+    // remove the digits as long as the interval still holds a shorter decimal
+    int32_t removed = 0;
+
+    if( vm_is_trailing_zeros || vr_is_trailing_zeros )
+    {
+        while( vp / 10 > vm / 10 )
+        {
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit  = vr % 10;
+            vr                 /= 10;
+            vp                 /= 10;
+            vm                 /= 10;
+            ++removed;
+        }
+
+        if( vm_is_trailing_zeros )
+        {
+            while( vm % 10 == 0 )
+            {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit  = vr % 10;
+                vr                 /= 10;
+                vp                 /= 10;
+                vm                 /= 10;
+                ++removed;
+            }
+        }
+
+        if( vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0 )
+        {
+            // the exact value is a tie so it is rounded to even
+            last_removed_digit = 4;
+        }
+
+        *digits = vr + ( ( vr == vm && ( !accept_bounds || !vm_is_trailing_zeros ) ) || last_removed_digit >= 5 );
+    }
+    else
+    {
+        while( vp / 10 > vm / 10 )
+        {
+            last_removed_digit  = vr % 10;
+            vr                 /= 10;
+            vp                 /= 10;
+            vm                 /= 10;
+            ++removed;
+        }
+
+        *digits = vr + ( vr == vm || last_removed_digit >= 5 );
+    }
+
+    *exponent = e10 + removed;
+}
+
+static inline int xi_format_copy( char* buffer, size_t buffer_size, const char* text, size_t size )
+{
+    if( size >= buffer_size )
+    {
+        return -1;
+    }
+
+    memcpy( buffer, text, size );
+    buffer[ size ] = '\0';
+
+    return ( int ) size;
+}
+
+int xi_format_f32( char* buffer, size_t buffer_size, float value, int precision )
+{
+    char text[ 64 ];
+    char digits_text[ 12 ];
+    char* out           = text;
+    uint32_t bits       = 0;
+    uint32_t digits     = 0;
+    int32_t exponent    = 0;
+
+    memcpy( &bits, &value, sizeof( bits ) );
+
+    const char sign                 = ( bits >> 31 ) != 0;
+    const uint32_t ieee_mantissa    = bits & ( ( 1u << XI_FLOAT_MANTISSA_BITS ) - 1 );
+    const uint32_t ieee_exponent    = ( bits >> XI_FLOAT_MANTISSA_BITS ) & ( ( 1u << XI_FLOAT_EXPONENT_BITS ) - 1 );
+
+    if( ieee_exponent == ( ( 1u << XI_FLOAT_EXPONENT_BITS ) - 1 ) )
+    {
+        return ieee_mantissa ? xi_format_copy( buffer, buffer_size, "nan", 3 )
+                             : xi_format_copy( buffer, buffer_size, sign ? "-inf" : "inf", sign ? 4 : 3 );
+    }
+
+    if( sign )
+    {
+        *( out++ ) = '-';
+    }
+
+    if( ieee_exponent != 0 || ieee_mantissa != 0 )
+    {
+        xi_float_shortest( ieee_mantissa, ieee_exponent, &digits, &exponent );
+    }
+
+    char* digits_begin  = xi_format_u32_backwards( digits_text + sizeof( digits_text ), digits );
+    int32_t length      = ( int32_t ) ( digits_text + sizeof( digits_text ) - digits_begin );
+
+    // the position of the point after the first digit in the scientific notation
+    const int32_t scientific = length - 1 + exponent;
+
+    if( scientific < -4 || scientific >= 16 )
+    {
+        *( out++ ) = digits_begin[ 0 ];
+
+        if( length > 1 )
+        {
+            *( out++ ) = '.';
+            memcpy( out, digits_begin + 1, ( size_t ) length - 1 );
+            out += length - 1;
+        }
+
+        *( out++ ) = 'e';
+        out += xi_format_i32( out, text + sizeof( text ) - out, scientific );
+
+        return xi_format_copy( buffer, buffer_size, text, ( size_t ) ( out - text ) );
+    }
+
+    if( precision >= 0 )
+    {
+        // the digits behind the required decimals are rounded half up
+        const int32_t keep = length + exponent + precision;
+
+        if( keep < 0 )
+        {
+            digits      = 0;
+            exponent    = -precision;
+        }
+        else if( keep < length )
+        {
+            uint32_t divisor = 1;
+
+            for( int32_t i = keep; i < length; ++i )
+            {
+                divisor *= 10;
+            }
+
+            digits      = ( digits + divisor / 2 ) / divisor;
+            exponent   += length - keep;
+        }
+
+        digits_begin    = xi_format_u32_backwards( digits_text + sizeof( digits_text ), digits );
+        length          = ( int32_t ) ( digits_text + sizeof( digits_text ) - digits_begin );
+    }
+
+    // the point is after this many digits
+    const int32_t point = length + exponent;
+
+    if( point <= 0 )
+    {
+        *( out++ ) = '0';
+        *( out++ ) = '.';
+        memset( out, '0', ( size_t ) -point );
+        out += -point;
+        memcpy( out, digits_begin, ( size_t ) length );
+        out += length;
+    }
+    else if( exponent >= 0 )
+    {
+        memcpy( out, digits_begin, ( size_t ) length );
+        out += length;
+        memset( out, '0', ( size_t ) exponent );
+        out += exponent;
+        *( out++ ) = '.';
+        *( out++ ) = '0';
+    }
+    else
+    {
+        memcpy( out, digits_begin, ( size_t ) point );
+        out += point;
+        *( out++ ) = '.';
+        memcpy( out, digits_begin + point, ( size_t ) ( length - point ) );
+        out += length - point;
+    }
+
+    if( precision >= 0 )
+    {
+        // the decimals that are missing or the ".0" of the shortest form
+        char* point_at      = ( char* ) memchr( text, '.', ( size_t ) ( out - text ) );
+        const int32_t have  = ( int32_t ) ( out - point_at - 1 );
+
+        if( precision == 0 )
+        {
+            out = point_at;
+        }
+        else if( have < precision )
+        {
+            memset( out, '0', ( size_t ) ( precision - have ) );
+            out += precision - have;
+        }
+    }
+
+    return xi_format_copy( buffer, buffer_size, text, ( size_t ) ( out - text ) );
+}
+
+#ifdef __cplusplus
+}
+#endif
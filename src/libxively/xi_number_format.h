@@ -0,0 +1,28 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_NUMBER_FORMAT_H__
+#define __XI_NUMBER_FORMAT_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the shortest text of the float that reads back to the same value
+#define XI_FLOAT_PRECISION_SHORTEST -1
+
+// writes the decimal text of the value with the guard, returns its length or -1 if it does not fit the buffer
+int xi_format_i32( char* buffer, size_t buffer_size, int32_t value );
+
+// writes the float with the given number of decimals or the shortest text that reads back to the same
+// float, the ones below 1e-4 or from 1e16 on are written with the exponent, returns the length or -1
+int xi_format_f32( char* buffer, size_t buffer_size, float value, int precision );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_NUMBER_FORMAT_H__
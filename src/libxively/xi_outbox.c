@@ -0,0 +1,576 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include "xi_outbox.h"
+
+#if defined( XI_OUTBOX_ENABLED ) && !defined( XI_NOB_ENABLED )
+
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "xi_allocator.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_data_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the records start at the page of their own so that syncing them leaves the header alone
+#define XI_OUTBOX_HEADER_SIZE   4096
+
+// the seq of the record that has been sent ahead of the head of the queue
+#define XI_OUTBOX_SENT          UINT64_MAX
+
+static const char xi_outbox_magic[ 8 ] = "XIOUTB1";
+
+static uint32_t xi_outbox_default_clock_ms( void )
+{
+    return ( uint32_t ) time( 0 ) * 1000;
+}
+
+static inline uint32_t xi_outbox_now( const xi_outbox_t* outbox )
+{
+    return outbox->config.clock_ms ? outbox->config.clock_ms() : xi_outbox_default_clock_ms();
+}
+
+static inline char xi_is_success( const xi_response_t* response )
+{
+    return response && response->http.http_status >= 200 && response->http.http_status < 300;
+}
+
+// FNV-1a, it only has to tell the torn writes
+static uint32_t xi_outbox_hash( const void* data, size_t size )
+{
+    const unsigned char* p  = ( const unsigned char* ) data;
+    uint32_t hash           = 2166136261u;
+
+    for( size_t i = 0; i < size; ++i )
+    {
+        hash ^= p[ i ];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static inline xi_outbox_header_t* xi_outbox_header( const xi_outbox_t* outbox )
+{
+    return ( xi_outbox_header_t* ) outbox->map;
+}
+
+static inline xi_outbox_record_t* xi_outbox_record( const xi_outbox_t* outbox, uint64_t seq )
+{
+    return ( xi_outbox_record_t* ) ( outbox->map + XI_OUTBOX_HEADER_SIZE ) + seq % outbox->config.capacity;
+}
+
+static uint32_t xi_outbox_record_check( const xi_outbox_record_t* record )
+{
+    xi_outbox_record_t copy;
+
+    memcpy( &copy, record, sizeof( xi_outbox_record_t ) );
+    copy.check = 0;
+
+    return xi_outbox_hash( &copy, sizeof( xi_outbox_record_t ) );
+}
+
+static inline uint32_t xi_outbox_commit_check( const xi_outbox_commit_t* commit )
+{
+    return xi_outbox_hash( commit, offsetof( xi_outbox_commit_t, check ) );
+}
+
+// the range is extended to the page boundary msync wants
+static int xi_outbox_sync( const xi_outbox_t* outbox, size_t offset, size_t size )
+{
+    const size_t begin = offset & ~( outbox->page_size - 1 );
+
+    return msync( outbox->map + begin, offset + size - begin, MS_SYNC );
+}
+
+static int xi_outbox_sync_records( const xi_outbox_t* outbox )
+{
+    const size_t capacity   = outbox->config.capacity;
+    const size_t size       = sizeof( xi_outbox_record_t );
+    const size_t begin      = ( size_t ) ( outbox->committed_tail % capacity );
+    const size_t end        = ( size_t ) ( outbox->tail % capacity );
+
+    if( outbox->tail - outbox->committed_tail >= capacity )
+    {
+        return xi_outbox_sync( outbox, XI_OUTBOX_HEADER_SIZE, capacity * size );
+    }
+
+    if( begin < end )
+    {
+        return xi_outbox_sync( outbox, XI_OUTBOX_HEADER_SIZE + begin * size, ( end - begin ) * size );
+    }
+
+    // the pending records wrap around the end of the file
+    if( xi_outbox_sync( outbox, XI_OUTBOX_HEADER_SIZE + begin * size, ( capacity - begin ) * size ) != 0 )
+    {
+        return -1;
+    }
+
+    return end ? xi_outbox_sync( outbox, XI_OUTBOX_HEADER_SIZE, end * size ) : 0;
+}
+
+// the records go to the storage before the state that points at them, the state
+// overwrites the older one of the two so that the torn write leaves the other
+static int xi_outbox_write_commit( xi_outbox_t* outbox )
+{
+    xi_outbox_commit_t commit;
+
+    if( outbox->tail != outbox->committed_tail )
+    {
+        XI_CHECK_CND( xi_outbox_sync_records( outbox ) != 0, XI_OUTBOX_FILE_ERROR );
+    }
+
+    memset( &commit, 0, sizeof( xi_outbox_commit_t ) );
+
+    commit.seq      = outbox->seq + 1;
+    commit.head     = outbox->head;
+    commit.tail     = outbox->tail;
+    commit.dropped  = outbox->dropped;
+    commit.check    = xi_outbox_commit_check( &commit );
+
+    memcpy( &xi_outbox_header( outbox )->commits[ commit.seq & 1 ], &commit, sizeof( xi_outbox_commit_t ) );
+
+    XI_CHECK_CND( xi_outbox_sync( outbox, 0, sizeof( xi_outbox_header_t ) ) != 0, XI_OUTBOX_FILE_ERROR );
+
+    outbox->seq             = commit.seq;
+    outbox->committed_tail  = outbox->tail;
+    outbox->last_commit_ms  = xi_outbox_now( outbox );
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+// picks up the state of the last commit, returns 0 if there is no valid one
+static char xi_outbox_recover( xi_outbox_t* outbox )
+{
+    const xi_outbox_header_t* header    = xi_outbox_header( outbox );
+    const xi_outbox_commit_t* last      = 0;
+
+    if( memcmp( header->magic, xi_outbox_magic, sizeof( xi_outbox_magic ) ) != 0
+        || header->record_size != sizeof( xi_outbox_record_t )
+        || header->capacity != outbox->config.capacity )
+    {
+        return 0;
+    }
+
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const xi_outbox_commit_t* commit = &header->commits[ i ];
+
+        if( commit->check == xi_outbox_commit_check( commit )
+            && commit->head <= commit->tail
+            && commit->tail - commit->head <= outbox->config.capacity
+            && ( last == 0 || commit->seq > last->seq ) )
+        {
+            last = commit;
+        }
+    }
+
+    if( last == 0 )
+    {
+        return 0;
+    }
+
+    outbox->seq             = last->seq;
+    outbox->head            = last->head;
+    outbox->tail            = last->tail;
+    outbox->committed_tail  = last->tail;
+    outbox->dropped         = last->dropped;
+
+    return 1;
+}
+
+static void xi_outbox_close( xi_outbox_t* outbox )
+{
+    if( outbox->map )
+    {
+        munmap( outbox->map, outbox->map_size );
+    }
+
+    if( outbox->fd >= 0 )
+    {
+        close( outbox->fd );
+    }
+
+    XI_SAFE_FREE( outbox );
+}
+
+// the records overwritten or torn since the last commit, and the ones already sent, are skipped
+static inline char xi_outbox_is_queued( const xi_outbox_record_t* record, uint64_t seq )
+{
+    return record->seq == seq && record->check == xi_outbox_record_check( record );
+}
+
+static void xi_outbox_skip( xi_outbox_t* outbox )
+{
+    while( outbox->head != outbox->tail && !xi_outbox_is_queued( xi_outbox_record( outbox, outbox->head ), outbox->head ) )
+    {
+        outbox->head += 1;
+    }
+}
+
+// posts the datapoints of the datastream at the head of the queue, up to the
+// limit of a single request, and marks them as sent once the server takes them
+static const xi_response_t* xi_outbox_drain_datastream( xi_context_t* xi, xi_outbox_t* outbox )
+{
+    char datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    size_t count    = 0;
+    uint64_t seq    = outbox->head;
+
+    memcpy( datastream_id, xi_outbox_record( outbox, outbox->head )->datastream_id, XI_MAX_DATASTREAM_NAME );
+
+    for( ; seq != outbox->tail && count < XI_DATAPOINTS_POST_SIZE; ++seq )
+    {
+        const xi_outbox_record_t* record = xi_outbox_record( outbox, seq );
+
+        if( !xi_outbox_is_queued( record, seq ) || strcmp( record->datastream_id, datastream_id ) != 0 )
+        {
+            continue;
+        }
+
+        xi_datapoint_t* dp = &outbox->batch[ count++ ];
+
+        dp->timestamp.timestamp = ( xi_time_t ) record->timestamp;
+        dp->timestamp.micro     = ( xi_time_t ) record->micro;
+        dp->value_type          = ( xi_value_type_t ) record->value_type;
+
+        memcpy( &dp->value, &record->value, sizeof( record->value ) );
+    }
+
+    // the post goes to the server instead of back into the queue
+    xi->outbox = 0;
+
+    const xi_response_t* response = xi_datapoints_post( xi, xi->feed_id, datastream_id, outbox->batch, count );
+
+    xi->outbox = outbox;
+
+    // nothing is lost if it fails, the same datapoints are sent again
+    if( !xi_is_success( response ) )
+    {
+        return response;
+    }
+
+    for( uint64_t i = outbox->head; i != seq; ++i )
+    {
+        xi_outbox_record_t* record = xi_outbox_record( outbox, i );
+
+        if( xi_outbox_is_queued( record, i ) && strcmp( record->datastream_id, datastream_id ) == 0 )
+        {
+            record->seq = XI_OUTBOX_SENT;
+        }
+    }
+
+    return response;
+}
+
+// sends the queue datastream by datastream until it's empty, the update fails
+// or the drain_requests have been sent, the rest goes on at the next poll
+static const xi_response_t* xi_outbox_drain( xi_context_t* xi, xi_outbox_t* outbox )
+{
+    const xi_response_t* response   = 0;
+    const uint32_t limit            = outbox->config.drain_requests ? outbox->config.drain_requests : 1;
+
+    outbox->last_drain_ms   = xi_outbox_now( outbox );
+    outbox->drain_more      = 0;
+
+    xi_outbox_skip( outbox );
+
+    for( uint32_t requests = 0; outbox->head != outbox->tail; ++requests )
+    {
+        if( requests == limit )
+        {
+            outbox->drain_more = 1;
+            break;
+        }
+
+        response = xi_outbox_drain_datastream( xi, outbox );
+
+        if( !xi_is_success( response ) )
+        {
+            return response;
+        }
+
+        xi_outbox_skip( outbox );
+        xi_outbox_write_commit( outbox );
+    }
+
+    return response;
+}
+
+static const xi_response_t* xi_outbox_accepted( xi_context_t* xi )
+{
+    xi_response_t* accepted = xi_data_layer_response( xi->layer_chain.top );
+
+    memset( accepted, 0, sizeof( xi_response_t ) );
+
+    accepted->http.http_status = 202;
+    strcpy( accepted->http.http_status_string, "Accepted" );
+
+    return accepted;
+}
+
+xi_context_t* xi_outbox_enable(
+      xi_context_t* xi
+    , const char* path
+    , const xi_outbox_config_t* config )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( path != 0 );
+    assert( config != 0 );
+    assert( config->capacity > 0 );
+
+    // the outbox of the same file has to commit what it holds before the file is read
+    xi_outbox_disable( xi );
+
+    xi_outbox_t* outbox = ( xi_outbox_t* ) xi_alloc( sizeof( xi_outbox_t ) );
+    struct stat st;
+    char recovered      = 0;
+
+    XI_CHECK_MEMORY( outbox );
+
+    memset( outbox, 0, sizeof( xi_outbox_t ) );
+
+    outbox->config      = *config;
+    outbox->fd          = open( path, O_RDWR | O_CREAT, 0600 );
+    outbox->page_size   = ( size_t ) sysconf( _SC_PAGESIZE );
+    outbox->map_size    = XI_OUTBOX_HEADER_SIZE + ( size_t ) config->capacity * sizeof( xi_outbox_record_t );
+
+    XI_CHECK_CND( outbox->fd < 0 || fstat( outbox->fd, &st ) != 0, XI_OUTBOX_FILE_ERROR );
+
+    // the file of the other size is not the one of this outbox
+    if( ( size_t ) st.st_size != outbox->map_size )
+    {
+        XI_CHECK_CND( ftruncate( outbox->fd, 0 ) != 0
+                      || ftruncate( outbox->fd, ( off_t ) outbox->map_size ) != 0, XI_OUTBOX_FILE_ERROR );
+    }
+
+    outbox->map = ( unsigned char* ) mmap( 0, outbox->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, outbox->fd, 0 );
+
+    if( outbox->map == MAP_FAILED )
+    {
+        outbox->map = 0;
+        xi_set_err( XI_OUTBOX_FILE_ERROR );
+        goto err_handling;
+    }
+
+    recovered = xi_outbox_recover( outbox );
+
+    if( !recovered )
+    {
+        xi_outbox_header_t* header = xi_outbox_header( outbox );
+
+        memset( header, 0, sizeof( xi_outbox_header_t ) );
+        memcpy( header->magic, xi_outbox_magic, sizeof( xi_outbox_magic ) );
+
+        header->record_size = sizeof( xi_outbox_record_t );
+        header->capacity    = config->capacity;
+
+        XI_CHECK_CND( xi_outbox_write_commit( outbox ) != 0, XI_OUTBOX_FILE_ERROR );
+    }
+
+    xi_debug_format( "the outbox holds %lu datapoints", ( unsigned long ) ( outbox->tail - outbox->head ) );
+
+    // whatever has been left in the file is sent at the first chance
+    outbox->last_commit_ms  = xi_outbox_now( outbox );
+    outbox->last_drain_ms   = outbox->last_commit_ms - config->drain_interval_ms;
+
+    xi->outbox = outbox;
+
+    return xi;
+
+err_handling:
+    if( outbox )
+    {
+        xi_outbox_close( outbox );
+    }
+
+    return 0;
+}
+
+void xi_outbox_disable( xi_context_t* xi )
+{
+    xi_outbox_t* outbox = ( xi_outbox_t* ) xi->outbox;
+
+    if( outbox == 0 )
+    {
+        return;
+    }
+
+    xi_outbox_write_commit( outbox );
+    xi_outbox_close( outbox );
+
+    xi->outbox = 0;
+}
+
+static void xi_outbox_commit_if_due( xi_outbox_t* outbox, uint32_t now )
+{
+    if( outbox->tail != outbox->committed_tail
+        && ( outbox->tail - outbox->committed_tail >= outbox->config.commit_records
+             || now - outbox->last_commit_ms >= outbox->config.commit_interval_ms ) )
+    {
+        xi_outbox_write_commit( outbox );
+    }
+}
+
+int xi_outbox_commit( xi_context_t* xi )
+{
+    xi_outbox_t* outbox = ( xi_outbox_t* ) xi->outbox;
+
+    return outbox ? xi_outbox_write_commit( outbox ) : -1;
+}
+
+const xi_response_t* xi_outbox_poll( xi_context_t* xi )
+{
+    xi_outbox_t* outbox = ( xi_outbox_t* ) xi->outbox;
+
+    if( outbox == 0 )
+    {
+        return 0;
+    }
+
+    const uint32_t now = xi_outbox_now( outbox );
+
+    xi_outbox_commit_if_due( outbox, now );
+
+    if( outbox->head != outbox->tail
+        && ( outbox->drain_more || now - outbox->last_drain_ms >= outbox->config.drain_interval_ms ) )
+    {
+        return xi_outbox_drain( xi, outbox );
+    }
+
+    return 0;
+}
+
+size_t xi_outbox_pending( const xi_context_t* xi )
+{
+    const xi_outbox_t* outbox = ( const xi_outbox_t* ) xi->outbox;
+
+    return outbox ? ( size_t ) ( outbox->tail - outbox->head ) : 0;
+}
+
+// the datastream id is checked by the caller
+static void xi_outbox_put(
+      xi_outbox_t* outbox
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    xi_outbox_record_t* record = 0;
+
+    // the oldest one makes room, its record tells it has been overwritten by its seq
+    if( outbox->tail - outbox->head == outbox->config.capacity )
+    {
+        outbox->head    += 1;
+        outbox->dropped += 1;
+    }
+
+    record = xi_outbox_record( outbox, outbox->tail );
+
+    memset( record, 0, sizeof( xi_outbox_record_t ) );
+
+    record->seq         = outbox->tail;
+    record->timestamp   = datapoint->timestamp.timestamp;
+    record->micro       = ( uint32_t ) datapoint->timestamp.micro;
+    record->value_type  = ( uint32_t ) datapoint->value_type;
+
+    // the server keeps one datapoint per timestamp, so the ones given here never repeat
+    if( datapoint->timestamp.timestamp == 0 )
+    {
+        xi_timestamp_t* last = &outbox->last_stamp;
+        xi_time_t seconds, micro;
+
+        xi_time_now( &seconds, &micro );
+        xi_time_after( &seconds, &micro, last->timestamp, last->micro );
+
+        last->timestamp     = seconds;
+        last->micro         = micro;
+        record->timestamp   = seconds;
+        record->micro       = ( uint32_t ) micro;
+    }
+
+    strcpy( record->datastream_id, datastream_id );
+    memcpy( &record->value, &datapoint->value, sizeof( record->value ) );
+
+    record->check       = xi_outbox_record_check( record );
+    outbox->tail       += 1;
+}
+
+const xi_response_t* xi_outbox_enqueue(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    return xi_outbox_enqueue_datapoints( xi, datastream_id, datapoint, 1 );
+}
+
+const xi_response_t* xi_outbox_enqueue_datapoints(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoints
+    , size_t count )
+{
+    xi_outbox_t* outbox = ( xi_outbox_t* ) xi->outbox;
+
+    XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME, XI_DATASTREAM_ID_TOO_LONG );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        xi_outbox_put( outbox, datastream_id, &datapoints[ i ] );
+    }
+
+    xi_outbox_commit_if_due( outbox, xi_outbox_now( outbox ) );
+
+    return xi_outbox_accepted( xi );
+
+err_handling:
+    return 0;
+}
+
+const xi_response_t* xi_outbox_enqueue_feed(
+      xi_context_t* xi
+    , const xi_feed_t* feed )
+{
+    xi_outbox_t* outbox = ( xi_outbox_t* ) xi->outbox;
+
+    // nothing of the feed is queued if one of its ids is wrong
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        XI_CHECK_CND( strlen( feed->datastreams[ i ].datastream_id ) >= XI_MAX_DATASTREAM_NAME, XI_DATASTREAM_ID_TOO_LONG );
+    }
+
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* datastream = &feed->datastreams[ i ];
+
+        for( size_t j = 0; j < datastream->datapoint_count; ++j )
+        {
+            xi_outbox_put( outbox, datastream->datastream_id, &datastream->datapoints[ j ] );
+        }
+    }
+
+    xi_outbox_commit_if_due( outbox, xi_outbox_now( outbox ) );
+
+    return xi_outbox_accepted( xi );
+
+err_handling:
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XI_OUTBOX_ENABLED && !XI_NOB_ENABLED
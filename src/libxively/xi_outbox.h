@@ -0,0 +1,97 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_OUTBOX_H__
+#define __XI_OUTBOX_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef XI_OUTBOX_ENABLED
+
+// the datapoint as it is stored in the file, the seq tells the record
+// overwritten after the last commit from the one the commit points at
+typedef struct
+{
+    uint64_t            seq;
+    int64_t             timestamp;
+    uint32_t            micro;
+    uint32_t            check;
+    uint32_t            value_type;
+    char                datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    union
+    {
+        int32_t         i32_value;
+        float           f32_value;
+        char            str_value[ XI_VALUE_STRING_MAX_SIZE ];
+    } value;
+} xi_outbox_record_t;
+
+// the state of the queue, the file has two of them and the valid one with the greater seq wins
+typedef struct
+{
+    uint64_t            seq;
+    uint64_t            head;
+    uint64_t            tail;
+    uint64_t            dropped;
+    uint32_t            check;
+    uint32_t            reserved;
+} xi_outbox_commit_t;
+
+typedef struct
+{
+    char                magic[ 8 ];
+    uint32_t            record_size;
+    uint32_t            capacity;
+    xi_outbox_commit_t  commits[ 2 ];
+} xi_outbox_header_t;
+
+typedef struct
+{
+    xi_outbox_config_t  config;
+    int                 fd;
+    unsigned char*      map;
+    size_t              map_size;
+    size_t              page_size;
+    uint64_t            seq;                // of the last commit
+    uint64_t            head;
+    uint64_t            tail;
+    uint64_t            committed_tail;
+    uint64_t            dropped;
+    uint32_t            last_commit_ms;
+    uint32_t            last_drain_ms;
+    char                drain_more;         // the last drain has stopped at the limit of the requests
+    xi_timestamp_t      last_stamp;         // given to the datapoint without the timestamp
+    xi_datapoint_t      batch[ XI_DATAPOINTS_POST_SIZE ]; // of the datastream being drained
+} xi_outbox_t;
+
+// writes the datapoint into the queue and commits it if it's due, the queue is drained by the xi_outbox_poll
+const xi_response_t* xi_outbox_enqueue(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint );
+
+// the same for the datapoints of xi_datapoints_post
+const xi_response_t* xi_outbox_enqueue_datapoints(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoints
+    , size_t count );
+
+// the same for all of the datapoints of the datastreams of xi_feed_update
+const xi_response_t* xi_outbox_enqueue_feed(
+      xi_context_t* xi
+    , const xi_feed_t* feed );
+
+#endif // XI_OUTBOX_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_OUTBOX_H__
@@ -0,0 +1,249 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "xi_resource.h"
+#include "xi_http_layer_constants.h"
+#include "xi_generator.h"
+#include "xi_debug.h"
+#include "xi_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void xi_resource_format_timestamp( const xi_timestamp_t* timestamp )
+{
+    xi_format_iso8601( buffer_32, timestamp->timestamp, timestamp->micro );
+}
+
+// the socket api carries the request in an envelope instead of the request line
+static inline char xi_resource_is_socket( const xi_context_t* xi )
+{
+    return xi->protocol == XI_WS || xi->protocol == XI_TCP;
+}
+
+// the extension the server picks the format of the body by
+static inline const char* xi_resource_format( const xi_context_t* xi )
+{
+    switch( xi->protocol )
+    {
+        case XI_HTTP_JSON:
+            return XI_HTTP_TEMPLATE_JSON;
+        case XI_HTTP_CBOR:
+            return XI_HTTP_TEMPLATE_CBOR;
+        case XI_WS:
+        case XI_TCP:
+            return XI_HTTP_EMPTY;
+        default:
+            return XI_HTTP_TEMPLATE_CSV;
+    }
+}
+
+const char* xi_resource_method( xi_query_type_t query_type )
+{
+    switch( query_type )
+    {
+        case HTTP_LAYER_INPUT_DATASTREAM_GET:
+        case HTTP_LAYER_INPUT_FEED_GET:
+        case HTTP_LAYER_INPUT_FEED_GET_ALL:
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
+            return XI_HTTP_GET;
+        case HTTP_LAYER_INPUT_DATASTREAM_UPDATE:
+        case HTTP_LAYER_INPUT_FEED_UPDATE:
+        case HTTP_LAYER_INPUT_COLUMNS_UPDATE:
+        case HTTP_LAYER_INPUT_ARENA_FEED_UPDATE:
+            return XI_HTTP_PUT;
+        case HTTP_LAYER_INPUT_DATASTREAM_CREATE:
+        case HTTP_LAYER_INPUT_DATAPOINTS_POST:
+            return XI_HTTP_POST;
+        case HTTP_LAYER_INPUT_DATASTREAM_DELETE:
+        case HTTP_LAYER_INPUT_DATAPOINT_DELETE:
+        case HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE:
+            return XI_HTTP_DELETE;
+        default:
+            return 0;
+    }
+}
+
+const void* xi_resource_query_generator( const void* input, short* state )
+{
+    // unpack the data
+    const http_layer_input_t* const http_layer_input
+            = ( const http_layer_input_t* ) input;
+
+    const union http_union_data_t* ld = &http_layer_input->http_union_data;
+
+    // the punctuation of the query string and of the params object of the socket api
+    static const char* const query[]    = { "?", "=", "&", "" };
+    static const char* const params[]   = { ",\"params\":{\"", "\":\"", "\",\"", "\"}" };
+
+    // local global index required to be static cause used via the persistent for
+    static unsigned char i      = 0;
+    static const char* const* p = 0;
+
+    ENABLE_GENERATOR();
+
+    BEGIN_CORO( *state )
+
+        p = xi_resource_is_socket( http_layer_input->xi_context ) ? params : query;
+
+        if( http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET )
+        {
+            // PRECONDITIONS
+            assert( ld->xi_get_feed.feed->datastream_count > 0 );
+
+            gen_ptr_text( *state, p[ 0 ] );
+            gen_ptr_text( *state, XI_CSV_DATASTREAMS );
+            gen_ptr_text( *state, p[ 1 ] );
+            gen_ptr_text( *state, ld->xi_get_feed.feed->datastreams[ 0 ].datastream_id );
+
+            for( i = 1; i < ld->xi_get_feed.feed->datastream_count; ++i )
+            {
+                gen_ptr_text( *state, XI_CSV_COMMA );
+                gen_ptr_text( *state, ld->xi_get_feed.feed->datastreams[ i ].datastream_id );
+            }
+
+            gen_ptr_text_and_exit( *state, p[ 3 ] );
+        }
+
+        if( http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_HISTORY
+            || http_layer_input->query_type == HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE )
+        {
+            gen_ptr_text( *state, p[ 0 ] );
+            gen_static_text( *state, "start" );
+            gen_ptr_text( *state, p[ 1 ] );
+
+            xi_resource_format_timestamp( http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_HISTORY
+                ? ld->xi_get_datastream_history.start : ld->xi_delete_datapoint_range.value_start );
+            gen_ptr_text( *state, buffer_32 );
+
+            gen_ptr_text( *state, p[ 2 ] );
+            gen_static_text( *state, "end" );
+            gen_ptr_text( *state, p[ 1 ] );
+
+            xi_resource_format_timestamp( http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_HISTORY
+                ? ld->xi_get_datastream_history.end : ld->xi_delete_datapoint_range.value_end );
+            gen_ptr_text( *state, buffer_32 );
+        }
+
+        if( http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_HISTORY )
+        {
+            if( ld->xi_get_datastream_history.interval )
+            {
+                gen_ptr_text( *state, p[ 2 ] );
+                gen_static_text( *state, "interval" );
+                gen_ptr_text( *state, p[ 1 ] );
+
+                sprintf( buffer_32, "%"PRIu32, ld->xi_get_datastream_history.interval );
+                gen_ptr_text( *state, buffer_32 );
+            }
+
+            gen_ptr_text( *state, p[ 2 ] );
+            gen_static_text( *state, "limit" );
+            gen_ptr_text( *state, p[ 1 ] );
+
+            sprintf( buffer_32, "%"PRIu32, ld->xi_get_datastream_history.limit );
+            gen_ptr_text( *state, buffer_32 );
+        }
+
+        if( http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_HISTORY
+            || http_layer_input->query_type == HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE )
+        {
+            gen_ptr_text_and_exit( *state, p[ 3 ] );
+        }
+
+        gen_ptr_text_and_exit( *state, XI_HTTP_EMPTY );
+
+    END_CORO()
+
+    return 0;
+}
+
+const void* xi_resource_path_generator( const void* input, short* state )
+{
+    // unpack the data
+    const http_layer_input_t* const http_layer_input
+            = ( const http_layer_input_t* ) input;
+
+    const union http_union_data_t* ld   = &http_layer_input->http_union_data;
+    const char socket                   = xi_resource_is_socket( http_layer_input->xi_context );
+
+    ENABLE_GENERATOR();
+
+    BEGIN_CORO( *state )
+
+        // the socket api leaves the version out
+        gen_ptr_text( *state, XI_HTTP_TEMPLATE_FEED + ( socket ? 3 : 0 ) );
+        gen_ptr_text( *state, XI_CSV_SLASH );
+
+        {
+            memset( buffer_32, 0, 32 );
+            sprintf( buffer_32, "%"PRIu32, ( uint32_t ) http_layer_input->xi_context->feed_id );
+            gen_ptr_text( *state, buffer_32 ); // feed id
+        }
+
+        // the coroutine must not yield from within a nested switch
+        if( http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET
+            || http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_GET_ALL
+            || http_layer_input->query_type == HTTP_LAYER_INPUT_FEED_UPDATE
+            || http_layer_input->query_type == HTTP_LAYER_INPUT_COLUMNS_UPDATE
+            || http_layer_input->query_type == HTTP_LAYER_INPUT_ARENA_FEED_UPDATE )
+        {
+            gen_ptr_text( *state, xi_resource_format( http_layer_input->xi_context ) );
+        }
+        else
+        {
+            gen_ptr_text( *state, XI_CSV_SLASH );
+            gen_ptr_text( *state, XI_CSV_DATASTREAMS );
+
+            if( http_layer_input->query_type == HTTP_LAYER_INPUT_DATASTREAM_CREATE )
+            {
+                gen_ptr_text_and_exit( *state, xi_resource_format( http_layer_input->xi_context ) );
+            }
+
+            // all of the datastream members of the union start with the datastream id
+            gen_ptr_text( *state, XI_CSV_SLASH );
+            gen_ptr_text( *state, ld->xi_get_datastream.datastream );
+
+            if( http_layer_input->query_type == HTTP_LAYER_INPUT_DATAPOINT_DELETE )
+            {
+                gen_ptr_text( *state, XI_CSV_SLASH );
+                gen_ptr_text( *state, XI_CSV_DATAPOINTS );
+                gen_ptr_text( *state, XI_CSV_SLASH );
+
+                xi_resource_format_timestamp( &ld->xi_delete_datapoint.value->timestamp );
+                gen_ptr_text( *state, buffer_32 );
+            }
+            else if( http_layer_input->query_type == HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE
+                     || http_layer_input->query_type == HTTP_LAYER_INPUT_DATAPOINTS_POST )
+            {
+                gen_ptr_text( *state, XI_CSV_SLASH );
+                gen_ptr_text( *state, XI_CSV_DATAPOINTS );
+            }
+
+            // the range of the datapoints is deleted without the extension
+            if( http_layer_input->query_type != HTTP_LAYER_INPUT_DATAPOINT_DELETE_RANGE )
+            {
+                gen_ptr_text( *state, xi_resource_format( http_layer_input->xi_context ) );
+            }
+        }
+
+        // the socket api takes the query as the params of the envelope
+        if( socket )
+        {
+            gen_ptr_text_and_exit( *state, XI_HTTP_EMPTY );
+        }
+
+        call_sub_gen_and_exit( *state, input, xi_resource_query_generator );
+
+    END_CORO()
+
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
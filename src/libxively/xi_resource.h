@@ -0,0 +1,28 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_RESOURCE_H__
+#define __XI_RESOURCE_H__
+
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// returns the method of the query followed by a space e.g. "PUT ", 0 if the query is unknown
+const char* xi_resource_method( xi_query_type_t query_type );
+
+// generates the path of the resource that the query refers to e.g. /v2/feeds/123/datastreams/temp.csv
+// the input is expected to be the http_layer_input_t, it is shared by all of the transport layers
+const void* xi_resource_path_generator( const void* input, short* state );
+
+// generates the query of the resource e.g. ?start=...&end=..., or the params of the socket api
+// envelope e.g. ,"params":{"start":"...","end":"..."}, nothing if the query has none
+const void* xi_resource_query_generator( const void* input, short* state );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_RESOURCE_H__
@@ -0,0 +1,110 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xi_sha1.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XI_SHA1_ROL( v, n ) ( ( ( v ) << ( n ) ) | ( ( v ) >> ( 32 - ( n ) ) ) )
+
+static void xi_sha1_block( xi_sha1_t* ctx )
+{
+    uint32_t w[ 80 ];
+
+    for( unsigned char i = 0; i < 16; ++i )
+    {
+        w[ i ] = ( ( uint32_t ) ctx->block[ i * 4 ] << 24 )
+               | ( ( uint32_t ) ctx->block[ i * 4 + 1 ] << 16 )
+               | ( ( uint32_t ) ctx->block[ i * 4 + 2 ] << 8 )
+               | ( ( uint32_t ) ctx->block[ i * 4 + 3 ] );
+    }
+
+    for( unsigned char i = 16; i < 80; ++i )
+    {
+        w[ i ] = XI_SHA1_ROL( w[ i - 3 ] ^ w[ i - 8 ] ^ w[ i - 14 ] ^ w[ i - 16 ], 1 );
+    }
+
+    uint32_t a = ctx->h[ 0 ], b = ctx->h[ 1 ], c = ctx->h[ 2 ], d = ctx->h[ 3 ], e = ctx->h[ 4 ];
+
+    for( unsigned char i = 0; i < 80; ++i )
+    {
+        uint32_t f, k;
+
+        if( i < 20 )        { f = ( b & c ) | ( ~b & d );            k = 0x5A827999; }
+        else if( i < 40 )   { f = b ^ c ^ d;                         k = 0x6ED9EBA1; }
+        else if( i < 60 )   { f = ( b & c ) | ( b & d ) | ( c & d ); k = 0x8F1BBCDC; }
+        else                { f = b ^ c ^ d;                         k = 0xCA62C1D6; }
+
+        uint32_t t = XI_SHA1_ROL( a, 5 ) + f + e + k + w[ i ];
+
+        e = d;
+        d = c;
+        c = XI_SHA1_ROL( b, 30 );
+        b = a;
+        a = t;
+    }
+
+    ctx->h[ 0 ] += a;
+    ctx->h[ 1 ] += b;
+    ctx->h[ 2 ] += c;
+    ctx->h[ 3 ] += d;
+    ctx->h[ 4 ] += e;
+}
+
+void xi_sha1_init( xi_sha1_t* ctx )
+{
+    ctx->h[ 0 ]     = 0x67452301;
+    ctx->h[ 1 ]     = 0xEFCDAB89;
+    ctx->h[ 2 ]     = 0x98BADCFE;
+    ctx->h[ 3 ]     = 0x10325476;
+    ctx->h[ 4 ]     = 0xC3D2E1F0;
+    ctx->length     = 0;
+}
+
+void xi_sha1_update( xi_sha1_t* ctx, const void* data, size_t size )
+{
+    const unsigned char* p = ( const unsigned char* ) data;
+
+    while( size-- )
+    {
+        ctx->block[ ctx->length++ % 64 ] = *p++;
+
+        if( ctx->length % 64 == 0 )
+        {
+            xi_sha1_block( ctx );
+        }
+    }
+}
+
+void xi_sha1_final( xi_sha1_t* ctx, unsigned char digest[ XI_SHA1_DIGEST_SIZE ] )
+{
+    const uint64_t bits = ( uint64_t ) ctx->length * 8;
+    const unsigned char pad = 0x80;
+    const unsigned char zero = 0x00;
+
+    xi_sha1_update( ctx, &pad, 1 );
+
+    while( ctx->length % 64 != 56 )
+    {
+        xi_sha1_update( ctx, &zero, 1 );
+    }
+
+    for( signed char i = 7; i >= 0; --i )
+    {
+        const unsigned char b = ( unsigned char ) ( bits >> ( i * 8 ) );
+        xi_sha1_update( ctx, &b, 1 );
+    }
+
+    for( unsigned char i = 0; i < XI_SHA1_DIGEST_SIZE; ++i )
+    {
+        digest[ i ] = ( unsigned char ) ( ctx->h[ i / 4 ] >> ( 24 - ( i % 4 ) * 8 ) );
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
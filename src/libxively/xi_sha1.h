@@ -0,0 +1,33 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_SHA1_H__
+#define __XI_SHA1_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XI_SHA1_DIGEST_SIZE 20
+
+typedef struct
+{
+    uint32_t        h[ 5 ];
+    uint32_t        length;         // number of the bytes processed so far
+    unsigned char   block[ 64 ];
+} xi_sha1_t;
+
+void xi_sha1_init( xi_sha1_t* ctx );
+
+void xi_sha1_update( xi_sha1_t* ctx, const void* data, size_t size );
+
+void xi_sha1_final( xi_sha1_t* ctx, unsigned char digest[ XI_SHA1_DIGEST_SIZE ] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_SHA1_H__
@@ -0,0 +1,355 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xi_layer_api.h"
+#include "xi_common.h"
+#include "xi_socket_api.h"
+#include "xi_http_layer_constants.h"
+#include "xi_generator.h"
+#include "xi_resource.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+      XI_SOCKET_ENVELOPE = 0
+    , XI_SOCKET_MEMBER
+    , XI_SOCKET_KEY
+    , XI_SOCKET_COLON
+    , XI_SOCKET_VALUE
+    , XI_SOCKET_IN_VALUE
+    , XI_SOCKET_NEXT
+};
+
+enum
+{
+      XI_SOCKET_VALUE_GOES_ON = 0
+    , XI_SOCKET_VALUE_ENDS_WITH
+    , XI_SOCKET_VALUE_ENDED_BEFORE
+};
+
+static inline char xi_socket_is_space( char c )
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline const char* xi_socket_method( xi_query_type_t query_type )
+{
+    const char* method = xi_resource_method( query_type );
+
+    if( method == XI_HTTP_GET )     { return "get"; }
+    if( method == XI_HTTP_PUT )     { return "put"; }
+    if( method == XI_HTTP_POST )    { return "post"; }
+
+    return "delete";
+}
+
+const void* xi_socket_request_generator( const void* input, short* state )
+{
+    // unpack the data
+    const http_layer_input_t* const http_layer_input
+            = ( const http_layer_input_t* ) input;
+
+    const xi_context_t* xi = http_layer_input->xi_context;
+
+    ENABLE_GENERATOR();
+
+    BEGIN_CORO( *state )
+
+        gen_static_text( *state, "{\"method\":\"" );
+        gen_ptr_text( *state, xi_socket_method( http_layer_input->query_type ) );
+        gen_static_text( *state, "\",\"resource\":\"" );
+
+        call_sub_gen( *state, input, xi_resource_path_generator );
+
+        gen_static_text( *state, "\"" );
+
+        call_sub_gen( *state, input, xi_resource_query_generator );
+
+        gen_static_text( *state, ",\"headers\":{\"X-ApiKey\":\"" );
+        gen_ptr_text( *state, xi->api_key ? xi->api_key : XI_HTTP_EMPTY );
+        gen_static_text( *state, "\"}" );
+
+        if( http_layer_input->payload_generator )
+        {
+            gen_static_text( *state, ",\"body\":" );
+
+            call_sub_gen( *state, &http_layer_input->http_union_data, http_layer_input->payload_generator );
+        }
+
+        gen_static_text_and_exit( *state, "}" );
+
+    END_CORO()
+
+    return 0;
+}
+
+void xi_socket_response_init( xi_socket_response_t* parser )
+{
+    memset( parser, 0, sizeof( xi_socket_response_t ) );
+}
+
+// follows the value of any kind, the strings and the containers may hold anything
+static char xi_socket_value_char( xi_socket_response_t* parser, char c )
+{
+    if( parser->in_string )
+    {
+        if( parser->escaped )
+        {
+            parser->escaped = 0;
+        }
+        else if( c == '\\' )
+        {
+            parser->escaped = 1;
+        }
+        else if( c == '"' )
+        {
+            parser->in_string = 0;
+
+            return parser->depth == 0 ? XI_SOCKET_VALUE_ENDS_WITH : XI_SOCKET_VALUE_GOES_ON;
+        }
+
+        return XI_SOCKET_VALUE_GOES_ON;
+    }
+
+    switch( c )
+    {
+        case '"':
+            parser->in_string = 1;
+            return XI_SOCKET_VALUE_GOES_ON;
+        case '{':
+        case '[':
+            parser->depth += 1;
+            return XI_SOCKET_VALUE_GOES_ON;
+        case '}':
+        case ']':
+            if( parser->depth == 0 )
+            {
+                return XI_SOCKET_VALUE_ENDED_BEFORE;
+            }
+
+            return --parser->depth == 0 ? XI_SOCKET_VALUE_ENDS_WITH : XI_SOCKET_VALUE_GOES_ON;
+        case ',':
+            return parser->depth == 0 ? XI_SOCKET_VALUE_ENDED_BEFORE : XI_SOCKET_VALUE_GOES_ON;
+        default:
+            if( xi_socket_is_space( c ) )
+            {
+                return parser->depth == 0 && parser->started ? XI_SOCKET_VALUE_ENDED_BEFORE : XI_SOCKET_VALUE_GOES_ON;
+            }
+
+            parser->started = 1;
+            return XI_SOCKET_VALUE_GOES_ON;
+    }
+}
+
+// the body of the success goes to the next layer and the one of the failure to the status string
+static void xi_socket_response_body(
+      xi_socket_response_t* parser
+    , layer_connectivity_t* context
+    , xi_response_t* response
+    , const char* data
+    , unsigned short size
+    , char last )
+{
+    const unsigned short status = response->http.http_status;
+
+    if( status != 200 )
+    {
+        for( unsigned short i = 0; i < size && parser->message_pos < XI_HTTP_STATUS_STRING_SIZE - 1; ++i )
+        {
+            response->http.http_status_string[ parser->message_pos++ ] = data[ i ];
+        }
+
+        return;
+    }
+
+    if( parser->body_failed || ( size == 0 && !last ) )
+    {
+        return;
+    }
+
+    const_data_descriptor_t body = { data, size, size, 0 };
+
+    layer_state_t state = CALL_ON_NEXT_ON_DATA_READY(
+          context->self
+        , ( const void* ) &body
+        , last ? LAYER_HINT_NONE : LAYER_HINT_MORE_DATA );
+
+    parser->body_failed = state == LAYER_STATE_ERROR;
+}
+
+static layer_state_t xi_socket_response_end(
+      const xi_socket_response_t* parser
+    , const xi_response_t* response )
+{
+    if( response->http.http_status == 0 )
+    {
+        xi_debug_logger( "the envelope has no status" );
+        return LAYER_STATE_ERROR;
+    }
+
+    return response->http.http_status == 200 && parser->body_failed ? LAYER_STATE_ERROR : LAYER_STATE_OK;
+}
+
+layer_state_t xi_socket_response_parse(
+      xi_socket_response_t* parser
+    , layer_connectivity_t* context
+    , xi_response_t* response
+    , const_data_descriptor_t* buffer )
+{
+    const char in_body          = parser->state == XI_SOCKET_IN_VALUE && strcmp( parser->key, "body" ) == 0;
+    unsigned short body_begin   = in_body ? buffer->curr_pos : buffer->real_size;
+
+    while( buffer->curr_pos < buffer->real_size )
+    {
+        const char c = buffer->data_ptr[ buffer->curr_pos ];
+
+        switch( parser->state )
+        {
+            case XI_SOCKET_ENVELOPE:
+                if( c == '{' )
+                {
+                    parser->state = XI_SOCKET_MEMBER;
+                }
+                else if( !xi_socket_is_space( c ) )
+                {
+                    return LAYER_STATE_ERROR;
+                }
+                break;
+            case XI_SOCKET_MEMBER:
+            case XI_SOCKET_NEXT:
+                if( c == '}' )
+                {
+                    buffer->curr_pos += 1;
+                    return xi_socket_response_end( parser, response );
+                }
+                else if( c == ',' && parser->state == XI_SOCKET_NEXT )
+                {
+                    parser->state = XI_SOCKET_MEMBER;
+                }
+                else if( c == '"' && parser->state == XI_SOCKET_MEMBER )
+                {
+                    parser->state       = XI_SOCKET_KEY;
+                    parser->key_size    = 0;
+                    parser->escaped     = 0;
+                }
+                else if( !xi_socket_is_space( c ) )
+                {
+                    return LAYER_STATE_ERROR;
+                }
+                break;
+            case XI_SOCKET_KEY:
+                if( c == '"' && !parser->escaped )
+                {
+                    parser->key[ parser->key_size ] = '\0';
+                    parser->state                   = XI_SOCKET_COLON;
+                    break;
+                }
+
+                parser->escaped = c == '\\' && !parser->escaped;
+
+                if( !parser->escaped && parser->key_size < sizeof( parser->key ) - 1 )
+                {
+                    parser->key[ parser->key_size++ ] = c;
+                }
+                break;
+            case XI_SOCKET_COLON:
+                if( c == ':' )
+                {
+                    parser->state = XI_SOCKET_VALUE;
+                }
+                else if( !xi_socket_is_space( c ) )
+                {
+                    return LAYER_STATE_ERROR;
+                }
+                break;
+            case XI_SOCKET_VALUE:
+                if( xi_socket_is_space( c ) )
+                {
+                    break;
+                }
+
+                parser->state       = XI_SOCKET_IN_VALUE;
+                parser->depth       = 0;
+                parser->in_string   = 0;
+                parser->escaped     = 0;
+                parser->started     = 0;
+
+                if( strcmp( parser->key, "status" ) == 0 )
+                {
+                    response->http.http_status = 0;
+                }
+                else if( strcmp( parser->key, "body" ) == 0 )
+                {
+                    // the body cannot be told from the error before the status is known
+                    if( response->http.http_status == 0 )
+                    {
+                        xi_debug_logger( "the body comes before the status" );
+                        return LAYER_STATE_ERROR;
+                    }
+
+                    body_begin = buffer->curr_pos;
+                }
+
+                // the first char of the value is read as the part of it
+                continue;
+            case XI_SOCKET_IN_VALUE:
+                {
+                    const char end = xi_socket_value_char( parser, c );
+
+                    // only the number itself, whatever else the value holds
+                    if( strcmp( parser->key, "status" ) == 0 && c >= '0' && c <= '9' && end == XI_SOCKET_VALUE_GOES_ON )
+                    {
+                        response->http.http_status = response->http.http_status * 10 + ( c - '0' );
+                    }
+
+                    if( end == XI_SOCKET_VALUE_GOES_ON )
+                    {
+                        break;
+                    }
+
+                    if( strcmp( parser->key, "body" ) == 0 )
+                    {
+                        const unsigned short body_end = buffer->curr_pos + ( end == XI_SOCKET_VALUE_ENDS_WITH ? 1 : 0 );
+
+                        xi_socket_response_body( parser, context, response
+                            , buffer->data_ptr + body_begin, body_end - body_begin, 1 );
+
+                        body_begin = buffer->real_size;
+                    }
+
+                    parser->state = XI_SOCKET_NEXT;
+
+                    // the char after the value is read as the separator
+                    if( end == XI_SOCKET_VALUE_ENDED_BEFORE )
+                    {
+                        continue;
+                    }
+                }
+                break;
+            default:
+                return LAYER_STATE_ERROR;
+        }
+
+        buffer->curr_pos += 1;
+    }
+
+    // the body goes on in the next piece
+    if( body_begin < buffer->real_size )
+    {
+        xi_socket_response_body( parser, context, response
+            , buffer->data_ptr + body_begin, buffer->real_size - body_begin, 0 );
+    }
+
+    return LAYER_STATE_WANT_READ;
+}
+
+#ifdef __cplusplus
+}
+#endif
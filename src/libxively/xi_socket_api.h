@@ -0,0 +1,62 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_SOCKET_API_H__
+#define __XI_SOCKET_API_H__
+
+#include <stdint.h>
+
+#include "xi_layer.h"
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The socket api of the service takes each request as a JSON envelope:
+//
+//      {"method":"get","resource":"/feeds/123/datastreams/temp","params":{"limit":"10"},
+//       "headers":{"X-ApiKey":"<key>"},"body":<the JSON body of the request>}
+//
+// and replies the same way:
+//
+//      {"status":200,"resource":"/feeds/123/datastreams/temp","body":<the JSON body>}
+//
+// The body is the one of the JSON REST api, so the transports that speak it
+// are followed by the json layer. The body is streamed on as it comes, the one
+// of the 200 to the json layer and the other ones to the status string, so the
+// status has to come before it and the envelope with the body first is refused.
+
+typedef struct
+{
+    unsigned char               state;
+    unsigned char               depth;              // of the nesting within the value being read
+    char                        in_string;
+    char                        escaped;
+    char                        started;            // whether the primitive value has begun
+    char                        body_failed;        // the layer after has not taken the body
+    unsigned char               key_size;
+    char                        key[ 8 ];           // of the top-level member being read, the longer ones are cut
+    unsigned char               message_pos;        // within the status string the error body goes to
+} xi_socket_response_t;
+
+// generates the envelope of the request, the input is expected to be the http_layer_input_t
+const void* xi_socket_request_generator( const void* input, short* state );
+
+void xi_socket_response_init( xi_socket_response_t* parser );
+
+// reads the piece of the reply envelope, the status goes to the response and the body is
+// handed on to the next layer of the context, returns LAYER_STATE_OK once the envelope
+// is over and LAYER_STATE_WANT_READ if it goes on past the data, the data after the
+// envelope is left in the buffer
+layer_state_t xi_socket_response_parse(
+      xi_socket_response_t* parser
+    , layer_connectivity_t* context
+    , xi_response_t* response
+    , const_data_descriptor_t* buffer );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_SOCKET_API_H__
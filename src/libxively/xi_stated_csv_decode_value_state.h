@@ -4,14 +4,22 @@
 #ifndef __XI_STATED_CSV_DECODE_VALUE_STATE_H__
 #define __XI_STATED_CSV_DECODE_VALUE_STATE_H__
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct
 {
-    short state;
-    short counter;
+    short       state;
+    short       counter;
+    uint32_t    mantissa;   // the digits of the number decoded so far
+    short       exponent;   // the number of the digits after the dot
+    char        negative;
+    char        inexact;    // the digits did not fit the mantissa
+    short       power;      // the power of ten written after the 'e'
+    char        power_negative;
 } xi_stated_csv_decode_value_state_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,133 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+
+#include "xi_layer_api.h"
+#include "xi_common.h"
+#include "xi_tcp_layer.h"
+#include "xi_tcp_layer_data.h"
+#include "xi_http_layer_constants.h"
+#include "xi_generator.h"
+#include "xi_resource.h"
+#include "xi_socket_api.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline layer_state_t tcp_layer_send_text(
+      layer_connectivity_t* context
+    , const char* text )
+{
+    const unsigned short size           = ( unsigned short ) strlen( text );
+    const const_data_descriptor_t desc  = { text, size, size, 0 };
+
+    return CALL_ON_PREV_DATA_READY( context->self, ( const void* ) &desc, LAYER_HINT_NONE );
+}
+
+static layer_state_t tcp_layer_send_generated(
+      layer_connectivity_t* context
+    , xi_generator_t* gen
+    , const void* input )
+{
+    layer_state_t state = LAYER_STATE_OK;
+    short gstate        = 0;
+
+    while( gstate != 1 && state == LAYER_STATE_OK )
+    {
+        const const_data_descriptor_t* data
+            = ( const const_data_descriptor_t* ) ( *gen )( input, &gstate );
+
+        if( data )
+        {
+            state = CALL_ON_PREV_DATA_READY( context->self, ( const void* ) data, LAYER_HINT_NONE );
+        }
+    }
+
+    return state;
+}
+
+layer_state_t tcp_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    tcp_layer_data_t* tcp_layer_data            = ( tcp_layer_data_t* ) context->self->user_data;
+    const http_layer_input_t* http_layer_input  = ( const http_layer_input_t* ) data;
+
+    if( xi_resource_method( http_layer_input->query_type ) == 0 || !tcp_layer_data->connected )
+    {
+        return LAYER_STATE_ERROR;
+    }
+
+    // reset the response parser
+    xi_socket_response_init( &tcp_layer_data->message );
+
+    layer_state_t state = tcp_layer_send_generated( context, &xi_socket_request_generator, http_layer_input );
+
+    if( state == LAYER_STATE_OK )
+    {
+        state = tcp_layer_send_text( context, XI_HTTP_NEWLINE );
+    }
+
+    return state;
+}
+
+layer_state_t tcp_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    tcp_layer_data_t* tcp_layer_data    = ( tcp_layer_data_t* ) context->self->user_data;
+    const_data_descriptor_t* buffer     = ( const_data_descriptor_t* ) data;
+
+    // the newline after the envelope is skipped by the next one
+    return xi_socket_response_parse( &tcp_layer_data->message, context, tcp_layer_data->response, buffer );
+}
+
+layer_state_t tcp_layer_close(
+      layer_connectivity_t* context )
+{
+    tcp_layer_data_t* tcp_layer_data = ( tcp_layer_data_t* ) context->self->user_data;
+
+    tcp_layer_data->connected = 0;
+
+    return CALL_ON_PREV_CLOSE( context->self );
+}
+
+layer_state_t tcp_layer_on_close(
+      layer_connectivity_t* context )
+{
+    tcp_layer_data_t* tcp_layer_data = ( tcp_layer_data_t* ) context->self->user_data;
+
+    tcp_layer_data->connected = 0;
+
+    return CALL_ON_NEXT_ON_CLOSE( context->self );
+}
+
+layer_state_t tcp_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( data );
+    XI_UNUSED( hint );
+
+    tcp_layer_data_t* tcp_layer_data = ( tcp_layer_data_t* ) context->self->user_data;
+
+    // the key goes with each request so there is nothing to exchange
+    tcp_layer_data->connected = 1;
+
+    return LAYER_STATE_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
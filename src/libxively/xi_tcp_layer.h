@@ -0,0 +1,50 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_TCP_LAYER_H__
+#define __XI_TCP_LAYER_H__
+
+#include "xi_layer.h"
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The TCP layer replaces the HTTP layer for the XI_TCP protocol. It speaks the
+// socket api of the service on the plain connection, each request is the JSON
+// envelope described in xi_socket_api.h followed by the newline:
+//
+//      {"method":"put","resource":"/feeds/123/datastreams/temp",
+//       "headers":{"X-ApiKey":"<key>"},"body":{"current_value":"1.5"}}\n
+//
+// and each reply is the envelope with the status and the body:
+//
+//      {"status":200,"resource":"/feeds/123/datastreams/temp"}
+
+layer_state_t tcp_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t tcp_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t tcp_layer_close(
+      layer_connectivity_t* context );
+
+layer_state_t tcp_layer_on_close(
+      layer_connectivity_t* context );
+
+layer_state_t tcp_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_TCP_LAYER_H__
@@ -0,0 +1,29 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_TCP_LAYER_DATA_H__
+#define __XI_TCP_LAYER_DATA_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+#include "xi_socket_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    char                        connected;
+
+    // incoming message
+    xi_socket_response_t        message;
+    xi_response_t*              response;
+} tcp_layer_data_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_TCP_LAYER_DATA_H__
@@ -1,6 +1,13 @@
 // Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
 // This is part of Xively C library, it is under the BSD 3-Clause license.
 
+#include <string.h>
+#include <time.h>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/time.h>
+#endif
+
 #include "xi_time.h"
 
 #ifdef __cplusplus
@@ -157,6 +164,163 @@ struct xi_tm* xi_gmtime( register const xi_time_t *timer )
     return timep;
 }
 
+// the length of the "YYYY-MM-DDTHH:MM:SS" part
+#define ISO8601_PREFIX_SIZE 19
+
+// the days since the epoch and back, see Howard Hinnant, "chrono-Compatible Low-Level Date Algorithms"
+static long xi_days_from_civil( long y, const long m, const long d )
+{
+    y -= m <= 2;
+
+    const long era  = ( y >= 0 ? y : y - 399 ) / 400;
+    const long yoe  = y - era * 400;
+    const long doy  = ( 153 * ( m + ( m > 2 ? -3 : 9 ) ) + 2 ) / 5 + d - 1;
+    const long doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+static void xi_civil_from_days( long z, long* y, long* m, long* d )
+{
+    z += 719468;
+
+    const long era  = ( z >= 0 ? z : z - 146096 ) / 146097;
+    const long doe  = z - era * 146097;
+    const long yoe  = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    const long doy  = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    const long mp   = ( 5 * doy + 2 ) / 153;
+
+    *d = doy - ( 153 * mp + 2 ) / 5 + 1;
+    *m = mp + ( mp < 10 ? 3 : -9 );
+    *y = yoe + era * 400 + ( *m <= 2 );
+}
+
+static inline void xi_put_digits( char* dst, long value, int count )
+{
+    while( count-- > 0 )
+    {
+        dst[ count ] = ( char ) ( '0' + value % 10 );
+        value       /= 10;
+    }
+}
+
+static inline char xi_get_digits( const char* src, int count, long* value )
+{
+    *value = 0;
+
+    for( int i = 0; i < count; ++i )
+    {
+        if( src[ i ] < '0' || src[ i ] > '9' )
+        {
+            return 0;
+        }
+
+        *value = *value * 10 + ( src[ i ] - '0' );
+    }
+
+    return 1;
+}
+
+void xi_format_iso8601( char* buffer, xi_time_t seconds, xi_time_t micro )
+{
+    static xi_time_t last_seconds   = -1;
+    static char last_prefix[ ISO8601_PREFIX_SIZE ];
+
+    if( seconds != last_seconds )
+    {
+        const long days         = seconds >= 0 ? seconds / SECS_DAY : ( seconds - SECS_DAY + 1 ) / SECS_DAY;
+        const long day_clock    = seconds - days * SECS_DAY;
+        long y = 0, m = 0, d = 0;
+
+        xi_civil_from_days( days, &y, &m, &d );
+
+        xi_put_digits( last_prefix, y, 4 );
+        last_prefix[ 4 ] = '-';
+        xi_put_digits( last_prefix + 5, m, 2 );
+        last_prefix[ 7 ] = '-';
+        xi_put_digits( last_prefix + 8, d, 2 );
+        last_prefix[ 10 ] = 'T';
+        xi_put_digits( last_prefix + 11, day_clock / 3600, 2 );
+        last_prefix[ 13 ] = ':';
+        xi_put_digits( last_prefix + 14, ( day_clock / 60 ) % 60, 2 );
+        last_prefix[ 16 ] = ':';
+        xi_put_digits( last_prefix + 17, day_clock % 60, 2 );
+
+        last_seconds = seconds;
+    }
+
+    memcpy( buffer, last_prefix, ISO8601_PREFIX_SIZE );
+    buffer[ ISO8601_PREFIX_SIZE ] = '.';
+    xi_put_digits( buffer + ISO8601_PREFIX_SIZE + 1, micro, 6 );
+    buffer[ XI_ISO8601_SIZE - 1 ]   = 'Z';
+    buffer[ XI_ISO8601_SIZE ]       = '\0';
+}
+
+char xi_parse_iso8601( const char* text, xi_time_t* seconds, xi_time_t* micro )
+{
+    static xi_time_t last_seconds = 0;
+    static char last_prefix[ ISO8601_PREFIX_SIZE ];
+
+    long y = 0, m = 0, d = 0, hh = 0, mm = 0, ss = 0, us = 0;
+
+    if( text[ 4 ] != '-' || text[ 7 ] != '-' || text[ 10 ] != 'T' || text[ 13 ] != ':' || text[ 16 ] != ':'
+        || text[ ISO8601_PREFIX_SIZE ] != '.' || text[ XI_ISO8601_SIZE - 1 ] != 'Z'
+        || !xi_get_digits( text + ISO8601_PREFIX_SIZE + 1, 6, &us ) )
+    {
+        return 0;
+    }
+
+    if( memcmp( text, last_prefix, ISO8601_PREFIX_SIZE ) != 0 )
+    {
+        if( !xi_get_digits( text, 4, &y ) || !xi_get_digits( text + 5, 2, &m ) || !xi_get_digits( text + 8, 2, &d )
+            || !xi_get_digits( text + 11, 2, &hh ) || !xi_get_digits( text + 14, 2, &mm )
+            || !xi_get_digits( text + 17, 2, &ss ) || m < 1 || m > 12 )
+        {
+            return 0;
+        }
+
+        last_seconds = xi_days_from_civil( y, m, d ) * SECS_DAY + ( hh * 60 + mm ) * 60 + ss;
+        memcpy( last_prefix, text, ISO8601_PREFIX_SIZE );
+    }
+
+    *seconds    = last_seconds;
+    *micro      = us;
+
+    return 1;
+}
+
+void xi_time_now( xi_time_t* seconds, xi_time_t* micro )
+{
+#if defined( __unix__ ) || defined( __APPLE__ )
+    struct timeval tv;
+
+    gettimeofday( &tv, 0 );
+
+    *seconds    = ( xi_time_t ) tv.tv_sec;
+    *micro      = ( xi_time_t ) tv.tv_usec;
+#else
+    *seconds    = ( xi_time_t ) time( 0 );
+    *micro      = 0;
+#endif
+}
+
+void xi_time_after( xi_time_t* seconds, xi_time_t* micro, xi_time_t prev_seconds, xi_time_t prev_micro )
+{
+    if( *seconds > prev_seconds || ( *seconds == prev_seconds && *micro > prev_micro ) )
+    {
+        return;
+    }
+
+    *seconds    = prev_seconds;
+    *micro      = prev_micro + 1;
+
+    if( *micro == 1000000 )
+    {
+        *seconds   += 1;
+        *micro      = 0;
+    }
+}
+
 #ifdef __cplusplus
 }
 #endif
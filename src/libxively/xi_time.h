@@ -36,6 +36,29 @@ xi_time_t xi_mktime( struct xi_tm* t );
 
 struct xi_tm* xi_gmtime( register const xi_time_t* t );
 
+// the size of the "YYYY-MM-DDTHH:MM:SS.uuuuuuZ" text without the guard
+#define XI_ISO8601_SIZE 27
+
+/* Writes the UTC time with the microseconds and the guard into the buffer of XI_ISO8601_SIZE + 1 chars.
+ * The date and the time of the last second written are kept, so the datapoints of the same second only
+ * get their microseconds rendered.
+ */
+void xi_format_iso8601( char* buffer, xi_time_t seconds, xi_time_t micro );
+
+/* Reads the text of the xi_format_iso8601 form, returns 0 if the text is not of that form.
+ * The seconds of the last date and time read are kept in the same way.
+ */
+char xi_parse_iso8601( const char* text, xi_time_t* seconds, xi_time_t* micro );
+
+/* Reads the current UTC time, the microseconds stay 0 on the platforms without the sub-second clock.
+ */
+void xi_time_now( xi_time_t* seconds, xi_time_t* micro );
+
+/* Moves the time a microsecond past the previous one unless it is past it already, so that the
+ * datapoints stamped within the resolution of the clock still get timestamps of their own.
+ */
+void xi_time_after( xi_time_t* seconds, xi_time_t* micro, xi_time_t prev_seconds, xi_time_t prev_micro );
+
 #ifdef __cplusplus
 }
 #endif
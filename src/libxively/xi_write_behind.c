@@ -0,0 +1,220 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <string.h>
+#include <time.h>
+
+#include "xi_write_behind.h"
+#include "xi_allocator.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_data_layer_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef XI_NOB_ENABLED
+
+static uint32_t xi_write_behind_default_clock_ms( void )
+{
+    return ( uint32_t ) time( 0 ) * 1000;
+}
+
+static inline uint32_t xi_write_behind_now( const xi_write_behind_t* wb )
+{
+    return wb->config.clock_ms ? wb->config.clock_ms() : xi_write_behind_default_clock_ms();
+}
+
+static inline char xi_write_behind_is_due( const xi_write_behind_t* wb, uint32_t now )
+{
+    return now - wb->last_flush_ms >= wb->config.flush_interval_ms
+        || now - wb->oldest_ms >= wb->config.max_latency_ms;
+}
+
+static inline char xi_is_success( const xi_response_t* response )
+{
+    return response && response->http.http_status >= 200 && response->http.http_status < 300;
+}
+
+xi_context_t* xi_write_behind_enable(
+      xi_context_t* xi
+    , const xi_write_behind_config_t* config )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( config != 0 );
+
+    xi_write_behind_t* wb = ( xi_write_behind_t* ) xi->write_behind;
+
+    if( wb == 0 )
+    {
+        wb = ( xi_write_behind_t* ) xi_alloc( sizeof( xi_write_behind_t ) );
+
+        XI_CHECK_MEMORY( wb );
+
+        memset( wb, 0, sizeof( xi_write_behind_t ) );
+    }
+
+    wb->config          = *config;
+    wb->last_flush_ms   = xi_write_behind_now( wb );
+    xi->write_behind    = wb;
+
+    return xi;
+
+err_handling:
+    return 0;
+}
+
+const xi_response_t* xi_write_behind_disable( xi_context_t* xi )
+{
+    const xi_write_behind_t* wb = ( const xi_write_behind_t* ) xi->write_behind;
+    const xi_response_t* ret    = xi_write_behind_flush( xi );
+
+    // the queue that could not be sent stays enabled with all of its datapoints
+    if( wb && wb->queue.datastream_count )
+    {
+        return ret;
+    }
+
+    XI_SAFE_FREE( xi->write_behind );
+
+    return ret;
+}
+
+const xi_response_t* xi_write_behind_flush( xi_context_t* xi )
+{
+    xi_write_behind_t* wb           = ( xi_write_behind_t* ) xi->write_behind;
+    const xi_response_t* response   = 0;
+
+    if( wb == 0 || wb->queue.datastream_count == 0 )
+    {
+        return 0;
+    }
+
+    wb->last_flush_ms = xi_write_behind_now( wb );
+
+    // the feed update carries all of the queued datapoints of each datastream
+    response = xi_feed_update( xi, &wb->queue );
+
+    // nothing is lost if it fails, the whole queue is sent again
+    if( xi_is_success( response ) )
+    {
+        wb->queue.datastream_count = 0;
+    }
+
+    return response;
+}
+
+const xi_response_t* xi_write_behind_poll( xi_context_t* xi )
+{
+    xi_write_behind_t* wb = ( xi_write_behind_t* ) xi->write_behind;
+
+    if( wb == 0 || wb->queue.datastream_count == 0
+        || !xi_write_behind_is_due( wb, xi_write_behind_now( wb ) ) )
+    {
+        return 0;
+    }
+
+    return xi_write_behind_flush( xi );
+}
+
+const xi_response_t* xi_write_behind_enqueue(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    xi_write_behind_t* wb           = ( xi_write_behind_t* ) xi->write_behind;
+    xi_response_t* accepted         = xi_data_layer_response( xi->layer_chain.top );
+    const xi_response_t* response   = 0;
+    xi_datastream_t* ds             = 0;
+
+    XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME, XI_DATASTREAM_ID_TOO_LONG );
+
+    for( size_t i = 0; i < wb->queue.datastream_count; ++i )
+    {
+        if( strcmp( wb->queue.datastreams[ i ].datastream_id, datastream_id ) == 0 )
+        {
+            ds = &wb->queue.datastreams[ i ];
+            break;
+        }
+    }
+
+    // make room if the queue is full
+    if( ( ds == 0 && wb->queue.datastream_count == XI_MAX_DATASTREAMS )
+        || ( ds != 0 && wb->config.mode == XI_WRITE_BEHIND_KEEP_ALL && ds->datapoint_count == XI_MAX_DATAPOINTS ) )
+    {
+        response = xi_write_behind_flush( xi );
+
+        if( !xi_is_success( response ) )
+        {
+            return response;
+        }
+
+        ds = 0;
+    }
+
+    if( wb->queue.datastream_count == 0 )
+    {
+        wb->queue.feed_id   = xi->feed_id;
+        wb->oldest_ms       = xi_write_behind_now( wb );
+    }
+
+    if( ds == 0 )
+    {
+        ds = &wb->queue.datastreams[ wb->queue.datastream_count++ ];
+
+        strcpy( ds->datastream_id, datastream_id );
+        ds->datapoint_count = 0;
+    }
+
+    if( wb->config.mode == XI_WRITE_BEHIND_KEEP_LATEST )
+    {
+        ds->datapoints[ 0 ] = *datapoint;
+        ds->datapoint_count = 1;
+    }
+    else
+    {
+        xi_datapoint_t* dp = &ds->datapoints[ ds->datapoint_count++ ];
+
+        *dp = *datapoint;
+
+        // the server would give all of them the same timestamp, and so would
+        // the clock of the seconds to the samples taken faster than 1 Hz
+        if( dp->timestamp.timestamp == 0 )
+        {
+            xi_time_now( &dp->timestamp.timestamp, &dp->timestamp.micro );
+
+            if( ds->datapoint_count > 1 )
+            {
+                const xi_timestamp_t* prev = &ds->datapoints[ ds->datapoint_count - 2 ].timestamp;
+
+                xi_time_after( &dp->timestamp.timestamp, &dp->timestamp.micro, prev->timestamp, prev->micro );
+            }
+        }
+    }
+
+    response = xi_write_behind_poll( xi );
+
+    if( response )
+    {
+        return response;
+    }
+
+    memset( accepted, 0, sizeof( xi_response_t ) );
+
+    accepted->http.http_status = 202;
+    strcpy( accepted->http.http_status_string, "Accepted" );
+
+    return accepted;
+
+err_handling:
+    return 0;
+}
+
+#endif // XI_NOB_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,33 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_WRITE_BEHIND_H__
+#define __XI_WRITE_BEHIND_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    xi_write_behind_config_t    config;
+    xi_feed_t                   queue;          // everything that waits to be sent
+    uint32_t                    oldest_ms;      // the time the oldest queued datapoint has been queued at
+    uint32_t                    last_flush_ms;
+} xi_write_behind_t;
+
+// puts the datapoint into the context's queue, flushes the queue if it's due
+const xi_response_t* xi_write_behind_enqueue(
+      xi_context_t* xi
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_WRITE_BEHIND_H__
@@ -0,0 +1,565 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "xi_layer_api.h"
+#include "xi_common.h"
+#include "xi_ws_layer.h"
+#include "xi_ws_layer_data.h"
+#include "xi_http_layer_constants.h"
+#include "xi_connection_data.h"
+#include "xi_generator.h"
+#include "xi_resource.h"
+#include "xi_socket_api.h"
+#include "xi_coroutine.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RFC 6455 constants
+#define XI_WS_GUID              "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define XI_WS_KEY_SIZE          16
+
+#define XI_WS_OPCODE_CONTINUATION   0x0
+#define XI_WS_OPCODE_TEXT           0x1
+#define XI_WS_OPCODE_BINARY         0x2
+#define XI_WS_OPCODE_CLOSE          0x8
+#define XI_WS_OPCODE_PING           0x9
+#define XI_WS_OPCODE_PONG           0xA
+
+enum
+{
+      XI_WS_HANDSHAKE_STATUS = 0
+    , XI_WS_HANDSHAKE_HEADERS
+    , XI_WS_HANDSHAKE_DONE
+    , XI_WS_HANDSHAKE_FAILED
+};
+
+enum
+{
+      XI_WS_FRAME_HEADER = 0
+    , XI_WS_FRAME_LENGTH
+    , XI_WS_FRAME_EXTENDED_LENGTH
+    , XI_WS_FRAME_PAYLOAD
+};
+
+static inline layer_state_t ws_layer_send_raw(
+      layer_connectivity_t* context
+    , const char* data
+    , size_t size )
+{
+    const const_data_descriptor_t desc = { data, size, size, 0 };
+
+    return CALL_ON_PREV_DATA_READY( context->self, ( const void* ) &desc, LAYER_HINT_NONE );
+}
+
+static inline layer_state_t ws_layer_send_text(
+      layer_connectivity_t* context
+    , const char* text )
+{
+    return ws_layer_send_raw( context, text, strlen( text ) );
+}
+
+// masks the data with the key of the current frame and sends it in chunks
+// of XI_WS_BUFFER_SIZE bytes
+static layer_state_t ws_layer_send_masked(
+      layer_connectivity_t* context
+    , ws_layer_data_t* ws_layer_data
+    , const char* data
+    , size_t size )
+{
+    while( size > 0 )
+    {
+        const size_t chunk = XI_MIN( size, sizeof( ws_layer_data->scratch ) );
+
+        for( size_t i = 0; i < chunk; ++i )
+        {
+            ws_layer_data->scratch[ i ] = data[ i ]
+                ^ ws_layer_data->mask[ ws_layer_data->mask_pos++ & 3 ];
+        }
+
+        layer_state_t state = ws_layer_send_raw( context, ws_layer_data->scratch, chunk );
+
+        if( state != LAYER_STATE_OK )
+        {
+            return state;
+        }
+
+        data += chunk;
+        size -= chunk;
+    }
+
+    return LAYER_STATE_OK;
+}
+
+// sends the header of a single, final and masked frame and picks
+// the masking key that is going to be used for its payload
+static layer_state_t ws_layer_send_frame_header(
+      layer_connectivity_t* context
+    , ws_layer_data_t* ws_layer_data
+    , unsigned char opcode
+    , uint32_t size )
+{
+    unsigned char header[ 14 ];
+    size_t header_size = 0;
+
+    header[ header_size++ ] = 0x80 | opcode;
+
+    if( size < 126 )
+    {
+        header[ header_size++ ] = 0x80 | ( unsigned char ) size;
+    }
+    else if( size <= 0xFFFF )
+    {
+        header[ header_size++ ] = 0x80 | 126;
+        header[ header_size++ ] = ( unsigned char ) ( size >> 8 );
+        header[ header_size++ ] = ( unsigned char ) size;
+    }
+    else
+    {
+        header[ header_size++ ] = 0x80 | 127;
+
+        for( int i = 7; i >= 0; --i )
+        {
+            header[ header_size++ ] = i < 4 ? ( unsigned char ) ( size >> ( i * 8 ) ) : 0;
+        }
+    }
+
+    for( int i = 0; i < 4; ++i )
+    {
+        ws_layer_data->mask[ i ]    = ( unsigned char ) ( rand() & 0xFF );
+        header[ header_size++ ]     = ws_layer_data->mask[ i ];
+    }
+
+    ws_layer_data->mask_pos = 0;
+
+    return ws_layer_send_raw( context, ( const char* ) header, header_size );
+}
+
+static layer_state_t ws_layer_send_generated(
+      layer_connectivity_t* context
+    , ws_layer_data_t* ws_layer_data
+    , xi_generator_t* gen
+    , const void* input )
+{
+    short gstate = 0;
+
+    while( gstate != 1 )
+    {
+        const const_data_descriptor_t* data
+            = ( const const_data_descriptor_t* ) ( *gen )( input, &gstate );
+
+        if( data )
+        {
+            layer_state_t state = ws_layer_send_masked(
+                  context, ws_layer_data, data->data_ptr, data->real_size );
+
+            if( state != LAYER_STATE_OK )
+            {
+                return state;
+            }
+        }
+    }
+
+    return LAYER_STATE_OK;
+}
+
+static void ws_layer_reset_parser( ws_layer_data_t* ws_layer_data )
+{
+    ws_layer_data->frame_state      = XI_WS_FRAME_HEADER;
+    ws_layer_data->payload_size     = 0;
+    ws_layer_data->payload_pos      = 0;
+
+    xi_socket_response_init( &ws_layer_data->message );
+}
+
+layer_state_t ws_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    ws_layer_data_t* ws_layer_data              = ( ws_layer_data_t* ) context->self->user_data;
+    const http_layer_input_t* http_layer_input  = ( const http_layer_input_t* ) data;
+    const char* method                          = xi_resource_method( http_layer_input->query_type );
+
+    if( method == 0 || !ws_layer_data->connected )
+    {
+        return LAYER_STATE_ERROR;
+    }
+
+    ws_layer_reset_parser( ws_layer_data );
+
+    layer_state_t state = ws_layer_send_frame_header(
+          context, ws_layer_data, XI_WS_OPCODE_TEXT
+        , xi_generator_length( &xi_socket_request_generator, http_layer_input ) );
+
+    if( state == LAYER_STATE_OK )
+    {
+        state = ws_layer_send_generated( context, ws_layer_data, &xi_socket_request_generator, http_layer_input );
+    }
+
+    return state;
+}
+
+// parses the server's part of the opening handshake, the only things that
+// matter are the 101 status and the value of the Sec-WebSocket-Accept
+static layer_state_t ws_layer_parse_handshake(
+      ws_layer_data_t* ws_layer_data
+    , const_data_descriptor_t* buffer )
+{
+    while( buffer->curr_pos < buffer->real_size )
+    {
+        const char c = buffer->data_ptr[ buffer->curr_pos++ ];
+
+        if( c == '\r' )
+        {
+            continue;
+        }
+
+        if( c != '\n' )
+        {
+            if( ws_layer_data->line_size < sizeof( ws_layer_data->line ) - 1 )
+            {
+                ws_layer_data->line[ ws_layer_data->line_size++ ] = c;
+            }
+
+            continue;
+        }
+
+        ws_layer_data->line[ ws_layer_data->line_size ] = '\0';
+        ws_layer_data->line_size = 0;
+
+        if( ws_layer_data->handshake_state == XI_WS_HANDSHAKE_STATUS )
+        {
+            if( strncmp( ws_layer_data->line, "HTTP/1.1 101", 12 ) != 0 )
+            {
+                xi_debug_format( "unexpected handshake status: %s", ws_layer_data->line );
+                ws_layer_data->handshake_state = XI_WS_HANDSHAKE_FAILED;
+                return LAYER_STATE_OK;
+            }
+
+            ws_layer_data->handshake_state = XI_WS_HANDSHAKE_HEADERS;
+        }
+        else if( ws_layer_data->line[ 0 ] == '\0' )
+        {
+            ws_layer_data->handshake_state = ws_layer_data->accept_ok
+                ? XI_WS_HANDSHAKE_DONE : XI_WS_HANDSHAKE_FAILED;
+            return LAYER_STATE_OK;
+        }
+        else if( strncasecmp( ws_layer_data->line, "sec-websocket-accept:", 21 ) == 0 )
+        {
+            const char* value = ws_layer_data->line + 21;
+
+            while( *value == ' ' ) { ++value; }
+
+            ws_layer_data->accept_ok = strcmp( value, ws_layer_data->expected_accept ) == 0;
+        }
+    }
+
+    return LAYER_STATE_WANT_READ;
+}
+
+// handles a piece of the data message, the message is the envelope of the socket api
+static layer_state_t ws_layer_on_message(
+      layer_connectivity_t* context
+    , ws_layer_data_t* ws_layer_data
+    , const char* data
+    , size_t size
+    , char last )
+{
+    const_data_descriptor_t piece = { data, ( unsigned short ) size, ( unsigned short ) size, 0 };
+
+    const layer_state_t state = xi_socket_response_parse(
+          &ws_layer_data->message, context, ws_layer_data->response, &piece );
+
+    if( state == LAYER_STATE_ERROR )
+    {
+        return state;
+    }
+
+    // nothing but the envelope is expected within the message
+    return last && state != LAYER_STATE_OK ? LAYER_STATE_ERROR : LAYER_STATE_OK;
+}
+
+// called when the whole payload of a frame has been received
+static layer_state_t ws_layer_on_frame_end(
+      layer_connectivity_t* context
+    , ws_layer_data_t* ws_layer_data )
+{
+    layer_state_t state             = LAYER_STATE_OK;
+    const unsigned char opcode      = ws_layer_data->frame_opcode;
+
+    ws_layer_data->frame_state      = XI_WS_FRAME_HEADER;
+
+    switch( opcode )
+    {
+        case XI_WS_OPCODE_PING:
+            state = ws_layer_send_frame_header(
+                  context, ws_layer_data, XI_WS_OPCODE_PONG, ws_layer_data->payload_size );
+
+            if( state == LAYER_STATE_OK )
+            {
+                state = ws_layer_send_masked(
+                      context, ws_layer_data
+                    , ( const char* ) ws_layer_data->control, ws_layer_data->payload_size );
+            }
+
+            return state == LAYER_STATE_OK ? LAYER_STATE_WANT_READ : state;
+        case XI_WS_OPCODE_PONG:
+            return LAYER_STATE_WANT_READ;
+        case XI_WS_OPCODE_CLOSE:
+            xi_debug_logger( "connection closed by the server" );
+            ws_layer_data->connected = 0;
+            return LAYER_STATE_ERROR;
+        default:
+            return ws_layer_data->frame_fin ? LAYER_STATE_OK : LAYER_STATE_WANT_READ;
+    }
+}
+
+layer_state_t ws_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    ws_layer_data_t* ws_layer_data      = ( ws_layer_data_t* ) context->self->user_data;
+    const_data_descriptor_t* buffer     = ( const_data_descriptor_t* ) data;
+
+    if( !ws_layer_data->connected )
+    {
+        return ws_layer_parse_handshake( ws_layer_data, buffer );
+    }
+
+    while( buffer->curr_pos < buffer->real_size
+        || ( ws_layer_data->frame_state == XI_WS_FRAME_PAYLOAD
+            && ws_layer_data->payload_pos == ws_layer_data->payload_size ) )
+    {
+        if( ws_layer_data->frame_state == XI_WS_FRAME_PAYLOAD )
+        {
+            const uint32_t size = XI_MIN(
+                  ( uint32_t ) ( buffer->real_size - buffer->curr_pos )
+                , ws_layer_data->payload_size - ws_layer_data->payload_pos );
+            const char* ptr = buffer->data_ptr + buffer->curr_pos;
+            const char last = ws_layer_data->payload_pos + size == ws_layer_data->payload_size;
+
+            if( ws_layer_data->frame_opcode & 0x8 )
+            {
+                memcpy( ws_layer_data->control + ws_layer_data->payload_pos, ptr, size );
+            }
+            else
+            {
+                layer_state_t state = ws_layer_on_message(
+                      context, ws_layer_data, ptr, size
+                    , last && ws_layer_data->frame_fin );
+
+                if( state == LAYER_STATE_ERROR )
+                {
+                    return state;
+                }
+            }
+
+            buffer->curr_pos            += size;
+            ws_layer_data->payload_pos  += size;
+
+            if( last )
+            {
+                layer_state_t state = ws_layer_on_frame_end( context, ws_layer_data );
+
+                if( state != LAYER_STATE_WANT_READ )
+                {
+                    return state;
+                }
+            }
+
+            continue;
+        }
+
+        const unsigned char c = ( unsigned char ) buffer->data_ptr[ buffer->curr_pos++ ];
+
+        if( ws_layer_data->frame_state == XI_WS_FRAME_HEADER )
+        {
+            ws_layer_data->frame_fin    = ( c & 0x80 ) != 0;
+            ws_layer_data->frame_opcode = c & 0x0F;
+            ws_layer_data->frame_state  = XI_WS_FRAME_LENGTH;
+            continue;
+        }
+
+        if( ws_layer_data->frame_state == XI_WS_FRAME_LENGTH )
+        {
+            // frames sent by the server must not be masked
+            if( c & 0x80 )
+            {
+                xi_debug_logger( "masked frame from the server" );
+                return LAYER_STATE_ERROR;
+            }
+
+            ws_layer_data->payload_size = c & 0x7F;
+            ws_layer_data->payload_pos  = 0;
+
+            if( ws_layer_data->payload_size >= 126 )
+            {
+                ws_layer_data->frame_counter    = ws_layer_data->payload_size == 126 ? 2 : 8;
+                ws_layer_data->payload_size     = 0;
+                ws_layer_data->frame_state      = XI_WS_FRAME_EXTENDED_LENGTH;
+                continue;
+            }
+        }
+        else // XI_WS_FRAME_EXTENDED_LENGTH
+        {
+            // only 32-bit lengths are supported
+            if( ws_layer_data->payload_size & 0xFF000000 )
+            {
+                return LAYER_STATE_ERROR;
+            }
+
+            ws_layer_data->payload_size = ( ws_layer_data->payload_size << 8 ) | c;
+
+            if( --ws_layer_data->frame_counter > 0 )
+            {
+                continue;
+            }
+        }
+
+        // control frames must fit in a single frame of at most 125 bytes
+        if( ( ws_layer_data->frame_opcode & 0x8 )
+            && ws_layer_data->payload_size > sizeof( ws_layer_data->control ) )
+        {
+            return LAYER_STATE_ERROR;
+        }
+
+        ws_layer_data->frame_state = XI_WS_FRAME_PAYLOAD;
+    }
+
+    return LAYER_STATE_WANT_READ;
+}
+
+layer_state_t ws_layer_close(
+      layer_connectivity_t* context )
+{
+    ws_layer_data_t* ws_layer_data = ( ws_layer_data_t* ) context->self->user_data;
+
+    // the handshake cut short starts over with the next connect
+    ws_layer_data->connect_state = 0;
+
+    if( ws_layer_data->connected )
+    {
+        // status code 1000 - normal closure
+        static const char code[] = { 0x03, ( char ) 0xE8 };
+
+        ws_layer_data->connected = 0;
+
+        if( ws_layer_send_frame_header( context, ws_layer_data, XI_WS_OPCODE_CLOSE, sizeof( code ) ) == LAYER_STATE_OK )
+        {
+            ws_layer_send_masked( context, ws_layer_data, code, sizeof( code ) );
+        }
+    }
+
+    return CALL_ON_PREV_CLOSE( context->self );
+}
+
+layer_state_t ws_layer_on_close(
+      layer_connectivity_t* context )
+{
+    ws_layer_data_t* ws_layer_data = ( ws_layer_data_t* ) context->self->user_data;
+
+    ws_layer_data->connected      = 0;
+    ws_layer_data->connect_state  = 0;
+
+    return CALL_ON_NEXT_ON_CLOSE( context->self );
+}
+
+layer_state_t ws_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint )
+{
+    XI_UNUSED( hint );
+
+    ws_layer_data_t* ws_layer_data              = ( ws_layer_data_t* ) context->self->user_data;
+    const xi_connection_data_t* connection_data = ( const xi_connection_data_t* ) data;
+
+    BEGIN_CORO( ws_layer_data->connect_state )
+
+    {
+        unsigned char nonce[ XI_WS_KEY_SIZE ];
+        unsigned char digest[ XI_SHA1_DIGEST_SIZE ];
+        char key[ XI_BASE64_ENCODED_SIZE( XI_WS_KEY_SIZE ) + 1 ];
+        xi_sha1_t sha1;
+
+        for( size_t i = 0; i < sizeof( nonce ); ++i )
+        {
+            nonce[ i ] = ( unsigned char ) ( rand() & 0xFF );
+        }
+
+        xi_base64_encode( key, nonce, sizeof( nonce ) );
+
+        xi_sha1_init( &sha1 );
+        xi_sha1_update( &sha1, key, strlen( key ) );
+        xi_sha1_update( &sha1, XI_WS_GUID, sizeof( XI_WS_GUID ) - 1 );
+        xi_sha1_final( &sha1, digest );
+
+        xi_base64_encode( ws_layer_data->expected_accept, digest, sizeof( digest ) );
+
+        ws_layer_data->connected        = 0;
+        ws_layer_data->handshake_state  = XI_WS_HANDSHAKE_STATUS;
+        ws_layer_data->accept_ok        = 0;
+        ws_layer_data->line_size        = 0;
+
+        layer_state_t state = ws_layer_send_text( context, "GET " XI_WS_RESOURCE " HTTP/1.1\r\n" );
+
+        if( state == LAYER_STATE_OK )
+        {
+            snprintf( ws_layer_data->line, sizeof( ws_layer_data->line )
+                , "Host: %s:%d\r\n", connection_data->address, connection_data->port );
+            state = ws_layer_send_text( context, ws_layer_data->line );
+        }
+
+        if( state == LAYER_STATE_OK )
+        {
+            state = ws_layer_send_text( context
+                , "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Version: 13\r\n"
+                  "Sec-WebSocket-Key: " );
+        }
+
+        if( state == LAYER_STATE_OK ) { state = ws_layer_send_text( context, key ); }
+        if( state == LAYER_STATE_OK ) { state = ws_layer_send_text( context, XI_HTTP_CRLF ); }
+        if( state == LAYER_STATE_OK ) { state = ws_layer_send_text( context, XI_HTTP_TEMPLATE_USER_AGENT ); }
+        if( state == LAYER_STATE_OK ) { state = ws_layer_send_text( context, XI_USER_AGENT ); }
+        if( state == LAYER_STATE_OK ) { state = ws_layer_send_text( context, "\r\n\r\n" ); }
+
+        ws_layer_data->line_size = 0;
+
+        if( state != LAYER_STATE_OK )
+        {
+            EXIT( ws_layer_data->connect_state, LAYER_STATE_ERROR );
+        }
+    }
+
+    // the response is parsed by the on_data_ready
+    YIELD( ws_layer_data->connect_state, LAYER_STATE_WANT_READ );
+
+    ws_layer_data->connected = ws_layer_data->handshake_state == XI_WS_HANDSHAKE_DONE;
+
+    // make the next connect start from the beginning
+    RESTART( ws_layer_data->connect_state, ws_layer_data->connected ? LAYER_STATE_OK : LAYER_STATE_ERROR );
+
+    END_CORO()
+
+    return LAYER_STATE_ERROR;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,44 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_WS_LAYER_H__
+#define __XI_WS_LAYER_H__
+
+#include "xi_layer.h"
+#include "xi_http_layer_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The WebSocket layer replaces the HTTP layer for the XI_WS protocol. Each
+// request is sent as a single masked text frame that holds the JSON envelope
+// of the socket api, see xi_socket_api.h, and the server replies with the
+// envelope of the response in a text message.
+
+layer_state_t ws_layer_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t ws_layer_on_data_ready(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+layer_state_t ws_layer_close(
+      layer_connectivity_t* context );
+
+layer_state_t ws_layer_on_close(
+      layer_connectivity_t* context );
+
+layer_state_t ws_layer_connect(
+      layer_connectivity_t* context
+    , const void* data
+    , const layer_hint_t hint );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_WS_LAYER_H__
@@ -0,0 +1,53 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+#ifndef __XI_WS_LAYER_DATA_H__
+#define __XI_WS_LAYER_DATA_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+#include "xi_config.h"
+#include "xi_sha1.h"
+#include "xi_base64.h"
+#include "xi_socket_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    // connection and handshake
+    char                        connected;
+    short                       connect_state;
+    char                        handshake_state;
+    char                        accept_ok;
+    char                        expected_accept[ XI_BASE64_ENCODED_SIZE( XI_SHA1_DIGEST_SIZE ) + 1 ];
+    unsigned char               line_size;
+    char                        line[ XI_WS_BUFFER_SIZE ];
+
+    // outgoing frames
+    unsigned char               mask[ 4 ];
+    unsigned char               mask_pos;
+    char                        scratch[ XI_WS_BUFFER_SIZE ];
+
+    // incoming frames
+    unsigned char               frame_state;
+    unsigned char               frame_fin;
+    unsigned char               frame_opcode;
+    unsigned char               frame_counter;
+    uint32_t                    payload_size;
+    uint32_t                    payload_pos;
+    unsigned char               control[ 125 ];
+
+    // incoming message
+    xi_socket_response_t        message;
+    xi_response_t*              response;
+} ws_layer_data_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_WS_LAYER_DATA_H__
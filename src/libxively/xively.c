@@ -9,6 +9,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "xi_allocator.h"
 #include "xively.h"
@@ -28,7 +29,23 @@
 #include "xi_http_layer.h"
 #include "xi_http_layer_data.h"
 #include "xi_csv_layer.h"
+#include "xi_json_layer.h"
+#include "xi_cbor_layer.h"
+#include "xi_data_layer_data.h"
+#include "xi_ws_layer.h"
+#include "xi_ws_layer_data.h"
+#include "xi_tcp_layer.h"
+#include "xi_tcp_layer_data.h"
+#include "xi_mqtt_layer.h"
+#include "xi_mqtt_layer_data.h"
+#include "xi_http2_layer.h"
+#include "xi_http2_layer_data.h"
 #include "xi_connection_data.h"
+#include "xi_write_behind.h"
+#include "xi_aggregator.h"
+#include "xi_outbox.h"
+#include "xi_feed_cache.h"
+#include "xi_feed_delta.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -170,6 +187,31 @@ uint32_t xi_get_network_timeout( void )
     return xi_globals.network_timeout;
 }
 
+void xi_set_response_mode( xi_context_t* xi, xi_response_mode_t mode )
+{
+    xi->response_mode = mode;
+}
+
+void xi_set_mqtt_qos( xi_context_t* xi, uint8_t qos )
+{
+    xi->mqtt_qos = qos ? 1 : 0;
+}
+
+void xi_set_retry_policy( const xi_retry_policy_t* policy )
+{
+    xi_globals.retry_policy = *policy;
+
+    if( xi_globals.retry_policy.max_attempts == 0 )
+    {
+        xi_globals.retry_policy.max_attempts = 1;
+    }
+}
+
+const xi_retry_policy_t* xi_get_retry_policy( void )
+{
+    return &xi_globals.retry_policy;
+}
+
 //-----------------------------------------------------------------------
 // LAYERS SETTINGS
 //-----------------------------------------------------------------------
@@ -187,6 +229,12 @@ enum LAYERS_ID
       IO_LAYER = 0
     , HTTP_LAYER
     , CSV_LAYER
+    , WS_LAYER
+    , TCP_LAYER
+    , MQTT_LAYER
+    , HTTP2_LAYER
+    , JSON_LAYER
+    , CBOR_LAYER
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -194,6 +242,26 @@ enum LAYERS_ID
 #define CONNECTION_SCHEME_1_DATA IO_LAYER, HTTP_LAYER, CSV_LAYER
 DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_1, CONNECTION_SCHEME_1_DATA );
 
+#define CONNECTION_SCHEME_6_DATA IO_LAYER, HTTP_LAYER, JSON_LAYER
+DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_6, CONNECTION_SCHEME_6_DATA );
+
+#define CONNECTION_SCHEME_7_DATA IO_LAYER, HTTP_LAYER, CBOR_LAYER
+DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_7, CONNECTION_SCHEME_7_DATA );
+
+#ifndef XI_NOB_ENABLED
+#define CONNECTION_SCHEME_2_DATA IO_LAYER, WS_LAYER, JSON_LAYER
+DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_2, CONNECTION_SCHEME_2_DATA );
+
+#define CONNECTION_SCHEME_3_DATA IO_LAYER, TCP_LAYER, JSON_LAYER
+DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_3, CONNECTION_SCHEME_3_DATA );
+
+#define CONNECTION_SCHEME_4_DATA IO_LAYER, MQTT_LAYER, CSV_LAYER
+DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_4, CONNECTION_SCHEME_4_DATA );
+
+#define CONNECTION_SCHEME_5_DATA IO_LAYER, HTTP2_LAYER, CSV_LAYER
+DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_5, CONNECTION_SCHEME_5_DATA );
+#endif
+
 #if XI_IO_LAYER == XI_IO_POSIX
 
     // posix io layer
@@ -209,6 +277,18 @@ DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_1, CONNECTION_SCHEME_1_DATA );
                                 , &http_layer_close, &http_layer_on_close, 0, 0 )
         , LAYER_TYPE( CSV_LAYER, &csv_layer_data_ready, &csv_layer_on_data_ready
                             , &csv_layer_close, &csv_layer_on_close, 0, 0 )
+        , LAYER_TYPE( WS_LAYER, &ws_layer_data_ready, &ws_layer_on_data_ready
+                              , &ws_layer_close, &ws_layer_on_close, 0, &ws_layer_connect )
+        , LAYER_TYPE( TCP_LAYER, &tcp_layer_data_ready, &tcp_layer_on_data_ready
+                               , &tcp_layer_close, &tcp_layer_on_close, 0, &tcp_layer_connect )
+        , LAYER_TYPE( MQTT_LAYER, &mqtt_layer_data_ready, &mqtt_layer_on_data_ready
+                                , &mqtt_layer_close, &mqtt_layer_on_close, 0, &mqtt_layer_connect )
+        , LAYER_TYPE( HTTP2_LAYER, &http2_layer_data_ready, &http2_layer_on_data_ready
+                                 , &http2_layer_close, &http2_layer_on_close, 0, &http2_layer_connect )
+        , LAYER_TYPE( JSON_LAYER, &json_layer_data_ready, &json_layer_on_data_ready
+                                , &json_layer_close, &json_layer_on_close, 0, 0 )
+        , LAYER_TYPE( CBOR_LAYER, &cbor_layer_data_ready, &cbor_layer_on_data_ready
+                                , &cbor_layer_close, &cbor_layer_on_close, 0, 0 )
     END_LAYER_TYPES_CONF()
 
 #elif XI_IO_LAYER == XI_IO_DUMMY
@@ -225,6 +305,18 @@ DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_1, CONNECTION_SCHEME_1_DATA );
                                 , &http_layer_close, &http_layer_on_close, 0, 0 )
         , LAYER_TYPE( CSV_LAYER, &csv_layer_data_ready, &csv_layer_on_data_ready
                             , &csv_layer_close, &csv_layer_on_close, 0, 0 )
+        , LAYER_TYPE( WS_LAYER, &ws_layer_data_ready, &ws_layer_on_data_ready
+                              , &ws_layer_close, &ws_layer_on_close, 0, &ws_layer_connect )
+        , LAYER_TYPE( TCP_LAYER, &tcp_layer_data_ready, &tcp_layer_on_data_ready
+                               , &tcp_layer_close, &tcp_layer_on_close, 0, &tcp_layer_connect )
+        , LAYER_TYPE( MQTT_LAYER, &mqtt_layer_data_ready, &mqtt_layer_on_data_ready
+                                , &mqtt_layer_close, &mqtt_layer_on_close, 0, &mqtt_layer_connect )
+        , LAYER_TYPE( HTTP2_LAYER, &http2_layer_data_ready, &http2_layer_on_data_ready
+                                 , &http2_layer_close, &http2_layer_on_close, 0, &http2_layer_connect )
+        , LAYER_TYPE( JSON_LAYER, &json_layer_data_ready, &json_layer_on_data_ready
+                                , &json_layer_close, &json_layer_on_close, 0, 0 )
+        , LAYER_TYPE( CBOR_LAYER, &cbor_layer_data_ready, &cbor_layer_on_data_ready
+                                , &cbor_layer_close, &cbor_layer_on_close, 0, 0 )
     END_LAYER_TYPES_CONF()
 
 #elif XI_IO_LAYER == XI_IO_MBED
@@ -240,6 +332,18 @@ DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_1, CONNECTION_SCHEME_1_DATA );
                                 , &http_layer_close, &http_layer_on_close )
         , LAYER_TYPE( CSV_LAYER, &csv_layer_data_ready, &csv_layer_on_data_ready
                             , &csv_layer_close, &csv_layer_on_close )
+        , LAYER_TYPE( WS_LAYER, &ws_layer_data_ready, &ws_layer_on_data_ready
+                              , &ws_layer_close, &ws_layer_on_close )
+        , LAYER_TYPE( TCP_LAYER, &tcp_layer_data_ready, &tcp_layer_on_data_ready
+                               , &tcp_layer_close, &tcp_layer_on_close )
+        , LAYER_TYPE( MQTT_LAYER, &mqtt_layer_data_ready, &mqtt_layer_on_data_ready
+                                , &mqtt_layer_close, &mqtt_layer_on_close )
+        , LAYER_TYPE( HTTP2_LAYER, &http2_layer_data_ready, &http2_layer_on_data_ready
+                                 , &http2_layer_close, &http2_layer_on_close )
+        , LAYER_TYPE( JSON_LAYER, &json_layer_data_ready, &json_layer_on_data_ready
+                                , &json_layer_close, &json_layer_on_close )
+        , LAYER_TYPE( CBOR_LAYER, &cbor_layer_data_ready, &cbor_layer_on_data_ready
+                                , &cbor_layer_close, &cbor_layer_on_close )
     END_LAYER_TYPES_CONF()
 
 #elif XI_IO_LAYER == XI_IO_POSIX_ASYNCH
@@ -256,6 +360,18 @@ DEFINE_CONNECTION_SCHEME( CONNECTION_SCHEME_1, CONNECTION_SCHEME_1_DATA );
                                 , &http_layer_close, &http_layer_on_close, 0, 0 )
         , LAYER_TYPE( CSV_LAYER, &csv_layer_data_ready, &csv_layer_on_data_ready
                             , &csv_layer_close, &csv_layer_on_close, 0, 0 )
+        , LAYER_TYPE( WS_LAYER, &ws_layer_data_ready, &ws_layer_on_data_ready
+                              , &ws_layer_close, &ws_layer_on_close, 0, &ws_layer_connect )
+        , LAYER_TYPE( TCP_LAYER, &tcp_layer_data_ready, &tcp_layer_on_data_ready
+                               , &tcp_layer_close, &tcp_layer_on_close, 0, &tcp_layer_connect )
+        , LAYER_TYPE( MQTT_LAYER, &mqtt_layer_data_ready, &mqtt_layer_on_data_ready
+                                , &mqtt_layer_close, &mqtt_layer_on_close, 0, &mqtt_layer_connect )
+        , LAYER_TYPE( HTTP2_LAYER, &http2_layer_data_ready, &http2_layer_on_data_ready
+                                 , &http2_layer_close, &http2_layer_on_close, 0, &http2_layer_connect )
+        , LAYER_TYPE( JSON_LAYER, &json_layer_data_ready, &json_layer_on_data_ready
+                                , &json_layer_close, &json_layer_on_close, 0, 0 )
+        , LAYER_TYPE( CBOR_LAYER, &cbor_layer_data_ready, &cbor_layer_on_data_ready
+                                , &cbor_layer_close, &cbor_layer_on_close, 0, 0 )
     END_LAYER_TYPES_CONF()
 #endif
 
@@ -268,6 +384,18 @@ BEGIN_FACTORY_CONF()
                                , &default_layer_heap_alloc, &default_layer_heap_free )
     , FACTORY_ENTRY( CSV_LAYER, &placement_layer_pass_create, &placement_layer_pass_delete
                            , &default_layer_heap_alloc, &default_layer_heap_free )
+    , FACTORY_ENTRY( WS_LAYER, &placement_layer_pass_create, &placement_layer_pass_delete
+                          , &default_layer_heap_alloc, &default_layer_heap_free )
+    , FACTORY_ENTRY( TCP_LAYER, &placement_layer_pass_create, &placement_layer_pass_delete
+                           , &default_layer_heap_alloc, &default_layer_heap_free )
+    , FACTORY_ENTRY( MQTT_LAYER, &placement_layer_pass_create, &placement_layer_pass_delete
+                            , &default_layer_heap_alloc, &default_layer_heap_free )
+    , FACTORY_ENTRY( HTTP2_LAYER, &placement_layer_pass_create, &placement_layer_pass_delete
+                             , &default_layer_heap_alloc, &default_layer_heap_free )
+    , FACTORY_ENTRY( JSON_LAYER, &placement_layer_pass_create, &placement_layer_pass_delete
+                            , &default_layer_heap_alloc, &default_layer_heap_free )
+    , FACTORY_ENTRY( CBOR_LAYER, &placement_layer_pass_create, &placement_layer_pass_delete
+                            , &default_layer_heap_alloc, &default_layer_heap_free )
 END_FACTORY_CONF()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -289,6 +417,14 @@ xi_context_t* xi_create_context(
     // copy given numeric parameters as is
     ret->protocol       = protocol;
     ret->feed_id        = feed_id;
+    ret->response_mode  = XI_RESPONSE_MODE_FULL;
+    ret->write_behind   = 0;
+    ret->feed_cache     = 0;
+    ret->aggregator     = 0;
+    ret->outbox         = 0;
+    ret->connected      = 0;
+    ret->mqtt_qos       = 0;
+    ret->http2_submit   = 0;
 
     // copy string parameters carefully
     if( api_key )
@@ -330,6 +466,130 @@ xi_context_t* xi_create_context(
                 ret->layer_chain = create_and_connect_layers( CONNECTION_SCHEME_1, user_datas, CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_1 ) );
             }
             break;
+        case XI_HTTP_JSON:
+            {
+                static http_layer_data_t    http_layer_data;
+                static json_layer_data_t    json_layer_data;
+                static xi_response_t        xi_response;
+
+                // clean the structures
+                memset( &http_layer_data, 0, sizeof( http_layer_data_t ) );
+                memset( &json_layer_data, 0, sizeof( json_layer_data_t ) );
+                memset( &xi_response, 0, sizeof( xi_response_t ) );
+
+                // the response pointer
+                http_layer_data.response    = &xi_response;
+                json_layer_data.response    = &xi_response;
+
+                void* user_datas[] = { 0, ( void* ) &http_layer_data, ( void* ) &json_layer_data };
+
+                ret->layer_chain = create_and_connect_layers( CONNECTION_SCHEME_6, user_datas, CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_6 ) );
+            }
+            break;
+        case XI_HTTP_CBOR:
+            {
+                static http_layer_data_t    http_layer_data;
+                static cbor_layer_data_t    cbor_layer_data;
+                static xi_response_t        xi_response;
+
+                // clean the structures
+                memset( &http_layer_data, 0, sizeof( http_layer_data_t ) );
+                memset( &cbor_layer_data, 0, sizeof( cbor_layer_data_t ) );
+                memset( &xi_response, 0, sizeof( xi_response_t ) );
+
+                // the response pointer
+                http_layer_data.response    = &xi_response;
+                cbor_layer_data.response    = &xi_response;
+
+                void* user_datas[] = { 0, ( void* ) &http_layer_data, ( void* ) &cbor_layer_data };
+
+                ret->layer_chain = create_and_connect_layers( CONNECTION_SCHEME_7, user_datas, CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_7 ) );
+            }
+            break;
+#ifndef XI_NOB_ENABLED
+        case XI_WS:
+            {
+                static ws_layer_data_t      ws_layer_data;
+                static json_layer_data_t    json_layer_data;
+                static xi_response_t        xi_response;
+
+                // clean the structures
+                memset( &ws_layer_data, 0, sizeof( ws_layer_data_t ) );
+                memset( &json_layer_data, 0, sizeof( json_layer_data_t ) );
+                memset( &xi_response, 0, sizeof( xi_response_t ) );
+
+                // the socket api carries the JSON bodies
+                ws_layer_data.response      = &xi_response;
+                json_layer_data.response    = &xi_response;
+
+                void* user_datas[] = { 0, ( void* ) &ws_layer_data, ( void* ) &json_layer_data };
+
+                ret->layer_chain = create_and_connect_layers( CONNECTION_SCHEME_2, user_datas, CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_2 ) );
+            }
+            break;
+        case XI_TCP:
+            {
+                static tcp_layer_data_t     tcp_layer_data;
+                static json_layer_data_t    json_layer_data;
+                static xi_response_t        xi_response;
+
+                // clean the structures
+                memset( &tcp_layer_data, 0, sizeof( tcp_layer_data_t ) );
+                memset( &json_layer_data, 0, sizeof( json_layer_data_t ) );
+                memset( &xi_response, 0, sizeof( xi_response_t ) );
+
+                // the socket api carries the JSON bodies
+                tcp_layer_data.response     = &xi_response;
+                json_layer_data.response    = &xi_response;
+
+                void* user_datas[] = { 0, ( void* ) &tcp_layer_data, ( void* ) &json_layer_data };
+
+                ret->layer_chain = create_and_connect_layers( CONNECTION_SCHEME_3, user_datas, CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_3 ) );
+            }
+            break;
+        case XI_MQTT:
+            {
+                static mqtt_layer_data_t    mqtt_layer_data;
+                static csv_layer_data_t     csv_layer_data;
+                static xi_response_t        xi_response;
+
+                // clean the structures
+                memset( &mqtt_layer_data, 0, sizeof( mqtt_layer_data_t ) );
+                memset( &csv_layer_data, 0, sizeof( csv_layer_data_t ) );
+                memset( &xi_response, 0, sizeof( xi_response_t ) );
+
+                // the api key is the user name of the session
+                mqtt_layer_data.api_key     = ret->api_key ? ret->api_key : "";
+                mqtt_layer_data.response    = &xi_response;
+                csv_layer_data.response     = &xi_response;
+
+                void* user_datas[] = { 0, ( void* ) &mqtt_layer_data, ( void* ) &csv_layer_data };
+
+                ret->layer_chain = create_and_connect_layers( CONNECTION_SCHEME_4, user_datas, CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_4 ) );
+            }
+            break;
+        case XI_HTTP2:
+            {
+                static http2_layer_data_t   http2_layer_data;
+                static csv_layer_data_t     csv_layer_data;
+                static xi_response_t        xi_response;
+
+                // clean the structures
+                memset( &http2_layer_data, 0, sizeof( http2_layer_data_t ) );
+                memset( &csv_layer_data, 0, sizeof( csv_layer_data_t ) );
+                memset( &xi_response, 0, sizeof( xi_response_t ) );
+
+                // the api key is indexed by the server after the first request
+                http2_layer_data.api_key    = ret->api_key ? ret->api_key : "";
+                http2_layer_data.response   = &xi_response;
+                csv_layer_data.response     = &xi_response;
+
+                void* user_datas[] = { 0, ( void* ) &http2_layer_data, ( void* ) &csv_layer_data };
+
+                ret->layer_chain = create_and_connect_layers( CONNECTION_SCHEME_5, user_datas, CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_5 ) );
+            }
+            break;
+#endif
         default:
             goto err_handling;
     }
@@ -360,389 +620,711 @@ void xi_delete_context( xi_context_t* context )
         case XI_HTTP:
             destroy_and_disconnect_layers( &( context->layer_chain ), CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_1 ) );
             break;
+        case XI_HTTP_JSON:
+            destroy_and_disconnect_layers( &( context->layer_chain ), CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_6 ) );
+            break;
+        case XI_HTTP_CBOR:
+            destroy_and_disconnect_layers( &( context->layer_chain ), CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_7 ) );
+            break;
+#ifndef XI_NOB_ENABLED
+        case XI_WS:
+            if( context->connected )
+            {
+                CALL_ON_SELF_CLOSE( context->layer_chain.top );
+            }
+
+            destroy_and_disconnect_layers( &( context->layer_chain ), CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_2 ) );
+            break;
+        case XI_TCP:
+            if( context->connected )
+            {
+                CALL_ON_SELF_CLOSE( context->layer_chain.top );
+            }
+
+            destroy_and_disconnect_layers( &( context->layer_chain ), CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_3 ) );
+            break;
+        case XI_MQTT:
+            if( context->connected )
+            {
+                CALL_ON_SELF_CLOSE( context->layer_chain.top );
+            }
+
+            destroy_and_disconnect_layers( &( context->layer_chain ), CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_4 ) );
+            break;
+        case XI_HTTP2:
+            if( context->connected )
+            {
+                CALL_ON_SELF_CLOSE( context->layer_chain.top );
+            }
+
+            destroy_and_disconnect_layers( &( context->layer_chain ), CONNECTION_SCHEME_LENGTH( CONNECTION_SCHEME_5 ) );
+            break;
+#endif
         default:
             assert( 0 && "not yet implemented!" );
             break;
     }
 
+#if defined( XI_OUTBOX_ENABLED ) && !defined( XI_NOB_ENABLED )
+    xi_outbox_disable( context );
+#endif
+
+    XI_SAFE_FREE( context->write_behind );
+    XI_SAFE_FREE( context->feed_cache );
+    XI_SAFE_FREE( context->aggregator );
     XI_SAFE_FREE( context->api_key );
     XI_SAFE_FREE( context );
 }
 
 #ifndef XI_NOB_ENABLED
-const xi_response_t* xi_feed_get(
-          xi_context_t* xi
-        , xi_feed_t* feed )
-{
-    // we shall need it later
-    layer_state_t state = LAYER_STATE_OK;
-
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
-
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
-
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
+//-----------------------------------------------------------------------
+// REQUEST HELPERS
+//-----------------------------------------------------------------------
 
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
-    }
+static void xi_default_sleep_ms( uint32_t milliseconds )
+{
+#if XI_IO_LAYER == XI_IO_POSIX
+    struct timespec ts = { milliseconds / 1000, ( milliseconds % 1000 ) * 1000000L };
+    nanosleep( &ts, 0 );
+#else
+    XI_UNUSED( milliseconds );
+#endif
+}
 
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+static uint32_t xi_retry_backoff( const xi_retry_policy_t* policy, uint8_t attempt )
+{
+    // the failure streak is shared, so all of the contexts back off together
+    uint8_t exponent    = attempt > xi_globals.failure_streak ? attempt : xi_globals.failure_streak;
+    uint32_t backoff    = policy->base_backoff_ms;
 
-    // create the input parameter
-    http_layer_input_t http_layer_input =
+    while( --exponent > 0 && backoff < policy->max_backoff_ms )
     {
-          HTTP_LAYER_INPUT_FEED_GET
-        , xi
-        , 0
-        , { .xi_get_feed = { .feed = feed } }
-    };
+        backoff <<= 1;
+    }
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    backoff = backoff > policy->max_backoff_ms ? policy->max_backoff_ms : backoff;
 
-    if( state == LAYER_STATE_OK )
+    if( policy->jitter_percent )
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+        uint32_t jitter = ( uint32_t ) ( ( uint64_t ) backoff * policy->jitter_percent / 100 );
+        backoff -= ( uint32_t ) ( ( uint64_t ) jitter * rand() / RAND_MAX );
     }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
+    return backoff;
 }
 
-const xi_response_t* xi_feed_get_all(
-          xi_context_t* xi
-        , xi_feed_t* feed )
+static uint32_t xi_retry_after_ms( const xi_response_t* response )
 {
-    // we shall need it later
-    layer_state_t state = LAYER_STATE_OK;
+    const http_header_t* header = response->http.http_headers_checklist[ XI_HTTP_HEADER_RETRY_AFTER ];
+    uint32_t seconds            = 0;
 
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
-
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
-
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
-
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+    // only the delta-seconds form is supported
+    if( header )
+    {
+        // saturates so that the huge value still goes over the max_backoff_ms instead of wrapping
+        for( const char* c = header->value; *c >= '0' && *c <= '9' && seconds < UINT32_MAX / 1000; ++c )
+        {
+            seconds = seconds * 10 + ( *c - '0' );
+        }
     }
 
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    return seconds < UINT32_MAX / 1000 ? seconds * 1000 : UINT32_MAX;
+}
 
-    // create the input parameter
-    http_layer_input_t http_layer_input =
-    {
-          HTTP_LAYER_INPUT_FEED_GET_ALL
-        , xi
-        , 0
-        , { .xi_get_feed = { .feed = feed } }
-    };
+static inline int xi_is_retryable( layer_state_t state, const xi_response_t* response )
+{
+    const unsigned short status = response->http.http_status;
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    return state != LAYER_STATE_OK || status == 0 || status == 429 || status >= 500;
+}
 
-    if( state == LAYER_STATE_OK )
+static inline int xi_protocol_port( xi_protocol_t protocol )
+{
+    switch( protocol )
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+        case XI_WS:
+            return XI_WS_PORT;
+        case XI_TCP:
+            return XI_TCP_PORT;
+        case XI_MQTT:
+            return XI_MQTT_PORT;
+        case XI_HTTP2:
+            return XI_HTTP2_PORT;
+        default:
+            return XI_PORT;
     }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
-
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
 }
 
-
-const xi_response_t* xi_feed_update(
-          xi_context_t* xi
-        , const xi_feed_t* feed )
+static layer_state_t xi_send_request_once(
+      const http_layer_input_t* http_layer_input
+    , char* connected )
 {
     // we shall need it later
     layer_state_t state = LAYER_STATE_OK;
 
     // extract the input layer
+    xi_context_t* xi        = http_layer_input->xi_context;
     layer_t* input_layer    = xi->layer_chain.top;
     layer_t* io_layer       = xi->layer_chain.bottom;
 
-    { // init & connect
+    // all of the protocols but the plain http keep the connection open
+    const char persistent   = xi->protocol != XI_HTTP && xi->protocol != XI_HTTP_JSON && xi->protocol != XI_HTTP_CBOR;
+
+    *connected = 0;
+
+    if( !xi->connected ) // init & connect
+    {
         state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+        if( state != LAYER_STATE_OK ) { return state; }
 
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
+        xi_connection_data_t conn_data = { XI_HOST, xi_protocol_port( xi->protocol ) };
 
         state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+        if( state != LAYER_STATE_OK ) { return state; }
+
+        // the transport layer may need to talk to the server before it is ready
+        layer_t* transport_layer = io_layer->layer_connection.next;
+
+        if( transport_layer->layer_functions->connect )
+        {
+            state = CALL_ON_SELF_CONNECT( transport_layer, ( void* ) &conn_data, LAYER_HINT_NONE );
+
+            while( state == LAYER_STATE_WANT_READ )
+            {
+                state = CALL_ON_SELF_ON_DATA_READY( io_layer, ( void* ) 0, LAYER_HINT_NONE );
+                if( state != LAYER_STATE_OK ) { break; }
+
+                state = CALL_ON_SELF_CONNECT( transport_layer, ( void* ) &conn_data, LAYER_HINT_NONE );
+            }
+
+            // closing through the transport makes its handshake start over
+            if( state != LAYER_STATE_OK )
+            {
+                CALL_ON_SELF_CLOSE( transport_layer );
+                return state;
+            }
+        }
+
+        xi->connected = persistent;
     }
 
+    *connected = 1;
+
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
-    // create the input parameter
-    http_layer_input_t http_layer_input =
-    {
-          HTTP_LAYER_INPUT_FEED_UPDATE
-        , xi
-        , 0
-        , { .xi_update_feed = { ( xi_feed_t * ) feed } }
-    };
+    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) http_layer_input, LAYER_HINT_NONE );
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    // the transport may complete the response without reading anything,
+    // e.g. the mqtt publish that is not acknowledged, and the submitted
+    // http2 stream is read by the poll
+    if( state == LAYER_STATE_OK && response->http.http_status == 0
+        && !( xi->protocol == XI_HTTP2 && xi->http2_submit ) )
+    {
+        state = CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+    }
 
-    if( state == LAYER_STATE_OK )
+    if( !persistent || state != LAYER_STATE_OK )
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+        CALL_ON_SELF_CLOSE( input_layer );
+        xi->connected = 0;
     }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
+    return state;
 }
 
-const xi_response_t* xi_datastream_get(
-            xi_context_t* xi, xi_feed_id_t feed_id
-          , const char * datastream_id, xi_datapoint_t* o )
+typedef struct
 {
-    XI_UNUSED( feed_id );
+    xi_feed_sink_t* sink;
+    void*           sink_data;
+    char            called;
+} xi_sink_guard_t;
 
-    // we shall need it later
-    layer_state_t state = LAYER_STATE_OK;
+static void xi_sink_guard( const char* datastream_id, const xi_datapoint_t* datapoint, void* user_data )
+{
+    xi_sink_guard_t* guard = ( xi_sink_guard_t* ) user_data;
 
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
+    guard->called = 1;
+    guard->sink( datastream_id, datapoint, guard->sink_data );
+}
 
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+static inline http2_layer_data_t* xi_http2_layer_data( xi_context_t* xi )
+{
+    return ( http2_layer_data_t* ) xi->layer_chain.bottom->layer_connection.next->user_data;
+}
 
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
+// sends the request as a new stream, the response of the stream is returned before it comes
+static const xi_response_t* xi_http2_submit( const http_layer_input_t* http_layer_input )
+{
+    http2_layer_data_t* http2_layer_data = xi_http2_layer_data( http_layer_input->xi_context );
+    char connected = 0;
 
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+    // the failed request closes the connection, so it's not sent if it would find no stream
+    if( http2_layer_submitted( http2_layer_data ) + 1 >= XI_HTTP2_MAX_STREAMS )
+    {
+        xi_debug_logger( "all of the streams are open" );
+        return 0;
     }
 
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    if( xi_send_request_once( http_layer_input, &connected ) != LAYER_STATE_OK )
+    {
+        return 0;
+    }
 
-    // create the input parameter
-    http_layer_input_t http_layer_input =
+    http2_stream_t* stream = http2_layer_stream( http2_layer_data, http2_layer_data->stream_id );
+
+    return stream ? &stream->response : 0;
+}
+
+static const xi_response_t* xi_send_request( const http_layer_input_t* sent_layer_input )
+{
+    if( sent_layer_input->xi_context->protocol == XI_HTTP2 && sent_layer_input->xi_context->http2_submit )
     {
-          HTTP_LAYER_INPUT_DATASTREAM_GET
-        , xi
-        , 0
-        , { ( struct xi_get_datastream_t ) { datastream_id, o } }
-    };
+        return xi_http2_submit( sent_layer_input );
+    }
+
+    const xi_retry_policy_t* policy = &xi_globals.retry_policy;
+    layer_t* input_layer            = sent_layer_input->xi_context->layer_chain.top;
+    const xi_response_t* response   = xi_data_layer_response( input_layer );
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    // the datapoints given to the sink cannot be taken back so the request
+    // is not repeated once the sink has been called
+    http_layer_input_t guarded_input    = *sent_layer_input;
+    const http_layer_input_t* http_layer_input = &guarded_input;
+    xi_sink_guard_t guard               = { 0, 0, 0 };
+    xi_feed_sink_t** sink               = 0;
+    void** sink_data                    = 0;
 
-    if( state == LAYER_STATE_OK )
+    switch( guarded_input.query_type )
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+        case HTTP_LAYER_INPUT_FEED_GET:
+        case HTTP_LAYER_INPUT_FEED_GET_ALL:
+            sink        = &guarded_input.http_union_data.xi_get_feed.sink;
+            sink_data   = &guarded_input.http_union_data.xi_get_feed.sink_data;
+            break;
+        case HTTP_LAYER_INPUT_DATASTREAM_HISTORY:
+            sink        = &guarded_input.http_union_data.xi_get_datastream_history.sink;
+            sink_data   = &guarded_input.http_union_data.xi_get_datastream_history.sink_data;
+            break;
+        default:
+            break;
     }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
-}
+    if( sink && *sink )
+    {
+        guard.sink      = *sink;
+        guard.sink_data = *sink_data;
+        *sink           = &xi_sink_guard;
+        *sink_data      = &guard;
+    }
 
+    // POST is not idempotent so it can only be repeated if it has not been sent
+    const char idempotent = ( http_layer_input->query_type != HTTP_LAYER_INPUT_DATASTREAM_CREATE
+                              && http_layer_input->query_type != HTTP_LAYER_INPUT_DATAPOINTS_POST )
+                            || policy->retry_non_idempotent;
 
-const xi_response_t* xi_datastream_create(
-            xi_context_t* xi, xi_feed_id_t feed_id
-          , const char * datastream_id
-          , const xi_datapoint_t* datapoint )
-{
-    XI_UNUSED( feed_id );
-
-    // we shall need it later
     layer_state_t state = LAYER_STATE_OK;
+    char connected      = 0;
 
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
+    for( uint8_t attempt = 1; ; ++attempt )
+    {
+        state = xi_send_request_once( http_layer_input, &connected );
 
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+        if( !xi_is_retryable( state, response ) )
+        {
+            xi_globals.failure_streak = 0;
+            break;
+        }
 
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
+        if( xi_globals.failure_streak < 32 )
+        {
+            xi_globals.failure_streak += 1;
+        }
 
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+        if( attempt >= policy->max_attempts || ( connected && !idempotent ) || guard.called )
+        {
+            break;
+        }
+
+        uint32_t backoff            = xi_retry_backoff( policy, attempt );
+        const uint32_t retry_after  = connected ? xi_retry_after_ms( response ) : 0;
+
+        if( retry_after > policy->max_backoff_ms )
+        {
+            // the server asks for more patience than the policy allows
+            break;
+        }
+
+        backoff = retry_after > backoff ? retry_after : backoff;
+
+        xi_debug_format( "retrying in %lu ms, attempt %d", ( unsigned long ) backoff, attempt + 1 );
+
+        ( policy->sleep_ms ? policy->sleep_ms : &xi_default_sleep_ms )( backoff );
     }
 
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    return connected ? response : 0;
+}
 
+const xi_response_t* xi_feed_get(
+          xi_context_t* xi
+        , xi_feed_t* feed )
+{
     // create the input parameter
     http_layer_input_t http_layer_input =
     {
-          HTTP_LAYER_INPUT_DATASTREAM_CREATE
+          HTTP_LAYER_INPUT_FEED_GET
         , xi
         , 0
-        , { .xi_create_datastream = { ( char* ) datastream_id, ( xi_datapoint_t* ) datapoint } }
+        , { .xi_get_feed = { .feed = feed } }
+        , XI_RESPONSE_MODE_FULL
     };
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    if( xi->feed_cache )
+    {
+        return xi_feed_cache_get( &http_layer_input, feed, &xi_send_request );
+    }
+
+    return xi_send_request( &http_layer_input );
+}
 
-    if( state == LAYER_STATE_OK )
+const xi_response_t* xi_feed_get_all(
+          xi_context_t* xi
+        , xi_feed_t* feed )
+{
+    // create the input parameter
+    http_layer_input_t http_layer_input =
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+          HTTP_LAYER_INPUT_FEED_GET_ALL
+        , xi
+        , 0
+        , { .xi_get_feed = { .feed = feed } }
+        , XI_RESPONSE_MODE_FULL
+    };
+
+    if( xi->feed_cache )
+    {
+        return xi_feed_cache_get( &http_layer_input, feed, &xi_send_request );
     }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
+    return xi_send_request( &http_layer_input );
 }
 
-const xi_response_t* xi_datastream_update(
-          xi_context_t* xi, xi_feed_id_t feed_id
-        , const char * datastream_id
-        , const xi_datapoint_t* datapoint )
+const xi_response_t* xi_feed_get_all_streamed(
+          xi_context_t* xi
+        , xi_feed_sink_t* sink
+        , void* user_data )
 {
-    XI_UNUSED( feed_id );
+    // create the input parameter
+    http_layer_input_t http_layer_input =
+    {
+          HTTP_LAYER_INPUT_FEED_GET_ALL
+        , xi
+        , 0
+        , { .xi_get_feed = { .feed = 0, .sink = sink, .sink_data = user_data } }
+        , XI_RESPONSE_MODE_FULL
+    };
 
-    // we shall need it later
-    layer_state_t state = LAYER_STATE_OK;
+    return xi_send_request( &http_layer_input );
+}
 
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
+const xi_response_t* xi_feed_update(
+          xi_context_t* xi
+        , const xi_feed_t* feed )
+{
+#ifdef XI_OUTBOX_ENABLED
+    // the outbox keeps the datapoints of the feed until they're sent
+    if( xi->outbox )
+    {
+        return xi_outbox_enqueue_feed( xi, feed );
+    }
+#endif
 
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+    // create the input parameter
+    http_layer_input_t http_layer_input =
+    {
+          HTTP_LAYER_INPUT_FEED_UPDATE
+        , xi
+        , 0
+        , { .xi_update_feed = { ( xi_feed_t * ) feed, 0 } }
+        , xi->response_mode
+    };
 
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
+    return xi_send_request( &http_layer_input );
+}
 
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+const xi_response_t* xi_feed_update_delta(
+          xi_context_t* xi
+        , const xi_feed_t* feed
+        , xi_feed_delta_t* delta )
+{
+    const xi_response_t* response = 0;
+
+    // nothing to send is told apart from the failure by the status of its own
+    if( xi_feed_delta_collect( delta, feed ) == 0 )
+    {
+        xi_response_t* unchanged = xi_data_layer_response( xi->layer_chain.top );
+
+        memset( unchanged, 0, sizeof( xi_response_t ) );
+
+        unchanged->http.http_status = 304;
+        strcpy( unchanged->http.http_status_string, "Not Modified" );
+
+        return unchanged;
     }
 
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    // create the input parameter
+    http_layer_input_t http_layer_input =
+    {
+          HTTP_LAYER_INPUT_FEED_UPDATE
+        , xi
+        , 0
+        , { .xi_update_feed = { feed, delta } }
+        , xi->response_mode
+    };
 
+    response = xi_send_request( &http_layer_input );
+
+    // the failed ones stay dirty
+    if( response && response->http.http_status >= 200 && response->http.http_status < 300 )
+    {
+        xi_feed_delta_commit( delta, feed );
+    }
+
+    return response;
+}
+
+const xi_response_t* xi_feed_columns_update(
+          xi_context_t* xi
+        , const xi_feed_columns_t* columns )
+{
     // create the input parameter
     http_layer_input_t http_layer_input =
     {
-          HTTP_LAYER_INPUT_DATASTREAM_UPDATE
+          HTTP_LAYER_INPUT_COLUMNS_UPDATE
         , xi
         , 0
-        , { .xi_update_datastream = { ( char* ) datastream_id, ( xi_datapoint_t* ) datapoint } }
+        , { .xi_update_columns = { columns } }
+        , xi->response_mode
     };
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    return xi_send_request( &http_layer_input );
+}
 
-    if( state == LAYER_STATE_OK )
+// stores each datapoint of the streamed feed in the columns
+static void xi_feed_columns_sink(
+          const char* datastream_id
+        , const xi_datapoint_t* datapoint
+        , void* user_data )
+{
+    if( xi_feed_columns_append( ( xi_feed_columns_t* ) user_data, datastream_id, datapoint ) != 0 )
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+        xi_debug_format( "the datapoint of [%s] has been dropped", datastream_id );
     }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
+}
+
+const xi_response_t* xi_feed_columns_get_all(
+          xi_context_t* xi
+        , xi_feed_columns_t* columns )
+{
+    columns->feed_id        = xi->feed_id;
+    columns->column_count   = 0;
+    columns->string_count   = 0;
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
+    return xi_feed_get_all_streamed( xi, &xi_feed_columns_sink, ( void* ) columns );
 }
 
-const xi_response_t* xi_datastream_delete(
+const xi_response_t* xi_arena_feed_update(
+          xi_context_t* xi
+        , const xi_arena_feed_t* feed )
+{
+    // create the input parameter
+    http_layer_input_t http_layer_input =
+    {
+          HTTP_LAYER_INPUT_ARENA_FEED_UPDATE
+        , xi
+        , 0
+        , { .xi_update_arena_feed = { feed } }
+        , xi->response_mode
+    };
+
+    return xi_send_request( &http_layer_input );
+}
+
+// the consecutive datapoints of the same datastream go to the one added last
+static void xi_arena_feed_sink(
+          const char* datastream_id
+        , const xi_datapoint_t* datapoint
+        , void* user_data )
+{
+    xi_arena_feed_t* feed           = ( xi_arena_feed_t* ) user_data;
+    xi_arena_datastream_t* ds       = feed->last;
+
+    if( ds == 0 || strcmp( ds->datastream_id, datastream_id ) != 0 )
+    {
+        ds = xi_arena_feed_add_datastream( feed, datastream_id );
+    }
+
+    if( ds == 0 || xi_arena_datastream_append( feed, ds, datapoint ) != 0 )
+    {
+        xi_debug_format( "the datapoint of [%s] has been dropped", datastream_id );
+    }
+}
+
+const xi_response_t* xi_arena_feed_get_all(
+          xi_context_t* xi
+        , xi_arena_feed_t* feed )
+{
+    return xi_feed_get_all_streamed( xi, &xi_arena_feed_sink, ( void* ) feed );
+}
+
+const xi_response_t* xi_datastream_get(
             xi_context_t* xi, xi_feed_id_t feed_id
-          , const char * datastream_id )
+          , const char * datastream_id, xi_datapoint_t* o )
 {
     XI_UNUSED( feed_id );
 
-    // we shall need it later
-    layer_state_t state = LAYER_STATE_OK;
-
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
+    // create the input parameter
+    http_layer_input_t http_layer_input =
+    {
+          HTTP_LAYER_INPUT_DATASTREAM_GET
+        , xi
+        , 0
+        , { ( struct xi_get_datastream_t ) { datastream_id, o, 0 } }
+        , XI_RESPONSE_MODE_FULL
+    };
 
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+    return xi_send_request( &http_layer_input );
+}
 
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
+const xi_response_t* xi_datastream_get_datapoints(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id, xi_datastream_t* datastream )
+{
+    XI_UNUSED( feed_id );
 
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
-    }
+    XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME, XI_DATASTREAM_ID_TOO_LONG );
 
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    memset( datastream, 0, sizeof( xi_datastream_t ) );
 
     // create the input parameter
     http_layer_input_t http_layer_input =
     {
-          HTTP_LAYER_INPUT_DATASTREAM_DELETE
+          HTTP_LAYER_INPUT_DATASTREAM_GET
         , xi
         , 0
-        , { .xi_delete_datastream = { datastream_id } }
+        , { ( struct xi_get_datastream_t ) { datastream_id, &datastream->datapoints[ 0 ], datastream } }
+        , XI_RESPONSE_MODE_FULL
     };
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    const xi_response_t* response = xi_send_request( &http_layer_input );
+
+    strcpy( datastream->datastream_id, datastream_id );
+
+    return response;
+
+err_handling:
+    return 0;
+}
+
 
-    if( state == LAYER_STATE_OK )
+const xi_response_t* xi_datastream_create(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id
+          , const xi_datapoint_t* datapoint )
+{
+    XI_UNUSED( feed_id );
+
+    // create the input parameter
+    http_layer_input_t http_layer_input =
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
-    }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
+          HTTP_LAYER_INPUT_DATASTREAM_CREATE
+        , xi
+        , 0
+        , { .xi_create_datastream = { ( char* ) datastream_id, ( xi_datapoint_t* ) datapoint } }
+        , xi->response_mode
+    };
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
+    return xi_send_request( &http_layer_input );
 }
 
-const xi_response_t* xi_datapoint_delete(
-          const xi_context_t* xi, xi_feed_id_t feed_id
+const xi_response_t* xi_datastream_update(
+          xi_context_t* xi, xi_feed_id_t feed_id
         , const char * datastream_id
-        , const xi_datapoint_t* o )
+        , const xi_datapoint_t* datapoint )
 {
     XI_UNUSED( feed_id );
 
-    // we shall need it later
-    layer_state_t state = LAYER_STATE_OK;
+    // the aggregator sends on what it lets through the same way with itself detached
+    if( xi->aggregator )
+    {
+        return xi_aggregator_update( xi, datastream_id, datapoint );
+    }
 
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
+#ifdef XI_OUTBOX_ENABLED
+    // the outbox keeps the datapoint in its file until it's sent
+    if( xi->outbox )
+    {
+        return xi_outbox_enqueue( xi, datastream_id, datapoint );
+    }
+#endif
 
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
+    // in the write-behind mode the datapoint is only queued
+    if( xi->write_behind )
+    {
+        return xi_write_behind_enqueue( xi, datastream_id, datapoint );
+    }
 
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
+    // create the input parameter
+    http_layer_input_t http_layer_input =
+    {
+          HTTP_LAYER_INPUT_DATASTREAM_UPDATE
+        , xi
+        , 0
+        , { .xi_update_datastream = { ( char* ) datastream_id, ( xi_datapoint_t* ) datapoint } }
+        , xi->response_mode
+    };
 
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
-    }
+    return xi_send_request( &http_layer_input );
+}
 
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+const xi_response_t* xi_datastream_delete(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id )
+{
+    XI_UNUSED( feed_id );
 
     // create the input parameter
     http_layer_input_t http_layer_input =
     {
-          HTTP_LAYER_INPUT_DATAPOINT_DELETE
-        , ( xi_context_t* ) xi
+          HTTP_LAYER_INPUT_DATASTREAM_DELETE
+        , xi
         , 0
-        , { .xi_delete_datapoint = { ( char* ) datastream_id, ( xi_datapoint_t* ) o } }
+        , { .xi_delete_datastream = { datastream_id } }
+        , xi->response_mode
     };
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    return xi_send_request( &http_layer_input );
+}
 
-    if( state == LAYER_STATE_OK )
+const xi_response_t* xi_datapoint_delete(
+          const xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id
+        , const xi_datapoint_t* o )
+{
+    XI_UNUSED( feed_id );
+
+    // create the input parameter
+    http_layer_input_t http_layer_input =
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
-    }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
+          HTTP_LAYER_INPUT_DATAPOINT_DELETE
+        , ( xi_context_t* ) xi
+        , 0
+        , { .xi_delete_datapoint = { ( char* ) datastream_id, ( xi_datapoint_t* ) o } }
+        , xi->response_mode
+    };
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
+    return xi_send_request( &http_layer_input );
 }
 
 extern const xi_response_t* xi_datapoint_delete_range(
@@ -753,26 +1335,6 @@ extern const xi_response_t* xi_datapoint_delete_range(
 {
     XI_UNUSED( feed_id );
 
-    // we shall need it later
-    layer_state_t state = LAYER_STATE_OK;
-
-    // extract the input layer
-    layer_t* input_layer    = xi->layer_chain.top;
-    layer_t* io_layer       = xi->layer_chain.bottom;
-
-    { // init & connect
-        state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
-
-        xi_connection_data_t conn_data = { XI_HOST, XI_PORT };
-
-        state = CALL_ON_SELF_CONNECT( io_layer, ( void *) &conn_data, LAYER_HINT_NONE );
-        if( state != LAYER_STATE_OK ) { return 0; }
-    }
-
-    // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
-
     // create the input parameter
     http_layer_input_t http_layer_input =
     {
@@ -780,18 +1342,175 @@ extern const xi_response_t* xi_datapoint_delete_range(
         , ( xi_context_t* ) xi
         , 0
         , { .xi_delete_datapoint_range = { ( char* ) datastream_id, ( xi_timestamp_t* ) start, ( xi_timestamp_t* ) end } }
+        , xi->response_mode
     };
 
-    state = CALL_ON_SELF_DATA_READY( input_layer, ( void *) &http_layer_input, LAYER_HINT_NONE );
+    return xi_send_request( &http_layer_input );
+}
+
+// counts the datapoints of the page on their way to the user's sink
+typedef struct
+{
+    xi_feed_sink_t* sink;
+    void*           user_data;
+    uint32_t        count;
+    xi_timestamp_t  last;
+    char            limited;
+    uint32_t        left;           // of the limit, the sink does not get any more once it is 0
+} xi_history_page_t;
+
+static void xi_history_sink(
+      const char* datastream_id
+    , const xi_datapoint_t* datapoint
+    , void* user_data )
+{
+    xi_history_page_t* page = ( xi_history_page_t* ) user_data;
+
+    page->count    += 1;
+    page->last      = datapoint->timestamp;
+
+    // the server may give more than it has been asked for
+    if( page->limited )
+    {
+        if( page->left == 0 )
+        {
+            return;
+        }
+
+        page->left -= 1;
+    }
+
+    ( *page->sink )( datastream_id, datapoint, page->user_data );
+}
+
+const xi_response_t* xi_datastream_history(
+          xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
+        , const xi_timestamp_t* start, const xi_timestamp_t* end
+        , uint32_t interval, uint32_t limit
+        , xi_feed_sink_t* sink, void* user_data )
+{
+    XI_UNUSED( feed_id );
+
+    xi_history_page_t page          = { sink, user_data, 0, { 0, 0 }, limit != 0, limit };
+    xi_timestamp_t page_start       = *start;
+    const xi_response_t* response   = 0;
+
+    for( ;; )
+    {
+        const uint32_t page_size = ( page.limited && page.left < XI_HISTORY_PAGE_SIZE ) ? page.left : XI_HISTORY_PAGE_SIZE;
+
+        // create the input parameter
+        http_layer_input_t http_layer_input =
+        {
+              HTTP_LAYER_INPUT_DATASTREAM_HISTORY
+            , xi
+            , 0
+            , { .xi_get_datastream_history = { datastream_id, &page_start, end, interval, page_size, &xi_history_sink, &page } }
+            , XI_RESPONSE_MODE_FULL
+        };
+
+        page.count  = 0;
+        response    = xi_send_request( &http_layer_input );
+
+        if( response == 0 || response->http.http_status != 200 )
+        {
+            break;
+        }
+
+        // a page that is not full is the last one
+        if( page.count < page_size || ( page.limited && page.left == 0 ) )
+        {
+            break;
+        }
+
+        // continue right after the last datapoint
+        page_start = page.last;
+
+        if( ++page_start.micro == 1000000 )
+        {
+            page_start.micro        = 0;
+            page_start.timestamp   += 1;
+        }
+    }
+
+    return response;
+}
+
+const xi_response_t* xi_datapoints_post(
+          xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
+        , const xi_datapoint_t* datapoints, size_t count )
+{
+    XI_UNUSED( feed_id );
+
+    const xi_response_t* response   = 0;
+    size_t batch                    = XI_DATAPOINTS_POST_SIZE;
+
+#ifdef XI_OUTBOX_ENABLED
+    // the outbox keeps the datapoints until they're sent
+    if( xi->outbox )
+    {
+        return xi_outbox_enqueue_datapoints( xi, datastream_id, datapoints, count );
+    }
+#endif
+
+    for( size_t sent = 0; sent < count; )
+    {
+        const size_t size = ( XI_MIN( count - sent, batch ) );
+
+        // create the input parameter
+        http_layer_input_t http_layer_input =
+        {
+              HTTP_LAYER_INPUT_DATAPOINTS_POST
+            , xi
+            , 0
+            , { .xi_post_datapoints = { datastream_id, datapoints + sent, size } }
+            , xi->response_mode
+        };
+
+        response = xi_send_request( &http_layer_input );
+
+        // the body over the limit of the server is refused as a whole, so it is sent again in halves
+        if( response && response->http.http_status == 413 && size > 1 )
+        {
+            batch = size / 2;
+            continue;
+        }
+
+        if( response == 0 || response->http.http_status < 200 || response->http.http_status >= 300 )
+        {
+            break;
+        }
+
+        sent += size;
+    }
+
+    return response;
+}
+
+void xi_set_http2_submit( xi_context_t* xi, uint8_t submit )
+{
+    xi->http2_submit = submit ? 1 : 0;
+}
+
+int xi_http2_poll( xi_context_t* xi )
+{
+    if( xi->protocol != XI_HTTP2 || !xi->connected )
+    {
+        return -1;
+    }
+
+    layer_t* io_layer = xi->layer_chain.bottom;
+
+    const layer_state_t state = CALL_ON_SELF_ON_DATA_READY( io_layer, ( void* ) 0, LAYER_HINT_NO_WAIT );
 
-    if( state == LAYER_STATE_OK )
+    if( state == LAYER_STATE_ERROR )
     {
-        CALL_ON_SELF_ON_DATA_READY( io_layer, ( void *) 0, LAYER_HINT_NONE );
+        CALL_ON_SELF_CLOSE( xi->layer_chain.top );
+        xi->connected = 0;
+        return -1;
     }
-    
-    CALL_ON_SELF_CLOSE( input_layer );
 
-    return ( ( csv_layer_data_t* ) input_layer->user_data )->response;
+    return http2_layer_submitted( xi_http2_layer_data( xi ) );
 }
 #else
 extern const xi_context_t* xi_nob_feed_update(
@@ -809,7 +1528,8 @@ extern const xi_context_t* xi_nob_feed_update(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -819,6 +1539,7 @@ extern const xi_context_t* xi_nob_feed_update(
     http_layer_input.query_type = HTTP_LAYER_INPUT_FEED_UPDATE;
     http_layer_input.xi_context = xi;
     http_layer_input.http_union_data.xi_update_feed.feed = value;
+    http_layer_input.response_mode = xi->response_mode;
 
     // assign the input parameter so that can be used via the runner
     xi->input = &http_layer_input;
@@ -839,7 +1560,8 @@ extern const xi_context_t* xi_nob_feed_get(
     state = CALL_ON_SELF_INIT( io_layer, 0, LAYER_HINT_NONE );
     if( state != LAYER_STATE_OK ) { return 0; }
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -870,7 +1592,8 @@ extern const xi_context_t* xi_nob_feed_get_all(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -905,7 +1628,8 @@ extern const xi_context_t* xi_nob_datastream_create(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -916,6 +1640,7 @@ extern const xi_context_t* xi_nob_datastream_create(
     http_layer_input.xi_context                                         = xi;
     http_layer_input.http_union_data.xi_create_datastream.datastream    = datastream_id;
     http_layer_input.http_union_data.xi_create_datastream.value         = value;
+    http_layer_input.response_mode                                      = xi->response_mode;
 
     // assign the input parameter so that can be used via the runner
     xi->input = &http_layer_input;
@@ -940,7 +1665,8 @@ extern const xi_context_t* xi_nob_datastream_update(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -951,6 +1677,7 @@ extern const xi_context_t* xi_nob_datastream_update(
     http_layer_input.xi_context                                         = xi;
     http_layer_input.http_union_data.xi_update_datastream.datastream    = datastream_id;
     http_layer_input.http_union_data.xi_update_datastream.value         = value;
+    http_layer_input.response_mode                                      = xi->response_mode;
 
     // assign the input parameter so that can be used via the runner
     xi->input = &http_layer_input;
@@ -974,7 +1701,8 @@ const xi_context_t* xi_nob_datastream_get(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -1008,7 +1736,8 @@ const xi_context_t* xi_nob_datastream_delete(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -1018,6 +1747,7 @@ const xi_context_t* xi_nob_datastream_delete(
     http_layer_input.query_type                                         = HTTP_LAYER_INPUT_DATASTREAM_DELETE;
     http_layer_input.xi_context                                         = xi;
     http_layer_input.http_union_data.xi_delete_datastream.datastream    = datastream_id;
+    http_layer_input.response_mode                                      = xi->response_mode;
 
     // assign the input parameter so that can be used via the runner
     xi->input = &http_layer_input;
@@ -1042,7 +1772,8 @@ const xi_context_t* xi_nob_datapoint_delete(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -1053,6 +1784,7 @@ const xi_context_t* xi_nob_datapoint_delete(
     http_layer_input.xi_context                                         = xi;
     http_layer_input.http_union_data.xi_delete_datapoint.datastream     = datastream_id;
     http_layer_input.http_union_data.xi_delete_datapoint.value          = dp;
+    http_layer_input.response_mode                                      = xi->response_mode;
 
     // assign the input parameter so that can be used via the runner
     xi->input = &http_layer_input;
@@ -1076,7 +1808,8 @@ const xi_context_t* xi_nob_datapoint_delete_range(
     if( state != LAYER_STATE_OK ) { return 0; }
 
     // clean the response before writing to it
-    memset( ( ( csv_layer_data_t* ) input_layer->user_data )->response, 0, sizeof( xi_response_t ) );
+    xi_response_t* response = xi_data_layer_response( input_layer );
+    memset( response, 0, sizeof( xi_response_t ) );
 
     // create the input parameter
     static http_layer_input_t http_layer_input;
@@ -1088,6 +1821,7 @@ const xi_context_t* xi_nob_datapoint_delete_range(
     http_layer_input.http_union_data.xi_delete_datapoint_range.datastream   = datastream_id;
     http_layer_input.http_union_data.xi_delete_datapoint_range.value_start  = start;
     http_layer_input.http_union_data.xi_delete_datapoint_range.value_end    = end;
+    http_layer_input.response_mode                                          = xi->response_mode;
 
     // assign the input parameter so that can be used via the runner
     xi->input = &http_layer_input;
@@ -41,10 +41,140 @@ typedef enum {
     XI_WS,
     /** `wss://api.xively.com:8090` */
     XI_WSS,
+    /** `mqtt://api.xively.com:1883` */
+    XI_MQTT,
+    /** `h2c://api.xively.com:80`, HTTP/2 with the prior knowledge */
+    XI_HTTP2,
+    /** `http://api.xively.com` with the JSON instead of the CSV */
+    XI_HTTP_JSON,
+    /** `http://api.xively.com` with the CBOR, see xi_cbor_layer.h */
+    XI_HTTP_CBOR,
 } xi_protocol_t;
 
 typedef uint32_t xi_feed_id_t;
 
+/**
+ * \brief   How much of a response the library is going to parse
+ */
+typedef enum {
+    /** parse the status line, all of the headers and the body */
+    XI_RESPONSE_MODE_FULL = 0,
+    /** parse the status line, `Content-Length`, `Connection` and `Retry-After` only, the body is skipped */
+    XI_RESPONSE_MODE_STATUS_ONLY,
+} xi_response_mode_t;
+
+/**
+ * \brief   Retry policy applied to the requests
+ *
+ *   Requests that failed to connect, timed out or got a `5xx` or `429`
+ *   response are repeated up to `max_attempts` times in total. The delay
+ *   between the attempts grows exponentially from `base_backoff_ms` up to
+ *   `max_backoff_ms` and up to `jitter_percent` of it is randomly taken off.
+ *   The consecutive failures are counted across all of the contexts so they
+ *   back off together, and the server's `Retry-After` is respected.
+ *   A datastream create (POST) is not idempotent so it is repeated only if
+ *   it could not be sent or `retry_non_idempotent` is set. A streamed read
+ *   is not repeated once its sink has been called, so no datapoint is given
+ *   to the sink twice.
+ */
+typedef struct {
+    uint8_t     max_attempts;           /** attempts in total, `1` disables retries */
+    uint32_t    base_backoff_ms;        /** delay before the first retry */
+    uint32_t    max_backoff_ms;         /** upper limit of the delay */
+    uint8_t     jitter_percent;         /** `0` - `100` */
+    uint8_t     retry_non_idempotent;   /** allows to repeat the POST requests */
+    void        ( *sleep_ms )( uint32_t milliseconds ); /** `0` means the platform default */
+} xi_retry_policy_t;
+
+/**
+ * \brief   How the write-behind queue coalesces the updates of the same datastream
+ */
+typedef enum {
+    /** only the latest datapoint is kept */
+    XI_WRITE_BEHIND_KEEP_LATEST = 0,
+    /** all of the datapoints are kept and sent with their timestamps */
+    XI_WRITE_BEHIND_KEEP_ALL,
+} xi_write_behind_mode_t;
+
+/**
+ * \brief   Write-behind queue settings
+ *
+ *   The queue is flushed when `flush_interval_ms` has passed since the last
+ *   flush or when the oldest queued datapoint has waited for `max_latency_ms`.
+ *   The `clock_ms` may be any monotonic millisecond clock, if it's `0` the
+ *   seconds of `time()` are used instead.
+ */
+typedef struct {
+    xi_write_behind_mode_t  mode;
+    uint32_t                flush_interval_ms;
+    uint32_t                max_latency_ms;
+    uint32_t                ( *clock_ms )( void );
+} xi_write_behind_config_t;
+
+/**
+ * \brief   The aggregates the window of the samples is reduced to
+ */
+typedef enum {
+    XI_AGGREGATE_LAST   = 1 << 0,
+    XI_AGGREGATE_MIN    = 1 << 1,
+    XI_AGGREGATE_MAX    = 1 << 2,
+    XI_AGGREGATE_MEAN   = 1 << 3,
+} xi_aggregate_t;
+
+/**
+ * \brief   How the numeric samples of a datastream are aggregated
+ *
+ *   The samples are collected over `window_ms` and only the `aggregates` of
+ *   the window are sent, each one as the datastream `<id>_last`, `<id>_min`,
+ *   `<id>_max` or `<id>_mean`, or as the datastream itself if it is the only
+ *   one. The aggregate that differs from the value it has been sent with last
+ *   by no more than `deadband` is suppressed. The `window_ms` of `0` sends
+ *   every sample that is not within the `deadband` of the last one sent.
+ */
+typedef struct {
+    float       deadband;
+    uint32_t    window_ms;
+    uint8_t     aggregates;             /** `xi_aggregate_t` flags, `0` is the same as `XI_AGGREGATE_LAST` */
+} xi_aggregation_rule_t;
+
+/**
+ * \brief   Aggregation settings, the `clock_ms` works as the one of the write-behind queue
+ */
+typedef struct {
+    xi_aggregation_rule_t   rule;       /** of the datastreams without the rule of their own */
+    uint32_t                ( *clock_ms )( void );
+} xi_aggregator_config_t;
+
+/**
+ * \brief   Outbox settings
+ *
+ *   The datapoints are written to the file right away, but the file is only
+ *   synced to the storage once `commit_records` of them are pending or
+ *   `commit_interval_ms` has passed, so the write rate stays bounded whatever
+ *   the rate of the samples. The outbox is drained every `drain_interval_ms`,
+ *   and each drain sends at most `drain_requests` requests so the caller is
+ *   never held up for long. A drain that stops at this limit goes on at the
+ *   next poll, a failed one waits for the interval. The `clock_ms` works as
+ *   the one of the write-behind queue.
+ */
+typedef struct {
+    uint32_t    capacity;               /** the datapoints the file holds, the oldest ones are dropped when it's full */
+    uint32_t    commit_records;
+    uint32_t    commit_interval_ms;
+    uint32_t    drain_interval_ms;
+    uint32_t    drain_requests;         /** the requests sent by one drain at most, the rest goes on at the next poll */
+    uint32_t    ( *clock_ms )( void );
+} xi_outbox_config_t;
+
+/**
+ * \brief   Feed cache counters
+ */
+typedef struct {
+    uint32_t hits;          /** fresh reads served without touching the network */
+    uint32_t misses;        /** reads sent without the validators */
+    uint32_t revalidations; /** reads sent with the validators of a stale entry */
+} xi_feed_cache_stats_t;
+
 /**
  * \brief   _The context structure_ - it's the first agument for all functions
  *          that communicate with Xively API (_i.e. not helpers or utilities_)
@@ -55,6 +185,14 @@ typedef struct {
     xi_feed_id_t feed_id;       /** Xively feed ID */
     layer_chain_t layer_chain;  /** Xively reference of layers */
     void*         input;        /** Xively ptr to the input data */
+    xi_response_mode_t response_mode; /** Xively response mode used by write requests */
+    void*         write_behind; /** Xively write-behind queue, `0` if disabled */
+    void*         feed_cache;   /** Xively feed cache, `0` if disabled */
+    void*         aggregator;   /** Xively edge aggregation, `0` if disabled */
+    void*         outbox;       /** Xively persistent outbound queue, `0` if disabled */
+    char          connected;    /** Xively persistent connection state, not used by `XI_HTTP` */
+    uint8_t       mqtt_qos;     /** Xively QoS level used by `XI_MQTT`, `0` or `1` */
+    uint8_t       http2_submit; /** Xively `XI_HTTP2` calls submit the requests rather than wait */
 } xi_context_t;
 
 /**
@@ -80,6 +218,12 @@ typedef enum
     XI_HTTP_HEADER_COUNT,
     /** `Age` */
     XI_HTTP_HEADER_AGE,
+    /** `Retry-After` */
+    XI_HTTP_HEADER_RETRY_AFTER,
+    /** `ETag` */
+    XI_HTTP_HEADER_ETAG,
+    /** `Last-Modified` */
+    XI_HTTP_HEADER_LAST_MODIFIED,
     // must go before the last here
     XI_HTTP_HEADER_UNKNOWN,
     // must be the last here
@@ -153,6 +297,8 @@ typedef struct {
     char              datastream_id[ XI_MAX_DATASTREAM_NAME ];
     size_t            datapoint_count;
     xi_datapoint_t    datapoints[ XI_MAX_DATAPOINTS ];
+    xi_datapoint_t    min_value;    /** read by the `XI_HTTP_JSON` only, the CSV does not carry it */
+    xi_datapoint_t    max_value;    /** read by the `XI_HTTP_JSON` only */
 } xi_datastream_t;
 
 /**
@@ -168,6 +314,117 @@ typedef struct {
     xi_datastream_t   datastreams[ XI_MAX_DATASTREAMS ];
 } xi_feed_t;
 
+/**
+ * \brief   The value of a sample of a column, the strings are the indexes into the string table
+ */
+typedef union {
+    int32_t     i32_value;
+    float       f32_value;
+    uint32_t    str_index;
+} xi_column_value_t;
+
+/**
+ * \brief   The datapoints of a datastream as the arrays of their timestamps and of their values
+ */
+typedef struct {
+    char                datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_value_type_t     value_type;                         /** of all of the values of the column */
+    size_t              sample_count;
+    int64_t             at[ XI_MAX_COLUMN_SAMPLES ];        /** microseconds since the epoch, `0` for the server-side timestamp */
+    xi_column_value_t   values[ XI_MAX_COLUMN_SAMPLES ];
+} xi_column_t;
+
+/**
+ * \brief   _Columnar feed structure_ - the datastreams as the columns of the samples
+ * \note    A sample takes 12 bytes where the `xi_datapoint_t` takes over 40, the
+ *          string values are stored once within the table shared by the columns.
+ */
+typedef struct {
+    xi_feed_id_t    feed_id;
+    size_t          column_count;
+    xi_column_t     columns[ XI_MAX_DATASTREAMS ];
+    size_t          string_count;
+    char            strings[ XI_MAX_COLUMN_STRINGS ][ XI_VALUE_STRING_MAX_SIZE ];
+} xi_feed_columns_t;
+
+/**
+ * \brief   The caller-provided memory the runtime-sized feeds are allocated from
+ * \note    Nothing is freed on its own, `xi_arena_reset()` releases all of it at once.
+ */
+typedef struct {
+    unsigned char*  base;
+    size_t          size;
+    size_t          used;
+    void*           last;                   /** the latest allocation, the only one that grows in place */
+} xi_arena_t;
+
+/**
+ * \brief   The datastream of the `xi_arena_feed_t`, its id and datapoints take only the space they need
+ */
+typedef struct xi_arena_datastream_t {
+    struct xi_arena_datastream_t*   next;
+    const char*                     datastream_id;
+    size_t                          datapoint_count;
+    size_t                          datapoint_capacity;
+    xi_datapoint_t*                 datapoints;
+} xi_arena_datastream_t;
+
+/**
+ * \brief   _Runtime-sized feed structure_ - any number of datastreams of any number of datapoints
+ */
+typedef struct {
+    xi_arena_t*             arena;
+    xi_feed_id_t            feed_id;
+    size_t                  datastream_count;
+    xi_arena_datastream_t*  datastreams;
+    xi_arena_datastream_t*  last;
+} xi_arena_feed_t;
+
+/**
+ * \brief   What `xi_feed_update_delta()` has sent of each datastream of the feed
+ * \note    The datastreams are told apart by their position within the feed.
+ */
+typedef struct {
+    size_t          sent_count;                                         /** the datastreams of the snapshot */
+    char            sent_ids[ XI_MAX_DATASTREAMS ][ XI_MAX_DATASTREAM_NAME ];
+    size_t          sent_datapoint_counts[ XI_MAX_DATASTREAMS ];
+    xi_datapoint_t  sent_datapoints[ XI_MAX_DATASTREAMS ];              /** the last datapoint of each one */
+    unsigned char   dirty[ ( XI_MAX_DATASTREAMS + 7 ) / 8 ];            /** the ones to send whatever the snapshot says */
+} xi_feed_delta_t;
+
+/**
+ * \brief   The handle of the interned datastream id, `-1` if there is none
+ */
+typedef int xi_id_handle_t;
+
+/**
+ * \brief   Maps the datastream ids to the small integer handles, the handles are given in order from `0`
+ */
+typedef struct {
+    size_t      id_count;
+    char        ids[ XI_MAX_INTERNED_IDS ][ XI_MAX_DATASTREAM_NAME ];
+    uint32_t    hashes[ XI_MAX_INTERNED_IDS ];
+    uint16_t    slots[ XI_MAX_INTERNED_IDS * 2 ];           /** the handle + 1 of the id hashed there, `0` for the empty slot */
+} xi_id_table_t;
+
+/**
+ * \brief   The hash index of the datastreams of the `xi_feed_t`
+ * \note    It has to be rebuilt whenever the datastreams of the feed change.
+ */
+typedef struct {
+    uint32_t    hashes[ XI_MAX_DATASTREAMS ];
+    uint16_t    slots[ XI_FEED_INDEX_SLOTS ];               /** the datastream index + 1, `0` for the empty slot */
+} xi_feed_index_t;
+
+/**
+ * \brief   Receives the datastreams of a streamed feed one by one as they are decoded
+ * \note    The datastream id and the datapoint are only valid for the duration of the call.
+ */
+typedef void ( xi_feed_sink_t )(
+          const char* datastream_id
+        , const xi_datapoint_t* datapoint
+        , void* user_data );
+
 //-----------------------------------------------------------------------
 // HELPER FUNCTIONS
 //-----------------------------------------------------------------------
@@ -268,6 +525,120 @@ extern xi_datapoint_t* xi_set_value_str( xi_datapoint_t* dp, const char* v );
  */
 extern char* xi_value_pointer_str( xi_datapoint_t* p );
 
+/**
+ * \brief   Appends the datapoint to the column of the datastream, the column is added if there is none
+ *
+ *   The integers appended to the float column become floats, the float appended
+ *   to the integer column turns all of it into floats. The strings do not mix
+ *   with the numbers.
+ *
+ * \return  `0` or `-1` if an error occurred, `XI_COLUMNS_FULL` and `XI_COLUMN_TYPE_MISMATCH`
+ *          leave the columns as they have been
+ */
+extern int xi_feed_columns_append(
+          xi_feed_columns_t* columns
+        , const char* datastream_id
+        , const xi_datapoint_t* datapoint );
+
+/**
+ * \brief   Gets the sample of the column as the datapoint
+ * \return  The datapoint
+ */
+extern xi_datapoint_t* xi_feed_columns_datapoint(
+          const xi_feed_columns_t* columns
+        , const xi_column_t* column
+        , size_t sample
+        , xi_datapoint_t* datapoint );
+
+/**
+ * \brief   Makes the arena of the buffer, the buffer has to outlive all of the feeds allocated from it
+ */
+extern void xi_arena_init( xi_arena_t* arena, void* buffer, size_t size );
+
+/**
+ * \brief   Releases everything allocated from the arena
+ */
+extern void xi_arena_reset( xi_arena_t* arena );
+
+/**
+ * \brief   Allocates the aligned block of the arena
+ * \return  The block or `0` with `XI_OUT_OF_MEMORY` if the arena is full
+ */
+extern void* xi_arena_alloc( xi_arena_t* arena, size_t size );
+
+/**
+ * \brief   Allocates the empty feed from the arena
+ * \return  The feed or `0` if an error occurred
+ */
+extern xi_arena_feed_t* xi_arena_feed_create( xi_arena_t* arena, xi_feed_id_t feed_id );
+
+/**
+ * \brief   Adds the datastream without the datapoints at the end of the feed
+ * \return  The datastream or `0` if an error occurred
+ */
+extern xi_arena_datastream_t* xi_arena_feed_add_datastream(
+          xi_arena_feed_t* feed
+        , const char* datastream_id );
+
+/**
+ * \brief   Appends the datapoint to the datastream of the feed
+ *
+ *   The datapoints of the datastream added last grow in place, the others are
+ *   moved to the end of the arena when they run out of space.
+ *
+ * \return  `0` or `-1` if an error occurred
+ */
+extern int xi_arena_datastream_append(
+          xi_arena_feed_t* feed
+        , xi_arena_datastream_t* datastream
+        , const xi_datapoint_t* datapoint );
+
+/**
+ * \brief   Forgets everything that has been sent, so the next delta update sends all of the feed
+ */
+extern void xi_feed_delta_init( xi_feed_delta_t* delta );
+
+/**
+ * \brief   Makes the next delta update send the datastream even if it looks the same as sent
+ */
+extern void xi_feed_delta_mark( xi_feed_delta_t* delta, size_t datastream_index );
+
+/**
+ * \brief   Empties the table
+ */
+extern void xi_id_table_init( xi_id_table_t* table );
+
+/**
+ * \brief   Gets the handle of the id, the id is added to the table if it is not there
+ * \return  The handle or `-1` if an error occurred
+ */
+extern xi_id_handle_t xi_id_intern( xi_id_table_t* table, const char* datastream_id );
+
+/**
+ * \brief   Gets the handle of the id without adding it
+ * \return  The handle or `-1` if the id is not in the table
+ */
+extern xi_id_handle_t xi_id_lookup( const xi_id_table_t* table, const char* datastream_id );
+
+/**
+ * \brief   Gets the id of the handle
+ */
+extern const char* xi_id_string( const xi_id_table_t* table, xi_id_handle_t handle );
+
+/**
+ * \brief   Builds the index of the datastreams of the feed, the first one wins if the ids repeat
+ */
+extern void xi_feed_index_build( xi_feed_index_t* index, const xi_feed_t* feed );
+
+/**
+ * \brief   Finds the datastream of the feed by its id in constant time
+ * \return  The datastream or `0` if there is none
+ */
+extern xi_datastream_t* xi_feed_find_datastream(
+          const xi_feed_index_t* index
+        , xi_feed_t* feed
+        , const char* datastream_id );
+
 /**
  * \brief   Sets the timeout for network operations
  *
@@ -287,6 +658,47 @@ extern void xi_set_network_timeout( uint32_t milliseconds );
  */
 extern uint32_t xi_get_network_timeout( void );
 
+/**
+ * \brief   Sets the response mode used by write requests
+ *
+ * \note    Write requests (updates, creates and deletes) only need to know
+ *          the `http_status`. With `XI_RESPONSE_MODE_STATUS_ONLY` the library
+ *          parses the status line and `Content-Length`, `Connection` and
+ *          `Retry-After` headers only and then skips the body without copying
+ *          it anywhere, so none of the other headers or the error message will
+ *          be available in the response. Read requests always parse the full
+ *          response.
+ */
+extern void xi_set_response_mode( xi_context_t* xi, xi_response_mode_t mode );
+
+/**
+ * \brief   Sets the QoS level used by the `XI_MQTT` contexts
+ *
+ * \note    With QoS `0` updates are returned with `202` as soon as they are
+ *          sent. With QoS `1` up to `XI_MQTT_MAX_INFLIGHT` updates may wait for
+ *          the acknowledgement and the update that fills the window blocks till
+ *          the broker acknowledges any of them. The waiting updates are kept and
+ *          sent again once the connection has been made again. The updates over
+ *          `XI_MQTT_INFLIGHT_PACKET_SIZE` are not kept, they block till their own
+ *          acknowledgement and get the `200` status.
+ */
+extern void xi_set_mqtt_qos( xi_context_t* xi, uint8_t qos );
+
+/**
+ * \brief   Sets the retry policy used by all of the contexts
+ *
+ * \note    The default policy makes a single attempt. Only the blocking API
+ *          retries, the policy is ignored when `XI_NOB_ENABLED` is set. The
+ *          default `sleep_ms` is implemented on POSIX only, other platforms
+ *          have to provide their own.
+ */
+extern void xi_set_retry_policy( const xi_retry_policy_t* policy );
+
+/**
+ * \brief   Gets the current retry policy
+ */
+extern const xi_retry_policy_t* xi_get_retry_policy( void );
+
 //-----------------------------------------------------------------------
 // MAIN LIBRARY FUNCTIONS
 //-----------------------------------------------------------------------
@@ -332,11 +744,77 @@ extern const xi_response_t* xi_feed_get(
 
 /**
  * \brief   Retrieve Xively feed all datastreams
+ * \note    Only the first `XI_MAX_DATASTREAMS` datastreams are stored, use the
+ *          `xi_feed_get_all_streamed()` if the feed may have more of them.
  */
 extern const xi_response_t* xi_feed_get_all(
           xi_context_t* xi
         , xi_feed_t* feed );
 
+/**
+ * \brief   Retrieve Xively feed all datastreams passing each one to the sink
+ *
+ *   The sink is called as soon as the datastream is decoded, before the rest
+ *   of the response arrives, so the feed of any size is processed in the
+ *   constant memory.
+ */
+extern const xi_response_t* xi_feed_get_all_streamed(
+          xi_context_t* xi
+        , xi_feed_sink_t* sink
+        , void* user_data );
+
+/**
+ * \brief   Update Xively feed with only the datastreams that have changed since the last successful update
+ *
+ *   The datastream is sent if its id, the number of its datapoints or its last
+ *   datapoint differs from what has been sent at its position, or if it has been
+ *   marked with `xi_feed_delta_mark()`. The snapshot only moves on if the update
+ *   succeeds, so the failed changes are sent again next time.
+ *
+ * \return  The response, the one with the `304` status if nothing has changed
+ *          and no request has been sent, or `0` if the request could not be sent
+ */
+extern const xi_response_t* xi_feed_update_delta(
+          xi_context_t* xi
+        , const xi_feed_t* feed
+        , xi_feed_delta_t* delta );
+
+/**
+ * \brief   Update Xively feed with all of the samples of the columns
+ */
+extern const xi_response_t* xi_feed_columns_update(
+          xi_context_t* xi
+        , const xi_feed_columns_t* columns );
+
+/**
+ * \brief   Retrieve Xively feed all datastreams into the columns
+ *
+ *   The response is decoded the same way as by `xi_feed_get_all_streamed()`,
+ *   the datapoints that do not fit the columns are dropped.
+ */
+extern const xi_response_t* xi_feed_columns_get_all(
+          xi_context_t* xi
+        , xi_feed_columns_t* columns );
+
+/**
+ * \brief   Update Xively feed with all of the datapoints of the runtime-sized feed
+ */
+extern const xi_response_t* xi_arena_feed_update(
+          xi_context_t* xi
+        , const xi_arena_feed_t* feed );
+
+/**
+ * \brief   Retrieve Xively feed all datastreams into the runtime-sized feed
+ *
+ *   The datastreams are appended to the feed, which is usually the one just
+ *   created. The response is decoded the same way as by `xi_feed_get_all_streamed()`,
+ *   so it is only limited by the size of the arena, the datapoints that do not fit
+ *   are dropped.
+ */
+extern const xi_response_t* xi_arena_feed_get_all(
+          xi_context_t* xi
+        , xi_arena_feed_t* feed );
+
 /**
  * \brief   Create a datastream with given value using server timestamp
  */
@@ -360,6 +838,17 @@ extern const xi_response_t* xi_datastream_get(
           xi_context_t* xi, xi_feed_id_t feed_id
         , const char * datastream_id, xi_datapoint_t* dp );
 
+/**
+ * \brief   Retrieve all of the datapoints the server sends for a given datastream
+ *
+ *   Each datapoint of the response is stored in `datastream->datapoints` in the
+ *   order they come in, up to `XI_MAX_DATAPOINTS` of them. The datastream
+ *   without the datapoints gets its current value as the only one.
+ */
+extern const xi_response_t* xi_datastream_get_datapoints(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id, xi_datastream_t* datastream );
+
 /**
  * \brief   Delete datastream
  * \warning This function destroys the data in Xively and there is no way to restore it!
@@ -389,6 +878,281 @@ extern const xi_response_t* xi_datapoint_delete_range(
           const xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
         , const xi_timestamp_t* start, const xi_timestamp_t* end );
 
+/**
+ * \brief   Retrieve the datapoints of a datastream in given time range
+ *
+ *   The datapoints are requested in pages of `XI_HISTORY_PAGE_SIZE` and each
+ *   one is passed to the sink as soon as it is decoded, the next page starts
+ *   right after the last datapoint of the previous one. Nothing is stored by
+ *   the library so any amount of history is read in the constant memory.
+ *
+ * \param   interval    The sampling interval in seconds, `0` for all of the datapoints
+ * \param   limit       The maximum number of datapoints passed to the sink, `0` for no limit
+ * \return  The response of the last page
+ */
+extern const xi_response_t* xi_datastream_history(
+          xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
+        , const xi_timestamp_t* start, const xi_timestamp_t* end
+        , uint32_t interval, uint32_t limit
+        , xi_feed_sink_t* sink, void* user_data );
+
+/**
+ * \brief   Store many timestamped datapoints of a datastream at once
+ *
+ *   The datapoints are posted to the datapoints of the datastream in requests
+ *   of up to `XI_DATAPOINTS_POST_SIZE` of them. A request refused by the server
+ *   as too large (`413`) is split in halves and sent again, the smaller size is
+ *   kept for the rest of the upload. The requests are not repeated by the retry
+ *   policy once they have been sent, unless `retry_non_idempotent` is set.
+ *
+ * \warning The datapoints without the timestamp all get the time of the request.
+ * \return  The response of the last request, it tells the error the upload stopped at,
+ *          the datapoints of the requests before that one have been stored.
+ *          `0` if there was nothing to send or the request could not be sent.
+ */
+extern const xi_response_t* xi_datapoints_post(
+          xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
+        , const xi_datapoint_t* datapoints, size_t count );
+
+//-----------------------------------------------------------------------
+// WRITE-BEHIND QUEUE
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Enables the write-behind mode of the context
+ *
+ *   In the write-behind mode `xi_datastream_update()` puts the datapoint into
+ *   a queue and returns a response with the `202` status. Everything that has
+ *   been queued is sent as a single `xi_feed_update()` once the queue is due
+ *   or full. The queue is limited by `XI_MAX_DATASTREAMS` and
+ *   `XI_MAX_DATAPOINTS`. Whatever is still queued when the context gets
+ *   deleted is dropped, so call `xi_write_behind_disable()` before.
+ *
+ * \return  The context or `0` if an error occurred
+ */
+extern xi_context_t* xi_write_behind_enable(
+          xi_context_t* xi
+        , const xi_write_behind_config_t* config );
+
+/**
+ * \brief   Flushes the queue and disables the write-behind mode
+ *
+ *   If the flush fails the write-behind mode stays enabled with everything
+ *   still queued, so the call can be repeated later. Check `xi->write_behind`
+ *   or the status of the response to tell whether it has been disabled.
+ *
+ * \return  The response of the last flush or `0` if nothing has been sent
+ */
+extern const xi_response_t* xi_write_behind_disable( xi_context_t* xi );
+
+/**
+ * \brief   Sends everything that is queued
+ *
+ * \note    If the update fails the datapoints that have not been accepted
+ *          by the server stay in the queue.
+ *
+ * \return  The response of the last request or `0` if nothing has been sent
+ */
+extern const xi_response_t* xi_write_behind_flush( xi_context_t* xi );
+
+/**
+ * \brief   Flushes the queue only if the flush interval or the max latency
+ *          has passed, it's meant to be called periodically
+ *
+ * \return  The response of the last request or `0` if nothing has been sent
+ */
+extern const xi_response_t* xi_write_behind_poll( xi_context_t* xi );
+
+//-----------------------------------------------------------------------
+// EDGE AGGREGATION
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Enables the aggregation of the samples of `xi_datastream_update()`
+ *
+ *   The samples are filtered and reduced as the rules say before they go
+ *   wherever `xi_datastream_update()` would send them, including the
+ *   write-behind queue. The suppressed and the collected samples get a response
+ *   with the `202` status. The samples of the strings are sent as they are.
+ *   The window whose aggregate gets a response other than `2xx` is kept, the
+ *   aggregates that have not been sent yet are sent again with the next update
+ *   or poll of the datastream and the new samples join the window meanwhile.
+ *   Up to `XI_MAX_DATASTREAMS` datastreams are aggregated, the rest are sent
+ *   as they are.
+ *
+ * \return  The context or `0` if an error occurred
+ */
+extern xi_context_t* xi_aggregator_enable(
+          xi_context_t* xi
+        , const xi_aggregator_config_t* config );
+
+/**
+ * \brief   Sets the rule of the datastream, its open window is sent first
+ * \return  `0` or `-1` if an error occurred or the window could not be sent,
+ *          the rule is not changed then
+ */
+extern int xi_aggregator_set_rule(
+          xi_context_t* xi
+        , const char* datastream_id
+        , const xi_aggregation_rule_t* rule );
+
+/**
+ * \brief   Sends the aggregates of the windows that have passed, it's meant
+ *          to be called periodically if the samples may stop coming
+ *
+ * \return  The response of the last request or `0` if nothing has been sent,
+ *          the poll stops at the first window that could not be sent and
+ *          returns its failure
+ */
+extern const xi_response_t* xi_aggregator_poll( xi_context_t* xi );
+
+/**
+ * \brief   Sends the aggregates of all of the open windows and disables the aggregation
+ *
+ *   If a window could not be sent the aggregation stays enabled with the
+ *   windows that are left and the failure is returned.
+ *
+ * \return  The response of the last request or `0` if nothing has been sent
+ */
+extern const xi_response_t* xi_aggregator_disable( xi_context_t* xi );
+
+#ifdef XI_OUTBOX_ENABLED
+//-----------------------------------------------------------------------
+// OUTBOX
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Enables the persistent outbound queue of the context
+ *
+ *   With the outbox `xi_datastream_update()`, `xi_datapoints_post()` and
+ *   `xi_feed_update()` write their datapoints into the memory-mapped ring
+ *   file at the `path` and return a response with the `202` status, the queue is sent by `xi_outbox_poll()` only, which reports
+ *   the failures. The queued datapoints are sent datastream by datastream as
+ *   the `xi_datapoints_post()` requests of up to `XI_DATAPOINTS_POST_SIZE` of
+ *   them, and are only removed from the file once the server accepts them.
+ *   The datapoints without the timestamp get the current time when queued,
+ *   made later than the one given before so that no two of them are equal.
+ *
+ *   The file of an earlier outbox is picked up where the last commit has left
+ *   it, the datapoints queued after it are lost if the process crashes, but
+ *   the queue is never corrupted. The file of the other capacity is recreated.
+ *   The outbox enabled already is committed and disabled before the file is
+ *   opened, so enabling it again keeps the datapoints it holds.
+ *
+ * \note    The outbox takes the place of the write-behind queue for the
+ *          `xi_datastream_update()`, the aggregation stays in front of it.
+ *          The feed is queued as the datapoints of its datastreams.
+ *          `xi_feed_update_delta()` is not queued, its datastreams stay dirty
+ *          if it fails.
+ *
+ * \return  The context or `0` if an error occurred
+ */
+extern xi_context_t* xi_outbox_enable(
+          xi_context_t* xi
+        , const char* path
+        , const xi_outbox_config_t* config );
+
+/**
+ * \brief   Commits the queue and disables the outbox, what is still queued stays in the file
+ */
+extern void xi_outbox_disable( xi_context_t* xi );
+
+/**
+ * \brief   Syncs all of the queued datapoints to the storage
+ * \return  `0` or `-1` if an error occurred
+ */
+extern int xi_outbox_commit( xi_context_t* xi );
+
+/**
+ * \brief   Commits and drains the queue if they are due, it has to be called periodically
+ *
+ * \return  The response of the last request, the failure the drain has stopped at,
+ *          or `0` if nothing has been sent
+ */
+extern const xi_response_t* xi_outbox_poll( xi_context_t* xi );
+
+/**
+ * \return  The number of the datapoints in the queue, `0` if the outbox is disabled
+ */
+extern size_t xi_outbox_pending( const xi_context_t* xi );
+#endif // XI_OUTBOX_ENABLED
+
+//-----------------------------------------------------------------------
+// FEED CACHE
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Enables the cache of the `xi_feed_get()` and `xi_feed_get_all()` reads
+ *
+ *   The entries are kept per feed and set of datastreams, the least recently
+ *   used one is replaced when `XI_FEED_CACHE_ENTRIES` are in use. An entry is
+ *   fresh for the `max-age` of the `Cache-Control` minus the `Age` of the
+ *   response and is returned as a `200` response without a request. A stale
+ *   entry is revalidated with the `If-None-Match` and `If-Modified-Since`
+ *   headers, a `304` fills the feed from the entry without any body parsing
+ *   and is returned as a `200` response as well.
+ *   An entry keeps every datapoint of the response, so a hit fills the
+ *   feed the same way the request would. Each entry takes the room of
+ *   `XI_MAX_DATASTREAMS` datastreams of `XI_MAX_DATAPOINTS` each.
+ *   The responses with `no-store` are not cached. The `clock_ms` works as
+ *   the one of the write-behind queue.
+ *
+ * \note    Only `XI_HTTP` responses carry the headers the cache relies on.
+ *
+ * \return  The context or `0` if an error occurred
+ */
+extern xi_context_t* xi_feed_cache_enable(
+          xi_context_t* xi
+        , uint32_t ( *clock_ms )( void ) );
+
+/**
+ * \brief   Drops all of the entries and disables the cache
+ */
+extern void xi_feed_cache_disable( xi_context_t* xi );
+
+/**
+ * \return  The counters of the cache or `0` if it's disabled
+ */
+extern const xi_feed_cache_stats_t* xi_feed_cache_stats( const xi_context_t* xi );
+
+//-----------------------------------------------------------------------
+// HTTP/2 STREAMS
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Makes the calls of the `XI_HTTP2` context submit their requests
+ *          rather than wait for the responses
+ *
+ *   While it is set each call sends its request as a new stream of the
+ *   connection and returns at once, so up to `XI_HTTP2_MAX_STREAMS - 1` of
+ *   them run at the same time with their frames interleaved. The response
+ *   returned is the one of the stream, its `http_status` stays `0` until the
+ *   `xi_http2_poll()` has read the end of the stream. It stays valid until
+ *   a later request takes the slot of the ended stream. The call returns `0`
+ *   if all of the streams are open or the request could not be sent.
+ *
+ * \note    What the call is given, e.g. the datapoint a get writes to, has to
+ *          outlive the stream. The calls that send more than one request, the
+ *          write-behind queue, the aggregation, the outbox and the feed cache
+ *          need the responses at once, so they are not meant to be submitted.
+ *          The blocking calls still work with the streams open and read their
+ *          frames while they wait.
+ */
+extern void xi_set_http2_submit( xi_context_t* xi, uint8_t submit );
+
+/**
+ * \brief   Reads what has arrived for the submitted streams without waiting
+ *          for more, it's meant to be called periodically
+ *
+ * \note    Only the POSIX io layer reads without waiting, the other ones
+ *          block till something arrives.
+ *
+ * \return  The number of the submitted streams that have not ended yet or `-1`
+ *          if the context is not connected, the streams that were open when
+ *          the connection failed are left with the `0` status
+ */
+extern int xi_http2_poll( xi_context_t* xi );
+
 #else
 //-----------------------------------------------------------------------
 // MAIN LIBRARY NON BLOCKING FUNCTIONS
@@ -0,0 +1,232 @@
+// Copyright (c) 2003-2014, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+// throughput of the csv decoding, build and run with: make tests XI_TEST_SUITE=bench XI_BUILD_TYPE=release
+
+#include "xively.h"
+#include "xi_csv_layer.h"
+#include "xi_csv_layer_data.h"
+#include "xi_csv_scan.h"
+#include "xi_number_format.h"
+#include "xi_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_LINES     20000
+#define BENCH_CHUNK     1024
+#define BENCH_ROUNDS    20
+
+static char* bench_body         = 0;
+static size_t bench_body_size   = 0;
+static size_t bench_decoded     = 0;
+
+static void bench_make_body( void )
+{
+    static const char* values[] = { "21", "-3.25", "1234.5678", "a rather long string value", "OK" };
+
+    bench_body      = ( char* ) malloc( BENCH_LINES * 80 );
+    bench_body_size = 0;
+
+    for( int i = 0; i < BENCH_LINES; ++i )
+    {
+        bench_body_size += sprintf( bench_body + bench_body_size
+            , "stream%d,2014-02-03T10:%02d:%02d.%06dZ,%s\n"
+            , i % 100, ( i / 60 ) % 60, i % 60, i, values[ i % 5 ] );
+    }
+}
+
+static double bench_seconds( clock_t start )
+{
+    return ( double ) ( clock() - start ) / CLOCKS_PER_SEC;
+}
+
+static void bench_report( const char* name, double seconds, size_t rounds )
+{
+    printf( "%-24s %10.1f MB/s\n", name, ( double ) ( bench_body_size * rounds ) / ( 1024.0 * 1024.0 ) / seconds );
+}
+
+static void bench_sink( const char* datastream_id, const xi_datapoint_t* datapoint, void* user_data )
+{
+    ( void ) datastream_id;
+    ( void ) datapoint;
+    ( void ) user_data;
+
+    bench_decoded += 1;
+}
+
+// the body is handed over in chunks cut at the end of a line as the timestamps can't be split
+static int bench_decode_feed( void )
+{
+    static csv_layer_data_t csv_layer_data;
+    layer_state_t state = LAYER_STATE_WANT_READ;
+    size_t offset       = 0;
+
+    memset( &csv_layer_data, 0, sizeof( csv_layer_data_t ) );
+
+    while( offset < bench_body_size )
+    {
+        size_t size = bench_body_size - offset;
+
+        if( size > BENCH_CHUNK )
+        {
+            size = BENCH_CHUNK;
+
+            while( bench_body[ offset + size - 1 ] != '\n' )
+            {
+                --size;
+            }
+        }
+
+        const_data_descriptor_t chunk = { bench_body + offset, size, size, 0 };
+        const layer_hint_t hint = offset + size < bench_body_size ? LAYER_HINT_MORE_DATA : LAYER_HINT_NONE;
+
+        state   = csv_layer_parse_feed( &csv_layer_data, &chunk, hint, &bench_sink, 0 );
+        offset += size;
+
+        if( state == LAYER_STATE_ERROR )
+        {
+            return -1;
+        }
+    }
+
+    return state == LAYER_STATE_OK ? 0 : -1;
+}
+
+// the bytewise loop the delimiter scan replaces
+static size_t bench_count_lines_bytewise( void )
+{
+    size_t lines = 0;
+
+    for( size_t i = 0; i < bench_body_size; ++i )
+    {
+        const char c = bench_body[ i ];
+
+        if( c == '\n' || c == '\r' || c == '\0' )
+        {
+            ++lines;
+        }
+    }
+
+    return lines;
+}
+
+static size_t bench_count_lines_scan( void )
+{
+    size_t lines = 0;
+
+    for( size_t i = 0; i < bench_body_size; ++i, ++lines )
+    {
+        i += xi_csv_scan_line( bench_body + i, bench_body_size - i );
+    }
+
+    return lines;
+}
+
+// the values per second the floats are formatted at
+static void bench_format_floats( char shortest )
+{
+    char buffer[ 32 ];
+    size_t total        = 0;
+    const int count     = BENCH_LINES * BENCH_ROUNDS;
+    clock_t start       = clock();
+
+    for( int i = 0; i < count; ++i )
+    {
+        const float value = ( float ) ( i % 10000 ) / 64.0f - 50.0f;
+
+        total += shortest ? ( size_t ) xi_format_f32( buffer, sizeof( buffer ), value, XI_FLOAT_PRECISION_SHORTEST )
+                          : ( size_t ) snprintf( buffer, sizeof( buffer ), "%f", value );
+    }
+
+    const double seconds = bench_seconds( start );
+
+    printf( "%-24s %10.1f M/s %6.1f chars\n", shortest ? "float format" : "float format snprintf"
+        , count / seconds / 1e6, ( double ) total / count );
+}
+
+// the timestamps per second, ten datapoints share each second
+static void bench_format_timestamps( char cached )
+{
+    char buffer[ 64 ];
+    const int count = BENCH_LINES * BENCH_ROUNDS;
+    clock_t start   = clock();
+
+    for( int i = 0; i < count; ++i )
+    {
+        const xi_time_t seconds = 1391421600 + i / 10;
+
+        if( cached )
+        {
+            xi_format_iso8601( buffer, seconds, i );
+        }
+        else
+        {
+            const struct xi_tm* tm = xi_gmtime( &seconds );
+
+            snprintf( buffer, sizeof( buffer ), "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ"
+                , tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec, i % 1000000 );
+        }
+    }
+
+    printf( "%-24s %10.1f M/s\n", cached ? "timestamp format" : "timestamp format printf"
+        , count / bench_seconds( start ) / 1e6 );
+}
+
+int main( void )
+{
+    clock_t start   = 0;
+    size_t lines    = 0;
+
+    bench_make_body();
+
+    printf( "%d lines, %lu bytes\n", BENCH_LINES, ( unsigned long ) bench_body_size );
+
+    start = clock();
+
+    for( int i = 0; i < BENCH_ROUNDS * 50; ++i )
+    {
+        lines += bench_count_lines_bytewise();
+    }
+
+    bench_report( "line scan bytewise", bench_seconds( start ), BENCH_ROUNDS * 50 );
+
+    start = clock();
+
+    for( int i = 0; i < BENCH_ROUNDS * 50; ++i )
+    {
+        lines -= bench_count_lines_scan();
+    }
+
+    bench_report( "line scan", bench_seconds( start ), BENCH_ROUNDS * 50 );
+
+    start = clock();
+
+    for( int i = 0; i < BENCH_ROUNDS; ++i )
+    {
+        if( bench_decode_feed() != 0 )
+        {
+            printf( "feed decoding failed\n" );
+            return 1;
+        }
+    }
+
+    bench_report( "feed decode", bench_seconds( start ), BENCH_ROUNDS );
+
+    bench_format_floats( 0 );
+    bench_format_floats( 1 );
+    bench_format_timestamps( 0 );
+    bench_format_timestamps( 1 );
+
+    free( bench_body );
+
+    if( lines != 0 || bench_decoded != ( size_t ) BENCH_LINES * BENCH_ROUNDS )
+    {
+        printf( "the results differ\n" );
+        return 1;
+    }
+
+    return 0;
+}
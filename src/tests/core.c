@@ -6,6 +6,19 @@
 #include "xively.h"
 #include "xi_err.h"
 #include "xi_helpers.h"
+#include "xi_layer.h"
+#include "xi_http_layer.h"
+#include "xi_http_layer_data.h"
+#include "xi_write_behind.h"
+#include "xi_layer_api.h"
+#include "xi_sha1.h"
+#include "xi_base64.h"
+#include "xi_config.h"
+#include "xi_macros.h"
+#include "xi_csv_layer.h"
+#include "xi_csv_scan.h"
+#include "xi_number_format.h"
+#include "xi_time.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,10 +26,108 @@
 #include <errno.h>
 #include <time.h>
 
+#ifdef XI_OUTBOX_ENABLED
+#include <unistd.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // HTTP PARSER TESTS
 ///////////////////////////////////////////////////////////////////////////////
 
+void test_parse_http_status_only(void* data)
+{
+    (void)(data);
+
+    const char response[] =
+        "HTTP/1.1 404 Not Found\r\n"
+        "Date: Mon, 03 Feb 2014 10:00:00 GMT\r\n"
+        "Content-Type: text/plain; charset=utf-8\r\n"
+        "content-length: 13\r\n"
+        "Connection: keep-alive\r\n"
+        "X-Request-Id: 0123456789abcdef\r\n"
+        "\r\n"
+        "Not found yet";
+
+    xi_response_t response_data;
+    memset( &response_data, 0, sizeof( xi_response_t ) );
+
+    http_layer_data_t http_layer_data;
+    memset( &http_layer_data, 0, sizeof( http_layer_data_t ) );
+    http_layer_data.response        = &response_data;
+    http_layer_data.response_mode   = XI_RESPONSE_MODE_STATUS_ONLY;
+
+    layer_t http_layer;
+    memset( &http_layer, 0, sizeof( layer_t ) );
+    http_layer.user_data                = &http_layer_data;
+    http_layer.layer_connection.self    = &http_layer;
+
+    layer_state_t state     = LAYER_STATE_WANT_READ;
+    unsigned short offset   = 0;
+
+    // feed the response in small chunks to exercise the resuming
+    while( offset < sizeof( response ) - 1 )
+    {
+        unsigned short size = sizeof( response ) - 1 - offset;
+        size = size > 5 ? 5 : size;
+
+        const_data_descriptor_t chunk = { response + offset, size, size, 0 };
+
+        tt_want_int_op( state, ==, LAYER_STATE_WANT_READ );
+
+        state   = http_layer_on_data_ready( &http_layer.layer_connection, &chunk, LAYER_HINT_MORE_DATA );
+        offset += size;
+
+        tt_want_int_op( chunk.curr_pos, ==, size );
+    }
+
+    tt_int_op( state, ==, LAYER_STATE_OK );
+    tt_int_op( response_data.http.http_status, ==, 404 );
+    tt_int_op( http_layer_data.content_length, ==, 13 );
+    tt_ptr_op( response_data.http.http_headers_checklist[ XI_HTTP_HEADER_CONNECTION ], !=, 0 );
+    tt_str_op( response_data.http.http_headers[ XI_HTTP_HEADER_CONNECTION ].value, ==, "keep-alive" );
+    tt_str_op( response_data.http.http_headers[ XI_HTTP_HEADER_CONTENT_LENGTH ].value, ==, "13" );
+
+    // nothing else is parsed nor copied
+    tt_ptr_op( response_data.http.http_headers_checklist[ XI_HTTP_HEADER_CONTENT_TYPE ], ==, 0 );
+    tt_ptr_op( response_data.http.http_headers_checklist[ XI_HTTP_HEADER_DATE ], ==, 0 );
+    tt_str_op( response_data.http.http_headers[ XI_HTTP_HEADER_UNKNOWN ].value, ==, "" );
+
+    // the body longer than a short is skipped to its very end
+    {
+        static char filler[ 4096 ];
+        const char headers[] = "HTTP/1.1 503 Service Unavailable\r\ncontent-length: 40000\r\n\r\n";
+        const_data_descriptor_t head = { headers, sizeof( headers ) - 1, sizeof( headers ) - 1, 0 };
+        size_t left = 40000;
+
+        memset( &response_data, 0, sizeof( xi_response_t ) );
+        memset( &http_layer_data, 0, sizeof( http_layer_data_t ) );
+        http_layer_data.response        = &response_data;
+        http_layer_data.response_mode   = XI_RESPONSE_MODE_STATUS_ONLY;
+
+        tt_int_op( http_layer_on_data_ready( &http_layer.layer_connection, &head, LAYER_HINT_MORE_DATA ), ==, LAYER_STATE_WANT_READ );
+
+        for( state = LAYER_STATE_WANT_READ; left > 0; left -= ( left < sizeof( filler ) ? left : sizeof( filler ) ) )
+        {
+            const unsigned short size       = left < sizeof( filler ) ? left : sizeof( filler );
+            const_data_descriptor_t chunk   = { filler, size, size, 0 };
+
+            tt_int_op( state, ==, LAYER_STATE_WANT_READ );
+            state = http_layer_on_data_ready( &http_layer.layer_connection, &chunk, LAYER_HINT_MORE_DATA );
+            tt_int_op( chunk.curr_pos, ==, size );
+        }
+
+        tt_int_op( state, ==, LAYER_STATE_OK );
+        tt_int_op( response_data.http.http_status, ==, 503 );
+        tt_int_op( http_layer_data.content_length, ==, 40000 );
+    }
+
+    /* Every test-case function needs to finish with an "end:"
+       label and (optionally) code to clean up local variables. */
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
 void test_parse_http_status(void* data)
 {
     (void)(data);
@@ -143,10 +254,42 @@ void test_csv_encode_datapoint( void* data )
 {
     (void)(data);
 
-    tt_assert( 0 == 0 );
+    char buffer[ 32 ];
+
+    // the shortest text that reads back to the same float
+    tt_int_op( xi_format_f32( buffer, sizeof( buffer ), 21.5f, XI_FLOAT_PRECISION_SHORTEST ), ==, 4 );
+    tt_str_op( buffer, ==, "21.5" );
+    xi_format_f32( buffer, sizeof( buffer ), 0.1f, XI_FLOAT_PRECISION_SHORTEST );
+    tt_str_op( buffer, ==, "0.1" );
+    xi_format_f32( buffer, sizeof( buffer ), -100.0f, XI_FLOAT_PRECISION_SHORTEST );
+    tt_str_op( buffer, ==, "-100.0" );
+    xi_format_f32( buffer, sizeof( buffer ), 1234.5678f, XI_FLOAT_PRECISION_SHORTEST );
+    tt_str_op( buffer, ==, "1234.5677" );
+    xi_format_f32( buffer, sizeof( buffer ), 0.00012f, XI_FLOAT_PRECISION_SHORTEST );
+    tt_str_op( buffer, ==, "0.00012" );
+    xi_format_f32( buffer, sizeof( buffer ), 1e-7f, XI_FLOAT_PRECISION_SHORTEST );
+    tt_str_op( buffer, ==, "1e-7" );
+    xi_format_f32( buffer, sizeof( buffer ), 3.4028235e38f, XI_FLOAT_PRECISION_SHORTEST );
+    tt_str_op( buffer, ==, "3.4028235e38" );
+    tt_assert( strtof( buffer, 0 ) == 3.4028235e38f );
+
+    // the fixed number of decimals
+    xi_format_f32( buffer, sizeof( buffer ), 21.5f, 2 );
+    tt_str_op( buffer, ==, "21.50" );
+    xi_format_f32( buffer, sizeof( buffer ), 9.999f, 2 );
+    tt_str_op( buffer, ==, "10.00" );
+    xi_format_f32( buffer, sizeof( buffer ), 0.0004f, 2 );
+    tt_str_op( buffer, ==, "0.00" );
+    xi_format_f32( buffer, sizeof( buffer ), 2.5f, 0 );
+    tt_str_op( buffer, ==, "3" );
+
+    // the integers
+    tt_int_op( xi_format_i32( buffer, sizeof( buffer ), INT32_MIN ), ==, 11 );
+    tt_str_op( buffer, ==, "-2147483648" );
+    xi_format_i32( buffer, sizeof( buffer ), 7 );
+    tt_str_op( buffer, ==, "7" );
+    tt_int_op( xi_format_i32( buffer, 3, 123 ), ==, -1 );
 
-    /* Every test-case function needs to finish with an "end:"
-       label and (optionally) code to clean up local variables. */
  end:
     xi_set_err( XI_NO_ERR );
     ;
@@ -164,13 +307,2350 @@ void test_helpers_copy_until( void* data )
 
 //decl
 
+static xi_datapoint_t* test_decode_value( const char* first, const char* second )
+{
+    static csv_layer_data_t csv_layer_data;
+    static xi_datapoint_t datapoint;
+    static char line[ 64 ];
+
+    memset( &csv_layer_data, 0, sizeof( csv_layer_data_t ) );
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    snprintf( line, sizeof( line ), "2014-01-01T10:20:30.000000Z,%s", first );
+
+    const_data_descriptor_t chunk = { line, strlen( line ), strlen( line ), 0 };
+
+    layer_state_t state = csv_layer_parse_datastream( &csv_layer_data, &chunk, second ? LAYER_HINT_MORE_DATA : LAYER_HINT_NONE, &datapoint );
+
+    if( second )
+    {
+        const_data_descriptor_t rest = { second, strlen( second ), strlen( second ), 0 };
+
+        state = csv_layer_parse_datastream( &csv_layer_data, &rest, LAYER_HINT_NONE, &datapoint );
+    }
+
+    return state == LAYER_STATE_OK ? &datapoint : 0;
+}
+
 void test_helpers_decode_value( void* data )
 {
     (void)(data);
 
-    tt_assert( 0 == 0 );
+    xi_datapoint_t* dp = 0;
+
+    // the floats are rounded exactly
+    dp = test_decode_value( "21.5", 0 );
+    tt_int_op( dp->value_type, ==, XI_VALUE_TYPE_F32 );
+    tt_assert( dp->value.f32_value == 21.5f );
+    tt_assert( test_decode_value( "-3.25", 0 )->value.f32_value == -3.25f );
+    tt_assert( test_decode_value( "0.1", 0 )->value.f32_value == 0.1f );
+    tt_assert( test_decode_value( "0.3", 0 )->value.f32_value == 0.3f );
+    tt_assert( test_decode_value( "1234.5678", 0 )->value.f32_value == 1234.5678f );
+    tt_assert( test_decode_value( "3.14159265358979", 0 )->value.f32_value == 3.14159265358979f );
+    tt_assert( test_decode_value( "12", "3.5\n" )->value.f32_value == 123.5f );
+
+    // the integers
+    dp = test_decode_value( "16777217", 0 );
+    tt_int_op( dp->value_type, ==, XI_VALUE_TYPE_I32 );
+    tt_int_op( dp->value.i32_value, ==, 16777217 );
+    tt_int_op( test_decode_value( "-2147483648", 0 )->value.i32_value, ==, INT32_MIN );
+    tt_int_op( test_decode_value( "-1", "2\r\n" )->value.i32_value, ==, -12 );
+
+    // the ones that do not fit the i32
+    dp = test_decode_value( "2147483648", 0 );
+    tt_int_op( dp->value_type, ==, XI_VALUE_TYPE_F32 );
+    tt_assert( dp->value.f32_value == 2147483648.0f );
+
+    // the exponent form the floats are written in below 1e-4 and from 1e16 up
+    {
+        char text[ 32 ];
+
+        xi_format_f32( text, sizeof( text ), 1e-5f, XI_CSV_FLOAT_PRECISION );
+        tt_str_op( text, ==, "1e-5" );
+        dp = test_decode_value( text, 0 );
+        tt_int_op( dp->value_type, ==, XI_VALUE_TYPE_F32 );
+        tt_assert( dp->value.f32_value == 1e-5f );
+
+        xi_format_f32( text, sizeof( text ), 1e16f, XI_CSV_FLOAT_PRECISION );
+        dp = test_decode_value( text, 0 );
+        tt_int_op( dp->value_type, ==, XI_VALUE_TYPE_F32 );
+        tt_assert( dp->value.f32_value == 1e16f );
+    }
+
+    tt_assert( test_decode_value( "-1.5e-7", 0 )->value.f32_value == -1.5e-7f );
+    tt_assert( test_decode_value( "2E+3", 0 )->value.f32_value == 2000.0f );
+    tt_assert( test_decode_value( "3.4028235e38", 0 )->value.f32_value == 3.4028235e38f );
+    tt_assert( test_decode_value( "1e", "-5\n" )->value.f32_value == 1e-5f );
+
+    // and the strings
+    tt_int_op( test_decode_value( "1e", 0 )->value_type, ==, XI_VALUE_TYPE_STR );
+    tt_int_op( test_decode_value( "1e-", 0 )->value_type, ==, XI_VALUE_TYPE_STR );
+    tt_int_op( test_decode_value( "e5", 0 )->value_type, ==, XI_VALUE_TYPE_STR );
+    tt_int_op( test_decode_value( "1e5e", 0 )->value_type, ==, XI_VALUE_TYPE_STR );
+    dp = test_decode_value( "12ab", 0 );
+    tt_int_op( dp->value_type, ==, XI_VALUE_TYPE_STR );
+    tt_str_op( dp->value.str_value, ==, "12ab" );
+    tt_str_op( test_decode_value( "-", 0 )->value.str_value, ==, "-" );
+    tt_str_op( test_decode_value( "1.2.3", 0 )->value.str_value, ==, "1.2.3" );
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static uint32_t test_retry_delays[ 8 ];
+static uint8_t  test_retry_sleeps = 0;
+
+static void test_retry_sleep_ms( uint32_t milliseconds )
+{
+    test_retry_delays[ test_retry_sleeps++ ] = milliseconds;
+}
+
+void test_retry_policy_backoff(void* data)
+{
+    (void)(data);
+
+    const xi_retry_policy_t policy = { 4, 100, 250, 0, 0, &test_retry_sleep_ms };
+    const xi_retry_policy_t single = { 1, 100, 10000, 0, 0, 0 };
+
+    xi_datapoint_t datapoint;
+    xi_set_value_i32( &datapoint, 1 );
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    xi_set_retry_policy( &policy );
+    test_retry_sleeps = 0;
+
+    // the dummy io layer never gets any response so every attempt fails
+    xi_datastream_update( xi, 1, "test", &datapoint );
+
+    tt_int_op( test_retry_sleeps, ==, 3 );
+    tt_int_op( test_retry_delays[ 0 ], ==, 100 );
+    tt_int_op( test_retry_delays[ 1 ], ==, 200 );
+    tt_int_op( test_retry_delays[ 2 ], ==, 250 );
+
+    // POST that has been sent must not be repeated
+    test_retry_sleeps = 0;
+    xi_datastream_create( xi, 1, "test", &datapoint );
+
+    tt_int_op( test_retry_sleeps, ==, 0 );
+
+ end:
+    xi_set_retry_policy( &single );
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static uint32_t test_clock = 0;
+
+static uint32_t test_clock_ms( void )
+{
+    return test_clock;
+}
+
+void test_write_behind_coalescing(void* data)
+{
+    (void)(data);
+
+    xi_write_behind_config_t config = { XI_WRITE_BEHIND_KEEP_LATEST, 1000, 5000, &test_clock_ms };
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    test_clock = 0;
+    tt_ptr_op( xi_write_behind_enable( xi, &config ), ==, xi );
+
+    const xi_write_behind_t* wb = ( const xi_write_behind_t* ) xi->write_behind;
+
+    for( int i = 0; i < 3; ++i )
+    {
+        xi_set_value_i32( &datapoint, i );
+        tt_int_op( xi_datastream_update( xi, 1, "a", &datapoint )->http.http_status, ==, 202 );
+    }
+
+    xi_set_value_i32( &datapoint, 7 );
+    tt_int_op( xi_datastream_update( xi, 1, "b", &datapoint )->http.http_status, ==, 202 );
+
+    tt_int_op( wb->queue.datastream_count, ==, 2 );
+    tt_int_op( wb->queue.datastreams[ 0 ].datapoint_count, ==, 1 );
+    tt_int_op( wb->queue.datastreams[ 0 ].datapoints[ 0 ].value.i32_value, ==, 2 );
+    tt_ptr_op( xi_write_behind_poll( xi ), ==, 0 );
+
+    config.mode = XI_WRITE_BEHIND_KEEP_ALL;
+    tt_ptr_op( xi_write_behind_enable( xi, &config ), ==, xi );
+
+    for( int i = 0; i < 3; ++i )
+    {
+        xi_set_value_i32( &datapoint, i );
+        xi_datastream_update( xi, 1, "c", &datapoint );
+    }
+
+    tt_int_op( wb->queue.datastream_count, ==, 3 );
+    tt_int_op( wb->queue.datastreams[ 2 ].datapoint_count, ==, 3 );
+    tt_assert( wb->queue.datastreams[ 2 ].datapoints[ 1 ].timestamp.timestamp != 0 );
+
+    // the samples taken at once still get the timestamps of their own
+    for( int i = 1; i < 3; ++i )
+    {
+        const xi_timestamp_t* prev  = &wb->queue.datastreams[ 2 ].datapoints[ i - 1 ].timestamp;
+        const xi_timestamp_t* next  = &wb->queue.datastreams[ 2 ].datapoints[ i ].timestamp;
+
+        tt_assert( next->timestamp > prev->timestamp
+                   || ( next->timestamp == prev->timestamp && next->micro > prev->micro ) );
+    }
+
+    // the flush is due, the dummy io layer fails it so nothing is lost
+    test_clock = 1000;
+    tt_ptr_op( xi_write_behind_poll( xi ), !=, 0 );
+    tt_int_op( wb->queue.datastream_count, ==, 3 );
+    tt_int_op( wb->queue.datastreams[ 2 ].datapoint_count, ==, 3 );
+
+    // the failed final flush keeps the queue enabled
+    tt_ptr_op( xi_write_behind_disable( xi ), !=, 0 );
+    tt_ptr_op( xi->write_behind, ==, wb );
+    tt_int_op( wb->queue.datastream_count, ==, 3 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_aggregator(void* data)
+{
+    (void)(data);
+
+    xi_write_behind_config_t config         = { XI_WRITE_BEHIND_KEEP_ALL, 100000, 100000, &test_clock_ms };
+    xi_aggregator_config_t aggregation      = { { 0.5f, 1000, XI_AGGREGATE_MIN | XI_AGGREGATE_MAX | XI_AGGREGATE_MEAN }, &test_clock_ms };
+    const xi_aggregation_rule_t every_one   = { 0, 0, 0 };
+    static const int32_t values[]           = { 10, 10, 11, 12, 9 };
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    test_clock = 0;
+    tt_ptr_op( xi_write_behind_enable( xi, &config ), ==, xi );
+    tt_ptr_op( xi_aggregator_enable( xi, &aggregation ), ==, xi );
+    tt_int_op( xi_aggregator_set_rule( xi, "s", &every_one ), ==, 0 );
+
+    const xi_write_behind_t* wb = ( const xi_write_behind_t* ) xi->write_behind;
+
+    // the samples wait for the window to pass
+    for( size_t i = 0; i < sizeof( values ) / sizeof( values[ 0 ] ); ++i )
+    {
+        test_clock = ( uint32_t ) i * 100;
+        xi_set_value_i32( &datapoint, values[ i ] );
+        tt_int_op( xi_datastream_update( xi, 1, "t", &datapoint )->http.http_status, ==, 202 );
+    }
+
+    tt_int_op( wb->queue.datastream_count, ==, 0 );
+
+    // the datastream with the rule of its own and the strings go straight through
+    xi_set_value_i32( &datapoint, 5 );
+    tt_int_op( xi_datastream_update( xi, 1, "s", &datapoint )->http.http_status, ==, 202 );
+    xi_set_value_str( &datapoint, "on" );
+    tt_int_op( xi_datastream_update( xi, 1, "t", &datapoint )->http.http_status, ==, 202 );
+    tt_int_op( wb->queue.datastream_count, ==, 2 );
+
+    // the sample after the window sends its aggregates and opens the next one
+    test_clock = 1000;
+    xi_set_value_f32( &datapoint, 20.0f );
+    tt_int_op( xi_datastream_update( xi, 1, "t", &datapoint )->http.http_status, ==, 202 );
+
+    tt_int_op( wb->queue.datastream_count, ==, 5 );
+    tt_str_op( wb->queue.datastreams[ 2 ].datastream_id, ==, "t_min" );
+    tt_int_op( wb->queue.datastreams[ 2 ].datapoints[ 0 ].value_type, ==, XI_VALUE_TYPE_I32 );
+    tt_int_op( wb->queue.datastreams[ 2 ].datapoints[ 0 ].value.i32_value, ==, 9 );
+    tt_str_op( wb->queue.datastreams[ 3 ].datastream_id, ==, "t_max" );
+    tt_int_op( wb->queue.datastreams[ 3 ].datapoints[ 0 ].value.i32_value, ==, 12 );
+    tt_str_op( wb->queue.datastreams[ 4 ].datastream_id, ==, "t_mean" );
+    tt_assert( wb->queue.datastreams[ 4 ].datapoints[ 0 ].value.f32_value == 10.4f );
+
+    // the window that is not followed by any sample is sent by the poll
+    test_clock = 1500;
+    tt_ptr_op( xi_aggregator_poll( xi ), ==, 0 );
+    test_clock = 2000;
+    tt_ptr_op( xi_aggregator_poll( xi ), !=, 0 );
+    tt_int_op( wb->queue.datastreams[ 2 ].datapoint_count, ==, 2 );
+    tt_int_op( wb->queue.datastreams[ 2 ].datapoints[ 1 ].value_type, ==, XI_VALUE_TYPE_F32 );
+    tt_assert( wb->queue.datastreams[ 4 ].datapoints[ 1 ].value.f32_value == 20.0f );
+
+    // the aggregates within the deadband of the ones sent last are suppressed
+    test_clock = 2100;
+    xi_set_value_f32( &datapoint, 20.25f );
+    tt_int_op( xi_datastream_update( xi, 1, "t", &datapoint )->http.http_status, ==, 202 );
+    xi_set_value_f32( &datapoint, 21.0f );
+    tt_int_op( xi_datastream_update( xi, 1, "t", &datapoint )->http.http_status, ==, 202 );
+    test_clock = 3100;
+    tt_ptr_op( xi_aggregator_poll( xi ), !=, 0 );
+    tt_int_op( wb->queue.datastreams[ 2 ].datapoint_count, ==, 2 );
+    tt_int_op( wb->queue.datastreams[ 3 ].datapoint_count, ==, 3 );
+    tt_assert( wb->queue.datastreams[ 3 ].datapoints[ 2 ].value.f32_value == 21.0f );
+    tt_int_op( wb->queue.datastreams[ 4 ].datapoint_count, ==, 3 );
+
+    tt_ptr_op( xi_aggregator_disable( xi ), ==, 0 );
+    tt_ptr_op( xi->aggregator, ==, 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static char             test_ws_sent[ 1024 ];
+static unsigned short   test_ws_sent_size = 0;
+static char             test_ws_handshake_done = 0;
+static char             test_ws_read_fails = 0;
+
+static layer_state_t test_ws_io_data_ready( layer_connectivity_t* context, const void* data, const layer_hint_t hint )
+{
+    (void)(context); (void)(hint);
+
+    const const_data_descriptor_t* buffer = ( const const_data_descriptor_t* ) data;
+
+    memcpy( test_ws_sent + test_ws_sent_size, buffer->data_ptr, buffer->real_size );
+    test_ws_sent_size += buffer->real_size;
+
+    return LAYER_STATE_OK;
+}
+
+// plays the server, replies to the handshake and then pings before the response
+static layer_state_t test_ws_io_on_data_ready( layer_connectivity_t* context, const void* data, const layer_hint_t hint )
+{
+    (void)(data); (void)(hint);
+
+    char reply[ 256 ];
+    size_t reply_size = 0;
+
+    if( test_ws_read_fails )
+    {
+        test_ws_read_fails -= 1;
+        return LAYER_STATE_ERROR;
+    }
+
+    if( !test_ws_handshake_done )
+    {
+        static const char guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        unsigned char digest[ XI_SHA1_DIGEST_SIZE ];
+        char accept[ XI_BASE64_ENCODED_SIZE( XI_SHA1_DIGEST_SIZE ) + 1 ];
+        xi_sha1_t sha1;
+
+        test_ws_sent[ test_ws_sent_size ] = '\0';
+        const char* key = strstr( test_ws_sent, "Sec-WebSocket-Key: " ) + 19;
+
+        xi_sha1_init( &sha1 );
+        xi_sha1_update( &sha1, key, strchr( key, '\r' ) - key );
+        xi_sha1_update( &sha1, guid, sizeof( guid ) - 1 );
+        xi_sha1_final( &sha1, digest );
+        xi_base64_encode( accept, digest, sizeof( digest ) );
+
+        reply_size = sprintf( reply
+            , "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+              "Sec-WebSocket-Accept: %s\r\n\r\n", accept );
+
+        test_ws_handshake_done  = 1;
+        test_ws_sent_size       = 0;
+    }
+    else
+    {
+        static const char message[] = "{\"status\":200,\"body\":{\"id\":\"temp\",\"current_value\":\"42\","
+                                      "\"at\":\"2014-01-01T10:20:30.000000Z\"}}";
+        static const char ping[]    = { ( char ) 0x89, 0x02, 'h', 'i' };
+
+        memcpy( reply, ping, sizeof( ping ) );
+        reply_size = sizeof( ping );
+        reply[ reply_size++ ] = ( char ) 0x81;
+        reply[ reply_size++ ] = sizeof( message ) - 1;
+        memcpy( reply + reply_size, message, sizeof( message ) - 1 );
+        reply_size += sizeof( message ) - 1;
+    }
+
+    const_data_descriptor_t desc = { reply, reply_size, reply_size, 0 };
+
+    CALL_ON_NEXT_ON_DATA_READY( context->self, ( const void* ) &desc, LAYER_HINT_NONE );
+
+    return LAYER_STATE_OK;
+}
+
+void test_ws_request_and_ping(void* data)
+{
+    (void)(data);
+
+    static const char request[] = "{\"method\":\"get\",\"resource\":\"/feeds/1/datastreams/temp\","
+                                  "\"headers\":{\"X-ApiKey\":\"apikey\"}}";
+    static layer_interface_t test_ws_io;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_context_t* xi = xi_create_context( XI_WS, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_ws_io                      = *io_layer->layer_functions;
+    test_ws_io.data_ready           = &test_ws_io_data_ready;
+    test_ws_io.on_data_ready        = &test_ws_io_on_data_ready;
+    io_layer->layer_functions       = &test_ws_io;
+
+    // the read fails in the middle of the handshake
+    test_ws_sent_size       = 0;
+    test_ws_handshake_done  = 0;
+    test_ws_read_fails      = 1;
+
+    const xi_response_t* response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_int_op( xi->connected, ==, 0 );
+
+    // so the next request starts the handshake over
+    test_ws_sent_size       = 0;
+
+    response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( datapoint.value.i32_value, ==, 42 );
+    tt_int_op( xi->connected, ==, 1 );
+
+    // single masked text frame
+    const unsigned char* frame = ( const unsigned char* ) test_ws_sent;
+    tt_int_op( frame[ 0 ], ==, 0x81 );
+    tt_int_op( frame[ 1 ], ==, 0x80 | ( sizeof( request ) - 1 ) );
+
+    for( size_t i = 0; i < sizeof( request ) - 1; ++i )
+    {
+        tt_int_op( frame[ 6 + i ] ^ frame[ 2 + ( i & 3 ) ], ==, request[ i ] );
+    }
+
+    // followed by the pong with the same payload
+    frame += 6 + sizeof( request ) - 1;
+    tt_int_op( frame[ 0 ], ==, 0x8A );
+    tt_int_op( frame[ 1 ], ==, 0x82 );
+    tt_int_op( frame[ 6 ] ^ frame[ 2 ], ==, 'h' );
+    tt_int_op( frame[ 7 ] ^ frame[ 3 ], ==, 'i' );
+    tt_int_op( test_ws_sent_size, ==, 6 + sizeof( request ) - 1 + 8 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static const char*      test_tcp_replies[ 6 ];
+static unsigned short   test_tcp_reply_sizes[ 6 ];
+static uint8_t          test_tcp_reply = 0;
+
+// plays the server, the replies are delivered one by one while the layer wants more
+static layer_state_t test_tcp_io_on_data_ready( layer_connectivity_t* context, const void* data, const layer_hint_t hint )
+{
+    (void)(data); (void)(hint);
+
+    layer_state_t state = LAYER_STATE_WANT_READ;
+
+    while( state == LAYER_STATE_WANT_READ && test_tcp_replies[ test_tcp_reply ] )
+    {
+        const char* reply               = test_tcp_replies[ test_tcp_reply ];
+        const unsigned short size       = test_tcp_reply_sizes[ test_tcp_reply++ ];
+        const_data_descriptor_t desc    = { reply, size ? size : strlen( reply ), size ? size : strlen( reply ), 0 };
+
+        state = CALL_ON_NEXT_ON_DATA_READY( context->self, ( const void* ) &desc, LAYER_HINT_NONE );
+    }
+
+    return state;
+}
+
+void test_tcp_requests(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_tcp_io;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_context_t* xi = xi_create_context( XI_TCP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_tcp_io                     = *io_layer->layer_functions;
+    test_tcp_io.data_ready          = &test_ws_io_data_ready;
+    test_tcp_io.on_data_ready       = &test_tcp_io_on_data_ready;
+    io_layer->layer_functions       = &test_tcp_io;
+
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = "{\"status\":200,\"resource\":\"/feeds/1/datastreams/temp\",\"body\":{\"id\":\"te";
+    test_tcp_replies[ 1 ]   = "mp\",\"current_value\":\"42\",\"at\":\"2014-01-01T10:20:30.000000Z\"}}\n";
+    test_tcp_replies[ 2 ]   = 0;
+
+    const xi_response_t* response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( datapoint.value.i32_value, ==, 42 );
+    tt_int_op( xi->connected, ==, 1 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_str_op( test_ws_sent, ==, "{\"method\":\"get\",\"resource\":\"/feeds/1/datastreams/temp\","
+                                 "\"headers\":{\"X-ApiKey\":\"apikey\"}}\n" );
+
+    // the connection is reused, the failure puts the body to the status string
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = "{\"status\":403,\"body\":\"forbidden\"}\n";
+    test_tcp_replies[ 1 ]   = 0;
+
+    xi_set_value_i32( &datapoint, 7 );
+    response = xi_datastream_update( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 403 );
+    tt_str_op( response->http.http_status_string, ==, "\"forbidden\"" );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_str_op( test_ws_sent, ==, "{\"method\":\"put\",\"resource\":\"/feeds/1/datastreams/temp\","
+                                 "\"headers\":{\"X-ApiKey\":\"apikey\"},"
+                                 "\"body\":{\"current_value\":\"7\",\"at\":\"2014-01-01T10:20:30.000000Z\"}}\n" );
+
+    // the body before the status is refused before anything of it is decoded
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = "{\"body\":{\"id\":\"temp\",\"current_value\":\"13\"},\"status\":404}\n";
+    test_tcp_replies[ 1 ]   = 0;
+
+    xi_set_value_i32( &datapoint, 7 );
+    response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 0 );
+    tt_int_op( datapoint.value.i32_value, ==, 7 );
+    tt_int_op( xi->connected, ==, 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_aggregator_failed_window(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_tcp_io;
+
+    xi_aggregator_config_t aggregation = { { 0, 1000, XI_AGGREGATE_MIN | XI_AGGREGATE_MAX }, &test_clock_ms };
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_context_t* xi = xi_create_context( XI_TCP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_tcp_io                     = *io_layer->layer_functions;
+    test_tcp_io.data_ready          = &test_ws_io_data_ready;
+    test_tcp_io.on_data_ready       = &test_tcp_io_on_data_ready;
+    io_layer->layer_functions       = &test_tcp_io;
+
+    test_clock = 0;
+    tt_ptr_op( xi_aggregator_enable( xi, &aggregation ), ==, xi );
+
+    xi_set_value_i32( &datapoint, 1 );
+    tt_int_op( xi_datastream_update( xi, 1, "t", &datapoint )->http.http_status, ==, 202 );
+    xi_set_value_i32( &datapoint, 3 );
+    tt_int_op( xi_datastream_update( xi, 1, "t", &datapoint )->http.http_status, ==, 202 );
+
+    // the min is sent, the max fails so the window is kept
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = "{\"status\":200}\n";
+    test_tcp_replies[ 1 ]   = "{\"status\":503,\"body\":\"unavailable\"}\n";
+    test_tcp_replies[ 2 ]   = 0;
+    test_clock              = 1000;
+
+    const xi_response_t* response = xi_aggregator_poll( xi );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 503 );
+    tt_int_op( test_tcp_reply, ==, 2 );
+
+    // the failure keeps the aggregation enabled
+    test_tcp_reply          = 1;
+    tt_int_op( xi_aggregator_disable( xi )->http.http_status, ==, 503 );
+    tt_ptr_op( xi->aggregator, !=, 0 );
+
+    // only the max is sent again
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = "{\"status\":200}\n";
+    test_tcp_replies[ 1 ]   = 0;
+
+    response = xi_aggregator_poll( xi );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( test_tcp_reply, ==, 1 );
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "/feeds/1/datastreams/t_max" ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\"current_value\":\"3\"" ) != 0 );
+
+    tt_ptr_op( xi_aggregator_disable( xi ), ==, 0 );
+    tt_ptr_op( xi->aggregator, ==, 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_mqtt_publish_and_subscribe(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_mqtt_io;
+    static const char connack[]     = { 0x20, 0x02, 0x00, 0x00 };
+    static const char suback[]      = { ( char ) 0x90, 0x03, 0x00, 0x01, 0x00 };
+    static const char publish[]     = "\x30\x40\x00\x20/v2/feeds/1/datastreams/temp.csv2014-01-01T10:20:30.000000Z,42";
+    static const char puback[]      = { 0x40, 0x02, 0x00, 0x03 };
+    static const char puback_4[]    = { 0x40, 0x02, 0x00, 0x04 };
+    static const char puback_8[]    = { 0x40, 0x02, 0x00, 0x08 };
+    static const char pingresp[]    = { ( char ) 0xD0, 0x00 };
+    static const char suback_2[]    = { ( char ) 0x90, 0x03, 0x00, 0x02, 0x00 };
+
+    const unsigned char* sent = ( const unsigned char* ) test_ws_sent;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_datapoint_t values[ 5 ];
+    memset( values, 0, sizeof( values ) );
+
+    xi_context_t* xi = xi_create_context( XI_MQTT, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_mqtt_io                    = *io_layer->layer_functions;
+    test_mqtt_io.data_ready         = &test_ws_io_data_ready;
+    test_mqtt_io.on_data_ready      = &test_tcp_io_on_data_ready;
+    io_layer->layer_functions       = &test_mqtt_io;
+
+    memset( test_tcp_reply_sizes, 0, sizeof( test_tcp_reply_sizes ) );
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = connack;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( connack );
+    test_tcp_replies[ 1 ]       = suback;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( suback );
+    test_tcp_replies[ 2 ]       = publish;
+    test_tcp_reply_sizes[ 2 ]   = sizeof( publish ) - 1;
+    test_tcp_replies[ 3 ]       = pingresp;
+    test_tcp_reply_sizes[ 3 ]   = sizeof( pingresp );
+    test_tcp_replies[ 4 ]       = 0;
+
+    // the get subscribes and takes the retained message
+    const xi_response_t* response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( datapoint.value.i32_value, ==, 42 );
+    tt_int_op( xi->connected, ==, 1 );
+
+    // CONNECT with the api key as the user name followed by the SUBSCRIBE
+    tt_int_op( ( unsigned char ) test_ws_sent[ 0 ], ==, 0x10 );
+    tt_assert( memcmp( test_ws_sent + 4, "MQTT", 4 ) == 0 );
+    tt_int_op( ( unsigned char ) test_ws_sent[ 9 ], ==, 0x82 );
+    tt_assert( memcmp( test_ws_sent + 2 + test_ws_sent[ 1 ] - 6, "apikey", 6 ) == 0 );
+    tt_int_op( ( unsigned char ) test_ws_sent[ 2 + test_ws_sent[ 1 ] ], ==, 0x82 );
+
+    // followed by the PINGREQ that bounds the wait
+    tt_int_op( sent[ test_ws_sent_size - 2 ], ==, 0xC0 );
+    tt_int_op( test_tcp_reply, ==, 3 );
+
+    // nothing has come on the topic since, the answer of the ping before is not taken for it
+    test_ws_sent_size       = 0;
+    test_tcp_replies[ 4 ]   = pingresp;
+    test_tcp_reply_sizes[ 4 ] = sizeof( pingresp );
+    test_tcp_replies[ 5 ]   = 0;
+    datapoint.value.i32_value = 0;
+
+    response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_int_op( response->http.http_status, ==, 304 );
+    tt_int_op( datapoint.value.i32_value, ==, 0 );
+    tt_int_op( test_tcp_reply, ==, 5 );
+    tt_int_op( test_ws_sent_size, ==, 2 );
+
+    // the new subscription without the retained message
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = suback_2;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( suback_2 );
+    test_tcp_replies[ 1 ]       = pingresp;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( pingresp );
+    test_tcp_replies[ 2 ]       = 0;
+
+    response = xi_datastream_get( xi, 1, "hum", &datapoint );
+
+    tt_int_op( response->http.http_status, ==, 404 );
+    tt_int_op( test_tcp_reply, ==, 2 );
+
+    // QoS 1 publishes don't wait for the acknowledgement until the window is full
+    xi_set_mqtt_qos( xi, 1 );
+    test_tcp_reply      = 0;
+    test_tcp_replies[ 0 ] = 0;
+
+    for( int i = 0; i < XI_MQTT_MAX_INFLIGHT - 1; ++i )
+    {
+        test_ws_sent_size = 0;
+        response = xi_datastream_update( xi, 1, "temp", &datapoint );
+        tt_int_op( response->http.http_status, ==, 202 );
+        tt_int_op( ( unsigned char ) test_ws_sent[ 0 ], ==, 0x32 );
+    }
+
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = puback;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( puback );
+    test_tcp_replies[ 1 ]       = 0;
+
+    response = xi_datastream_update( xi, 1, "temp", &datapoint );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( test_tcp_reply, ==, 1 );
+
+    // the connection is lost with the three of them waiting
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = 0;
+
+    response = xi_datastream_get( xi, 1, "temp", &datapoint );
+    tt_int_op( response->http.http_status, ==, 0 );
+    tt_int_op( xi->connected, ==, 0 );
+
+    // they are sent again right after the CONNACK of the new session
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = connack;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( connack );
+    test_tcp_replies[ 1 ]       = puback_4;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( puback_4 );
+    test_tcp_replies[ 2 ]       = 0;
+
+    response = xi_datastream_update( xi, 1, "temp", &datapoint );
+    tt_int_op( response->http.http_status, ==, 200 );
+
+    {
+        size_t pos          = 2 + sent[ 1 ];
+        uint16_t ids[ 4 ]   = { 0, 0, 0, 0 };
+        int publishes       = 0;
+
+        for( ; pos < test_ws_sent_size && publishes < 4; pos += 2 + sent[ pos + 1 ] )
+        {
+            tt_int_op( sent[ pos ], ==, 0x32 );
+            ids[ publishes++ ] = ( uint16_t ) ( ( sent[ pos + 36 ] << 8 ) | sent[ pos + 37 ] );
+        }
+
+        tt_int_op( publishes, ==, 4 );
+        tt_int_op( pos, ==, test_ws_sent_size );
+        tt_int_op( ids[ 0 ] + ids[ 1 ] + ids[ 2 ], ==, 4 + 5 + 6 );
+        tt_int_op( ids[ 3 ], ==, 7 );
+    }
+
+    // the datapoints are published too, the ones too big to be kept wait for their own PUBACK
+    for( int i = 0; i < 5; ++i )
+    {
+        xi_set_value_i32( &values[ i ], i );
+        values[ i ].timestamp.timestamp = 1388571630 + i;
+    }
+
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = puback_8;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( puback_8 );
+    test_tcp_replies[ 1 ]       = 0;
+
+    response = xi_datapoints_post( xi, 1, "temp", values, 5 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( sent[ 0 ], ==, 0x32 );
+    tt_int_op( test_ws_sent_size, >, XI_MQTT_INFLIGHT_PACKET_SIZE );
+    tt_int_op( test_tcp_reply, ==, 1 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_http2_streams(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_http2_io;
+    static const char settings[]    = { 0, 0, 0, 0x04, 0x00, 0, 0, 0, 0 };
+    static const char headers_1[]   = { 0, 0, 1, 0x01, 0x04, 0, 0, 0, 1, ( char ) 0x88 };
+    static const char data_1[]      = "\x00\x00\x1E\x00\x00\x00\x00\x00\x01" "2014-01-01T10:20:30.000000Z,42";
+    static const char end_1[]       = { 0, 0, 0, 0x00, 0x01, 0, 0, 0, 1 };
+    static const char ping[]        = "\x00\x00\x08\x06\x00\x00\x00\x00\x00" "pingpong";
+    static const char headers_3[]   = { 0, 0, 1, 0x01, 0x05, 0, 0, 0, 3, ( char ) 0x88 };
+    // huffman encoded "404" as the literal value of the :status
+    static const char headers_5[]   = { 0, 0, 5, 0x01, 0x04, 0, 0, 0, 5, 0x08, ( char ) 0x83, 0x68, 0x0D, 0x7F };
+    static const char data_5[]      = "\x00\x00\x09\x00\x01\x00\x00\x00\x05" "not found";
+    static const char headers_7[]   = { 0, 0, 1, 0x01, 0x04, 0, 0, 0, 7, ( char ) 0x88 };
+    static const char headers_9[]   = { 0, 0, 1, 0x01, 0x04, 0, 0, 0, 9, ( char ) 0x88 };
+    static const char data_7[]      = "\x00\x00\x1D\x00\x01\x00\x00\x00\x07" "2014-01-01T10:20:30.000000Z,1";
+    static const char data_9a[]     = "\x00\x00\x1C\x00\x00\x00\x00\x00\x09" "2014-01-01T10:20:30.000000Z,";
+    static const char data_9b[]     = "\x00\x00\x01\x00\x01\x00\x00\x00\x09" "9";
+    // 404 from the static table
+    static const char headers_11[]  = { 0, 0, 1, 0x01, 0x04, 0, 0, 0, 11, ( char ) 0x8D };
+    static const char headers_13[]  = { 0, 0, 1, 0x01, 0x04, 0, 0, 0, 13, ( char ) 0x88 };
+    static const char data_13_11[]  = "\x00\x00\x1D\x00\x01\x00\x00\x00\x0D" "2014-01-01T10:20:30.000000Z,5"
+                                      "\x00\x00\x04\x00\x01\x00\x00\x00\x0B" "gone";
+
+    const unsigned char* sent = ( const unsigned char* ) test_ws_sent;
+
+    xi_datapoint_t datapoint, datapoint_a, datapoint_b, datapoint_c;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+    memset( &datapoint_a, 0, sizeof( xi_datapoint_t ) );
+    memset( &datapoint_b, 0, sizeof( xi_datapoint_t ) );
+    memset( &datapoint_c, 0, sizeof( xi_datapoint_t ) );
+
+    xi_context_t* xi = xi_create_context( XI_HTTP2, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_http2_io                   = *io_layer->layer_functions;
+    test_http2_io.data_ready        = &test_ws_io_data_ready;
+    test_http2_io.on_data_ready     = &test_tcp_io_on_data_ready;
+    io_layer->layer_functions       = &test_http2_io;
+
+    memset( test_tcp_reply_sizes, 0, sizeof( test_tcp_reply_sizes ) );
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = settings;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( settings );
+    test_tcp_replies[ 1 ]       = headers_1;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( headers_1 );
+    test_tcp_replies[ 2 ]       = data_1;
+    test_tcp_reply_sizes[ 2 ]   = sizeof( data_1 ) - 1;
+    test_tcp_replies[ 3 ]       = end_1;
+    test_tcp_reply_sizes[ 3 ]   = sizeof( end_1 );
+    test_tcp_replies[ 4 ]       = 0;
+
+    const xi_response_t* response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( datapoint.value.i32_value, ==, 42 );
+    tt_int_op( xi->connected, ==, 1 );
+
+    // the preface, our SETTINGS and the ACK of the server's ones
+    tt_assert( memcmp( sent, "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", 24 ) == 0 );
+    tt_int_op( sent[ 24 + 3 ], ==, 0x04 );
+    tt_int_op( sent[ 24 + 2 ], ==, 12 );
+    tt_int_op( sent[ 45 + 3 ], ==, 0x04 );
+    tt_int_op( sent[ 45 + 4 ], ==, 0x01 );
+
+    // HEADERS on the stream 1 that ends the stream, GET from the static table
+    tt_int_op( sent[ 54 + 3 ], ==, 0x01 );
+    tt_int_op( sent[ 54 + 4 ], ==, 0x05 );
+    tt_int_op( sent[ 54 + 8 ], ==, 1 );
+    tt_int_op( sent[ 63 ], ==, 0x82 );
+    tt_int_op( sent[ 64 ], ==, 0x86 );
+    tt_int_op( sent[ 65 ], ==, 0x04 );
+    tt_int_op( sent[ 66 ], ==, 32 );
+    tt_assert( memcmp( sent + 67, "/v2/feeds/1/datastreams/temp.csv", 32 ) == 0 );
+
+    // the connection and the stream windows are given back after the DATA
+    tt_int_op( sent[ test_ws_sent_size - 26 + 3 ], ==, 0x08 );
+    tt_int_op( sent[ test_ws_sent_size - 26 + 8 ], ==, 0 );
+    tt_int_op( sent[ test_ws_sent_size - 14 ], ==, 30 );
+    tt_int_op( sent[ test_ws_sent_size - 13 + 3 ], ==, 0x08 );
+    tt_int_op( sent[ test_ws_sent_size - 13 + 8 ], ==, 1 );
+    tt_int_op( sent[ test_ws_sent_size - 1 ], ==, 30 );
+
+    // the next stream reuses the indexed headers and answers the PING
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = ping;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( ping ) - 1;
+    test_tcp_replies[ 1 ]       = headers_3;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( headers_3 );
+    test_tcp_replies[ 2 ]       = 0;
+
+    xi_set_value_i32( &datapoint, 7 );
+    response = xi_datastream_update( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+
+    tt_int_op( sent[ 2 ], ==, 5 + 1 + 34 + 3 + 5 );
+    tt_int_op( sent[ 4 ], ==, 0x04 );
+    tt_int_op( sent[ 8 ], ==, 3 );
+    tt_assert( memcmp( sent + 9, "\x02\x03PUT", 5 ) == 0 );
+    tt_int_op( sent[ 9 + 40 ], ==, 0xC0 );
+    tt_int_op( sent[ 9 + 41 ], ==, 0xBF );
+    tt_int_op( sent[ 9 + 42 ], ==, 0xBE );
+    tt_assert( memcmp( sent + 9 + 43, "\x0F\x0D\x02" "30", 5 ) == 0 );
+
+    // the body in a single DATA frame that ends the stream
+    tt_int_op( sent[ 57 + 2 ], ==, 30 );
+    tt_int_op( sent[ 57 + 4 ], ==, 0x01 );
+    tt_assert( memcmp( sent + 66, "2014-01-01T10:20:30.000000Z,7\n", 30 ) == 0 );
+
+    // followed by the PING ACK
+    tt_int_op( sent[ 96 + 3 ], ==, 0x06 );
+    tt_int_op( sent[ 96 + 4 ], ==, 0x01 );
+    tt_assert( memcmp( sent + 105, "pingpong", 8 ) == 0 );
+
+    // the error body goes to the status string
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = headers_5;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( headers_5 );
+    test_tcp_replies[ 1 ]       = data_5;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( data_5 ) - 1;
+    test_tcp_replies[ 2 ]       = 0;
+
+    response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 404 );
+    tt_str_op( response->http.http_status_string, ==, "not found" );
+    tt_int_op( sent[ 8 ], ==, 5 );
+
+    // the submitted requests are sent without reading anything, one stream is kept for the blocking calls
+    xi_set_http2_submit( xi, 1 );
+
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = 0;
+
+    const xi_response_t* response_a = xi_datastream_get( xi, 1, "a", &datapoint_a );
+    const xi_response_t* response_b = xi_datastream_get( xi, 1, "b", &datapoint_b );
+    const xi_response_t* response_c = xi_datastream_get( xi, 1, "c", &datapoint_c );
+
+    tt_assert( response_a != 0 && response_b != 0 && response_c != 0 );
+    tt_int_op( response_a->http.http_status, ==, 0 );
+    tt_int_op( sent[ 8 ], ==, 7 );
+    tt_int_op( sent[ 9 + sent[ 2 ] + 8 ], ==, 9 );
+    tt_int_op( test_tcp_reply, ==, 0 );
+
+    const size_t sent_size = test_ws_sent_size;
+
+    tt_assert( xi_datastream_get( xi, 1, "d", &datapoint ) == 0 );
+    tt_int_op( test_ws_sent_size, ==, sent_size );
+    tt_int_op( xi->connected, ==, 1 );
+
+    // the frames of the streams interleave, the body of each one goes to its own decoder
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = headers_9;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( headers_9 );
+    test_tcp_replies[ 1 ]       = headers_7;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( headers_7 );
+    test_tcp_replies[ 2 ]       = data_9a;
+    test_tcp_reply_sizes[ 2 ]   = sizeof( data_9a ) - 1;
+    test_tcp_replies[ 3 ]       = data_7;
+    test_tcp_reply_sizes[ 3 ]   = sizeof( data_7 ) - 1;
+    test_tcp_replies[ 4 ]       = data_9b;
+    test_tcp_reply_sizes[ 4 ]   = sizeof( data_9b ) - 1;
+    test_tcp_replies[ 5 ]       = 0;
+
+    tt_int_op( xi_http2_poll( xi ), ==, 1 );
+    tt_int_op( response_a->http.http_status, ==, 200 );
+    tt_int_op( response_b->http.http_status, ==, 200 );
+    tt_int_op( response_c->http.http_status, ==, 0 );
+    tt_int_op( datapoint_a.value.i32_value, ==, 1 );
+    tt_int_op( datapoint_b.value.i32_value, ==, 9 );
+
+    // the blocking call reads the frames of the submitted stream while it waits,
+    // and the ones that follow the end of its own stream as well
+    xi_set_http2_submit( xi, 0 );
+
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = headers_11;
+    test_tcp_reply_sizes[ 0 ]   = sizeof( headers_11 );
+    test_tcp_replies[ 1 ]       = headers_13;
+    test_tcp_reply_sizes[ 1 ]   = sizeof( headers_13 );
+    test_tcp_replies[ 2 ]       = data_13_11;
+    test_tcp_reply_sizes[ 2 ]   = sizeof( data_13_11 ) - 1;
+    test_tcp_replies[ 3 ]       = 0;
+
+    response = xi_datastream_get( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( datapoint.value.i32_value, ==, 5 );
+    tt_int_op( sent[ 8 ], ==, 13 );
+    tt_int_op( response_c->http.http_status, ==, 404 );
+    tt_str_op( response_c->http.http_status_string, ==, "gone" );
+    tt_int_op( xi_http2_poll( xi ), ==, 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static char    test_feed_sink_ids[ 64 ];
+static int32_t test_feed_sink_sum = 0;
+
+static void test_feed_sink( const char* datastream_id, const xi_datapoint_t* datapoint, void* user_data )
+{
+    ( *( int* ) user_data ) += 1;
+
+    strcat( test_feed_sink_ids, datastream_id );
+    test_feed_sink_sum += datapoint->value.i32_value;
+}
+
+void test_feed_get_all_streamed(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_feed_io;
+    static xi_feed_t feed;
+
+    const xi_retry_policy_t policy = { 3, 100, 1000, 0, 0, &test_retry_sleep_ms };
+    const xi_retry_policy_t single = { 1, 100, 10000, 0, 0, 0 };
+
+    int calls = 0;
+
+    xi_context_t* xi = xi_create_context( XI_TCP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_feed_io                    = *io_layer->layer_functions;
+    test_feed_io.data_ready         = &test_ws_io_data_ready;
+    test_feed_io.on_data_ready      = &test_tcp_io_on_data_ready;
+    io_layer->layer_functions       = &test_feed_io;
+
+    // the value of the second datastream is split between the reads
+    memset( test_tcp_reply_sizes, 0, sizeof( test_tcp_reply_sizes ) );
+    memset( test_feed_sink_ids, 0, sizeof( test_feed_sink_ids ) );
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = "{\"status\":200,\"body\":{\"datastreams\":[{\"id\":\"a\",\"current_value\":\"1\"},"
+                              "{\"id\":\"bb\",\"current_value\":\"2";
+    test_tcp_replies[ 1 ]   = "0\"},{\"id\":\"ccc\",\"current_value\":\"300\"}]}}\n";
+    test_tcp_replies[ 2 ]   = 0;
+    test_feed_sink_sum      = 0;
+
+    const xi_response_t* response = xi_feed_get_all_streamed( xi, &test_feed_sink, &calls );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( calls, ==, 3 );
+    tt_str_op( test_feed_sink_ids, ==, "abbccc" );
+    tt_int_op( test_feed_sink_sum, ==, 321 );
+
+    // the same response stored within the feed
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    test_tcp_reply          = 0;
+
+    response = xi_feed_get_all( xi, &feed );
+
+    tt_assert( response != 0 );
+    tt_int_op( feed.datastream_count, ==, 3 );
+    tt_str_op( feed.datastreams[ 1 ].datastream_id, ==, "bb" );
+    tt_int_op( feed.datastreams[ 2 ].datapoints[ 0 ].value.i32_value, ==, 300 );
+
+    // the connection breaks after the sink got the first datastream so it is not retried
+    memset( test_feed_sink_ids, 0, sizeof( test_feed_sink_ids ) );
+    calls                   = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 1 ]   = 0;
+    test_retry_sleeps       = 0;
+
+    xi_set_retry_policy( &policy );
+
+    response = xi_feed_get_all_streamed( xi, &test_feed_sink, &calls );
+
+    tt_int_op( calls, ==, 1 );
+    tt_str_op( test_feed_sink_ids, ==, "a" );
+    tt_int_op( test_retry_sleeps, ==, 0 );
+
+ end:
+    xi_set_retry_policy( &single );
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static char test_history_page[ XI_HISTORY_PAGE_SIZE * 64 + 64 ];
+
+static void test_history_sink( const char* datastream_id, const xi_datapoint_t* datapoint, void* user_data )
+{
+    // the sink sees the datastream id of every datapoint
+    if( strcmp( datastream_id, "t" ) == 0 )
+    {
+        ( *( int* ) user_data ) += 1;
+    }
+
+    test_feed_sink_sum += datapoint->value.i32_value;
+}
+
+void test_datastream_history_pages(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_history_io;
+
+    const xi_timestamp_t start  = { 1388534400, 0 };
+    const xi_timestamp_t end    = { 1388534400 + 86400, 0 };
+    int calls                   = 0;
+
+    xi_context_t* xi = xi_create_context( XI_TCP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_history_io                 = *io_layer->layer_functions;
+    test_history_io.data_ready      = &test_ws_io_data_ready;
+    test_history_io.on_data_ready   = &test_tcp_io_on_data_ready;
+    io_layer->layer_functions       = &test_history_io;
+
+    // the full page makes the next one to be requested
+    int size = sprintf( test_history_page, "{\"status\":200,\"body\":{\"id\":\"t\",\"datapoints\":[" );
+
+    for( int i = 0; i < XI_HISTORY_PAGE_SIZE; ++i )
+    {
+        size += sprintf( test_history_page + size, "%s{\"at\":\"2014-01-01T%02d:%02d:%02d.000000Z\",\"value\":\"1\"}"
+            , i ? "," : "", i / 3600, i / 60 % 60, i % 60 );
+    }
+
+    sprintf( test_history_page + size, "]}}\n" );
+
+    memset( test_tcp_reply_sizes, 0, sizeof( test_tcp_reply_sizes ) );
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = test_history_page;
+    test_tcp_replies[ 1 ]       = "{\"status\":200,\"body\":{\"id\":\"t\",\"datapoints\":["
+                                  "{\"at\":\"2014-01-02T00:00:00.000000Z\",\"value\":\"10\"},"
+                                  "{\"at\":\"2014-01-02T00:00:01.000000Z\",\"value\":\"20\"}]}}\n";
+    test_tcp_replies[ 2 ]       = 0;
+    test_feed_sink_sum          = 0;
+
+    const xi_response_t* response = xi_datastream_history( xi, 1, "t", &start, &end, 0, 0, &test_history_sink, &calls );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( calls, ==, XI_HISTORY_PAGE_SIZE + 2 );
+    tt_int_op( test_feed_sink_sum, ==, XI_HISTORY_PAGE_SIZE + 30 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent
+        , "{\"method\":\"get\",\"resource\":\"/feeds/1/datastreams/t\",\"params\":{"
+          "\"start\":\"2014-01-01T00:00:00.000000Z\",\"end\":\"2014-01-02T00:00:00.000000Z\","
+          "\"limit\":\"" XI_STR( XI_HISTORY_PAGE_SIZE ) "\"}" ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\"start\":\"2014-01-01T00:16:39.000001Z\"," ) != 0 );
+
+    // the server that gives more than the limit stops at the limit
+    test_ws_sent_size           = 0;
+    test_tcp_reply              = 0;
+    test_tcp_replies[ 0 ]       = "{\"status\":200,\"body\":{\"id\":\"t\",\"datapoints\":["
+                                  "{\"at\":\"2014-01-02T00:00:00.000000Z\",\"value\":\"1\"},"
+                                  "{\"at\":\"2014-01-02T00:00:01.000000Z\",\"value\":\"2\"},"
+                                  "{\"at\":\"2014-01-02T00:00:02.000000Z\",\"value\":\"4\"}]}}\n";
+    test_tcp_replies[ 1 ]       = 0;
+    test_feed_sink_sum          = 0;
+    calls                       = 0;
+
+    response = xi_datastream_history( xi, 1, "t", &start, &end, 0, 2, &test_history_sink, &calls );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( calls, ==, 2 );
+    tt_int_op( test_feed_sink_sum, ==, 3 );
+    tt_int_op( test_tcp_reply, ==, 1 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_feed_cache_revalidation(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_cache_io;
+    static xi_feed_t feed;
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+    tt_ptr_op( xi_feed_cache_enable( xi, &test_clock_ms ), ==, xi );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_cache_io                   = *io_layer->layer_functions;
+    test_cache_io.data_ready        = &test_ws_io_data_ready;
+    test_cache_io.on_data_ready     = &test_tcp_io_on_data_ready;
+    io_layer->layer_functions       = &test_cache_io;
+
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.datastream_count = 1;
+    strcpy( feed.datastreams[ 0 ].datastream_id, "temp" );
+
+    // fresh for 10 - 2 seconds
+    memset( test_tcp_reply_sizes, 0, sizeof( test_tcp_reply_sizes ) );
+    test_clock              = 0;
+    test_ws_sent_size       = 0;
+    test_tcp_reply          = 0;
+    test_tcp_replies[ 0 ]   = "HTTP/1.1 200 OK\r\nETag: \"v1\"\r\nCache-Control: max-age=10\r\nAge: 2\r\n"
+                              "Content-Length: 71\r\n\r\ntemp,2014-01-01T10:20:30.000000Z,42\n"
+                              "temp,2014-01-01T10:20:31.000000Z,43";
+    test_tcp_replies[ 1 ]   = 0;
+
+    const xi_response_t* response = xi_feed_get( xi, &feed );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( feed.datastreams[ 0 ].datapoint_count, ==, 2 );
+    tt_int_op( feed.datastreams[ 0 ].datapoints[ 0 ].value.i32_value, ==, 42 );
+
+    // the fresh entry does not touch the network and gives back all of the datapoints
+    test_clock                                          = 7999;
+    test_ws_sent_size                                   = 0;
+    memset( feed.datastreams[ 0 ].datapoints, 0, sizeof( feed.datastreams[ 0 ].datapoints ) );
+    feed.datastreams[ 0 ].datapoint_count               = 0;
+
+    response = xi_feed_get( xi, &feed );
+
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( test_ws_sent_size, ==, 0 );
+    tt_int_op( feed.datastreams[ 0 ].datapoint_count, ==, 2 );
+    tt_int_op( feed.datastreams[ 0 ].datapoints[ 0 ].value.i32_value, ==, 42 );
+    tt_int_op( feed.datastreams[ 0 ].datapoints[ 1 ].value.i32_value, ==, 43 );
+
+    // the stale one is revalidated
+    test_clock                                          = 8000;
+    test_tcp_reply                                      = 0;
+    test_tcp_replies[ 0 ]                               = "HTTP/1.1 304 Not Modified\r\nCache-Control: max-age=10\r\n\r\n";
+    feed.datastreams[ 0 ].datapoints[ 0 ].value.i32_value = 0;
+
+    response = xi_feed_get( xi, &feed );
+
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_int_op( feed.datastreams[ 0 ].datapoints[ 0 ].value.i32_value, ==, 42 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "\r\nIf-None-Match: \"v1\"\r\n" ) != 0 );
+
+    // and fresh again
+    test_clock          = 17999;
+    test_ws_sent_size   = 0;
+
+    response = xi_feed_get( xi, &feed );
+
+    tt_int_op( test_ws_sent_size, ==, 0 );
+
+    const xi_feed_cache_stats_t* stats = xi_feed_cache_stats( xi );
+
+    tt_int_op( stats->hits, ==, 2 );
+    tt_int_op( stats->misses, ==, 1 );
+    tt_int_op( stats->revalidations, ==, 1 );
 
  end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_csv_scan_split_values(void* data)
+{
+    (void)(data);
+
+    static csv_layer_data_t csv_layer_data;
+    char buffer[ 40 ];
+    int count = 0;
+
+    // the delimiters on both sides of the vector boundaries
+    memset( buffer, 'x', sizeof( buffer ) );
+    tt_int_op( xi_csv_scan_line( buffer, sizeof( buffer ) ), ==, sizeof( buffer ) );
+    buffer[ 35 ] = '\0';
+    tt_int_op( xi_csv_scan_line( buffer, sizeof( buffer ) ), ==, 35 );
+    buffer[ 17 ] = ',';
+    tt_int_op( xi_csv_scan_line( buffer, sizeof( buffer ) ), ==, 35 );
+    tt_int_op( xi_csv_scan_field( buffer, sizeof( buffer ) ), ==, 17 );
+    buffer[ 15 ] = '\r';
+    tt_int_op( xi_csv_scan_field( buffer, sizeof( buffer ) ), ==, 15 );
+    buffer[ 0 ] = '\n';
+    tt_int_op( xi_csv_scan_line( buffer, sizeof( buffer ) ), ==, 0 );
+
+    // the value and the datastream id are split between the chunks
+    const char* chunks[] = {
+          "a,2014-01-01T10:20:30.000000Z,123"
+        , "4567\nb"
+        , ",2014-01-01T10:20:30.000000Z,8\n" };
+
+    memset( &csv_layer_data, 0, sizeof( csv_layer_data_t ) );
+    memset( test_feed_sink_ids, 0, sizeof( test_feed_sink_ids ) );
+    test_feed_sink_sum = 0;
+
+    layer_state_t state = LAYER_STATE_OK;
+
+    for( size_t i = 0; i < sizeof( chunks ) / sizeof( chunks[ 0 ] ); ++i )
+    {
+        const_data_descriptor_t chunk = { chunks[ i ], strlen( chunks[ i ] ), strlen( chunks[ i ] ), 0 };
+
+        state = csv_layer_parse_feed(
+              &csv_layer_data
+            , &chunk
+            , i + 1 < sizeof( chunks ) / sizeof( chunks[ 0 ] ) ? LAYER_HINT_MORE_DATA : LAYER_HINT_NONE
+            , &test_feed_sink
+            , &count );
+    }
+
+    tt_int_op( state, ==, LAYER_STATE_OK );
+    tt_int_op( count, ==, 2 );
+    tt_str_op( test_feed_sink_ids, ==, "ab" );
+    tt_int_op( test_feed_sink_sum, ==, 1234575 );
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_iso8601_timestamps(void* data)
+{
+    (void)(data);
+
+    char text[ XI_ISO8601_SIZE + 1 ];
+    char expected[ 64 ];
+    xi_time_t seconds   = 0;
+    xi_time_t micro     = 0;
+
+    xi_format_iso8601( text, 1391421600, 123 );
+    tt_str_op( text, ==, "2014-02-03T10:00:00.000123Z" );
+
+    // the cached date and time of the same second
+    xi_format_iso8601( text, 1391421600, 999999 );
+    tt_str_op( text, ==, "2014-02-03T10:00:00.999999Z" );
+    xi_format_iso8601( text, 951782400, 0 );
+    tt_str_op( text, ==, "2000-02-29T00:00:00.000000Z" );
+
+    tt_int_op( xi_parse_iso8601( "2014-02-03T10:00:00.000123Z", &seconds, &micro ), ==, 1 );
+    tt_int_op( seconds, ==, 1391421600 );
+    tt_int_op( micro, ==, 123 );
+    tt_int_op( xi_parse_iso8601( "2014-02-03T10:00:00.5Z", &seconds, &micro ), ==, 0 );
+    tt_int_op( xi_parse_iso8601( "2014-13-03T10:00:00.000000Z", &seconds, &micro ), ==, 0 );
+
+    // the same as the gmtime and the mktime all over the range
+    for( xi_time_t t = 0; t < INT32_MAX - 1000003; t += 1000003 )
+    {
+        struct xi_tm tm = *xi_gmtime( &t );
+
+        snprintf( expected, sizeof( expected ), "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ"
+            , tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, 42 );
+
+        xi_format_iso8601( text, t, 42 );
+        tt_str_op( text, ==, expected );
+
+        tt_int_op( xi_parse_iso8601( expected, &seconds, &micro ), ==, 1 );
+        tt_int_op( seconds, ==, t );
+        tt_int_op( seconds, ==, xi_mktime( &tm ) );
+    }
+
+ end:
+    ;
+}
+
+static const char*  test_json_reply     = 0;
+static size_t       test_json_chunk     = 0;
+static size_t       test_json_body_size = 0;                // of the binary bodies, the text ones are measured
+
+// plays the server, the headers come at once and the body in chunks of the test_json_chunk
+static layer_state_t test_json_io_on_data_ready( layer_connectivity_t* context, const void* data, const layer_hint_t hint )
+{
+    (void)(data); (void)(hint);
+
+    const char* body    = strstr( test_json_reply, "\r\n\r\n" ) + 4;
+    const char* end     = body + ( test_json_body_size ? test_json_body_size : strlen( body ) );
+    layer_state_t state = LAYER_STATE_WANT_READ;
+
+    const_data_descriptor_t desc = { test_json_reply, body - test_json_reply, body - test_json_reply, 0 };
+
+    state = CALL_ON_NEXT_ON_DATA_READY( context->self, ( const void* ) &desc, LAYER_HINT_NONE );
+
+    for( const char* chunk = body; state == LAYER_STATE_WANT_READ && chunk < end; chunk += test_json_chunk )
+    {
+        const size_t size                   = end - chunk < ( long ) test_json_chunk ? ( size_t ) ( end - chunk ) : test_json_chunk;
+        const const_data_descriptor_t part  = { chunk, size, size, 0 };
+
+        state = CALL_ON_NEXT_ON_DATA_READY( context->self, ( const void* ) &part, LAYER_HINT_NONE );
+    }
+
+    return state;
+}
+
+void test_retry_after_saturates(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_retry_io;
+
+    // the 4294968 seconds would wrap to 704 ms
+    const xi_retry_policy_t policy = { 4, 100, 1000, 0, 0, &test_retry_sleep_ms };
+    const xi_retry_policy_t single = { 1, 100, 10000, 0, 0, 0 };
+
+    xi_datapoint_t datapoint;
+    xi_set_value_i32( &datapoint, 1 );
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_retry_io                   = *io_layer->layer_functions;
+    test_retry_io.on_data_ready     = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_retry_io;
+
+    test_json_reply     = "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 4294968\r\nContent-Length: 0\r\n\r\n";
+    test_json_chunk     = 1;
+    test_retry_sleeps   = 0;
+
+    xi_set_retry_policy( &policy );
+
+    const xi_response_t* response = xi_datastream_update( xi, 1, "test", &datapoint );
+
+    // the server asks for more than the policy allows so it is not retried at all
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 503 );
+    tt_int_op( test_retry_sleeps, ==, 0 );
+
+ end:
+    xi_set_retry_policy( &single );
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_json_feed_and_datastream(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_json_io;
+    static xi_feed_t feed;
+    static char reply[ 1024 ];
+
+    static const char body[] =
+        "{\"version\":\"1.0.0\",\"datastreams\":["
+        "{\"id\":\"temp\",\"current_value\":\"21.5\",\"at\":\"2014-01-01T10:20:30.000000Z\","
+        "\"max_value\":\"30.0\",\"min_value\":\"-4\",\"tags\":[\"a\\\"b\",{\"id\":\"x\"}],\"unit\":{\"label\":\"C\"}},\n"
+        "{\"id\":\"hum\",\"current_value\":40,\"datapoints\":["
+        "{\"at\":\"2014-01-01T10:20:30.000000Z\",\"value\":\"38\"},{\"value\":\"40\"}]},\n"
+        "{\"id\":\"name\",\"current_value\":\"k\\u00e9y \\\"x\\\"\",\"min_value\":null}]}";
+
+    int calls = 0;
+    xi_datapoint_t datapoint;
+
+    xi_context_t* xi = xi_create_context( XI_HTTP_JSON, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_json_io                    = *io_layer->layer_functions;
+    test_json_io.data_ready         = &test_ws_io_data_ready;
+    test_json_io.on_data_ready      = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_json_io;
+
+    sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s", ( int ) sizeof( body ) - 1, body );
+    test_json_reply = reply;
+
+    // any split of the body gives the same feed
+    for( test_json_chunk = 1; test_json_chunk < sizeof( body ); test_json_chunk = test_json_chunk * 2 + 1 )
+    {
+        memset( &feed, 0, sizeof( xi_feed_t ) );
+        test_ws_sent_size = 0;
+
+        const xi_response_t* response = xi_feed_get_all( xi, &feed );
+
+        tt_assert( response != 0 );
+        tt_int_op( response->http.http_status, ==, 200 );
+        tt_int_op( feed.datastream_count, ==, 3 );
+
+        test_ws_sent[ test_ws_sent_size ] = '\0';
+        tt_assert( strstr( test_ws_sent, "GET /v2/feeds/1.json " ) != 0 );
+
+        const xi_datastream_t* temp = &feed.datastreams[ 0 ];
+        tt_str_op( temp->datastream_id, ==, "temp" );
+        tt_int_op( temp->datapoint_count, ==, 1 );
+        tt_int_op( temp->datapoints[ 0 ].value_type, ==, XI_VALUE_TYPE_F32 );
+        tt_assert( temp->datapoints[ 0 ].value.f32_value == 21.5f );
+        tt_int_op( temp->datapoints[ 0 ].timestamp.timestamp, ==, 1388571630 );
+        tt_assert( temp->max_value.value.f32_value == 30.0f );
+        tt_int_op( temp->min_value.value.i32_value, ==, -4 );
+
+        const xi_datastream_t* hum = &feed.datastreams[ 1 ];
+        tt_str_op( hum->datastream_id, ==, "hum" );
+        tt_int_op( hum->datapoint_count, ==, 2 );
+        tt_int_op( hum->datapoints[ 0 ].value.i32_value, ==, 38 );
+        tt_int_op( hum->datapoints[ 0 ].timestamp.timestamp, ==, 1388571630 );
+        tt_int_op( hum->datapoints[ 1 ].value.i32_value, ==, 40 );
+        tt_int_op( hum->datapoints[ 1 ].timestamp.timestamp, ==, 0 );
+
+        const xi_datastream_t* name = &feed.datastreams[ 2 ];
+        tt_int_op( name->datapoints[ 0 ].value_type, ==, XI_VALUE_TYPE_STR );
+        tt_str_op( name->datapoints[ 0 ].value.str_value, ==, "k\xc3\xa9y \"x\"" );
+        tt_int_op( name->min_value.value_type, ==, 0 );
+    }
+
+    // the sink gets every datapoint or the current value if there are none
+    memset( test_feed_sink_ids, 0, sizeof( test_feed_sink_ids ) );
+    test_json_chunk = 5;
+
+    tt_assert( xi_feed_get_all_streamed( xi, &test_feed_sink, &calls ) != 0 );
+    tt_int_op( calls, ==, 4 );
+    tt_str_op( test_feed_sink_ids, ==, "temphumhumname" );
+
+    // the truncated document is an error
+    sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%.*s", ( int ) sizeof( body ) - 2, ( int ) sizeof( body ) - 2, body );
+    xi_set_err( XI_NO_ERR );
+
+    xi_feed_get_all( xi, &feed );
+    tt_int_op( xi_get_last_error(), ==, XI_JSON_DECODE_PARSER_ERROR );
+    xi_set_err( XI_NO_ERR );
+
+    // the update is sent as the current value
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+    xi_set_value_f32( &datapoint, 21.5f );
+    datapoint.timestamp.timestamp = 1388571630;
+
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_ws_sent_size   = 0;
+
+    const xi_response_t* response = xi_datastream_update( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "PUT /v2/feeds/1/datastreams/temp.json " ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\r\n\r\n{\"current_value\":\"21.5\",\"at\":\"2014-01-01T10:20:30.000000Z\"}" ) != 0 );
+
+    // and the feed with all of the datapoints of the datastream
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.datastream_count                   = 2;
+    feed.datastreams[ 0 ].datapoint_count   = 1;
+    feed.datastreams[ 1 ].datapoint_count   = 2;
+    strcpy( feed.datastreams[ 0 ].datastream_id, "name" );
+    strcpy( feed.datastreams[ 1 ].datastream_id, "hum" );
+    xi_set_value_str( &feed.datastreams[ 0 ].datapoints[ 0 ], "a\"b" );
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 0 ], 38 );
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 1 ], 40 );
+    feed.datastreams[ 1 ].datapoints[ 0 ].timestamp.timestamp = 1388571630;
+
+    test_ws_sent_size = 0;
+
+    tt_assert( xi_feed_update( xi, &feed ) != 0 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "PUT /v2/feeds/1.json " ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\r\n\r\n{\"version\":\"1.0.0\",\"datastreams\":["
+        "{\"id\":\"name\",\"current_value\":\"a\\\"b\"},"
+        "{\"id\":\"hum\",\"datapoints\":[{\"at\":\"2014-01-01T10:20:30.000000Z\",\"value\":\"38\"},{\"value\":\"40\"}]}]}" ) != 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+// the body sent after the headers is the expected one
+static int test_cbor_sent_body( const unsigned char* expected, size_t size )
+{
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+
+    const char* body = strstr( test_ws_sent, "\r\n\r\n" ) + 4;
+
+    return ( size_t ) ( test_ws_sent + test_ws_sent_size - body ) == size && memcmp( body, expected, size ) == 0;
+}
+
+void test_cbor_feed_and_datastream(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_cbor_io;
+    static xi_feed_t feed;
+    static char reply[ 1024 ];
+
+    // [["temp",[[t,21.5],[+1s,-4],[+1s,1.5 as half]]],["name",[[null,"hi"]]]]
+    static const unsigned char body[] =
+    {
+          0x82
+        , 0x82, 0x64, 't', 'e', 'm', 'p', 0x83
+        , 0x82, 0x1b, 0x00, 0x04, 0xee, 0xe6, 0x06, 0xc0, 0x57, 0x80, 0xfa, 0x41, 0xac, 0x00, 0x00
+        , 0x82, 0x1a, 0x00, 0x0f, 0x42, 0x40, 0x23
+        , 0x82, 0x1a, 0x00, 0x0f, 0x42, 0x40, 0xf9, 0x3e, 0x00
+        , 0x82, 0x64, 'n', 'a', 'm', 'e', 0x81
+        , 0x82, 0xf6, 0x62, 'h', 'i'
+    };
+
+    static const unsigned char update[] =
+    {
+        0x81, 0x82, 0x1b, 0x00, 0x04, 0xee, 0xe6, 0x06, 0xc0, 0x57, 0x80, 0xfa, 0x41, 0xac, 0x00, 0x00
+    };
+
+    static const unsigned char feed_update[] =
+    {
+          0x81, 0x82, 0x63, 'h', 'u', 'm', 0x82
+        , 0x82, 0x1b, 0x00, 0x04, 0xee, 0xe6, 0x06, 0xc0, 0x57, 0x80, 0x18, 0x26
+        , 0x82, 0x1a, 0x00, 0x98, 0x96, 0x80, 0x18, 0x28
+    };
+
+    int calls = 0;
+    int header_size = 0;
+    xi_datapoint_t datapoint;
+
+    xi_context_t* xi = xi_create_context( XI_HTTP_CBOR, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_cbor_io                    = *io_layer->layer_functions;
+    test_cbor_io.data_ready         = &test_ws_io_data_ready;
+    test_cbor_io.on_data_ready      = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_cbor_io;
+
+    header_size = sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", ( int ) sizeof( body ) );
+    memcpy( reply + header_size, body, sizeof( body ) );
+    test_json_reply     = reply;
+    test_json_body_size = sizeof( body );
+
+    // any split of the body gives the same feed
+    for( test_json_chunk = 1; test_json_chunk <= sizeof( body ); test_json_chunk = test_json_chunk * 2 + 1 )
+    {
+        memset( &feed, 0, sizeof( xi_feed_t ) );
+        test_ws_sent_size = 0;
+
+        const xi_response_t* response = xi_feed_get_all( xi, &feed );
+
+        tt_assert( response != 0 );
+        tt_int_op( response->http.http_status, ==, 200 );
+        tt_int_op( feed.datastream_count, ==, 2 );
+
+        test_ws_sent[ test_ws_sent_size ] = '\0';
+        tt_assert( strstr( test_ws_sent, "GET /v2/feeds/1.cbor " ) != 0 );
+
+        const xi_datastream_t* temp = &feed.datastreams[ 0 ];
+        tt_str_op( temp->datastream_id, ==, "temp" );
+        tt_int_op( temp->datapoint_count, ==, 3 );
+        tt_int_op( temp->datapoints[ 0 ].value_type, ==, XI_VALUE_TYPE_F32 );
+        tt_assert( temp->datapoints[ 0 ].value.f32_value == 21.5f );
+        tt_int_op( temp->datapoints[ 0 ].timestamp.timestamp, ==, 1388571630 );
+        tt_int_op( temp->datapoints[ 1 ].value_type, ==, XI_VALUE_TYPE_I32 );
+        tt_int_op( temp->datapoints[ 1 ].value.i32_value, ==, -4 );
+        tt_int_op( temp->datapoints[ 1 ].timestamp.timestamp, ==, 1388571631 );
+        tt_assert( temp->datapoints[ 2 ].value.f32_value == 1.5f );
+        tt_int_op( temp->datapoints[ 2 ].timestamp.timestamp, ==, 1388571632 );
+
+        const xi_datastream_t* name = &feed.datastreams[ 1 ];
+        tt_str_op( name->datastream_id, ==, "name" );
+        tt_int_op( name->datapoint_count, ==, 1 );
+        tt_int_op( name->datapoints[ 0 ].value_type, ==, XI_VALUE_TYPE_STR );
+        tt_str_op( name->datapoints[ 0 ].value.str_value, ==, "hi" );
+        tt_int_op( name->datapoints[ 0 ].timestamp.timestamp, ==, 0 );
+    }
+
+    // the sink gets every datapoint
+    memset( test_feed_sink_ids, 0, sizeof( test_feed_sink_ids ) );
+    test_json_chunk = 5;
+
+    tt_assert( xi_feed_get_all_streamed( xi, &test_feed_sink, &calls ) != 0 );
+    tt_int_op( calls, ==, 4 );
+    tt_str_op( test_feed_sink_ids, ==, "temptemptempname" );
+
+    // the truncated body is an error
+    header_size = sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", ( int ) sizeof( body ) - 1 );
+    memcpy( reply + header_size, body, sizeof( body ) - 1 );
+    test_json_body_size = sizeof( body ) - 1;
+    xi_set_err( XI_NO_ERR );
+
+    xi_feed_get_all( xi, &feed );
+    tt_int_op( xi_get_last_error(), ==, XI_CBOR_DECODE_PARSER_ERROR );
+    xi_set_err( XI_NO_ERR );
+
+    // the update is the datapoints with the one
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+    xi_set_value_f32( &datapoint, 21.5f );
+    datapoint.timestamp.timestamp = 1388571630;
+
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_json_body_size = 0;
+    test_ws_sent_size   = 0;
+
+    const xi_response_t* response = xi_datastream_update( xi, 1, "temp", &datapoint );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "PUT /v2/feeds/1/datastreams/temp.cbor " ) != 0 );
+    tt_assert( strstr( test_ws_sent, "Content-Length: 16\r\n" ) != 0 );
+    tt_assert( test_cbor_sent_body( update, sizeof( update ) ) );
+
+    // and the feed with the at of the second datapoint as the delta
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.datastream_count                   = 1;
+    feed.datastreams[ 0 ].datapoint_count   = 2;
+    strcpy( feed.datastreams[ 0 ].datastream_id, "hum" );
+    xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 0 ], 38 );
+    xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 1 ], 40 );
+    feed.datastreams[ 0 ].datapoints[ 0 ].timestamp.timestamp = 1388571630;
+    feed.datastreams[ 0 ].datapoints[ 1 ].timestamp.timestamp = 1388571640;
+
+    test_ws_sent_size = 0;
+
+    tt_assert( xi_feed_update( xi, &feed ) != 0 );
+    tt_assert( test_cbor_sent_body( feed_update, sizeof( feed_update ) ) );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    test_json_body_size = 0;
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_csv_feed_update_datapoints(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_csv_io;
+    static xi_feed_t feed;
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_csv_io                     = *io_layer->layer_functions;
+    test_csv_io.data_ready          = &test_ws_io_data_ready;
+    test_csv_io.on_data_ready       = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_csv_io;
+
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_json_chunk     = 1;
+
+    // every datapoint is the line of its own, the datastream without the count sends the first one
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.datastream_count                   = 2;
+    feed.datastreams[ 0 ].datapoint_count   = 3;
+    strcpy( feed.datastreams[ 0 ].datastream_id, "a" );
+    strcpy( feed.datastreams[ 1 ].datastream_id, "b" );
+
+    for( int i = 0; i < 3; ++i )
+    {
+        xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ i ], i );
+        feed.datastreams[ 0 ].datapoints[ i ].timestamp.timestamp = 1388571630 + i;
+    }
+
+    xi_set_value_f32( &feed.datastreams[ 1 ].datapoints[ 0 ], 0.5f );
+
+    test_ws_sent_size = 0;
+
+    tt_assert( xi_feed_update( xi, &feed ) != 0 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "PUT /v2/feeds/1.csv " ) != 0 );
+    tt_assert( strstr( test_ws_sent, "Content-Length: 102\r\n" ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\r\n\r\n"
+        "a,2014-01-01T10:20:30.000000Z,0\n"
+        "a,2014-01-01T10:20:31.000000Z,1\n"
+        "a,2014-01-01T10:20:32.000000Z,2\n"
+        "b,0.5\n" ) != 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_csv_feed_get_datapoints(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_csv_io;
+    static xi_feed_t feed;
+    static xi_datastream_t datastream;
+    static char reply[ 512 ];
+
+    static const char body[] =
+        "a,2014-01-01T10:20:30.000000Z,1\n"
+        "a,2014-01-01T10:20:31.000000Z,2\n"
+        "b,2014-01-01T10:20:30.000000Z,x\n"
+        "a,2014-01-01T10:20:32.000000Z,3\n";
+
+    static const char history[] =
+        "2014-01-01T10:20:30.000000Z,1.5\n"
+        "2014-01-01T10:20:31.000000Z,2\n";
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_csv_io                     = *io_layer->layer_functions;
+    test_csv_io.data_ready          = &test_ws_io_data_ready;
+    test_csv_io.on_data_ready       = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_csv_io;
+
+    sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s", ( int ) sizeof( body ) - 1, body );
+    test_json_reply = reply;
+
+    // the consecutive lines of the same datastream are its datapoints
+    for( test_json_chunk = 1; test_json_chunk < sizeof( body ); test_json_chunk = test_json_chunk * 2 + 1 )
+    {
+        memset( &feed, 0, sizeof( xi_feed_t ) );
+        test_ws_sent_size = 0;
+
+        tt_assert( xi_feed_get_all( xi, &feed ) != 0 );
+        tt_int_op( feed.datastream_count, ==, 3 );
+        tt_str_op( feed.datastreams[ 0 ].datastream_id, ==, "a" );
+        tt_int_op( feed.datastreams[ 0 ].datapoint_count, ==, 2 );
+        tt_int_op( feed.datastreams[ 0 ].datapoints[ 0 ].value.i32_value, ==, 1 );
+        tt_int_op( feed.datastreams[ 0 ].datapoints[ 1 ].value.i32_value, ==, 2 );
+        tt_int_op( feed.datastreams[ 0 ].datapoints[ 1 ].timestamp.timestamp, ==, 1388571631 );
+        tt_str_op( feed.datastreams[ 1 ].datastream_id, ==, "b" );
+        tt_int_op( feed.datastreams[ 1 ].datapoint_count, ==, 1 );
+        tt_str_op( feed.datastreams[ 1 ].datapoints[ 0 ].value.str_value, ==, "x" );
+        tt_str_op( feed.datastreams[ 2 ].datastream_id, ==, "a" );
+        tt_int_op( feed.datastreams[ 2 ].datapoint_count, ==, 1 );
+        tt_int_op( feed.datastreams[ 2 ].datapoints[ 0 ].value.i32_value, ==, 3 );
+    }
+
+    // and the datastream read keeps every line
+    sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s", ( int ) sizeof( history ) - 1, history );
+    test_json_chunk = 7;
+
+    tt_assert( xi_datastream_get_datapoints( xi, 1, "temp", &datastream ) != 0 );
+    tt_str_op( datastream.datastream_id, ==, "temp" );
+    tt_int_op( datastream.datapoint_count, ==, 2 );
+    tt_assert( datastream.datapoints[ 0 ].value.f32_value == 1.5f );
+    tt_int_op( datastream.datapoints[ 1 ].value.i32_value, ==, 2 );
+    tt_int_op( datastream.datapoints[ 1 ].timestamp.timestamp, ==, 1388571631 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_feed_update_delta(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_csv_io;
+    static xi_feed_t feed;
+    static xi_feed_delta_t delta;
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_csv_io                     = *io_layer->layer_functions;
+    test_csv_io.data_ready          = &test_ws_io_data_ready;
+    test_csv_io.on_data_ready       = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_csv_io;
+
+    test_json_chunk = 1;
+
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.datastream_count = 3;
+    strcpy( feed.datastreams[ 0 ].datastream_id, "a" );
+    strcpy( feed.datastreams[ 1 ].datastream_id, "b" );
+    strcpy( feed.datastreams[ 2 ].datastream_id, "c" );
+    xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 0 ], 1 );
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 0 ], 2 );
+    xi_set_value_str( &feed.datastreams[ 2 ].datapoints[ 0 ], "x" );
+
+    xi_feed_delta_init( &delta );
+
+    // everything is sent first, then nothing until something changes
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_ws_sent_size   = 0;
+
+    tt_assert( xi_feed_update_delta( xi, &feed, &delta ) != 0 );
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "\r\n\r\na,1\nb,2\nc,x\n" ) != 0 );
+
+    test_ws_sent_size = 0;
+    tt_int_op( xi_feed_update_delta( xi, &feed, &delta )->http.http_status, ==, 304 );
+    tt_int_op( test_ws_sent_size, ==, 0 );
+
+    // the failed update is sent again with the datastream changed since
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 0 ], 3 );
+    test_json_reply     = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+    test_ws_sent_size   = 0;
+
+    tt_assert( xi_feed_update_delta( xi, &feed, &delta ) != 0 );
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "Content-Length: 4\r\n" ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\r\n\r\nb,3\n" ) != 0 );
+
+    xi_set_value_str( &feed.datastreams[ 2 ].datapoints[ 0 ], "y" );
+    xi_feed_delta_mark( &delta, 0 );
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_ws_sent_size   = 0;
+
+    tt_assert( xi_feed_update_delta( xi, &feed, &delta ) != 0 );
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "\r\n\r\na,1\nb,3\nc,y\n" ) != 0 );
+
+    test_ws_sent_size = 0;
+    tt_int_op( xi_feed_update_delta( xi, &feed, &delta )->http.http_status, ==, 304 );
+    tt_int_op( test_ws_sent_size, ==, 0 );
+
+    // the plain update still sends all of them
+    tt_assert( xi_feed_update( xi, &feed ) != 0 );
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "\r\n\r\na,1\nb,3\nc,y\n" ) != 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+#ifdef XI_OUTBOX_ENABLED
+void test_outbox(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_csv_io;
+
+    xi_outbox_config_t config   = { 4, 2, 1000, 1000, 2, &test_clock_ms };
+    char path[]                 = "/tmp/xi_outbox_XXXXXX";
+    int fd                      = mkstemp( path );
+    const xi_response_t* response = 0;
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+    tt_assert( fd >= 0 );
+    close( fd );
+
+    test_clock = 0;
+    tt_ptr_op( xi_outbox_enable( xi, path, &config ), ==, xi );
+    tt_int_op( xi_outbox_pending( xi ), ==, 0 );
+
+    // the updates are only queued
+    xi_set_value_i32( &datapoint, 1 );
+    tt_int_op( xi_datastream_update( xi, 1, "a", &datapoint )->http.http_status, ==, 202 );
+    xi_set_value_i32( &datapoint, 2 );
+    tt_int_op( xi_datastream_update( xi, 1, "b", &datapoint )->http.http_status, ==, 202 );
+    xi_set_value_i32( &datapoint, 3 );
+    tt_int_op( xi_datastream_update( xi, 1, "a", &datapoint )->http.http_status, ==, 202 );
+    tt_int_op( xi_outbox_pending( xi ), ==, 3 );
+
+    // enabling it again commits the last one that has not been committed yet
+    tt_ptr_op( xi_outbox_enable( xi, path, &config ), ==, xi );
+    tt_int_op( xi_outbox_pending( xi ), ==, 3 );
+
+    // the file is picked up where it has been left
+    xi_outbox_disable( xi );
+    tt_ptr_op( xi->outbox, ==, 0 );
+    tt_ptr_op( xi_outbox_enable( xi, path, &config ), ==, xi );
+    tt_int_op( xi_outbox_pending( xi ), ==, 3 );
+
+    // the oldest one makes room for the new one
+    xi_set_value_i32( &datapoint, 4 );
+    xi_datastream_update( xi, 1, "c", &datapoint );
+    xi_set_value_i32( &datapoint, 5 );
+    tt_int_op( xi_datastream_update( xi, 1, "c", &datapoint )->http.http_status, ==, 202 );
+    tt_int_op( xi_outbox_pending( xi ), ==, 4 );
+
+    // the poll reports the failure of the drain, the dummy io layer fails it so it stays
+    response = xi_outbox_poll( xi );
+    tt_assert( response == 0 || response->http.http_status != 200 );
+    tt_int_op( xi_outbox_pending( xi ), ==, 4 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_csv_io                     = *io_layer->layer_functions;
+    test_csv_io.data_ready          = &test_ws_io_data_ready;
+    test_csv_io.on_data_ready       = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_csv_io;
+
+    test_json_chunk     = 1;
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_ws_sent_size   = 0;
+
+    // the failed drain waits for the interval
+    tt_ptr_op( xi_outbox_poll( xi ), ==, 0 );
+
+    // a request per datastream, the drain stops at two of them
+    test_clock = 1000;
+    tt_int_op( xi_outbox_poll( xi )->http.http_status, ==, 200 );
+    tt_int_op( xi_outbox_pending( xi ), ==, 2 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "POST /v2/feeds/1/datastreams/b/datapoints.csv" ) != 0 );
+    tt_assert( strstr( test_ws_sent, "POST /v2/feeds/1/datastreams/a/datapoints.csv" ) != 0 );
+    tt_assert( strstr( test_ws_sent, ",1\n" ) == 0 );
+    tt_assert( strstr( test_ws_sent, ",3\n" ) != 0 );
+
+    // and goes on with the next poll
+    test_ws_sent_size = 0;
+    tt_int_op( xi_outbox_poll( xi )->http.http_status, ==, 200 );
+    tt_int_op( xi_outbox_pending( xi ), ==, 0 );
+    tt_ptr_op( xi_outbox_poll( xi ), ==, 0 );
+
+    // both of the datapoints of the c in one request, with the different timestamps
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "POST /v2/feeds/1/datastreams/c/datapoints.csv" ) != 0 );
+
+    const char* first   = strstr( test_ws_sent, "\r\n\r\n" ) + 4;
+    const char* second  = strchr( first, '\n' ) + 1;
+
+    tt_int_op( second[ 28 ], ==, '5' );
+    tt_assert( strncmp( first, second, 27 ) < 0 );
+
+    // the datapoints posted and the feed are queued as well
+    {
+        static xi_feed_t feed;
+        xi_datapoint_t values[ 2 ];
+
+        memset( &feed, 0, sizeof( xi_feed_t ) );
+        xi_set_value_i32( &values[ 0 ], 7 );
+        xi_set_value_i32( &values[ 1 ], 8 );
+
+        feed.datastream_count               = 1;
+        feed.datastreams[ 0 ].datapoint_count = 1;
+        strcpy( feed.datastreams[ 0 ].datastream_id, "d" );
+        xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 0 ], 9 );
+
+        test_ws_sent_size = 0;
+        tt_int_op( xi_datapoints_post( xi, 1, "c", values, 2 )->http.http_status, ==, 202 );
+        tt_int_op( xi_feed_update( xi, &feed )->http.http_status, ==, 202 );
+        tt_int_op( xi_outbox_pending( xi ), ==, 3 );
+        tt_int_op( test_ws_sent_size, ==, 0 );
+
+        test_clock = 2000;
+        tt_int_op( xi_outbox_poll( xi )->http.http_status, ==, 200 );
+        tt_int_op( xi_outbox_pending( xi ), ==, 0 );
+
+        test_ws_sent[ test_ws_sent_size ] = '\0';
+        tt_assert( strstr( test_ws_sent, "POST /v2/feeds/1/datastreams/c/datapoints.csv" ) != 0 );
+        tt_assert( strstr( test_ws_sent, "POST /v2/feeds/1/datastreams/d/datapoints.csv" ) != 0 );
+    }
+
+    // the file of the other capacity starts empty
+    xi_set_value_i32( &datapoint, 6 );
+    xi_datastream_update( xi, 1, "a", &datapoint );
+    config.capacity = 8;
+    tt_ptr_op( xi_outbox_enable( xi, path, &config ), ==, xi );
+    tt_int_op( xi_outbox_pending( xi ), ==, 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    unlink( path );
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
+void test_feed_columns(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_csv_io;
+    static xi_feed_columns_t columns;
+    static xi_datapoint_t dp;
+    static char reply[ 512 ];
+
+    static const char body[] =
+        "a,2014-01-01T10:20:30.000000Z,1\n"
+        "b,2014-01-01T10:20:30.000000Z,x\n"
+        "a,2014-01-01T10:20:31.000000Z,2\n";
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    // the float turns the integer column into floats, the strings are stored once
+    memset( &columns, 0, sizeof( xi_feed_columns_t ) );
+
+    xi_set_value_i32( &dp, 1 );
+    tt_int_op( xi_feed_columns_append( &columns, "n", &dp ), ==, 0 );
+    xi_set_value_f32( &dp, 0.5f );
+    dp.timestamp.timestamp  = 1388571630;
+    dp.timestamp.micro      = 250;
+    tt_int_op( xi_feed_columns_append( &columns, "n", &dp ), ==, 0 );
+    xi_set_value_str( &dp, "x" );
+    tt_int_op( xi_feed_columns_append( &columns, "s", &dp ), ==, 0 );
+    tt_int_op( xi_feed_columns_append( &columns, "s", &dp ), ==, 0 );
+
+    tt_int_op( columns.column_count, ==, 2 );
+    tt_int_op( columns.string_count, ==, 1 );
+    tt_int_op( columns.columns[ 0 ].value_type, ==, XI_VALUE_TYPE_F32 );
+    tt_assert( columns.columns[ 0 ].values[ 0 ].f32_value == 1.0f );
+    tt_assert( columns.columns[ 0 ].at[ 0 ] == 0 );
+    tt_assert( columns.columns[ 0 ].at[ 1 ] == 1388571630000250LL );
+    tt_int_op( columns.columns[ 1 ].sample_count, ==, 2 );
+
+    tt_assert( xi_feed_columns_datapoint( &columns, &columns.columns[ 0 ], 1, &dp ) == &dp );
+    tt_int_op( dp.value_type, ==, XI_VALUE_TYPE_F32 );
+    tt_int_op( dp.timestamp.timestamp, ==, 1388571630 );
+    tt_int_op( dp.timestamp.micro, ==, 250 );
+
+    xi_set_value_i32( &dp, 2 );
+    tt_int_op( xi_feed_columns_append( &columns, "s", &dp ), ==, -1 );
+    tt_int_op( xi_get_last_error(), ==, XI_COLUMN_TYPE_MISMATCH );
+    tt_int_op( columns.columns[ 1 ].sample_count, ==, 2 );
+    xi_set_err( XI_NO_ERR );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_csv_io                     = *io_layer->layer_functions;
+    test_csv_io.data_ready          = &test_ws_io_data_ready;
+    test_csv_io.on_data_ready       = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_csv_io;
+
+    // the read groups the datapoints by the datastream whatever their order
+    sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s", ( int ) sizeof( body ) - 1, body );
+    test_json_reply = reply;
+    test_json_chunk = 5;
+    test_ws_sent_size = 0;
+
+    tt_assert( xi_feed_columns_get_all( xi, &columns ) != 0 );
+    tt_int_op( columns.column_count, ==, 2 );
+    tt_str_op( columns.columns[ 0 ].datastream_id, ==, "a" );
+    tt_int_op( columns.columns[ 0 ].sample_count, ==, 2 );
+    tt_int_op( columns.columns[ 0 ].values[ 1 ].i32_value, ==, 2 );
+    tt_str_op( columns.strings[ columns.columns[ 1 ].values[ 0 ].str_index ], ==, "x" );
+
+    // and the update sends the samples column by column
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_ws_sent_size   = 0;
+
+    tt_assert( xi_feed_columns_update( xi, &columns ) != 0 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "PUT /v2/feeds/1.csv " ) != 0 );
+    tt_assert( strstr( test_ws_sent, "Content-Length: 96\r\n" ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\r\n\r\n"
+        "a,2014-01-01T10:20:30.000000Z,1\n"
+        "a,2014-01-01T10:20:31.000000Z,2\n"
+        "b,2014-01-01T10:20:30.000000Z,x\n" ) != 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_arena_feed(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_csv_io;
+    static unsigned char buffer[ 4096 ];
+    static xi_arena_t arena;
+    static xi_datapoint_t dp;
+    static char reply[ 1024 ];
+    static char body[ 768 ];
+
+    xi_arena_feed_t* feed       = 0;
+    xi_arena_datastream_t* a    = 0;
+    xi_arena_datastream_t* b    = 0;
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    // the arena that is too small fails cleanly
+    xi_arena_init( &arena, buffer, sizeof( xi_arena_feed_t ) + 1 );
+    feed = xi_arena_feed_create( &arena, 1 );
+    tt_assert( feed != 0 );
+    tt_assert( xi_arena_feed_add_datastream( feed, "a" ) == 0 );
+    tt_int_op( xi_get_last_error(), ==, XI_OUT_OF_MEMORY );
+    tt_int_op( feed->datastream_count, ==, 0 );
+    xi_set_err( XI_NO_ERR );
+
+    // the id and the number of the datapoints are not limited by the xi_feed_t
+    xi_arena_init( &arena, buffer, sizeof( buffer ) );
+    feed = xi_arena_feed_create( &arena, 1 );
+    tt_assert( feed != 0 );
+    a = xi_arena_feed_add_datastream( feed, "temperature_outside" );
+    tt_assert( a != 0 );
+    tt_int_op( xi_arena_datastream_append( feed, a, xi_set_value_i32( &dp, 0 ) ), ==, 0 );
+    b = xi_arena_feed_add_datastream( feed, "b" );
+    tt_assert( b != 0 );
+    tt_int_op( xi_arena_datastream_append( feed, b, xi_set_value_i32( &dp, 7 ) ), ==, 0 );
+
+    for( int i = 1; i < XI_MAX_DATAPOINTS + 4; ++i )
+    {
+        tt_int_op( xi_arena_datastream_append( feed, a, xi_set_value_i32( &dp, i ) ), ==, 0 );
+    }
+
+    tt_int_op( feed->datastream_count, ==, 2 );
+    tt_int_op( a->datapoint_count, ==, XI_MAX_DATAPOINTS + 4 );
+    tt_int_op( a->datapoints[ XI_MAX_DATAPOINTS + 3 ].value.i32_value, ==, XI_MAX_DATAPOINTS + 3 );
+    tt_assert( arena.used < sizeof( xi_feed_t ) );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_csv_io                     = *io_layer->layer_functions;
+    test_csv_io.data_ready          = &test_ws_io_data_ready;
+    test_csv_io.on_data_ready       = &test_json_io_on_data_ready;
+    io_layer->layer_functions       = &test_csv_io;
+
+    test_json_reply     = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    test_json_chunk     = 1;
+    test_ws_sent_size   = 0;
+
+    tt_assert( xi_arena_feed_update( xi, feed ) != 0 );
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "PUT /v2/feeds/1.csv " ) != 0 );
+    tt_assert( strstr( test_ws_sent, "\r\n\r\ntemperature_outside,0\ntemperature_outside,1\n" ) != 0 );
+    tt_assert( strstr( test_ws_sent, "temperature_outside,19\nb,7\n" ) != 0 );
+
+    // the read appends the datastreams of the response to the new feed
+    body[ 0 ] = '\0';
+
+    for( int i = 0; i < XI_MAX_DATAPOINTS + 4; ++i )
+    {
+        sprintf( body + strlen( body ), "a,2014-01-01T10:20:%02d.000000Z,%d\n", i, i );
+    }
+
+    strcat( body, "b,2014-01-01T10:20:30.000000Z,x\n" );
+    sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s", ( int ) strlen( body ), body );
+    test_json_reply = reply;
+    test_json_chunk = 13;
+
+    xi_arena_reset( &arena );
+    feed = xi_arena_feed_create( &arena, 1 );
+    tt_assert( feed != 0 );
+
+    tt_assert( xi_arena_feed_get_all( xi, feed ) != 0 );
+    tt_int_op( feed->datastream_count, ==, 2 );
+    tt_str_op( feed->datastreams->datastream_id, ==, "a" );
+    tt_int_op( feed->datastreams->datapoint_count, ==, XI_MAX_DATAPOINTS + 4 );
+    tt_int_op( feed->datastreams->datapoints[ XI_MAX_DATAPOINTS + 3 ].timestamp.timestamp, ==, 1388571600 + XI_MAX_DATAPOINTS + 3 );
+    tt_str_op( feed->last->datastream_id, ==, "b" );
+    tt_str_op( feed->last->datapoints[ 0 ].value.str_value, ==, "x" );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_id_table(void* data)
+{
+    (void)(data);
+
+    static xi_id_table_t table;
+    static xi_feed_t feed;
+    static xi_feed_index_t index;
+    char id[ XI_MAX_DATASTREAM_NAME ];
+
+    // the handles are given in order and the same id keeps its handle
+    xi_id_table_init( &table );
+
+    for( int i = 0; i < XI_MAX_INTERNED_IDS; ++i )
+    {
+        sprintf( id, "id%d", i );
+        tt_int_op( xi_id_intern( &table, id ), ==, i );
+    }
+
+    tt_int_op( xi_id_intern( &table, "id7" ), ==, 7 );
+    tt_int_op( xi_id_lookup( &table, "id42" ), ==, 42 );
+    tt_int_op( xi_id_lookup( &table, "missing" ), ==, -1 );
+    tt_str_op( xi_id_string( &table, 42 ), ==, "id42" );
+
+    tt_int_op( xi_id_intern( &table, "one_too_many" ), ==, -1 );
+    tt_int_op( xi_get_last_error(), ==, XI_ID_TABLE_FULL );
+    xi_set_err( XI_NO_ERR );
+
+    tt_int_op( xi_id_intern( &table, "the_id_that_is_too_long" ), ==, -1 );
+    tt_int_op( xi_get_last_error(), ==, XI_DATASTREAM_ID_TOO_LONG );
+    xi_set_err( XI_NO_ERR );
+
+    // the index finds each datastream of the full feed, the repeated id finds the first one
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.datastream_count = XI_MAX_DATASTREAMS;
+
+    for( int i = 0; i < XI_MAX_DATASTREAMS; ++i )
+    {
+        sprintf( feed.datastreams[ i ].datastream_id, "ds%d", i );
+    }
+
+    strcpy( feed.datastreams[ XI_MAX_DATASTREAMS - 1 ].datastream_id, "ds0" );
+
+    xi_feed_index_build( &index, &feed );
+
+    for( int i = 0; i < XI_MAX_DATASTREAMS - 1; ++i )
+    {
+        sprintf( id, "ds%d", i );
+        tt_assert( xi_feed_find_datastream( &index, &feed, id ) == &feed.datastreams[ i ] );
+    }
+
+    tt_assert( xi_feed_find_datastream( &index, &feed, "ds99" ) == 0 );
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static char         test_post_batches[ 8 ];
+static size_t       test_post_requests  = 0;
+
+// refuses the first request as too large and stores the rest, counts the datapoints of each one
+static layer_state_t test_post_io_on_data_ready( layer_connectivity_t* context, const void* data, const layer_hint_t hint )
+{
+    const char* body    = strstr( test_ws_sent, "\r\n\r\n" ) + 4;
+    char lines          = '0';
+
+    test_ws_sent[ test_ws_sent_size ] = '\0';
+    tt_assert( strstr( test_ws_sent, "POST /v2/feeds/1/datastreams/temp/datapoints.csv " ) != 0 );
+
+    for( ; *body; ++body )
+    {
+        lines += *body == '\n';
+    }
+
+    test_post_batches[ test_post_requests++ ]   = lines;
+    test_ws_sent_size                           = 0;
+    test_json_reply                             = test_post_requests == 1
+        ? "HTTP/1.1 413 Request Entity Too Large\r\nContent-Length: 0\r\n\r\n"
+        : "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+ end:
+    return test_json_io_on_data_ready( context, data, hint );
+}
+
+void test_datapoints_post_batches(void* data)
+{
+    (void)(data);
+
+    static layer_interface_t test_post_io;
+    xi_datapoint_t datapoints[ 5 ];
+
+    xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+    tt_assert( xi != 0 );
+
+    layer_t* io_layer               = xi->layer_chain.bottom;
+    test_post_io                    = *io_layer->layer_functions;
+    test_post_io.data_ready         = &test_ws_io_data_ready;
+    test_post_io.on_data_ready      = &test_post_io_on_data_ready;
+    io_layer->layer_functions       = &test_post_io;
+
+    memset( datapoints, 0, sizeof( datapoints ) );
+    memset( test_post_batches, 0, sizeof( test_post_batches ) );
+
+    for( int i = 0; i < 5; ++i )
+    {
+        xi_set_value_i32( &datapoints[ i ], i );
+        datapoints[ i ].timestamp.timestamp = 1388571630 + i;
+    }
+
+    test_json_chunk     = 1;
+    test_post_requests  = 0;
+    test_ws_sent_size   = 0;
+
+    // the refused request is sent again in halves
+    const xi_response_t* response = xi_datapoints_post( xi, 1, "temp", datapoints, 5 );
+
+    tt_assert( response != 0 );
+    tt_int_op( response->http.http_status, ==, 200 );
+    tt_str_op( test_post_batches, ==, "5221" );
+
+    tt_ptr_op( xi_datapoints_post( xi, 1, "temp", datapoints, 0 ), ==, 0 );
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    xi_set_err( XI_NO_ERR );
     ;
 }
 
@@ -273,6 +2753,7 @@ struct testcase_t core_tests[] = {
     { "test_parse_http_status", test_parse_http_status, TT_ENABLED_, 0, 0 },
     { "test_parse_http_header", test_parse_http_header, TT_ENABLED_, 0, 0 },
     { "test_parse_http", test_parse_http, TT_ENABLED_, 0, 0 },
+    { "test_parse_http_status_only", test_parse_http_status_only, TT_ENABLED_, 0, 0 },
 
     { "test_http_construct_request", test_http_construct_request, TT_ENABLED_, 0, 0 },
     { "test_http_construct_content", test_http_construct_content, TT_ENABLED_, 0, 0 },
@@ -287,6 +2768,32 @@ struct testcase_t core_tests[] = {
     { "test_helpers_decode_value", test_helpers_decode_value, TT_ENABLED_, 0, 0 },
 
     { "test_create_and_delete_context", test_create_and_delete_context, TT_ENABLED_, 0, 0 },
+    { "test_retry_policy_backoff", test_retry_policy_backoff, TT_ENABLED_, 0, 0 },
+    { "test_retry_after_saturates", test_retry_after_saturates, TT_ENABLED_, 0, 0 },
+    { "test_write_behind_coalescing", test_write_behind_coalescing, TT_ENABLED_, 0, 0 },
+    { "test_aggregator", test_aggregator, TT_ENABLED_, 0, 0 },
+    { "test_ws_request_and_ping", test_ws_request_and_ping, TT_ENABLED_, 0, 0 },
+    { "test_tcp_requests", test_tcp_requests, TT_ENABLED_, 0, 0 },
+    { "test_aggregator_failed_window", test_aggregator_failed_window, TT_ENABLED_, 0, 0 },
+    { "test_mqtt_publish_and_subscribe", test_mqtt_publish_and_subscribe, TT_ENABLED_, 0, 0 },
+    { "test_http2_streams", test_http2_streams, TT_ENABLED_, 0, 0 },
+    { "test_feed_get_all_streamed", test_feed_get_all_streamed, TT_ENABLED_, 0, 0 },
+    { "test_datastream_history_pages", test_datastream_history_pages, TT_ENABLED_, 0, 0 },
+    { "test_feed_cache_revalidation", test_feed_cache_revalidation, TT_ENABLED_, 0, 0 },
+    { "test_csv_scan_split_values", test_csv_scan_split_values, TT_ENABLED_, 0, 0 },
+    { "test_iso8601_timestamps", test_iso8601_timestamps, TT_ENABLED_, 0, 0 },
+    { "test_json_feed_and_datastream", test_json_feed_and_datastream, TT_ENABLED_, 0, 0 },
+    { "test_cbor_feed_and_datastream", test_cbor_feed_and_datastream, TT_ENABLED_, 0, 0 },
+    { "test_csv_feed_update_datapoints", test_csv_feed_update_datapoints, TT_ENABLED_, 0, 0 },
+    { "test_csv_feed_get_datapoints", test_csv_feed_get_datapoints, TT_ENABLED_, 0, 0 },
+    { "test_feed_update_delta", test_feed_update_delta, TT_ENABLED_, 0, 0 },
+#ifdef XI_OUTBOX_ENABLED
+    { "test_outbox", test_outbox, TT_ENABLED_, 0, 0 },
+#endif
+    { "test_feed_columns", test_feed_columns, TT_ENABLED_, 0, 0 },
+    { "test_arena_feed", test_arena_feed, TT_ENABLED_, 0, 0 },
+    { "test_id_table", test_id_table, TT_ENABLED_, 0, 0 },
+    { "test_datapoints_post_batches", test_datapoints_post_batches, TT_ENABLED_, 0, 0 },
     { "test_datapoint_value_setters_and_getters", test_datapoint_value_setters_and_getters, TT_ENABLED_, 0, 0 },
     /* The array has to end with END_OF_TESTCASES. */
     END_OF_TESTCASES